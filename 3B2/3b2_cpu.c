@@ -957,6 +957,7 @@ t_stat cpu_set_size(UNIT *uptr, int32 val, CONST char *cptr, void *desc)
 
     free(RAM);
     RAM = nRAM;
+    flush_xlate_cache();
 
     MEM_SIZE = uval;
 
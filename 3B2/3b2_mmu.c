@@ -34,6 +34,8 @@ UNIT mmu_unit = { UDATA(NULL, 0, 0) };
 
 MMU_STATE mmu_state;
 
+MMU_XC_ENT mmu_xc[MMU_XC_SIZE];
+
 REG mmu_reg[] = {
     { HRDATAD (ENABLE, mmu_state.enabled, 1, "Enabled?")        },
     { HRDATAD (CONFIG, mmu_state.conf,   32, "Configuration")   },
@@ -193,6 +195,7 @@ void mmu_write(uint32 pa, uint32 val, size_t size)
         mmu_state.sec[offset].addr = val & 0xffffffe0;
         /* We flush the entire section on writing SRAMA */
         flush_cache_sec((uint8) offset);
+        flush_xlate_cache();
         sim_debug(WRITE_MSG, &mmu_dev,
                   "[%08x] MMU_SRAMA[%d] = %08x (addr=%08x)\n",
                   R[NUM_PC], offset, val, mmu_state.sec[offset].addr);
@@ -201,7 +204,9 @@ void mmu_write(uint32 pa, uint32 val, size_t size)
         offset = offset & 3;
         mmu_state.srb[offset] = val;
         mmu_state.sec[offset].len = (val >> 10) & 0x1fff;
-        /* We do not flush the cache on writing SRAMB */
+        /* We do not flush the cache on writing SRAMB, but the
+           translation cache is not architectural, so flush it */
+        flush_xlate_cache();
         sim_debug(WRITE_MSG, &mmu_dev,
                   "[%08x] MMU_SRAMB[%d] = %08x (len=%06x)\n",
                   R[NUM_PC], offset, val, mmu_state.sec[offset].len);
@@ -217,6 +222,7 @@ void mmu_write(uint32 pa, uint32 val, size_t size)
         break;
     case MMU_CONF:
         mmu_state.conf = val & 0x7;
+        flush_xlate_cache();
         sim_debug(WRITE_MSG, &mmu_dev,
                   "[%08x] MMU_CONF = %08x\n",
                   R[NUM_PC], val);
@@ -810,6 +816,63 @@ t_stat read_operand(uint32 va, uint8 *val) {
     return succ;
 }
 
+/*
+ * Enter a translation that has just succeeded into the translation
+ * cache, if repeating it would have no side effects and the whole
+ * page maps to RAM.
+ */
+static void put_xlate(uint32 va, uint8 r_acc)
+{
+    MMU_XC_ENT *xc;
+    uint32 sd0, sd1, pd, pa;
+    uint8 pd_acc, ci, flags;
+
+    if (get_sdce(va, &sd0, &sd1) != SCPE_OK) {
+        return;
+    }
+
+    if (SD_CONTIG(sd0)) {
+        if (MMU_CONF_R ||
+            SD_TRAP(sd0) ||
+            SHOULD_UPDATE_SD_M_BIT(sd0) ||
+            mmu_check_perm(SD_ACC(sd0), r_acc) != SCPE_OK ||
+            (SOT(va) | 0x7ff) > MAX_OFFSET(sd0)) {
+            return;
+        }
+        pa = SD_SEG_ADDR(sd1) + (SOT(va) & ~0x7ffu);
+        flags = MMU_XC_VALID | MMU_XC_CONTIG;
+    } else {
+        if (get_pdce(va, &pd, &pd_acc) != SCPE_OK ||
+            mmu_check_perm(pd_acc, r_acc) != SCPE_OK ||
+            ((r_acc == ACC_W || r_acc == ACC_IR) && PD_WFAULT(pd)) ||
+            SHOULD_UPDATE_PD_M_BIT(pd) ||
+            SHOULD_UPDATE_PD_R_BIT(pd)) {
+            return;
+        }
+        pa = PD_ADDR(pd);
+        flags = MMU_XC_VALID;
+    }
+
+    if (!addr_is_mem(pa) || !addr_is_mem(pa + 0x7ff)) {
+        return;
+    }
+
+    xc = &mmu_xc[MMU_XC_IDX(va, r_acc)];
+    xc->page = MMU_XC_PAGE(va);
+    xc->r_acc = r_acc;
+    xc->cm = CPU_CM;
+    xc->flags = flags;
+    ci = (SID(va) * NUM_SDCE) + SD_IDX(va);
+    xc->sdcl = mmu_state.sdcl[ci];
+    xc->sdch = mmu_state.sdch[ci];
+    ci = (SID(va) * NUM_PDCE) + PD_IDX(va);
+    xc->pdcll = mmu_state.pdcll[ci];
+    xc->pdclh = mmu_state.pdclh[ci];
+    xc->pdcrl = mmu_state.pdcrl[ci];
+    xc->pdcrh = mmu_state.pdcrh[ci];
+    xc->mem = RAM + ((pa - PHYS_MEM_BASE) >> 2);
+}
+
 uint32 mmu_xlate_addr(uint32 va, uint8 r_acc)
 {
     uint32 pa;
@@ -819,6 +882,9 @@ uint32 mmu_xlate_addr(uint32 va, uint8 r_acc)
 
     if (succ == SCPE_OK) {
         mmu_state.var = va;
+        if (mmu_enabled()) {
+            put_xlate(va, r_acc);
+        }
         return pa;
     } else {
         cpu_abort(NORMAL_EXCEPTION, EXTERNAL_MEMORY_FAULT);
@@ -837,6 +903,7 @@ void mmu_enable()
               "[%08x] Enabling MMU.\n",
               R[NUM_PC]);
     mmu_state.enabled = TRUE;
+    flush_xlate_cache();
 }
 
 void mmu_disable()
@@ -845,6 +912,7 @@ void mmu_disable()
               "[%08x] Disabling MMU.\n",
               R[NUM_PC]);
     mmu_state.enabled = FALSE;
+    flush_xlate_cache();
 }
 
 /*
@@ -853,30 +921,81 @@ void mmu_disable()
 
 uint8 read_b(uint32 va, uint8 r_acc)
 {
+    uint32 *m;
+
+    if ((m = get_xlate(va, r_acc)) != NULL) {
+        mmu_state.var = va;
+        return (*m >> ((~(va & 3) << 3) & 0x1f)) & BYTE_MASK;
+    }
+
     return pread_b(mmu_xlate_addr(va, r_acc));
 }
 
 uint16 read_h(uint32 va, uint8 r_acc)
 {
+    uint32 *m;
+
+    if (!(va & 1) && (m = get_xlate(va, r_acc)) != NULL) {
+        mmu_state.var = va;
+        return (va & 2) ? (*m & HALF_MASK) : ((*m >> 16) & HALF_MASK);
+    }
+
     return pread_h(mmu_xlate_addr(va, r_acc));
 }
 
 uint32 read_w(uint32 va, uint8 r_acc)
 {
+    uint32 *m;
+
+    if (!(va & 3) && (m = get_xlate(va, r_acc)) != NULL) {
+        mmu_state.var = va;
+        return *m;
+    }
+
     return pread_w(mmu_xlate_addr(va, r_acc));
 }
 
 void write_b(uint32 va, uint8 val)
 {
+    uint32 *m;
+    int32 sc;
+
+    if ((m = get_xlate(va, ACC_W)) != NULL) {
+        mmu_state.var = va;
+        sc = (~(va & 3) << 3) & 0x1f;
+        *m = (*m & ~(0xffu << sc)) | ((uint32) val << sc);
+        return;
+    }
+
     pwrite_b(mmu_xlate_addr(va, ACC_W), val);
 }
 
 void write_h(uint32 va, uint16 val)
 {
+    uint32 *m;
+
+    if (!(va & 1) && (m = get_xlate(va, ACC_W)) != NULL) {
+        mmu_state.var = va;
+        if (va & 2) {
+            *m = (*m & ~HALF_MASK) | (uint32) val;
+        } else {
+            *m = (*m & HALF_MASK) | ((uint32) val << 16);
+        }
+        return;
+    }
+
     pwrite_h(mmu_xlate_addr(va, ACC_W), val);
 }
 
 void write_w(uint32 va, uint32 val)
 {
+    uint32 *m;
+
+    if (!(va & 3) && (m = get_xlate(va, ACC_W)) != NULL) {
+        mmu_state.var = va;
+        *m = val;
+        return;
+    }
+
     pwrite_w(mmu_xlate_addr(va, ACC_W), val);
 }
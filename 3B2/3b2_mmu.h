@@ -139,6 +139,24 @@
  *  "U" is only set in the left cache entry, and indicates
  *  which slot (left or right) was most recently updated.
  *
+ *
+ * Translation Cache
+ * -----------------
+ *
+ * Separately from the architectural SDC and PDC above, the simulator
+ * keeps a host-side translation cache that maps a 2K virtual page,
+ * access type and CPU mode directly to a host pointer into RAM. It is
+ * not visible to the simulated machine. An entry is only created
+ * after a successful translation that left both the SD and (for paged
+ * segments) the PD in the architectural caches, and that would have
+ * no side effects if repeated: no fault, no object trap, and no R or
+ * M bit left to update. Each entry remembers the SDC and PDC words it
+ * was built from, and is only used while those words are unchanged,
+ * so the emulated cache behavior is preserved exactly. The whole
+ * cache is also flushed when the emulated caches are flushed, when
+ * SRAMA, SRAMB or the configuration register are written, when the
+ * MMU is enabled or disabled, and when RAM is reallocated.
+ *
  ***********************************************************************/
 
 #define MMUBASE 0x40000
@@ -275,6 +293,13 @@
 
 #define PDCLH_USED_MASK       0x40u
 
+/* Translation cache */
+#define MMU_XC_SIZE           256
+#define MMU_XC_PAGE(va)       ((va) & 0xfffff800)
+#define MMU_XC_IDX(va,acc)    ((((va) >> 11) ^ ((uint32)(acc) << 4)) & (MMU_XC_SIZE - 1))
+#define MMU_XC_CONTIG         0x1u    /* Entry is for a contiguous segment */
+#define MMU_XC_VALID          0x2u    /* Entry is in use */
+
 /* Fault codes */
 #define MMU_FAULT(f) {                                      \
         if (fc) {                                           \
@@ -313,7 +338,22 @@ typedef struct _mmu_state {
 
 } MMU_STATE;
 
+typedef struct _mmu_xc_ent {
+    uint32 page;            /* Virtual page address */
+    uint8  r_acc;           /* Access request type */
+    uint8  cm;              /* CPU mode at translation */
+    uint8  flags;           /* MMU_XC_ flags */
+    uint32 sdcl;            /* SDC words the entry depends on */
+    uint32 sdch;
+    uint32 pdcll;           /* PDC words the entry depends on */
+    uint32 pdclh;
+    uint32 pdcrl;
+    uint32 pdcrh;
+    uint32 *mem;            /* Host pointer to start of page in RAM */
+} MMU_XC_ENT;
+
 extern MMU_STATE mmu_state;
+extern MMU_XC_ENT mmu_xc[MMU_XC_SIZE];
 
 extern volatile int32 stop_reason;
 extern DEVICE mmu_dev;
@@ -502,6 +542,15 @@ static SIM_INLINE void flush_cache_sec(uint8 sec)
     }
 }
 
+static SIM_INLINE void flush_xlate_cache()
+{
+    int i;
+
+    for (i = 0; i < MMU_XC_SIZE; i++) {
+        mmu_xc[i].flags = 0;
+    }
+}
+
 static SIM_INLINE void flush_caches()
 {
     uint8 i;
@@ -509,6 +558,44 @@ static SIM_INLINE void flush_caches()
     for (i = 0; i < NUM_SEC; i++) {
         flush_cache_sec(i);
     }
+
+    flush_xlate_cache();
+}
+
+/*
+ * Look up a virtual address in the translation cache. Returns a host
+ * pointer to the word containing the address, or NULL on a miss.
+ */
+static SIM_INLINE uint32 *get_xlate(uint32 va, uint8 r_acc)
+{
+    MMU_XC_ENT *xc = &mmu_xc[MMU_XC_IDX(va, r_acc)];
+    uint8 ci;
+
+    if (!(xc->flags & MMU_XC_VALID) ||
+        xc->page != MMU_XC_PAGE(va) ||
+        xc->r_acc != r_acc ||
+        xc->cm != CPU_CM) {
+        return NULL;
+    }
+
+    ci = (SID(va) * NUM_SDCE) + SD_IDX(va);
+
+    if (mmu_state.sdcl[ci] != xc->sdcl || mmu_state.sdch[ci] != xc->sdch) {
+        return NULL;
+    }
+
+    if (!(xc->flags & MMU_XC_CONTIG)) {
+        ci = (SID(va) * NUM_PDCE) + PD_IDX(va);
+
+        if (mmu_state.pdcll[ci] != xc->pdcll ||
+            mmu_state.pdclh[ci] != xc->pdclh ||
+            mmu_state.pdcrl[ci] != xc->pdcrl ||
+            mmu_state.pdcrh[ci] != xc->pdcrh) {
+            return NULL;
+        }
+    }
+
+    return xc->mem + ((va & 0x7ff) >> 2);
 }
 
 static SIM_INLINE t_stat mmu_check_perm(uint8 flags, uint8 r_acc)
@@ -314,6 +314,12 @@ static t_stat disk2_detach(UNIT *uptr)
     if (uptr->flags & UNIT_DISK2_VERBOSE)
         sim_printf("Detach DISK2%d\n", i);
 
+    if (disk2_info->drive[i].imd != NULL) {
+        r = diskClose(&disk2_info->drive[i].imd);  /* save written tracks */
+        if (r != SCPE_OK)
+            return r;
+    }
+
     r = detach_unit(uptr);  /* detach unit */
     if ( r != SCPE_OK)
         return r;
@@ -385,6 +385,12 @@ static t_stat disk3_detach(UNIT *uptr)
     if (uptr->flags & UNIT_DISK3_VERBOSE)
         sim_printf("Detach DISK3%d\n", i);
 
+    if (disk3_info->drive[i].imd != NULL) {
+        r = diskClose(&disk3_info->drive[i].imd);  /* save written tracks */
+        if (r != SCPE_OK)
+            return r;
+    }
+
     r = detach_unit(uptr);  /* detach unit */
     if ( r != SCPE_OK)
         return r;
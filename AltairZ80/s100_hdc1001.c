@@ -279,6 +279,12 @@ static t_stat hdc1001_detach(UNIT *uptr)
     if (uptr->flags & UNIT_HDC1001_VERBOSE)
         sim_printf("Detach HDC1001%d\n", i);
 
+    if (hdc1001_info->drive[i].imd != NULL) {
+        r = diskClose(&hdc1001_info->drive[i].imd);  /* save written tracks */
+        if (r != SCPE_OK)
+            return r;
+    }
+
     r = detach_unit(uptr);  /* detach unit */
     if ( r != SCPE_OK)
         return r;
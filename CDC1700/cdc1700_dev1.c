@@ -945,8 +945,8 @@ t_stat ptr_svc(UNIT *uptr)
     return SCPE_OK;
   }
 
-  if ((temp = getc(uptr->fileref)) == EOF) {
-    if (feof(uptr->fileref)) {
+  if ((temp = sim_ustream_getc(uptr)) == EOF) {
+    if (sim_ustream_eof(uptr)) {
       if ((ptr_dev.dctrl & DBG_DTRACE) != 0)
         fprintf(DBGOUT, "%s[PTR: ptr_svc() exit - EOF]\r\n", INTprefix);
 
@@ -957,13 +957,12 @@ t_stat ptr_svc(UNIT *uptr)
       fw_IOintr(FALSE, &ptr_dev, &PTRdev, IO_ST_ALARM | IO_1721_MOTIONF, IO_ST_READY, 0xFFFF, "End of tape");
       return SCPE_OK;
     } else perror("PTR I/O error");
-    clearerr(uptr->fileref);
+    sim_ustream_error(uptr);
     if ((ptr_dev.dctrl & DBG_DTRACE) != 0)
       fprintf(DBGOUT, "%s[PTR: ptr_svc() exit - Read Error]\r\n", INTprefix);
     return SCPE_IOERR;
   }
   uptr->buf = temp & 0xFF;
-  uptr->pos++;
 
   fw_IOcompleteData(FALSE, &ptr_dev, &PTRdev, 0xFFFF, "Read Complete");
 
@@ -1262,10 +1261,8 @@ t_stat ptp_svc(UNIT *uptr)
     PTPdev.iod_PTPdelay &= ~IODP_PTPDATAWAIT;
 
     if ((uptr->flags & UNIT_ATT) != 0) {
-      if (putc(uptr->buf, uptr->fileref) == EOF) {
+      if (sim_ustream_putc(uptr->buf, uptr) == EOF)
         perror("PTP I/O error");
-        clearerr(uptr->fileref);
-      } else uptr->pos++;
     }
 
     fw_IOcompleteData(FALSE, &ptp_dev, &PTPdev, 0xFFFF, "Output complete");
@@ -512,9 +512,8 @@ enum IOstatus LPout(IO_DEVICE *iod, uint8 reg)
             }
 
             if ((lp_unit.flags & UNIT_ATT) != 0) {
-              if (fputs(ccontrol, lp_unit.fileref) == EOF) {
+              if (sim_ustream_puts(ccontrol, &lp_unit) == EOF) {
                 perror("LP I/O error");
-                clearerr(lp_unit.fileref);
               }
             }
             fw_IOunderwayData(&LPdev, 0);
@@ -568,9 +567,8 @@ enum IOstatus LPout(IO_DEVICE *iod, uint8 reg)
               int i;
               
               for (i = 0; i < iod->iod_LPcolumn; i++) {
-                if (putc(buffer[i], lp_unit.fileref) == EOF) {
+                if (sim_ustream_putc(buffer[i], &lp_unit) == EOF) {
                   perror("LP I/O error");
-                  clearerr(lp_unit.fileref);
                 }
               }
             }
@@ -598,16 +596,14 @@ enum IOstatus LPout(IO_DEVICE *iod, uint8 reg)
               int i;
 
               if (iod->iod_LPoverwrite) {
-                if (putc('\r', lp_unit.fileref) == EOF) {
+                if (sim_ustream_putc('\r', &lp_unit) == EOF) {
                   perror("LP I/O error");
-                  clearerr(lp_unit.fileref);
                 }
               }
 
               for (i = 0; i < iod->iod_LPcolumn; i++) {
-                if (putc(buffer[i], lp_unit.fileref) == EOF) {
+                if (sim_ustream_putc(buffer[i], &lp_unit) == EOF) {
                   perror("LP I/O error");
-                  clearerr(lp_unit.fileref);
                 }
               }
               iod->iod_LPoverwrite = TRUE;
@@ -620,14 +616,12 @@ enum IOstatus LPout(IO_DEVICE *iod, uint8 reg)
           /*** TODO: Implement format tape operations.
                For now, all operations generate a single space motion ***/
           if ((lp_unit.flags & UNIT_ATT) != 0) {
-            if (putc('\n', lp_unit.fileref) == EOF) {
+            if (sim_ustream_putc('\n', &lp_unit) == EOF) {
               perror("LP I/O error");
-              clearerr(lp_unit.fileref);
             }
             if ((Areg & IO_1740_DSP) != 0) {
-              if (putc('\n', lp_unit.fileref) == EOF) {
+              if (sim_ustream_putc('\n', &lp_unit) == EOF) {
                 perror("LP I/O error");
-                clearerr(lp_unit.fileref);
               }
             }
           }
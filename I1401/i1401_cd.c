@@ -294,11 +294,8 @@ else if (s2sel)                                         /* stacker 2? */
 else uptr = &stack_unit[0];                             /* then default */
 if ((uptr->flags & UNIT_ATT) == 0)                      /* attached? */
     return SCPE_OK;
-fputs (cdr_buf, uptr->fileref);                         /* write card */
-uptr->pos = ftell (uptr->fileref);                      /* update position */
-if (ferror (uptr->fileref)) {                           /* error? */
+if (sim_ustream_puts (cdr_buf, uptr) == EOF) {          /* write card, error? */
     sim_perror ("Card stacker I/O error");
-    clearerr (uptr->fileref);
     if (iochk)
         return SCPE_IOERR;
     }
@@ -373,12 +370,9 @@ else if (s4sel)                                         /* stack 4? */
 else uptr = &cdp_unit;                                  /* normal output */
 if ((uptr->flags & UNIT_ATT) == 0)                      /* attached? */
     return SCPE_UNATT;
-fputs (cdp_buf, uptr->fileref);                         /* output card */
-fputc ('\n', uptr->fileref);                            /* plus new line */
-uptr->pos = ftell (uptr->fileref);                      /* update position */
-if (ferror (uptr->fileref)) {                           /* error? */
+if ((sim_ustream_puts (cdp_buf, uptr) == EOF) ||       /* output card */
+    (sim_ustream_putc ('\n', uptr) == EOF)) {           /* plus new line, error? */
     sim_perror ("Card punch I/O error");
-    clearerr (uptr->fileref);
     if (iochk)
         return SCPE_IOERR;
     ind[IN_PNCH] = 1;
@@ -410,23 +404,23 @@ return SCPE_OK;
 
 t_stat cdr_read_file (char *buf, int32 sz)
 {
-fgets (buf, sz, cdr_unit.fileref);                      /* rd bin/char card */
-if (feof (cdr_unit.fileref))                            /* eof? */
+sim_ustream_gets (buf, sz, &cdr_unit);                  /* rd bin/char card */
+if (sim_ustream_eof (&cdr_unit))                        /* eof? */
     return STOP_NOCD;
-if (ferror (cdr_unit.fileref)) {                        /* error? */
+if (sim_ustream_error (&cdr_unit)) {                    /* error? */
     ind[IN_READ] = 1;  
     sim_perror ("Card reader I/O error");
-    clearerr (cdr_unit.fileref);
     if (iochk)
         return SCPE_IOERR;
     return SCPE_OK;
     }
-cdr_unit.pos = ftell (cdr_unit.fileref);                /* update position */
 if (ssa) {                                              /* if last cd on */
-    getc (cdr_unit.fileref);                            /* see if more */
-    if (feof (cdr_unit.fileref))                        /* eof? set flag */
-        ind[IN_LST] = 1;
-    fseek (cdr_unit.fileref, cdr_unit.pos, SEEK_SET);
+    int32 c = sim_ustream_getc (&cdr_unit);             /* see if more */
+    if (c == EOF) {
+        if (sim_ustream_eof (&cdr_unit))                /* eof? set flag */
+            ind[IN_LST] = 1;
+        }
+    else sim_ustream_ungetc (c, &cdr_unit);
     }
 return SCPE_OK;
 }
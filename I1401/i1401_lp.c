@@ -240,15 +240,12 @@ return r;
 t_stat lpt_puts (const char *buf)
 {
 if ((lpt_unit.flags & UNIT_ATT) != 0) {                 /* attached? */
-    fputs (buf, lpt_unit.fileref);                      /* print string */
-    if (ferror (lpt_unit.fileref)) {                    /* error? */
+    if (sim_ustream_puts (buf, &lpt_unit) == EOF) {     /* print string, error? */
         ind[IN_LPT] = 1;
         sim_perror ("Line printer I/O error");
-        clearerr (lpt_unit.fileref);
         if (iochk)
             return SCPE_IOERR;
         }
-    lpt_unit.pos = ftell (lpt_unit.fileref);            /* update position */
     return SCPE_OK;
     }
 if ((lpt_unit.flags & UNIT_CONS) != 0) {               /* default to cons? */
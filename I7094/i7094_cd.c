@@ -215,16 +215,14 @@ switch (cdr_sta) {                                      /* case on state */
             cdr_cbuf[i] = ' ';
         cdr_sta = CDS_DATA;                             /* data state */
         cdr_bptr = 0;                                   /* init buf ptr */
-        fgets (cdr_cbuf, (uptr->flags & UNIT_CBN)? (2 * CD_CHRLNT) + 2: CD_CHRLNT + 2,
-            uptr->fileref);                             /* read card */
-        if (feof (uptr->fileref))                       /* eof? */
+        sim_ustream_gets (cdr_cbuf, (uptr->flags & UNIT_CBN)? (2 * CD_CHRLNT) + 2: CD_CHRLNT + 2,
+            uptr);                                      /* read card */
+        if (sim_ustream_eof (uptr))                     /* eof? */
             return ch6_err_disc (CH_A, U_CDR, CHF_EOF); /* set EOF, disc */
-        if (ferror (uptr->fileref)) {                   /* error? */
+        if (sim_ustream_error (uptr)) {                 /* error? */
             sim_perror ("CDR I/O error");
-            clearerr (uptr->fileref);
             return SCPE_IOERR;                          /* stop */
             }
-        uptr->pos = ftell (uptr->fileref);              /* update position */
         for (i = 0; i < (2 * CD_CHRLNT); i++)           /* convert to BCD */
             cdr_cbuf[i] = ascii_to_bcd[cdr_cbuf[i] & 0177] & 077;
         for (col = 0; col < 72; col++) {                /* process 72 columns */
@@ -447,11 +445,8 @@ for (i = ((2 * CD_CHRLNT) + 1); (i > 0) &&
     (cdp_cbuf[i - 1] == ' '); --i) ;                    /* trim spaces */
 cdp_cbuf[i++] = '\n';                                   /* append nl */
 cdp_cbuf[i++] = 0;                                      /* append nul */
-fputs (cdp_cbuf, uptr->fileref);                        /* write card */
-uptr->pos = ftell (uptr->fileref);                      /* update position */
-if (ferror (uptr->fileref)) {                           /* error? */
+if (sim_ustream_puts (cdp_cbuf, uptr) == EOF) {         /* write card, error? */
     sim_perror ("CDP I/O error");
-    clearerr (uptr->fileref);
     return SCPE_IOERR;
     }
 cdp_sta = CDS_END;                                      /* end state */
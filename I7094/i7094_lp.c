@@ -329,14 +329,12 @@ for (i = LPT_CHRLNT; (i > 0) &&
     (lpt_cbuf[i - 1] == ' '); --i) ;                    /* trim spaces */
 lpt_cbuf[i] = 0;                                        /* append nul */
 if (uptr->flags & UNIT_ATT) {                           /* file? */
-    fputs (lpt_cbuf, uptr->fileref);                    /* write line */
-    fputc ('\n', uptr->fileref);                        /* append nl */
-    uptr->pos = ftell (uptr->fileref);                  /* update position */
-    if (ferror (uptr->fileref)) {                       /* error? */
+    lpt_cbuf[i] = '\n';                                 /* append nl */
+    if (sim_ustream_write (uptr, lpt_cbuf, i + 1) != (size_t)(i + 1)) {
         sim_perror ("LPT I/O error");
-        clearerr (uptr->fileref);
         return SCPE_IOERR;
         }
+    lpt_cbuf[i] = 0;
     }
 else if (uptr->flags & UNIT_CONS) {                     /* print to console? */
     for (i = 0; lpt_cbuf[i] != 0; i++)
@@ -48,6 +48,7 @@ t_stat dpy_reset (DEVICE *dptr);
    dpy_dev      DPY device descriptor
    dpy_unit     DPY unit
    dpy_reg      DPY register list
+   dpy_mod      DPY modifier list
 */
 
 #define CYCLE_TIME 5                /* 5us memory cycle */
@@ -76,8 +77,14 @@ DEBTAB dpy_deb[] = {
     { NULL, 0 }
     };
 
+MTAB dpy_mod[] = {
+    { MTAB_XTD|MTAB_VDV|MTAB_VALR, 0, "DECAY", "DECAY={QUEUE|DENSE}",
+        &sim_display_set_decay, &sim_display_show_decay, NULL, "Phosphor decay model" },
+    { 0 }
+    };
+
 DEVICE dpy_dev = {
-        "DPY", &dpy_unit, NULL, NULL,
+        "DPY", &dpy_unit, NULL, dpy_mod,
         1, 10, 31, 1, 8, 8,
         NULL, NULL, &dpy_reset,
         NULL, NULL, NULL,
@@ -164,6 +171,8 @@ t_stat dpy_reset (DEVICE *dptr)
         cpls = cpls & ~CPLS_DPY;
         iosta = iosta & ~(IOS_PNT | IOS_SPC); /* clear flags */
         }
+    else
+        display_close();                /* release display, if any */
     sim_cancel (&dpy_unit);             /* deactivate unit */
     return SCPE_OK;
 }
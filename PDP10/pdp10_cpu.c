@@ -499,20 +499,20 @@ static t_stat jrst_tab[16] = {
 
 /* Memory operations */
 
-#define RD              mb = Read (ea, MM_OPND)
-#define RDAC            AC(ac) = Read (ea, MM_OPND)
-#define RM              mb = ReadM (ea, MM_OPND)
-#define RMAC            AC(ac) = ReadM (ea, MM_OPND)
-#define RDP             mb = Read (((a10) AC(ac)) & AMASK, MM_BSTK)
-#define RD2             rs[0] = Read (ea, MM_OPND); \
-                        rs[1] = Read (INCA (ea), MM_OPND)
-#define WR              Write (ea, mb, MM_OPND)
-#define WRAC            Write (ea, AC(ac), MM_OPND)
-#define WRP(x)          Write (((a10) INCA (AC(ac))), (x), MM_BSTK)
-#define WR1             Write (ea, rs[0], MM_OPND)
-#define WR2             ReadM (INCA (ea), MM_OPND); \
-                        Write (ea, rs[0], MM_OPND); \
-                        Write (INCA (ea), rs[1], MM_OPND)
+#define RD              mb = ReadF (ea, MM_OPND)
+#define RDAC            AC(ac) = ReadF (ea, MM_OPND)
+#define RM              mb = ReadMF (ea, MM_OPND)
+#define RMAC            AC(ac) = ReadMF (ea, MM_OPND)
+#define RDP             mb = ReadF (((a10) AC(ac)) & AMASK, MM_BSTK)
+#define RD2             rs[0] = ReadF (ea, MM_OPND); \
+                        rs[1] = ReadF (INCA (ea), MM_OPND)
+#define WR              WriteF (ea, mb, MM_OPND)
+#define WRAC            WriteF (ea, AC(ac), MM_OPND)
+#define WRP(x)          WriteF (((a10) INCA (AC(ac))), (x), MM_BSTK)
+#define WR1             WriteF (ea, rs[0], MM_OPND)
+#define WR2             ReadMF (INCA (ea), MM_OPND); \
+                        WriteF (ea, rs[0], MM_OPND); \
+                        WriteF (INCA (ea), rs[1], MM_OPND)
 
 /* Tests and compares */
 
@@ -620,6 +620,44 @@ static t_stat jrst_tab[16] = {
 #define POPF            if (LRZ (AC(ac)) == RMASK) SETF (F_T2)
 #define DMOVNF          if (rs[1] == 0) { MOVNF (rs[0]); }
 
+/* Fast path memory access for instruction fetch and operands
+
+   If the page is mapped in the host pointer page tables, access M directly;
+   otherwise (AC references, unmapped pages, write checks that need a page
+   table fill) use the pager routines.
+*/
+
+static SIM_INLINE d10 ReadF (a10 ea, int32 prv)
+{
+d10 *p;
+
+if ((ea >= AC_NUM) &&
+    ((p = (prv? hptbl_prv: hptbl_cur)[PAG_GETVPN (ea)].rd) != NULL))
+    return p[PAG_GETOFF (ea)];
+return Read (ea, prv);
+}
+
+static SIM_INLINE d10 ReadMF (a10 ea, int32 prv)
+{
+d10 *p;
+
+if ((ea >= AC_NUM) &&
+    ((p = (prv? hptbl_prv: hptbl_cur)[PAG_GETVPN (ea)].wr) != NULL))
+    return p[PAG_GETOFF (ea)];
+return ReadM (ea, prv);
+}
+
+static SIM_INLINE void WriteF (a10 ea, d10 val, int32 prv)
+{
+d10 *p;
+
+if ((ea >= AC_NUM) &&
+    ((p = (prv? hptbl_prv: hptbl_cur)[PAG_GETVPN (ea)].wr) != NULL))
+    p[PAG_GETOFF (ea)] = val;
+else Write (ea, val, prv);
+return;
+}
+
 t_value pdp10_pc_value (void)
 {
 return (t_value)pager_PC;
@@ -838,7 +876,7 @@ else {
 
 /* Ready (at last) to get an instruction */
 
-    inst = Read (pager_PC = PC, MM_CUR);                /* get instruction */
+    inst = ReadF (pager_PC = PC, MM_CUR);               /* get instruction */
     INCPC;  
     sim_interval = sim_interval - 1;
     }
@@ -863,7 +901,7 @@ for (indrct = inst, i = 0; ; i++) {                     /* calc eff addr */
             if ((ind_max != 0) && (i >= ind_max))       /* limit exceeded? */
                 ABORT (STOP_IND);
             }
-        indrct = Read (ea, MM_EA);                      /* fetch indirect */
+        indrct = ReadF (ea, MM_EA);                     /* fetch indirect */
         }
     else break;
     }
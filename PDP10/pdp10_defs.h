@@ -782,6 +782,19 @@ extern d10 ReadP (a10 ea);                              /* read, physical */
 extern void Write (a10 ea, d10 val, int32 prv);         /* write */
 extern void WriteE (a10 ea, d10 val);                   /* write, exec */
 extern void WriteP (a10 ea, d10 val);                   /* write, physical */
+
+/* Host pointer page tables
+
+   Parallel to the expanded pte tables in the pager, these give the address
+   in M of each mapped page, separately for read and for write access.  A
+   NULL pointer means the reference must take the normal pager path. */
+
+typedef struct {
+    d10         *rd;                                    /* readable page */
+    d10         *wr;                                    /* writeable page */
+    } PAGHP;
+
+extern PAGHP *hptbl_cur, *hptbl_prv;                    /* cur, prv (dyn) */
 extern t_bool AccViol (a10 ea, int32 prv, int32 mode);  /* access check */
 
 t_stat set_addr (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
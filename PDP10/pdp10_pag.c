@@ -86,6 +86,7 @@
 #define PTBL_M          (1u << 31)                      /* must be sign bit */
 #define PTBL_V          (1u << 30)
 #define PTBL_MASK       (PAG_PPN | PTBL_M | PTBL_V)
+#define PTBL_NUSED      (2 * PTBL_MEMSIZE)              /* filled entry list size */
 
 /* NXM processing */
 
@@ -108,9 +109,17 @@ int32 eptbl[PTBL_MEMSIZE];                              /* exec page table */
 int32 uptbl[PTBL_MEMSIZE];                              /* user page table */
 int32 physptbl[PTBL_MEMSIZE];                           /* phys page table */
 int32 *ptbl_cur, *ptbl_prv;
+PAGHP ehptbl[PTBL_MEMSIZE];                             /* exec host ptrs */
+PAGHP uhptbl[PTBL_MEMSIZE];                             /* user host ptrs */
+PAGHP physhptbl[PTBL_MEMSIZE];                          /* phys host ptrs */
+PAGHP *hptbl_cur, *hptbl_prv;
+int32 ptbl_used[PTBL_NUSED];                            /* filled exec/user entries */
+int32 ptbl_nused = PTBL_NUSED + 1;                      /* > PTBL_NUSED: list lost */
 int32 save_ea;
 
 int32 ptbl_fill (a10 ea, int32 *ptbl, int32 mode);
+void ptbl_set (int32 *tbl, int32 vpn, int32 xpte);
+void ptbl_clr (void);
 t_stat pag_ex (t_value *vptr, t_addr addr, UNIT *uptr, int32 sw);
 t_stat pag_dep (t_value val, t_addr addr, UNIT *uptr, int32 sw);
 t_stat pag_reset (DEVICE *dptr);
@@ -351,8 +360,8 @@ if (Q_ITS) {                                            /* ITS paging */
             ((acc == ITS_ACC_RW)? PTBL_M: 0);
         decvpn = PAG_GETVPN (ea);                       /* get tlb idx */
         if (!(mode & PTF_CON)) {
-            tbl[decvpn & ~1] = xpte;                    /* map lo ITS page */
-            tbl[decvpn | 1] = xpte + PAG_SIZE;          /* map hi */
+            ptbl_set (tbl, decvpn & ~1, xpte);          /* map lo ITS page */
+            ptbl_set (tbl, decvpn | 1, xpte + PAG_SIZE); /* map hi */
             }
         return (xpte + ((decvpn & 1)? PAG_SIZE: 0));
         }
@@ -393,7 +402,7 @@ else if (!T20PAG) {                                     /* TOPS-10 paging */
         xpte = ((pte & PTE_PPMASK) << PAG_V_PN) |       /* calc exp pte */
             PTBL_V | ((pte & PTE_T10_W)? PTBL_M: 0);
         if (!(mode & PTF_CON))                          /* set tbl if ~cons */
-            tbl[vpn] = xpte;
+            ptbl_set (tbl, vpn, xpte);
         return xpte;
         }
     PAGE_FAIL_TRAP;
@@ -561,11 +570,70 @@ else {                                                  /* TOPS-20 paging */
         ((acc & PTE_T20_W)? PF_T20_W: 0) |
         ((acc & PTE_T20_C)? PF_C: 0);
     if (!(mode & PTF_CON))                              /* set tbl if ~cons */
-        tbl[vpn] = xpte;
+        ptbl_set (tbl, vpn, xpte);
     return xpte;
     }                                                   /* end TOPS20 paging */
 }
 
+/* Set page table entry and its host pointers
+
+   The host pointers are only set for pages in existing memory; the write
+   pointer only if the expanded pte allows writing (PTBL_M).  Exec and user
+   entries which go from empty to filled are listed in ptbl_used, so that
+   ptbl_clr need only visit those.
+*/
+
+void ptbl_set (int32 *tbl, int32 vpn, int32 xpte)
+{
+PAGHP *hp;
+a10 pa = xpte & PAMASK;
+
+if (tbl == uptbl)
+    hp = &uhptbl[vpn];
+else if (tbl == eptbl)
+    hp = &ehptbl[vpn];
+else hp = &physhptbl[vpn];
+if ((xpte != 0) && (tbl[vpn] == 0) && (tbl != physptbl)) { /* newly filled? */
+    if (ptbl_nused < PTBL_NUSED)
+        ptbl_used[ptbl_nused++] = ((tbl == uptbl)? PTBL_MEMSIZE: 0) + vpn;
+    else ptbl_nused = PTBL_NUSED + 1;                   /* overflow, clear all */
+    }
+tbl[vpn] = xpte;
+if ((xpte == 0) || (M == NULL) || MEM_ADDR_NXM (pa))    /* invalid, nxm? */
+    hp->rd = hp->wr = NULL;                             /* use normal path */
+else {
+    hp->rd = M + pa;
+    hp->wr = (xpte < 0)? hp->rd: NULL;
+    }
+return;
+}
+
+/* Clear the exec and user page tables
+
+   Called on every change of page table base (WREBR, WRUBR, LDBRn, LPMR),
+   so only the entries filled since the last clear are visited.
+*/
+
+void ptbl_clr (void)
+{
+int32 i;
+
+if (ptbl_nused > PTBL_NUSED) {                          /* list lost? */
+    for (i = 0; i < PTBL_MEMSIZE; i++) {
+        ptbl_set (eptbl, i, 0);
+        ptbl_set (uptbl, i, 0);
+        }
+    }
+else {
+    while (ptbl_nused > 0) {                            /* filled entries */
+        i = ptbl_used[--ptbl_nused];
+        ptbl_set ((i >= PTBL_MEMSIZE)? uptbl: eptbl, i & PTBL_AMASK, 0);
+        }
+    }
+ptbl_nused = 0;
+return;
+}
+
 /* Set up pointers for AC, memory, and process table access */
 
 void set_dyn_ptrs (void)
@@ -575,16 +643,21 @@ int32 t;
 if (PAGING) {
     ac_cur = &acs[UBR_GETCURAC (ubr) * AC_NUM];
     ac_prv = &acs[UBR_GETPRVAC (ubr) * AC_NUM];
-    if (TSTF (F_USR))
+    if (TSTF (F_USR)) {
         ptbl_cur = ptbl_prv = &uptbl[0];
+        hptbl_cur = hptbl_prv = &uhptbl[0];
+        }
     else {
         ptbl_cur = &eptbl[0];
+        hptbl_cur = &ehptbl[0];
         ptbl_prv = TSTF (F_UIO)? &uptbl[0]: &eptbl[0];
+        hptbl_prv = TSTF (F_UIO)? &uhptbl[0]: &ehptbl[0];
         }
     }
 else {
     ac_cur = ac_prv = &acs[0];
     ptbl_cur = ptbl_prv = &physptbl[0];
+    hptbl_cur = hptbl_prv = &physhptbl[0];
     }
 t = EBR_GETEBR (ebr);
 epta = t << PAG_V_PN;
@@ -649,14 +722,14 @@ t_bool clrpt (a10 ea, int32 prv)
 int32 vpn = PAG_GETVPN (ea);                            /* get page num */
 
 if (Q_ITS) {                                            /* ITS? */
-    uptbl[vpn & ~1] = 0;                                /* clear double size */
-    uptbl[vpn | 1] = 0;                                 /* entries in */
-    eptbl[vpn & ~1] = 0;                                /* both page tables */
-    eptbl[vpn | 1] = 0;
+    ptbl_set (uptbl, vpn & ~1, 0);                      /* clear double size */
+    ptbl_set (uptbl, vpn | 1, 0);                       /* entries in */
+    ptbl_set (eptbl, vpn & ~1, 0);                      /* both page tables */
+    ptbl_set (eptbl, vpn | 1, 0);
     }
 else {
-    uptbl[vpn] = 0;                                     /* clear entries in */
-    eptbl[vpn] = 0;                                     /* both page tables */
+    ptbl_set (uptbl, vpn, 0);                           /* clear entries in */
+    ptbl_set (eptbl, vpn, 0);                           /* both page tables */
     }
 return FALSE;
 } 
@@ -664,7 +737,7 @@ return FALSE;
 t_bool wrebr (a10 ea, int32 prv)
 {
 ebr = ea & EBR_MASK;                                    /* store EBR */
-pag_reset (&pag_dev);                                   /* clear page tables */
+ptbl_clr ();                                            /* clear page tables */
 set_dyn_ptrs ();                                        /* set dynamic ptrs */
 return FALSE;
 }
@@ -685,7 +758,7 @@ if (val & UBR_SETACB)                                   /* set AC's? */
 else val = val & ~UBR_ACBMASK;                          /* no, keep old val */
 if (val & UBR_SETUBR) {                                 /* set UBR? */
     ubr = ubr & ~ubr_mask;
-    pag_reset (&pag_dev);                               /* yes, clr pg tbls */
+    ptbl_clr ();                                        /* yes, clr pg tbls */
     }
 else val = val & ~ubr_mask;                             /* no, keep old val */
 ubr = (ubr | val) & (UBR_ACBMASK | ubr_mask);
@@ -776,7 +849,7 @@ return FALSE;
 t_bool ldbr1 (a10 ea, int32 prv)
 {
 dbr1 = ea;
-pag_reset (&pag_dev);
+ptbl_clr ();
 return FALSE;
 }
 
@@ -789,7 +862,7 @@ return FALSE;
 t_bool ldbr2 (a10 ea, int32 prv)
 {
 dbr2 = ea;
-pag_reset (&pag_dev);
+ptbl_clr ();
 return FALSE;
 }
 
@@ -802,7 +875,7 @@ return FALSE;
 t_bool ldbr3 (a10 ea, int32 prv)
 {
 dbr3 = ea;
-pag_reset (&pag_dev);
+ptbl_clr ();
 return FALSE;
 }
 
@@ -815,7 +888,7 @@ return FALSE;
 t_bool ldbr4 (a10 ea, int32 prv)
 {
 dbr4 = ea;
-pag_reset (&pag_dev);
+ptbl_clr ();
 return FALSE;
 }
 
@@ -845,7 +918,7 @@ val = Read (ADDA (ea, 2), prv);
 dbr1 = (a10) (Read (ea, prv) & AMASK);
 dbr2 = (a10) (Read (ADDA (ea, 1), prv) & AMASK);
 quant = val;
-pag_reset (&pag_dev);
+ptbl_clr ();
 return FALSE;
 }
 
@@ -878,8 +951,8 @@ int32 tbln = uptr - pag_unit;
 if (addr >= PTBL_MEMSIZE)
     return SCPE_NXM;
 if (tbln)
-    uptbl[addr] = (int32) val & PTBL_MASK;
-else eptbl[addr] = (int32) val & PTBL_MASK;
+    ptbl_set (uptbl, (int32) addr, (int32) val & PTBL_MASK);
+else ptbl_set (eptbl, (int32) addr, (int32) val & PTBL_MASK);
 return SCPE_OK;
 }
 
@@ -887,9 +960,9 @@ t_stat pag_reset (DEVICE *dptr)
 {
 int32 i;
 
-for (i = 0; i < PTBL_MEMSIZE; i++) {
-    eptbl[i] = uptbl[i] = 0;
-    physptbl[i] = (i << PAG_V_PN) + PTBL_M + PTBL_V;
-    }
+ptbl_nused = PTBL_NUSED + 1;                            /* clear everything */
+ptbl_clr ();
+for (i = 0; i < PTBL_MEMSIZE; i++)
+    ptbl_set (physptbl, i, (i << PAG_V_PN) + PTBL_M + PTBL_V);
 return SCPE_OK;
 }
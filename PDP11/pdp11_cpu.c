@@ -957,6 +957,7 @@ while (reason == 0)  {
     if (hst_lnt) {                                      /* record history? */
         t_value val;
         uint32 i;
+        int32 pa;
         static int32 swmap[4] = {
             SWMASK ('K') | SWMASK ('V'), SWMASK ('S') | SWMASK ('V'),
             SWMASK ('U') | SWMASK ('V'), SWMASK ('U') | SWMASK ('V')
@@ -967,10 +968,18 @@ while (reason == 0)  {
         hst_ent->src = 0;
         hst_ent->dst = 0;
         hst_ent->inst[0] = IR;
-        for (i = 1; i < HIST_ILNT; i++) {
-            if (cpu_ex (&val, (PC + (i << 1)) & 0177777, &cpu_unit, swmap[cm & 03]))
-                hst_ent->inst[i] = 0;
-            else hst_ent->inst[i] = (uint16) val;
+        pa = relocR (PC | isenable);                    /* (already fetched) */
+        if (((PC & VA_DF) <= (VA_DF - ((HIST_ILNT - 1) << 1))) &&
+            ADDR_IS_MEM (pa + ((HIST_ILNT - 1) << 1))) {
+            for (i = 1; i < HIST_ILNT; i++)             /* same page, in mem */
+                hst_ent->inst[i] = M[(pa >> 1) + i];    /* read directly */
+            }
+        else {
+            for (i = 1; i < HIST_ILNT; i++) {           /* crosses page, I/O */
+                if (cpu_ex (&val, (PC + (i << 1)) & 0177777, &cpu_unit, swmap[cm & 03]))
+                    hst_ent->inst[i] = 0;
+                else hst_ent->inst[i] = (uint16) val;
+                }
             }
         hst_p = (hst_p + 1);
         if (hst_p >= hst_lnt)
@@ -162,11 +162,8 @@ if (lpt_csr & CSR_IE)
     SET_INT (LPT);
 if ((uptr->flags & UNIT_ATT) == 0)
     return IORETURN (lpt_stopioe, SCPE_UNATT);
-fputc (uptr->buf & 0177, uptr->fileref);
-uptr->pos = ftell (uptr->fileref);
-if (ferror (uptr->fileref)) {
+if (sim_ustream_putc (uptr->buf & 0177, uptr) == EOF) {
     sim_perror ("LPT I/O error");
-    clearerr (uptr->fileref);
     return SCPE_IOERR;
     }
 lpt_csr = lpt_csr & ~CSR_ERR;
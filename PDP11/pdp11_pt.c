@@ -236,19 +236,18 @@ ptr_csr = (ptr_csr | CSR_ERR) & ~CSR_BUSY;
 if (ptr_csr & CSR_IE) SET_INT (PTR);
 if ((ptr_unit.flags & UNIT_ATT) == 0)
     return IORETURN (ptr_stopioe, SCPE_UNATT);
-if ((temp = getc (ptr_unit.fileref)) == EOF) {
-    if (feof (ptr_unit.fileref)) {
+if ((temp = sim_ustream_getc (&ptr_unit)) == EOF) {
+    if (sim_ustream_eof (&ptr_unit)) {
         if (ptr_stopioe)
             sim_printf ("PTR end of file\n");
         else return SCPE_OK;
         }
     else sim_perror ("PTR I/O error");
-    clearerr (ptr_unit.fileref);
+    sim_ustream_error (&ptr_unit);
     return SCPE_IOERR;
     }
 ptr_csr = (ptr_csr | CSR_DONE) & ~CSR_ERR;
 ptr_unit.buf = temp & 0377;
-ptr_unit.pos = ptr_unit.pos + 1;
 return SCPE_OK;
 }
 
@@ -337,13 +336,11 @@ if (ptp_csr & CSR_IE)
     SET_INT (PTP);
 if ((ptp_unit.flags & UNIT_ATT) == 0)
     return IORETURN (ptp_stopioe, SCPE_UNATT);
-if (putc (ptp_unit.buf, ptp_unit.fileref) == EOF) {
+if (sim_ustream_putc (ptp_unit.buf, &ptp_unit) == EOF) {
     sim_perror ("PTP I/O error");
-    clearerr (ptp_unit.fileref);
     return SCPE_IOERR;
     }
 ptp_csr = ptp_csr & ~CSR_ERR;
-ptp_unit.pos = ptp_unit.pos + 1;
 return SCPE_OK;
 }
 
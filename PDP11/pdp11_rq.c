@@ -170,9 +170,6 @@ extern int32 MMR2;
 #define pktq            us10                            /* packet queue */
 #define uf              buf                             /* settable unit flags */
 #define cnum            wait                            /* controller index */
-#define io_status       u5                              /* io status from callback */
-#define io_complete     u6                              /* io completion flag */
-#define rqxb            filebuf                         /* xfer buffer */
 #define UNIT_WPRT       (UNIT_WLK | UNIT_RO)            /* write prot */
 #define RQ_RMV(u)       ((drv_tab[GET_DTYPE (u->flags)].flgs & RQDF_RMV)? \
                         UF_RMV: 0)
@@ -756,6 +753,30 @@ int32 rq_itime4 = 10;                                   /* stage 4 */
 int32 rq_qtime = RQ_QTIME;                              /* queue time */
 int32 rq_xtime = RQ_XTIME;                              /* transfer time */
 
+/* Data transfer state.  A unit works on one transfer at a time, in the
+   packet at cpkt; the state below is indexed by packet number.  The buffer
+   is allocated the first time a packet carries a transfer and kept until
+   the controller is reset or the unit is detached.  A transfer aborted
+   while its host I/O is outstanding is only marked; it is ended when that
+   I/O completes.
+
+   This state is not in the register list.  A transfer's progress is kept
+   in its packet and only advances once a chunk has been posted, so after
+   a RESTORE (which reattaches the unit) any chunk that was in flight is
+   simply issued again. */
+
+#define XF_TOP          0                               /* issue host I/O */
+#define XF_IO           1                               /* host I/O active */
+#define XF_BOT          2                               /* post results */
+
+typedef struct {
+    uint16              *xb;                            /* xfer buffer */
+    uint32              state;                          /* xfer state */
+    t_stat              sts;                            /* host I/O status */
+    uint32              iostarttime;                    /* cmd start time */
+    uint32              abo;                            /* abort pending */
+    } RQ_XFER;
+
 typedef struct {
     uint32              cnum;                           /* ctrl number */
     uint16              ubase;                          /* unit base */
@@ -779,6 +800,7 @@ typedef struct {
     struct uq_ring      cq;                             /* cmd ring */
     struct uq_ring      rq;                             /* rsp ring */
     struct rqpkt        pak[RQ_NPKTS];                  /* packet queue */
+    RQ_XFER             xfer[RQ_NPKTS];                 /* xfer state, by pkt */
     } MSC;
 
 /* debugging bitmaps */
@@ -862,19 +884,26 @@ t_bool rq_rw (MSC *cp, uint16 pkt, t_bool q);
 t_bool rq_scc (MSC *cp, uint16 pkt, t_bool q);
 t_bool rq_suc (MSC *cp, uint16 pkt, t_bool q);
 t_bool rq_plf (MSC *cp, uint16 err);
-t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 err);
-t_bool rq_hbe (MSC *cp, UNIT *uptr);
+t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 tpkt, uint16 err);
+t_bool rq_hbe (MSC *cp, UNIT *uptr, uint16 tpkt);
 t_bool rq_una (MSC *cp, uint16 un);
 t_bool rq_deqf (MSC *cp, uint16 *pkt);
 uint16 rq_deqh (MSC *cp, uint16 *lh);
 void rq_enqh (MSC *cp, uint16 *lh, uint16 pkt);
 void rq_enqt (MSC *cp, uint16 *lh, uint16 pkt);
+void rq_unlink (MSC *cp, uint16 *lh, uint16 pkt);
 t_bool rq_getpkt (MSC *cp, uint16 *pkt);
 t_bool rq_putpkt (MSC *cp, uint16 pkt, t_bool qt);
 t_bool rq_getdesc (MSC *cp, struct uq_ring *ring, uint32 *desc);
 t_bool rq_putdesc (MSC *cp, struct uq_ring *ring, uint32 desc);
 uint16 rq_rw_valid (MSC *cp, uint16 pkt, UNIT *uptr, uint16 cmd);
-t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint16 flg, uint16 sts);
+t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint16 pkt, uint16 flg, uint16 sts);
+t_bool rq_xfer_chk (MSC *cp, UNIT *uptr, uint16 pkt);
+void rq_xfer_top (MSC *cp, UNIT *uptr, uint16 pkt);
+t_stat rq_xfer_bot (MSC *cp, UNIT *uptr, uint16 pkt);
+int32 rq_xfer_due (MSC *cp, uint16 pkt);
+void rq_xfer_sched (MSC *cp, UNIT *uptr);
+void rq_xfer_restart (MSC *cp, UNIT *uptr);
 uint32 rq_map_ba (uint32 ba, uint32 ma);
 int32 rq_readb (uint32 ba, int32 bc, uint32 ma, uint8 *buf);
 int32 rq_readw (uint32 ba, int32 bc, uint32 ma, uint16 *buf);
@@ -1661,12 +1690,22 @@ sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_abo\n");
 
 tpkt = 0;                                               /* set no mtch */
 if ((uptr = rq_getucb (cp, lu))) {                      /* get unit */
-    if (uptr->cpkt &&                                   /* curr pkt? */
-        (GETP32 (uptr->cpkt, CMD_REFL) == ref)) {       /* match ref? */
-        tpkt = uptr->cpkt;                              /* save match */
-        uptr->cpkt = 0;                                 /* gonzo */
-        sim_cancel (uptr);                              /* cancel unit */
-        sim_activate (dptr->units + RQ_QUEUE, rq_qtime);
+    for (tpkt = uptr->cpkt; tpkt != 0; tpkt = cp->pak[tpkt].link) {
+        if (GETP32 (tpkt, CMD_REFL) == ref)             /* active, match ref? */
+            break;
+        }
+    if (tpkt) {                                         /* active pkt? */
+        if (cp->xfer[tpkt].state == XF_IO) {            /* host I/O busy? */
+            cp->xfer[tpkt].abo = 1;                     /* end at completion */
+            tpkt = 0;                                   /* no response yet */
+            }
+        else {
+            sim_cancel (uptr);                          /* cancel unit */
+            rq_unlink (cp, &uptr->cpkt, tpkt);          /* gonzo */
+            cp->xfer[tpkt].state = XF_TOP;
+            rq_xfer_sched (cp, uptr);                   /* resume others */
+            sim_activate (dptr->units + RQ_QUEUE, rq_qtime);
+            }
         }
     else if (uptr->pktq &&                              /* head of q? */
         (GETP32 (uptr->pktq, CMD_REFL) == ref)) {       /* match ref? */
@@ -1733,9 +1772,14 @@ UNIT *uptr;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_gcs\n");
 
-if ((uptr = rq_getucb (cp, lu)) &&                      /* valid lu? */
-    (tpkt = uptr->cpkt) &&                              /* queued pkt? */
-    (GETP32 (tpkt, CMD_REFL) == ref) &&                 /* match ref? */
+tpkt = 0;
+if ((uptr = rq_getucb (cp, lu))) {                      /* valid lu? */
+    for (tpkt = uptr->cpkt; tpkt != 0; tpkt = cp->pak[tpkt].link) {
+        if (GETP32 (tpkt, CMD_REFL) == ref)             /* active, match ref? */
+            break;
+        }
+    }
+if (tpkt &&                                             /* found pkt? */
     (GETP (tpkt, CMD_OPC, OPC) >= OP_ACC)) {            /* rd/wr cmd? */
     cp->pak[pkt].d[GCS_STSL] = cp->pak[tpkt].d[RW_WBCL];
     cp->pak[pkt].d[GCS_STSH] = cp->pak[tpkt].d[RW_WBCH];
@@ -1953,7 +1997,8 @@ if ((uptr = rq_getucb (cp, lu))) {                      /* unit exist? */
         }
     sts = rq_rw_valid (cp, pkt, uptr, cmd);             /* validity checks */
     if (sts == 0) {                                     /* ok? */
-        uptr->cpkt = pkt;                               /* op in progress */
+        rq_enqt (cp, &uptr->cpkt, pkt);                 /* op in progress */
+        cp->xfer[pkt].state = XF_TOP;
         cp->pak[pkt].d[RW_WBAL] = cp->pak[pkt].d[RW_BAL];
         cp->pak[pkt].d[RW_WBAH] = cp->pak[pkt].d[RW_BAH];
         cp->pak[pkt].d[RW_WBCL] = cp->pak[pkt].d[RW_BCL];
@@ -1962,8 +2007,8 @@ if ((uptr = rq_getucb (cp, lu))) {                      /* unit exist? */
         cp->pak[pkt].d[RW_WBLH] = cp->pak[pkt].d[RW_LBNH];
         cp->pak[pkt].d[RW_WMPL] = cp->pak[pkt].d[RW_MAPL];
         cp->pak[pkt].d[RW_WMPH] = cp->pak[pkt].d[RW_MAPH];
-        uptr->iostarttime = sim_grtime();
-        sim_activate (uptr, 0);                         /* activate */
+        cp->xfer[pkt].iostarttime = sim_grtime();
+        rq_xfer_sched (cp, uptr);                       /* activate */
         sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_rw - started\n");
         return OK;                                      /* done */
         }
@@ -2014,18 +2059,39 @@ if ((cmd == OP_WR) || (cmd == OP_ERS)) {                /* write op? */
 return 0;                                               /* success! */
 }
 
-/* I/O completion callback */
+/* I/O completion callback - the disk layer runs one request per unit at
+   a time, so this belongs to the one transfer waiting on host I/O.  If
+   that transfer was aborted meanwhile, its buffer is free again now, so
+   end it here and let any queued commands proceed. */
 
 void rq_io_complete (UNIT *uptr, t_stat status)
 {
 MSC *cp = rq_ctxmap[uptr->cnum];
+DEVICE *dptr = rq_devmap[cp->cnum];
+uint16 pkt;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_io_complete(status=%d)\n", status);
 
-uptr->io_status = status;
-uptr->io_complete = 1;
-/* Reschedule for the appropriate delay */
-sim_activate_notbefore (uptr, uptr->iostarttime+rq_xtime);
+for (pkt = uptr->cpkt; pkt != 0; pkt = cp->pak[pkt].link) {
+    if (cp->xfer[pkt].state == XF_IO) {                 /* waiting xfer? */
+        if (cp->xfer[pkt].abo) {                        /* aborted? */
+            uint16 cmd = GETP (pkt, CMD_OPC, OPC);      /* get opcode */
+
+            rq_unlink (cp, &uptr->cpkt, pkt);           /* gonzo */
+            cp->xfer[pkt].state = XF_TOP;
+            cp->xfer[pkt].abo = 0;
+            rq_putr (cp, pkt, cmd | OP_END, 0, ST_ABO, RSP_LNT, UQ_TYP_SEQ);
+            rq_putpkt (cp, pkt, TRUE);
+            sim_activate (dptr->units + RQ_QUEUE, rq_qtime);
+            }
+        else {
+            cp->xfer[pkt].sts = status;
+            cp->xfer[pkt].state = XF_BOT;               /* ready to post */
+            }
+        break;
+        }
+    }
+rq_xfer_sched (cp, uptr);                               /* reschedule */
 }
 
 /* Map buffer address */
@@ -2122,126 +2188,204 @@ if (ba & RQ_MAPXFER) {                                  /* mapped xfer? */
 return Map_WriteW (ba, bc, buf);                        /* unmapped xfer */
 }
 
-/* Unit service for data transfer commands */
+/* Unit service for data transfer commands
+
+   The transfer in progress on the unit works through its byte count in
+   chunks of at most RQ_MAXFR.  For each chunk the top half issues host
+   I/O to the transfer's own buffer and the bottom half, once the transfer
+   time has passed, moves the data to or from memory. */
 
 t_stat rq_svc (UNIT *uptr)
 {
 MSC *cp = rq_ctxmap[uptr->cnum];
-uint32 i, t, tbc, abc, wwc;
-uint32 err = 0;
-int32 pkt = uptr->cpkt;                                 /* get packet */
-uint32 cmd, ba, bc, bl, ma;
+uint16 pkt, nxt;
+t_stat r, sts = SCPE_OK;
 
-if ((cp == NULL) || (pkt == 0))                         /* what??? */
+if ((cp == NULL) || (uptr->cpkt == 0))                  /* what??? */
     return STOP_RQ;
-cmd = GETP (pkt, CMD_OPC, OPC);                         /* get cmd */
-ba = GETP32 (pkt, RW_WBAL);                             /* buf addr */
-bc = GETP32 (pkt, RW_WBCL);                             /* byte count */
-bl = GETP32 (pkt, RW_WBLL);                             /* block addr */
-ma = GETP32 (pkt, RW_WMPL);                             /* block addr */
+for (pkt = uptr->cpkt; pkt != 0; pkt = nxt) {           /* post due chunks */
+    nxt = cp->pak[pkt].link;
+    if ((cp->xfer[pkt].state == XF_BOT) &&
+        (rq_xfer_due (cp, pkt) == 0)) {
+        if ((r = rq_xfer_bot (cp, uptr, pkt)) != SCPE_OK)
+            sts = r;
+        if (uptr->cpkt == 0)                            /* all done/reset? */
+            break;
+        }
+    }
+for (pkt = uptr->cpkt; pkt != 0; pkt = cp->pak[pkt].link) {
+    if (cp->xfer[pkt].state == XF_IO)                   /* host I/O busy? */
+        break;
+    }
+if (pkt == 0) {                                         /* no, start next */
+    for (pkt = uptr->cpkt; pkt != 0; pkt = nxt) {
+        nxt = cp->pak[pkt].link;
+        if (cp->xfer[pkt].state == XF_TOP) {
+            rq_xfer_top (cp, uptr, pkt);
+            if ((uptr->cpkt == 0) ||                    /* all done/reset or */
+                (cp->xfer[pkt].state == XF_IO))         /* now busy? */
+                break;
+            }
+        }
+    }
+rq_xfer_sched (cp, uptr);                               /* next event */
+return sts;
+}
 
-sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_svc(unit=%d, pkt=%d, cmd=%s, lbn=%0X, bc=%0x, phase=%s)\n",
-           (int)(uptr-rq_devmap[cp->cnum]->units), pkt, rq_cmdname[cp->pak[pkt].d[CMD_OPC]&0x3f], bl, bc,
-           uptr->io_complete ? "bottom" : "top");
+/* Common transfer checks - end the command early if the unit went away
+   or became write protected, or there is nothing (more) to move */
 
-tbc = (bc > RQ_MAXFR)? RQ_MAXFR: bc;                    /* trim cnt to max */
+t_bool rq_xfer_chk (MSC *cp, UNIT *uptr, uint16 pkt)
+{
+uint32 cmd = GETP (pkt, CMD_OPC, OPC);                  /* get cmd */
 
 if ((uptr->flags & UNIT_ATT) == 0) {                    /* not attached? */
-    rq_rw_end (cp, uptr, 0, ST_OFL | SB_OFL_NV);        /* offl no vol */
-    return SCPE_OK;
+    rq_rw_end (cp, uptr, pkt, 0, ST_OFL | SB_OFL_NV);   /* offl no vol */
+    return TRUE;
     }
-if (bc == 0) {                                          /* no xfer? */
-    rq_rw_end (cp, uptr, 0, ST_SUC);                    /* ok by me... */
-    return SCPE_OK;
+if (GETP32 (pkt, RW_WBCL) == 0) {                       /* no xfer? */
+    rq_rw_end (cp, uptr, pkt, 0, ST_SUC);               /* ok by me... */
+    return TRUE;
     }
-
 if ((cmd == OP_ERS) || (cmd == OP_WR)) {                /* write op? */
     if (RQ_WPH (uptr)) {
-        rq_rw_end (cp, uptr, 0, ST_WPR | SB_WPR_HW);
-        return SCPE_OK;
+        rq_rw_end (cp, uptr, pkt, 0, ST_WPR | SB_WPR_HW);
+        return TRUE;
         }
     if (uptr->uf & UF_WPS) {
-        rq_rw_end (cp, uptr, 0, ST_WPR | SB_WPR_SW);
-        return SCPE_OK;
+        rq_rw_end (cp, uptr, pkt, 0, ST_WPR | SB_WPR_SW);
+        return TRUE;
         }
     }
+return FALSE;
+}
+
+/* Top half - I/O initiation for the next chunk of a transfer */
 
-if (!uptr->io_complete) { /* Top End (I/O Initiation) Processing */
-    if (cmd == OP_ERS) {                                /* erase? */
-        wwc = ((tbc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
-        memset (uptr->rqxb, 0, wwc * sizeof(uint16));   /* clr buf */
-        sim_disk_data_trace(uptr, (uint8 *)uptr->rqxb, bl, wwc << 1, "sim_disk_wrsect-ERS", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
-        err = sim_disk_wrsect_a (uptr, bl, (uint8 *)uptr->rqxb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
+void rq_xfer_top (MSC *cp, UNIT *uptr, uint16 pkt)
+{
+RQ_XFER *xf = &cp->xfer[pkt];
+uint32 i, t, tbc, abc, wwc;
+uint32 cmd, ba, bc, bl, ma;
+
+cmd = GETP (pkt, CMD_OPC, OPC);                         /* get cmd */
+ba = GETP32 (pkt, RW_WBAL);                             /* buf addr */
+bc = GETP32 (pkt, RW_WBCL);                             /* byte count */
+bl = GETP32 (pkt, RW_WBLL);                             /* block addr */
+ma = GETP32 (pkt, RW_WMPL);                             /* block addr */
+
+sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_svc(unit=%d, pkt=%d, cmd=%s, lbn=%0X, bc=%0x, phase=top)\n",
+           (int)(uptr-rq_devmap[cp->cnum]->units), pkt, rq_cmdname[cp->pak[pkt].d[CMD_OPC]&0x3f], bl, bc);
+
+if (rq_xfer_chk (cp, uptr, pkt))                        /* ended early? */
+    return;
+if (xf->xb == NULL) {                                   /* first use? */
+    xf->xb = (uint16 *) malloc ((RQ_MAXFR >> 1) * sizeof (uint16));
+    if (xf->xb == NULL) {
+        rq_rw_end (cp, uptr, pkt, 0, ST_CNT);           /* ctrl err */
+        return;
         }
+    }
+tbc = (bc > RQ_MAXFR)? RQ_MAXFR: bc;                    /* trim cnt to max */
+xf->state = XF_IO;                                      /* callback may be */
+xf->sts = SCPE_OK;                                      /* immediate */
+
+if (cmd == OP_ERS) {                                    /* erase? */
+    wwc = ((tbc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
+    memset (xf->xb, 0, wwc * sizeof(uint16));           /* clr buf */
+    sim_disk_data_trace(uptr, (uint8 *)xf->xb, bl, wwc << 1, "sim_disk_wrsect-ERS", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
+    sim_disk_wrsect_a (uptr, bl, (uint8 *)xf->xb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
+    }
 
-    else if (cmd == OP_WR) {                            /* write? */
-        t = rq_readw (ba, tbc, ma, (uint16 *)uptr->rqxb);/* fetch buffer */
-        if ((abc = tbc - t)) {                          /* any xfer? */
-            wwc = ((abc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
-            for (i = (abc >> 1); i < wwc; i++)
-                ((uint16 *)(uptr->rqxb))[i] = 0;
-            sim_disk_data_trace(uptr, (uint8 *)uptr->rqxb, bl, wwc << 1, "sim_disk_wrsect-WR", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
-            err = sim_disk_wrsect_a (uptr, bl, (uint8 *)uptr->rqxb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
-            }
+else if (cmd == OP_WR) {                                /* write? */
+    t = rq_readw (ba, tbc, ma, xf->xb);                 /* fetch buffer */
+    if ((abc = tbc - t)) {                              /* any xfer? */
+        wwc = ((abc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
+        for (i = (abc >> 1); i < wwc; i++)
+            xf->xb[i] = 0;
+        sim_disk_data_trace(uptr, (uint8 *)xf->xb, bl, wwc << 1, "sim_disk_wrsect-WR", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
+        sim_disk_wrsect_a (uptr, bl, (uint8 *)xf->xb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
         }
+    else xf->state = XF_BOT;                            /* nxm, post it */
+    }
+
+else {  /* OP_RD & OP_CMP */
+    sim_disk_rdsect_a (uptr, bl, (uint8 *)xf->xb, NULL, (tbc + RQ_NUMBY - 1) / RQ_NUMBY, rq_io_complete);
+    }                                                   /* end else read */
+}
+
+/* Bottom half - post a completed chunk, then end the command or go
+   around again for the next chunk */
+
+t_stat rq_xfer_bot (MSC *cp, UNIT *uptr, uint16 pkt)
+{
+RQ_XFER *xf = &cp->xfer[pkt];
+uint32 i, t, tbc, abc;
+uint32 err = 0;
+uint32 cmd, ba, bc, bl, ma;
+
+cmd = GETP (pkt, CMD_OPC, OPC);                         /* get cmd */
+ba = GETP32 (pkt, RW_WBAL);                             /* buf addr */
+bc = GETP32 (pkt, RW_WBCL);                             /* byte count */
+bl = GETP32 (pkt, RW_WBLL);                             /* block addr */
+ma = GETP32 (pkt, RW_WMPL);                             /* block addr */
 
-    else {  /* OP_RD & OP_CMP */
-        err = sim_disk_rdsect_a (uptr, bl, (uint8 *)uptr->rqxb, NULL, (tbc + RQ_NUMBY - 1) / RQ_NUMBY, rq_io_complete);
-        }                                               /* end else read */
-    return SCPE_OK;                                     /* done for now until callback */    
+sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_svc(unit=%d, pkt=%d, cmd=%s, lbn=%0X, bc=%0x, phase=bottom)\n",
+           (int)(uptr-rq_devmap[cp->cnum]->units), pkt, rq_cmdname[cp->pak[pkt].d[CMD_OPC]&0x3f], bl, bc);
+
+xf->state = XF_TOP;                                     /* next chunk */
+if (rq_xfer_chk (cp, uptr, pkt))                        /* ended early? */
+    return SCPE_OK;
+tbc = (bc > RQ_MAXFR)? RQ_MAXFR: bc;                    /* trim cnt to max */
+err = xf->sts;
+if (cmd == OP_ERS) {                                    /* erase? */
     }
-else { /* Bottom End (After I/O processing) */
-    uptr->io_complete = 0;
-    err = uptr->io_status;
-    if (cmd == OP_ERS) {                                /* erase? */
+
+else if (cmd == OP_WR) {                                /* write? */
+    t = rq_readw (ba, tbc, ma, xf->xb);                 /* fetch buffer */
+    abc = tbc - t;                                      /* any xfer? */
+    if (t) {                                            /* nxm? */
+        PUTP32 (pkt, RW_WBCL, bc - abc);                /* adj bc */
+        PUTP32 (pkt, RW_WBAL, ba + abc);                /* adj ba */
+        if (rq_hbe (cp, uptr, pkt))                     /* post err log */
+            rq_rw_end (cp, uptr, pkt, EF_LOG, ST_HST | SB_HST_NXM);
+        return SCPE_OK;                                 /* end else wr */
         }
+    }
 
-    else if (cmd == OP_WR) {                            /* write? */
-        t = rq_readw (ba, tbc, ma, (uint16 *)uptr->rqxb);/* fetch buffer */
-        abc = tbc - t;                                  /* any xfer? */
-        if (t) {                                        /* nxm? */
-            PUTP32 (pkt, RW_WBCL, bc - abc);            /* adj bc */
-            PUTP32 (pkt, RW_WBAL, ba + abc);            /* adj ba */
-            if (rq_hbe (cp, uptr))                      /* post err log */
-                rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);  
-            return SCPE_OK;                             /* end else wr */
+else {
+    sim_disk_data_trace(uptr, (uint8 *)xf->xb, bl, tbc, "sim_disk_rdsect", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
+    if ((cmd == OP_RD) && !err) {                       /* read? */
+        if ((t = rq_writew (ba, tbc, ma, xf->xb))) {    /* store, nxm? */
+            PUTP32 (pkt, RW_WBCL, bc - (tbc - t));      /* adj bc */
+            PUTP32 (pkt, RW_WBAL, ba + (tbc - t));      /* adj ba */
+            if (rq_hbe (cp, uptr, pkt))                 /* post err log */
+                rq_rw_end (cp, uptr, pkt, EF_LOG, ST_HST | SB_HST_NXM);
+            return SCPE_OK;
             }
         }
-
-    else {
-        sim_disk_data_trace(uptr, (uint8 *)uptr->rqxb, bl, tbc, "sim_disk_rdsect", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
-        if ((cmd == OP_RD) && !err) {                   /* read? */
-            if ((t = rq_writew (ba, tbc, ma, (uint16 *)uptr->rqxb))) {/* store, nxm? */
-                PUTP32 (pkt, RW_WBCL, bc - (tbc - t));  /* adj bc */
-                PUTP32 (pkt, RW_WBAL, ba + (tbc - t));  /* adj ba */
-                if (rq_hbe (cp, uptr))                  /* post err log */
-                    rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);      
+    else if ((cmd == OP_CMP) && !err) {                 /* compare? */
+        uint8 dby, mby;
+        for (i = 0; i < tbc; i++) {                     /* loop */
+            if (rq_readb (ba + i, 1, ma, &mby)) {       /* fetch, nxm? */
+                PUTP32 (pkt, RW_WBCL, bc - i);          /* adj bc */
+                PUTP32 (pkt, RW_WBAL, bc - i);          /* adj ba */
+                if (rq_hbe (cp, uptr, pkt))             /* post err log */
+                    rq_rw_end (cp, uptr, pkt, EF_LOG, ST_HST | SB_HST_NXM);
                 return SCPE_OK;
                 }
-            }
-        else if ((cmd == OP_CMP) && !err) {             /* compare? */
-            uint8 dby, mby;
-            for (i = 0; i < tbc; i++) {                 /* loop */
-                if (rq_readb (ba + i, 1, ma, &mby)) {   /* fetch, nxm? */
-                    PUTP32 (pkt, RW_WBCL, bc - i);      /* adj bc */
-                    PUTP32 (pkt, RW_WBAL, bc - i);      /* adj ba */
-                    if (rq_hbe (cp, uptr))              /* post err log */
-                        rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);
-                    return SCPE_OK;
-                    }
-                dby = (((uint16 *)(uptr->rqxb))[i >> 1] >> ((i & 1)? 8: 0)) & 0xFF;
-                if (mby != dby) {                       /* cmp err? */
-                    PUTP32 (pkt, RW_WBCL, bc - i);      /* adj bc */
-                    rq_rw_end (cp, uptr, 0, ST_CMP);    /* done */
-                    return SCPE_OK;                     /* exit */
-                    }                                   /* end if */
-                }                                       /* end for */
-            }                                           /* end else if */
-        }                                               /* end else read */
-    }                                                   /* end else bottom end */
+            dby = (xf->xb[i >> 1] >> ((i & 1)? 8: 0)) & 0xFF;
+            if (mby != dby) {                           /* cmp err? */
+                PUTP32 (pkt, RW_WBCL, bc - i);          /* adj bc */
+                rq_rw_end (cp, uptr, pkt, 0, ST_CMP);   /* done */
+                return SCPE_OK;                         /* exit */
+                }                                       /* end if */
+            }                                           /* end for */
+        }                                               /* end else if */
+    }                                                   /* end else read */
 if (err != 0) {                                         /* error? */
-    if (rq_dte (cp, uptr, ST_DRV))                      /* post err log */
-        rq_rw_end (cp, uptr, EF_LOG, ST_DRV);           /* if ok, report err */
+    if (rq_dte (cp, uptr, pkt, ST_DRV))                 /* post err log */
+        rq_rw_end (cp, uptr, pkt, EF_LOG, ST_DRV);      /* if ok, report err */
     sim_disk_perror (uptr, "RQ I/O error");
     sim_disk_clearerr (uptr);
     return SCPE_IOERR;
@@ -2252,17 +2396,64 @@ bl = bl + ((tbc + (RQ_NUMBY - 1)) / RQ_NUMBY);          /* incr blk # */
 PUTP32 (pkt, RW_WBAL, ba);                              /* update pkt */
 PUTP32 (pkt, RW_WBCL, bc);
 PUTP32 (pkt, RW_WBLL, bl);
-if (bc)                                                 /* more? resched */
-    sim_activate (uptr, 0);
-else rq_rw_end (cp, uptr, 0, ST_SUC);                   /* done! */
+if (bc == 0)                                            /* more? stay top */
+    rq_rw_end (cp, uptr, pkt, 0, ST_SUC);               /* done! */
 return SCPE_OK;
 }
 
+/* Time remaining before a transfer's chunk may be posted */
+
+int32 rq_xfer_due (MSC *cp, uint16 pkt)
+{
+uint32 dly = (cp->xfer[pkt].iostarttime + rq_xtime) - sim_grtime ();
+
+if (0x80000000 <= dly)                                  /* already past? */
+    return 0;
+return (int32) dly;
+}
+
+/* Schedule the unit for whatever its transfers need next: at once if a
+   chunk is ready to start, else when the earliest finished chunk is due.
+   While host I/O is outstanding the completion callback does this. */
+
+void rq_xfer_sched (MSC *cp, UNIT *uptr)
+{
+uint16 pkt;
+int32 t, dly = -1;
+
+for (pkt = uptr->cpkt; pkt != 0; pkt = cp->pak[pkt].link) {
+    if (cp->xfer[pkt].state == XF_IO)                   /* host I/O busy? */
+        return;
+    if (cp->xfer[pkt].state == XF_TOP)                  /* ready to start? */
+        t = 0;
+    else t = rq_xfer_due (cp, pkt);                     /* ready to post */
+    if ((dly < 0) || (t < dly))
+        dly = t;
+    }
+if (dly >= 0)
+    sim_activate_abs (uptr, dly);
+}
+
+/* Restart the unit's transfer after its host I/O went away under it, on
+   detach or on the reattach that ends a RESTORE.  Nothing has been posted
+   for the chunk in hand, so it is issued again from the top (or ended by
+   rq_xfer_chk if the unit is now offline). */
+
+void rq_xfer_restart (MSC *cp, UNIT *uptr)
+{
+uint16 pkt;
+
+for (pkt = uptr->cpkt; pkt != 0; pkt = cp->pak[pkt].link) {
+    cp->xfer[pkt].state = XF_TOP;
+    cp->xfer[pkt].abo = 0;
+    }
+rq_xfer_sched (cp, uptr);
+}
+
 /* Transfer command complete */
 
-t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint16 flg, uint16 sts)
+t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint16 pkt, uint16 flg, uint16 sts)
 {
-uint16 pkt = uptr->cpkt;                                /* packet */
 uint16 cmd = GETP (pkt, CMD_OPC, OPC);                  /* get cmd */
 uint32 bc = GETP32 (pkt, RW_BCL);                       /* init bc */
 uint32 wbc = GETP32 (pkt, RW_WBCL);                     /* work bc */
@@ -2270,7 +2461,8 @@ DEVICE *dptr = rq_devmap[uptr->cnum];
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_rw_end\n");
 
-uptr->cpkt = 0;                                         /* done */
+rq_unlink (cp, &uptr->cpkt, pkt);                       /* done */
+cp->xfer[pkt].state = XF_TOP;
 PUTP32 (pkt, RW_BCL, bc - wbc);                         /* bytes processed */
 cp->pak[pkt].d[RW_WBAL] = 0;                            /* clear temps */
 cp->pak[pkt].d[RW_WBAH] = 0;
@@ -2290,9 +2482,9 @@ return OK;
 
 /* Data transfer error log packet */
 
-t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 err)
+t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 tpkt, uint16 err)
 {
-uint16 pkt, tpkt;
+uint16 pkt;
 uint16 lu, ccyl, csurf, csect;
 uint32 dtyp, lbn, t;
 
@@ -2302,7 +2494,6 @@ if ((cp->cflgs & CF_THS) == 0)                          /* logging? */
     return OK;
 if (!rq_deqf (cp, &pkt))                                /* get log pkt */
     return ERR;
-tpkt = uptr->cpkt;                                      /* rw pkt */
 lu = cp->pak[tpkt].d[CMD_UN];                           /* unit # */
 lbn = GETP32 (tpkt, RW_WBLL);                           /* recent LBN */
 dtyp = GET_DTYPE (uptr->flags);                         /* drv type */
@@ -2346,9 +2537,9 @@ return rq_putpkt (cp, pkt, TRUE);
 
 /* Host bus error log packet */
 
-t_bool rq_hbe (MSC *cp, UNIT *uptr)
+t_bool rq_hbe (MSC *cp, UNIT *uptr, uint16 tpkt)
 {
-uint16 pkt, tpkt;
+uint16 pkt;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_hbe\n");
 
@@ -2356,7 +2547,6 @@ if ((cp->cflgs & CF_THS) == 0)                          /* logging? */
     return OK;
 if (!rq_deqf (cp, &pkt))                                /* get log pkt */
     return ERR;
-tpkt = uptr->cpkt;                                      /* rw pkt */
 cp->pak[pkt].d[ELP_REFL] = cp->pak[tpkt].d[CMD_REFL];   /* copy cmd ref */
 cp->pak[pkt].d[ELP_REFH] = cp->pak[tpkt].d[CMD_REFH];
 cp->pak[pkt].d[ELP_UN] = cp->pak[tpkt].d[CMD_UN];       /* copy unit */
@@ -2477,6 +2667,23 @@ else {
 return;
 }
 
+void rq_unlink (MSC *cp, uint16 *lh, uint16 pkt)
+{
+uint16 ptr;
+
+if (*lh == pkt) {                                       /* head? */
+    *lh = cp->pak[pkt].link;
+    return;
+    }
+for (ptr = *lh; ptr != 0; ptr = cp->pak[ptr].link) {    /* find prev */
+    if (cp->pak[ptr].link == pkt) {
+        cp->pak[ptr].link = cp->pak[pkt].link;          /* unlink */
+        return;
+        }
+    }
+return;
+}
+
 /* Packet and descriptor handling */
 
 /* Get packet from command ring */
@@ -2839,6 +3046,7 @@ if (r != SCPE_OK)
 
 if ((cp->csta == CST_UP) && sim_disk_isavailable (uptr))
     uptr->flags = uptr->flags | UNIT_ATP;
+rq_xfer_restart (cp, uptr);                             /* restored xfer? */
 return SCPE_OK;
 }
 
@@ -2846,13 +3054,20 @@ return SCPE_OK;
 
 t_stat rq_detach (UNIT *uptr)
 {
+MSC *cp = rq_ctxmap[uptr->cnum];
+uint16 pkt;
 t_stat r;
 
 r = sim_disk_detach (uptr);                             /* detach unit */
 if (r != SCPE_OK)
     return r;
+for (pkt = uptr->cpkt; pkt != 0; pkt = cp->pak[pkt].link) {
+    free (cp->xfer[pkt].xb);                            /* host I/O is done, */
+    cp->xfer[pkt].xb = NULL;                            /* free xfer buffers */
+    }
 uptr->flags = uptr->flags & ~(UNIT_ONL | UNIT_ATP);     /* clr onl, atn pend */
 uptr->uf = 0;                                           /* clr unit flgs */
+rq_xfer_restart (cp, uptr);                             /* end xfer offline */
 return SCPE_OK;
 } 
 
@@ -2904,6 +3119,8 @@ for (i = 0; i < RQ_NPKTS; i++) {                        /* all pkts free */
     else cp->pak[i].link = 0;
     for (j = 0; j < RQ_PKT_SIZE_W; j++)
         cp->pak[i].d[j] = 0;
+    cp->xfer[i].state = XF_TOP;                         /* no xfer */
+    cp->xfer[i].abo = 0;
     }
 cp->rspq = 0;                                           /* no q'd rsp pkts */
 cp->pbsy = 0;                                           /* all pkts free */
@@ -2917,9 +3134,10 @@ for (i = 0; i < (RQ_NUMDR + 2); i++) {                  /* init units */
     uptr->flags = uptr->flags & ~(UNIT_ONL | UNIT_ATP);
     uptr->uf = 0;                                       /* clr unit flags */
     uptr->cpkt = uptr->pktq = 0;                        /* clr pkt q's */
-    uptr->rqxb = (uint16 *) realloc (uptr->rqxb, (RQ_MAXFR >> 1) * sizeof (uint16));
-    if (uptr->rqxb == NULL)
-        return SCPE_MEM;
+    }
+for (i = 0; i < RQ_NPKTS; i++) {                        /* host I/O is quiet, */
+    free (cp->xfer[i].xb);                              /* free xfer buffers */
+    cp->xfer[i].xb = NULL;
     }
 return auto_config (0, 0);                              /* run autoconfig */
 }
@@ -3089,9 +3307,11 @@ if ((uptr->flags & UNIT_ONL) == 0) {
     else fprintf (st, "Unit %d is offline\n", u);
     return SCPE_OK;
     }
-if (uptr->cpkt) {
-    fprintf (st, "Unit %d current ", u);
-    rq_show_pkt (st, cp, uptr->cpkt);
+if ((pkt = uptr->cpkt)) {
+    do {
+        fprintf (st, "Unit %d current ", u);
+        rq_show_pkt (st, cp, pkt);
+        } while ((pkt = cp->pak[pkt].link));
     if ((pkt = uptr->pktq)) {
         do {
             fprintf (st, "Unit %d queued ", u);
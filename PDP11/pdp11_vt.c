@@ -130,6 +130,8 @@ MTAB vt_mod[] = {
                 &vt_set_hspace, &vt_show_hspace, NULL, "Horizontal Spacing" },
     { MTAB_XTD|MTAB_VDV|MTAB_VALR,   0, "VSPACE",  "VSPACE={TALL|NORMAL}",
                 &vt_set_vspace, &vt_show_vspace, NULL, "Vertical Spacing" },
+    { MTAB_XTD|MTAB_VDV|MTAB_VALR,   0, "DECAY",   "DECAY={QUEUE|DENSE}",
+                &sim_display_set_decay, &sim_display_show_decay, NULL, "Phosphor decay model" },
     { MTAB_XTD|MTAB_VDV|MTAB_VALR, 020, "ADDRESS", "ADDRESS",
                 &set_addr,      &show_addr,      NULL, "Bus address" },
     { MTAB_XTD|MTAB_VDV|MTAB_VALR,   0, "VECTOR",  "VECTOR",
@@ -325,6 +327,8 @@ vt_reset(DEVICE *dptr)
 {
     if (!(dptr->flags & DEV_DIS))
         vt11_reset(dptr, DEB_VT11);
+    else
+        vt11_close();                   /* release display, if any */
     vid_register_quit_callback (&vt_quit_callback);
     sim_debug (DEB_INT, &vt_dev, "CLR_INT(all)\n");
     CLR_INT (VTST);
@@ -275,6 +275,16 @@ int32 hst_lnt = 0;                                      /* history length */
 int32 hst_switches;                                     /* history option switches */
 FILE *hst_log;                                          /* history log file */
 int32 hst_log_p;                                        /* history last log written pointer */
+t_bool hst_log_bin = FALSE;                             /* history log is binary */
+InstHistory *hst_spill = NULL;                          /* binary log spill buffer */
+int32 hst_spill_cnt = 0;                                /* spill records pending */
+#if defined (SIM_ASYNCH_IO)
+pthread_t hst_spill_thread;                             /* spill writer thread */
+pthread_mutex_t hst_spill_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t hst_spill_cond = PTHREAD_COND_INITIALIZER;
+t_bool hst_spill_run = FALSE;                           /* writer running */
+t_bool hst_spill_exit = FALSE;                          /* writer exit request */
+#endif
 int32 step_out_nest_level = 0;                          /* step to call return - nest level */
 
 const uint32 byte_mask[33] = { 0x00000000,
@@ -310,6 +320,8 @@ t_stat cpu_reset (DEVICE *dptr);
 t_bool cpu_is_pc_a_subroutine_call (t_addr **ret_addrs);
 t_stat cpu_ex (t_value *vptr, t_addr exta, UNIT *uptr, int32 sw);
 t_stat cpu_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw);
+t_stat cpu_ex_range (t_value *vptr, t_addr exta, uint32 *count, UNIT *uptr, int32 sw);
+t_stat cpu_dep_range (const t_value *vptr, t_addr exta, uint32 *count, UNIT *uptr, int32 sw);
 t_stat cpu_set_size (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat cpu_set_hist (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
@@ -322,6 +334,15 @@ static SIM_INLINE int32 get_istr (int32 lnt, int32 acc);
 int32 ReadOcta (int32 va, int32 *opnd, int32 j, int32 acc);
 t_bool cpu_show_opnd (FILE *st, InstHistory *h, int32 line);
 t_stat cpu_show_hist_records (FILE *st, t_bool do_header, int32 start, int32 count);
+void cpu_show_hist_header (FILE *st);
+void cpu_show_hist_rec (FILE *st, InstHistory *h);
+t_stat cpu_set_hist_decode (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
+void cpu_hist_log (int32 start, int32 count);
+void cpu_hist_flush (void);
+void cpu_hist_close (void);
+#if defined (SIM_ASYNCH_IO)
+static void *_cpu_hist_spill (void *arg);
+#endif
 void cpu_idle (void);
 
 /* CPU data structures
@@ -423,6 +444,8 @@ MTAB cpu_mod[] = {
     MEM_MODIFIERS,   /* Model specific memory modifiers from vaxXXX_defs.h */
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP|MTAB_NC, 0, "HISTORY", "HISTORY",
       &cpu_set_hist, &cpu_show_hist, NULL, "Displays instruction history" },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_NC, 0, NULL, "HISTDECODE",
+      &cpu_set_hist_decode, NULL, NULL, "Decode binary instruction history log file" },
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "VIRTUAL", NULL,
       NULL, &cpu_show_virt, NULL, "show translation for address arg in KESU mode" },
     CPU_MODEL_MODIFIERS, /* Model specific cpu modifiers from vaxXXX_defs.h */
@@ -446,7 +469,7 @@ DEVICE cpu_dev = {
     &cpu_boot, NULL, NULL,
     NULL, DEV_DYNM | DEV_DEBUG, 0,
     cpu_deb, &cpu_set_size, NULL, &cpu_help, NULL, NULL,
-    &cpu_description
+    &cpu_description, NULL, &cpu_ex_range, &cpu_dep_range
     };
 
 t_stat cpu_show_model (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
@@ -506,8 +529,9 @@ if (abortval > 0) {                                     /* sim stop? */
     PSL = PSL | cc;                                     /* put PSL together */
     pcq_r->qptr = pcq_p;                                /* update pc q ptr */
     if (hst_log) {                                      /* auto logging history? */
-        cpu_show_hist_records (hst_log, FALSE, hst_log_p, (hst_p < hst_log_p) ? hst_lnt - (hst_log_p - hst_p) : hst_p - hst_log_p);
+        cpu_hist_log (hst_log_p, (hst_p < hst_log_p) ? hst_lnt - (hst_log_p - hst_p) : hst_p - hst_log_p);
         hst_log_p = hst_p;                              /* record everything logged */
+        cpu_hist_flush ();
         }
     return abortval;                                    /* return to SCP */
     }
@@ -1526,7 +1550,7 @@ for ( ;; ) {
 /* Optionally record instruction history */
 
     if (hst_lnt) {
-        int32 lim;
+        int32 lim, pa, st;
         t_value wd;
         InstHistory *h = &hst[hst_p];
 
@@ -1538,7 +1562,14 @@ for ( ;; ) {
         lim = PC - fault_PC;
         if ((uint32) lim > INST_SIZE)
             lim = INST_SIZE;
-        for (i = 0; i < lim; i++) {
+        pa = Test (fault_PC, acc, &st);                  /* instr phys addr */
+        if ((pa >= 0) &&                                /* mapped, in mem, */
+            (((fault_PC & VA_M_OFF) + lim) <= VA_PAGSIZE) && /* one page? */
+            ADDR_IS_MEM (pa) && ADDR_IS_MEM (pa + lim - 1)) {
+            for (i = 0; i < lim; i++, pa++)             /* copy directly */
+                h->inst[i] = (uint8) (M[pa >> 2] >> ((pa & 3) << 3));
+            }
+        else for (i = 0; i < lim; i++) {
             if ((cpu_ex (&wd, fault_PC + i, &cpu_unit, SWMASK ('V'))) == SCPE_OK)
                 h->inst[i] = (uint8) wd;
             else {
@@ -1552,7 +1583,7 @@ for ( ;; ) {
         if (hst_p >= hst_lnt)
             hst_p = 0;
         if (hst_log && (hst_p == hst_log_p))
-            cpu_show_hist_records (hst_log, FALSE, hst_log_p, hst_lnt);
+            cpu_hist_log (hst_log_p, hst_lnt);
         }
 
 /* Dispatch to instructions */
@@ -3307,6 +3338,77 @@ if (ADDR_IS_ROM (addr)) {
 return SCPE_NXM;
 }
 
+/* Memory examine/deposit of a range
+
+   Physical main memory is accessed directly a longword at a time, with
+   only a partial longword at either end of the range done a byte at a
+   time; anything else (virtual addresses, ROM, NVR, etc.) goes through
+   cpu_ex/cpu_dep one byte at a time.
+*/
+
+t_stat cpu_ex_range (t_value *vptr, t_addr exta, uint32 *count, UNIT *uptr, int32 sw)
+{
+uint32 i = 0, n = *count, addr = (uint32) exta, pa, lw;
+t_stat r = SCPE_OK;
+
+while (i < n) {
+    pa = addr & PAMASK;
+    if (!(sw & SWMASK ('V')) && ADDR_IS_MEM (pa)) {
+        if (((pa & 3) == 0) && ((n - i) >= 4)) {        /* whole longword? */
+            lw = M[pa >> 2];
+            vptr[i] = lw & BMASK;
+            vptr[i + 1] = (lw >> 8) & BMASK;
+            vptr[i + 2] = (lw >> 16) & BMASK;
+            vptr[i + 3] = (lw >> 24) & BMASK;
+            i = i + 4;
+            addr = addr + 4;
+            continue;
+            }
+        vptr[i] = (uint32) ReadB (pa);
+        }
+    else {
+        r = cpu_ex (&vptr[i], addr, uptr, sw);
+        if (r != SCPE_OK)
+            break;
+        }
+    i = i + 1;
+    addr = addr + 1;
+    }
+*count = i;
+return r;
+}
+
+t_stat cpu_dep_range (const t_value *vptr, t_addr exta, uint32 *count, UNIT *uptr, int32 sw)
+{
+uint32 i = 0, n = *count, addr = (uint32) exta, pa;
+t_stat r = SCPE_OK;
+
+while (i < n) {
+    pa = addr & PAMASK;
+    if (!(sw & SWMASK ('V')) && ADDR_IS_MEM (pa)) {
+        if (((pa & 3) == 0) && ((n - i) >= 4)) {        /* whole longword? */
+            M[pa >> 2] = ((uint32) vptr[i] & BMASK) |
+                (((uint32) vptr[i + 1] & BMASK) << 8) |
+                (((uint32) vptr[i + 2] & BMASK) << 16) |
+                (((uint32) vptr[i + 3] & BMASK) << 24);
+            i = i + 4;
+            addr = addr + 4;
+            continue;
+            }
+        WriteB (pa, (int32) vptr[i]);
+        }
+    else {
+        r = cpu_dep (vptr[i], addr, uptr, sw);
+        if (r != SCPE_OK)
+            break;
+        }
+    i = i + 1;
+    addr = addr + 1;
+    }
+*count = i;
+return r;
+}
+
 /* Memory allocation */
 
 t_stat cpu_set_size (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
@@ -3399,9 +3501,10 @@ if (cptr == NULL) {
         hst[i].iPC = 0;
     hst_p = 0;
     if (hst_log) {
+        cpu_hist_flush ();
         sim_set_fsize (hst_log, (t_addr)0);
         hst_log_p = 0;
-        cpu_show_hist_records (hst_log, TRUE, 0, 0);
+        cpu_show_hist_header (hst_log);
         }
     return SCPE_OK;
     }
@@ -3416,10 +3519,8 @@ if (hst_lnt) {
     free (hst);
     hst_lnt = 0;
     hst = NULL;
-    if (hst_log) {
-        fclose (hst_log);
-        hst_log = NULL;
-        }
+    if (hst_log)
+        cpu_hist_close ();
     }
 if (lnt) {
     hst = (InstHistory *) calloc (lnt, sizeof (InstHistory));
@@ -3428,9 +3529,28 @@ if (lnt) {
     hst_lnt = lnt;
     hst_switches = sim_switches;
     if (cptr && *cptr) {
-        hst_log = sim_fopen (cptr, "w");
+        hst_log_bin = (sim_switches & SWMASK ('B')) != 0;
+        hst_log_p = 0;
+        hst_log = sim_fopen (cptr, hst_log_bin ? "wb" : "w");
+        if (hst_log && hst_log_bin) {
+            hst_spill = (InstHistory *) calloc (lnt, sizeof (InstHistory));
+#if defined (SIM_ASYNCH_IO)
+            hst_spill_exit = FALSE;
+            if (hst_spill &&
+                (pthread_create (&hst_spill_thread, NULL, &_cpu_hist_spill, NULL) == 0))
+                hst_spill_run = TRUE;
+#endif
+            if (hst_spill == NULL) {
+                fclose (hst_log);
+                hst_log = NULL;
+                free (hst);
+                hst_lnt = 0;
+                hst = NULL;
+                return SCPE_MEM;
+                }
+            }
         if (hst_log)
-            cpu_show_hist_records (hst_log, TRUE, 0, 0);
+            cpu_show_hist_header (hst_log);
         else {
             free (hst);
             hst_lnt = 0;
@@ -3442,6 +3562,164 @@ if (lnt) {
 return SCPE_OK;
 }
 
+/* History log file support
+
+   A text log receives formatted records, exactly as SHOW CPU HISTORY.
+   A binary log (SET CPU -B HISTORY=n:file) receives a header followed by
+   raw InstHistory records.  Whenever the ring wraps, the ring segment is
+   copied to a spill buffer and, when asynchronous I/O is available, a
+   writer thread does the file I/O so the simulator only pays for a
+   memory copy.  SET CPU HISTDECODE=file formats a binary log offline.
+
+   The binary records are the full in-memory ring entries, not a packed
+   format; the header's record size only lets HISTDECODE reject a log
+   written by a build with a different layout.  Capture itself is as for
+   SHOW CPU HISTORY: the operands the instruction used are copied into
+   the entry, and instruction bytes which are not in one mapped page of
+   memory are still fetched with cpu_ex.
+*/
+
+#define HST_BIN_MAGIC   "VAXHIST1"
+
+typedef struct {
+    char        magic[8];                               /* HST_BIN_MAGIC */
+    uint32      rec_size;                               /* sizeof (InstHistory) */
+    uint32      switches;                               /* hst_switches */
+    } HST_BIN_HDR;
+
+#if defined (SIM_ASYNCH_IO)
+static void *_cpu_hist_spill (void *arg)
+{
+int32 cnt;
+
+pthread_mutex_lock (&hst_spill_lock);
+while (1) {
+    while ((hst_spill_cnt == 0) && !hst_spill_exit)
+        pthread_cond_wait (&hst_spill_cond, &hst_spill_lock);
+    if (hst_spill_cnt == 0)                             /* nothing pending, exit */
+        break;
+    cnt = hst_spill_cnt;
+    pthread_mutex_unlock (&hst_spill_lock);
+    fwrite (hst_spill, sizeof (InstHistory), cnt, hst_log);
+    pthread_mutex_lock (&hst_spill_lock);
+    hst_spill_cnt = 0;                                  /* buffer free */
+    pthread_cond_broadcast (&hst_spill_cond);
+    }
+pthread_mutex_unlock (&hst_spill_lock);
+return NULL;
+}
+#endif
+
+void cpu_hist_log (int32 start, int32 count)
+{
+int32 k, seg;
+
+if (count <= 0)
+    return;
+if (!hst_log_bin) {                                     /* text? */
+    cpu_show_hist_records (hst_log, FALSE, start, count);
+    return;
+    }
+#if defined (SIM_ASYNCH_IO)
+if (hst_spill_run) {
+    pthread_mutex_lock (&hst_spill_lock);
+    while (hst_spill_cnt)                               /* wait for prior spill */
+        pthread_cond_wait (&hst_spill_cond, &hst_spill_lock);
+    for (k = 0; k < count; k = k + seg, start = 0) {    /* copy ring segments */
+        seg = hst_lnt - start;
+        if (seg > (count - k))
+            seg = count - k;
+        memcpy (&hst_spill[k], &hst[start], seg * sizeof (InstHistory));
+        }
+    hst_spill_cnt = count;
+    pthread_cond_broadcast (&hst_spill_cond);           /* wake writer */
+    pthread_mutex_unlock (&hst_spill_lock);
+    return;
+    }
+#endif
+for (k = 0; k < count; k = k + seg, start = 0) {        /* write ring segments */
+    seg = hst_lnt - start;
+    if (seg > (count - k))
+        seg = count - k;
+    fwrite (&hst[start], sizeof (InstHistory), seg, hst_log);
+    }
+}
+
+/* Wait for pending spill, flush log */
+
+void cpu_hist_flush (void)
+{
+#if defined (SIM_ASYNCH_IO)
+if (hst_spill_run) {
+    pthread_mutex_lock (&hst_spill_lock);
+    while (hst_spill_cnt)
+        pthread_cond_wait (&hst_spill_cond, &hst_spill_lock);
+    pthread_mutex_unlock (&hst_spill_lock);
+    }
+#endif
+if (hst_log)
+    fflush (hst_log);
+}
+
+/* Stop writer, close log */
+
+void cpu_hist_close (void)
+{
+#if defined (SIM_ASYNCH_IO)
+if (hst_spill_run) {
+    pthread_mutex_lock (&hst_spill_lock);
+    hst_spill_exit = TRUE;
+    pthread_cond_broadcast (&hst_spill_cond);
+    pthread_mutex_unlock (&hst_spill_lock);
+    pthread_join (hst_spill_thread, NULL);
+    hst_spill_run = FALSE;
+    }
+#endif
+fclose (hst_log);
+hst_log = NULL;
+hst_log_bin = FALSE;
+free (hst_spill);
+hst_spill = NULL;
+hst_spill_cnt = 0;
+}
+
+/* Decode binary history log */
+
+t_stat cpu_set_hist_decode (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+FILE *fp;
+HST_BIN_HDR hdr;
+InstHistory h;
+int32 sv_switches = hst_switches;
+t_stat r = SCPE_OK;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_MISVAL;
+fp = sim_fopen (cptr, "rb");
+if (fp == NULL)
+    return sim_messagef (SCPE_OPENERR, "Unable to open file '%s': %s\n", cptr, strerror (errno));
+if ((fread (&hdr, sizeof (hdr), 1, fp) != 1) ||
+    (memcmp (hdr.magic, HST_BIN_MAGIC, sizeof (hdr.magic)) != 0) ||
+    (hdr.rec_size != sizeof (InstHistory)))
+    r = sim_messagef (SCPE_FMT, "'%s' is not a binary history log from this simulator\n", cptr);
+else {
+    hst_switches = hdr.switches;                        /* format as recorded */
+    cpu_show_hist_header (stdout);
+    if (sim_log)
+        cpu_show_hist_header (sim_log);
+    while (fread (&h, sizeof (h), 1, fp) == 1) {
+        if (h.iPC == 0)                                 /* filled in? */
+            continue;
+        cpu_show_hist_rec (stdout, &h);
+        if (sim_log)
+            cpu_show_hist_rec (sim_log, &h);
+        }
+    hst_switches = sv_switches;
+    }
+fclose (fp);
+return r;
+}
+
 /* Show history */
 
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
@@ -3466,49 +3744,75 @@ return cpu_show_hist_records (st, TRUE, di, lnt);
 
 t_stat cpu_show_hist_records (FILE *st, t_bool do_header, int32 start, int32 count)
 {
-int32 i, k, numspec;
+int32 k;
 InstHistory *h;
 
 if (hst_lnt == 0)                                       /* enabled? */
     return SCPE_NOFNC;
-if (do_header) {
-    if (hst_switches & SWMASK('T'))
-        fprintf (st," TIME       ");
-    fprintf (st, "PC       PSL       IR\n\n");
-    }
+if (do_header)
+    cpu_show_hist_header (st);
 for (k = 0; k < count; k++) {                           /* print specified */
     h = &hst[(start++) % hst_lnt];                      /* entry pointer */
     if (h->iPC == 0)                                    /* filled in? */
         continue;
-    if (hst_switches & SWMASK('T'))                     /* sim_time */
-        fprintf(st, "%10.0f  ", h->time);
-    fprintf(st, "%08X %08X| ", h->iPC, h->PSL);         /* PC, PSL */
-    numspec = DR_GETNSP (drom[h->opc][0]);              /* #specifiers */
-    if (opcode[h->opc] == NULL)                         /* undefined? */
-        fprintf (st, "%03X (undefined)", h->opc);
-    else if (h->PSL & PSL_FPD)                          /* FPD set? */
-        fprintf (st, "%s FPD set", opcode[h->opc]);
-    else {                                              /* normal */
-        for (i = 0; i < INST_SIZE; i++)
-            sim_eval[i] = h->inst[i];
-        if ((fprint_sym (st, h->iPC, sim_eval, &cpu_unit, SWMASK ('M'))) > 0)
-            fprintf (st, "%03X (undefined)", h->opc);
-        if ((numspec > 1) ||
-            ((numspec == 1) && (drom[h->opc][1] < BB))) {
-            if (cpu_show_opnd (st, h, 0)) {             /* operands; more? */
-                if (cpu_show_opnd (st, h, 1)) {         /* 2nd line; more? */
-                    cpu_show_opnd (st, h, 2);           /* octa, 3rd/4th */
-                    cpu_show_opnd (st, h, 3);
-                    }
-                }
-            }
-        }                                               /* end else */
-    fputc ('\n', st);                                   /* end line */
+    cpu_show_hist_rec (st, h);
     }                                                   /* end for */
 fflush (st);
 return SCPE_OK;
 }
 
+/* History header; binary logs get a file header instead */
+
+void cpu_show_hist_header (FILE *st)
+{
+HST_BIN_HDR hdr;
+
+if ((st == hst_log) && hst_log_bin) {
+    memset (&hdr, 0, sizeof (hdr));
+    memcpy (hdr.magic, HST_BIN_MAGIC, sizeof (hdr.magic));
+    hdr.rec_size = sizeof (InstHistory);
+    hdr.switches = (uint32) hst_switches;
+    fwrite (&hdr, sizeof (hdr), 1, st);
+    fflush (st);
+    return;
+    }
+if (hst_switches & SWMASK('T'))
+    fprintf (st," TIME       ");
+fprintf (st, "PC       PSL       IR\n\n");
+}
+
+/* Print one history record */
+
+void cpu_show_hist_rec (FILE *st, InstHistory *h)
+{
+int32 i, numspec;
+
+if (hst_switches & SWMASK('T'))                         /* sim_time */
+    fprintf(st, "%10.0f  ", h->time);
+fprintf(st, "%08X %08X| ", h->iPC, h->PSL);             /* PC, PSL */
+numspec = DR_GETNSP (drom[h->opc][0]);                  /* #specifiers */
+if (opcode[h->opc] == NULL)                             /* undefined? */
+    fprintf (st, "%03X (undefined)", h->opc);
+else if (h->PSL & PSL_FPD)                              /* FPD set? */
+    fprintf (st, "%s FPD set", opcode[h->opc]);
+else {                                                  /* normal */
+    for (i = 0; i < INST_SIZE; i++)
+        sim_eval[i] = h->inst[i];
+    if ((fprint_sym (st, h->iPC, sim_eval, &cpu_unit, SWMASK ('M'))) > 0)
+        fprintf (st, "%03X (undefined)", h->opc);
+    if ((numspec > 1) ||
+        ((numspec == 1) && (drom[h->opc][1] < BB))) {
+        if (cpu_show_opnd (st, h, 0)) {                 /* operands; more? */
+            if (cpu_show_opnd (st, h, 1)) {             /* 2nd line; more? */
+                cpu_show_opnd (st, h, 2);               /* octa, 3rd/4th */
+                cpu_show_opnd (st, h, 3);
+                }
+            }
+        }
+    }                                                   /* end else */
+fputc ('\n', st);                                       /* end line */
+}
+
 t_bool cpu_show_opnd (FILE *st, InstHistory *h, int32 line)
 {
 
@@ -3725,13 +4029,17 @@ fprintf (st, "The CPU can maintain a history of the most recently executed instr
 fprintf (st, "This is controlled by the SET CPU HISTORY and SHOW CPU HISTORY commands:\n\n");
 fprintf (st, "   sim> SET CPU HISTORY                 clear history buffer\n");
 fprintf (st, "   sim> SET CPU HISTORY=0               disable history\n");
-fprintf (st, "   sim> SET CPU {-T} HISTORY=n{:file}   enable history, length = n\n");
+fprintf (st, "   sim> SET CPU {-T}{-B} HISTORY=n{:file} enable history, length = n\n");
 fprintf (st, "   sim> SHOW CPU HISTORY                print CPU history\n");
-fprintf (st, "   sim> SHOW CPU HISTORY=n              print first n entries of CPU history\n\n");
+fprintf (st, "   sim> SHOW CPU HISTORY=n              print first n entries of CPU history\n");
+fprintf (st, "   sim> SET CPU HISTDECODE=file         print binary history log file\n\n");
 fprintf (st, "The -T switch causes simulator time to be recorded (and displayed)\n");
 fprintf (st, "with each history entry.\n");
 fprintf (st, "When writing history to a file (SET CPU HISTORY=n:file), 'n' specifies\n");
 fprintf (st, "the buffer flush frequency.  Warning: prodigious amounts of disk space\n");
-fprintf (st, "may be comsumed.  The maximum length for the history is %d entries.\n\n", HIST_MAX);
+fprintf (st, "may be comsumed.  The maximum length for the history is %d entries.\n", HIST_MAX);
+fprintf (st, "The -B switch writes the log file as raw binary records, which is much\n");
+fprintf (st, "faster than formatting each record as it is logged.  A binary log is\n");
+fprintf (st, "converted to text later with SET CPU HISTDECODE=file.\n\n");
 return SCPE_OK;
 }
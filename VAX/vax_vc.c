@@ -951,21 +951,17 @@ lines = 0;
 for (ln = 0; ln < VC_YSIZE; ln++) {
     if ((vc_map[ln] & VCMAP_VLD) == 0) {                /* line invalid? */
         off = vc_map[ln] * 32;                          /* get video buf offset */
-        for (col = 0; col < VC_XSIZE; col++)  
-            vc_lines[ln*VC_XSIZE + col] = vid_mono_palette[(vc_buf[off + (col >> 5)] >> (col & 0x1F)) & 1];
+        vid_expand_1bpp (&vc_buf[off], &vc_lines[ln*VC_XSIZE], VC_XSIZE, vid_mono_palette);
                                                         /* 1bpp to 32bpp */
         if (CUR_V &&                                    /* cursor visible && need to draw cursor? */
             (vc_input_captured || (vc_dev.dctrl & DBG_CURSOR))) {
-            if ((ln >= CUR_Y) && (ln < (CUR_Y + 16))) { /* cursor on this line? */
+            if ((ln >= CUR_Y) && (ln < (CUR_Y + 16)) && /* cursor on this line? */
+                (CUR_X < VC_XSIZE)) {
                 cur = &vc_cur[((ln - CUR_Y) << 4)];     /* get image base */
-                for (col = 0; col < 16; col++) {
-                    if ((CUR_X + col) >= VC_XSIZE)      /* Part of cursor off screen? */
-                        continue;                       /* Skip */
-                    if (CUR_F)                          /* mask function */
-                        vc_lines[ln*VC_XSIZE + CUR_X + col] = vid_mono_palette[(vc_lines[ln*VC_XSIZE + CUR_X + col] == vid_mono_palette[1]) | (cur[col] & 1)];
-                    else
-                        vc_lines[ln*VC_XSIZE + CUR_X + col] = vid_mono_palette[(vc_lines[ln*VC_XSIZE + CUR_X + col] == vid_mono_palette[1]) & (~cur[col] & 1)];
-                    }
+                col = VC_XSIZE - CUR_X;                 /* clip to screen */
+                if (col > 16)
+                    col = 16;
+                vid_cursor_mono (&vc_lines[ln*VC_XSIZE + CUR_X], cur, col, vid_mono_palette, CUR_F != 0);
                 }
             }
         vc_map[ln] |= VCMAP_VLD;                        /* set valid */
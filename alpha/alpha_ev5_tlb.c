@@ -46,16 +46,46 @@
         tlb_ia                  TLB invalidate all
         tlb_is                  TLB invalidate single
         tlb_set_cm              TLB set current mode
+
+   Both TLBs are kept sorted by (asn, tag) so that lookup can use a binary
+   search.  A fill or single invalidate changes only one entry, which is
+   moved into place incrementally; only the bulk operations (invalidate all,
+   ASN change) re-sort the whole array, using an insertion sort since the
+   array is nearly ordered.
+
+   In front of the TLBs, each stream has a small direct-mapped translation
+   cache indexed by VPN.  Only successful translations are entered.  The
+   instruction cache is keyed by VPN and current mode, so a hit needs no
+   access check; the data cache is keyed by VPN alone and keeps the PTE,
+   because the access requested varies per reference.  Neither cache holds
+   an ASN; since both are flushed on an ASN change, every entry belongs to
+   the current address space.  The caches are host
+   side state only; they are flushed on any TLB write, ASN or superpage
+   change, and whenever the CPU resynchronizes its mode.
 */
 
 #include "alpha_defs.h"
 #include "alpha_ev5_defs.h"
 
-#define ITLB_SORT       qsort (itlb, ITLB_SIZE, sizeof (TLBENT), &tlb_comp);
-#define DTLB_SORT       qsort (dtlb, DTLB_SIZE, sizeof (TLBENT), &tlb_comp);
+#define ITLB_SORT       tlb_sort (itlb, ITLB_SIZE);
+#define DTLB_SORT       tlb_sort (dtlb, DTLB_SIZE);
+#define XC_SIZE         64                              /* xlate cache size */
+#define XC_GETIDX(v)    ((v) & (XC_SIZE - 1))
 #define TLB_ESIZE       (sizeof (TLBENT)/sizeof (uint32))
 #define MM_RW(x)        (((x) & PTE_FOW)? EXC_W: EXC_R)
 
+typedef struct {
+    uint32              tag;                            /* vpn */
+    uint32              cm;                             /* mode when filled */
+    uint32              pfn;                            /* pfn */
+    } IXCENT;
+
+typedef struct {
+    uint32              tag;                            /* vpn */
+    uint32              pte;                            /* pte, for acc check */
+    uint32              pfn;                            /* pfn */
+    } DXCENT;
+
 uint32 itlb_cm = 0;                                     /* current modes */
 uint32 itlb_spage = 0;                                  /* superpage enables */
 uint32 itlb_asn = 0;
@@ -68,6 +98,8 @@ uint32 dtlb_asn = 0;
 uint32 dtlb_nlu = 0;
 TLBENT d_mini_tlb;
 TLBENT dtlb[DTLB_SIZE];
+IXCENT itlb_xc[XC_SIZE];                                /* translation caches */
+DXCENT dtlb_xc[XC_SIZE];
 
 uint32 cm_eacc = ACC_E (MODE_K);                        /* precomputed */
 uint32 cm_racc = ACC_R (MODE_K);                        /* access checks */
@@ -82,6 +114,12 @@ void tlb_inval (TLBENT *tlbp);
 t_stat itlb_reset (void);
 t_stat dtlb_reset (void);
 int tlb_comp (const void *e1, const void *e2);
+void tlb_sort (TLBENT *tlb, int32 size);
+TLBENT *tlb_reposition (TLBENT *tlb, int32 size, int32 p);
+int32 itlb_find (uint32 vpn);
+int32 dtlb_find (uint32 vpn);
+void itlb_xc_flush (void);
+void dtlb_xc_flush (void);
 t_stat tlb_reset (DEVICE *dptr);
 
 /* TLB data structures
@@ -130,9 +168,12 @@ t_uint64 trans_i (t_uint64 va)
 uint32 va_sext = VA_GETSEXT (va);
 uint32 vpn = VA_GETVPN (va);
 TLBENT *tlbp;
+IXCENT *xcp = itlb_xc + XC_GETIDX (vpn);
 
 if ((va_sext != 0) && (va_sext != VA_M_SEXT))           /* invalid virt addr? */
     ABORT1 (va, EXC_BVA + EXC_E);
+if ((xcp->tag == vpn) && (xcp->cm == itlb_cm))          /* xlate cache hit? */
+    return PHYS_ADDR (xcp->pfn, va);                    /* access prechecked */
 if ((itlb_spage & SPEN_43) && VPN_GETSP43 (vpn) == 2) { /* 43b superpage? */
     if (itlb_cm != MODE_K) ABORT1 (va, EXC_ACV + EXC_E);
     return (va & SP43_MASK);
@@ -145,6 +186,9 @@ if (!(tlbp = itlb_lookup (vpn)))                        /* lookup vpn; miss? */
     ABORT1 (va, EXC_TBM + EXC_E);                       /* abort reference */
 if (cm_eacc & ~tlbp->pte)                               /* check access */
     ABORT1 (va, mm_exc (cm_eacc & ~tlbp->pte) | EXC_E);
+xcp->tag = vpn;                                         /* fill xlate cache */
+xcp->cm = itlb_cm;
+xcp->pfn = tlbp->pfn;
 return PHYS_ADDR (tlbp->pfn, va);                       /* return phys addr */
 }
 
@@ -153,9 +197,12 @@ t_uint64 trans_d (t_uint64 va, uint32 acc)
 uint32 va_sext = VA_GETSEXT (va);
 uint32 vpn = VA_GETVPN (va);
 TLBENT *tlbp;
+DXCENT *xcp = dtlb_xc + XC_GETIDX (vpn);
 
 if ((va_sext != 0) && (va_sext != VA_M_SEXT))           /* invalid virt addr? */
     ABORT1 (va, EXC_BVA + MM_RW (acc));
+if ((xcp->tag == vpn) && ((acc & ~xcp->pte) == 0))      /* xlate cache hit? */
+    return PHYS_ADDR (xcp->pfn, va);
 if ((dtlb_spage & SPEN_43) && (VPN_GETSP43 (vpn) == 2)) {
     if (dtlb_cm != MODE_K) ABORT1 (va, EXC_ACV + MM_RW (acc));
     return (va & SP43_MASK);                            /* 43b superpage? */
@@ -168,6 +215,9 @@ if (!(tlbp = dtlb_lookup (vpn)))                        /* lookup vpn; miss? */
     ABORT1 (va, EXC_TBM + MM_RW (acc));                 /* abort reference */
 if (acc & ~tlbp->pte)                                   /* check access */
     ABORT1 (va, mm_exc (acc & ~tlbp->pte) | MM_RW (acc));
+xcp->tag = vpn;                                         /* fill xlate cache */
+xcp->pte = tlbp->pte;
+xcp->pfn = tlbp->pfn;
 return PHYS_ADDR (tlbp->pfn, va);                       /* return phys addr */
 }
 
@@ -195,18 +245,20 @@ void tlb_is (t_uint64 va, uint32 flags)
 {
 uint32 va_sext = VA_GETSEXT (va);
 uint32 vpn = VA_GETVPN (va);
-TLBENT *itlbp, *dtlbp;
+int32 p;
 
 if ((va_sext != 0) && (va_sext != VA_M_SEXT)) return;
-if ((flags & TLB_CI) && (itlbp = itlb_lookup (vpn))) {
-    tlb_inval (itlbp);
+if ((flags & TLB_CI) && ((p = itlb_find (vpn)) >= 0)) {
+    tlb_inval (&itlb[p]);
     tlb_inval (&i_mini_tlb);
-    ITLB_SORT;
+    tlb_reposition (itlb, ITLB_SIZE, p);
+    itlb_xc_flush ();
     }
-if ((flags & TLB_CD) && (dtlbp = dtlb_lookup (vpn))) {
-    tlb_inval (dtlbp);
+if ((flags & TLB_CD) && ((p = dtlb_find (vpn)) >= 0)) {
+    tlb_inval (&dtlb[p]);
     tlb_inval (&d_mini_tlb);
-    DTLB_SORT;
+    tlb_reposition (dtlb, DTLB_SIZE, p);
+    dtlb_xc_flush ();
     }
 return;
 }
@@ -228,6 +280,7 @@ if (flags & TLB_CI) {
         }
     tlb_inval (&i_mini_tlb);
     ITLB_SORT;
+    itlb_xc_flush ();
     }
 if (flags & TLB_CD) {
     for (i = 0; i < DTLB_SIZE; i++) {
@@ -235,6 +288,7 @@ if (flags & TLB_CD) {
         }
     tlb_inval (&d_mini_tlb);
     DTLB_SORT;
+    dtlb_xc_flush ();
     }
 return;
 }
@@ -243,58 +297,74 @@ return;
 
 TLBENT *itlb_lookup (uint32 vpn)
 {
-int32 p, hi, lo;
+int32 p;
 
 if (vpn == i_mini_tlb.tag) return &i_mini_tlb;
+if ((p = itlb_find (vpn)) < 0) return NULL;
+i_mini_tlb.tag = vpn;
+i_mini_tlb.pte = itlb[p].pte;
+i_mini_tlb.pfn = itlb[p].pfn;
+itlb_nlu = itlb[p].idx + 1;
+if (itlb_nlu >= ITLB_SIZE) itlb_nlu = 0;
+return &i_mini_tlb;
+}
+
+TLBENT *dtlb_lookup (uint32 vpn)
+{
+int32 p;
+
+if (vpn == d_mini_tlb.tag) return &d_mini_tlb;
+if ((p = dtlb_find (vpn)) < 0) return NULL;
+d_mini_tlb.tag = vpn;
+d_mini_tlb.pte = dtlb[p].pte;
+d_mini_tlb.pfn = dtlb[p].pfn;
+dtlb_nlu = dtlb[p].idx + 1;
+if (dtlb_nlu >= DTLB_SIZE) dtlb_nlu = 0;
+return &d_mini_tlb;
+}
+
+/* TLB search - binary search of sorted TLB, returns entry index or -1 */
+
+int32 itlb_find (uint32 vpn)
+{
+int32 p, hi, lo;
+
 lo = 0;                                                 /* initial bounds */
 hi = ITLB_SIZE - 1;
 do {
     p = (lo + hi) >> 1;                                 /* probe */
     if ((itlb_asn == itlb[p].asn) && 
         (((vpn ^ itlb[p].tag) &
-         ~((uint32) itlb[p].gh_mask)) == 0)) {          /* match to TLB? */
-        i_mini_tlb.tag = vpn;
-        i_mini_tlb.pte = itlb[p].pte;
-        i_mini_tlb.pfn = itlb[p].pfn;
-        itlb_nlu = itlb[p].idx + 1;
-        if (itlb_nlu >= ITLB_SIZE) itlb_nlu = 0;
-        return &i_mini_tlb;
-        }
+         ~((uint32) itlb[p].gh_mask)) == 0))            /* match to TLB? */
+        return p;
     if ((itlb_asn < itlb[p].asn) ||
         ((itlb_asn == itlb[p].asn) && (vpn < itlb[p].tag)))
         hi = p - 1;                                     /* go down? p is upper */
     else lo = p + 1;                                    /* go up? p is lower */
     }
 while (lo <= hi);
-return NULL;
+return -1;
 }
 
-TLBENT *dtlb_lookup (uint32 vpn)
+int32 dtlb_find (uint32 vpn)
 {
 int32 p, hi, lo;
 
-if (vpn == d_mini_tlb.tag) return &d_mini_tlb;
 lo = 0;                                                 /* initial bounds */
 hi = DTLB_SIZE - 1;
 do {
     p = (lo + hi) >> 1;                                 /* probe */
     if ((dtlb_asn == dtlb[p].asn) && 
         (((vpn ^ dtlb[p].tag) &
-         ~((uint32) dtlb[p].gh_mask)) == 0)) {          /* match to TLB? */
-        d_mini_tlb.tag = vpn;
-        d_mini_tlb.pte = dtlb[p].pte;
-        d_mini_tlb.pfn = dtlb[p].pfn;
-        dtlb_nlu = dtlb[p].idx + 1;
-        if (dtlb_nlu >= DTLB_SIZE) dtlb_nlu = 0;
-        return &d_mini_tlb;
-        }
+         ~((uint32) dtlb[p].gh_mask)) == 0))            /* match to TLB? */
+        return p;
     if ((dtlb_asn < dtlb[p].asn) ||
         ((dtlb_asn == dtlb[p].asn) && (vpn < dtlb[p].tag)))
         hi = p - 1;                                     /* go down? p is upper */
     else lo = p + 1;                                    /* go up? p is lower */
     }
 while (lo <= hi);
-return NULL;
+return -1;
 }
 
 /* Load TLB entry at NLU pointer, advance NLU pointer */
@@ -315,8 +385,8 @@ for (i = 0; i < ITLB_SIZE; i++) {
         gh = PTE_GETGH (tlbp->pte);
         tlbp->gh_mask = (1u << (3 * gh)) - 1;
         tlb_inval (&i_mini_tlb);
-        ITLB_SORT;
-        return tlbp;
+        itlb_xc_flush ();
+        return tlb_reposition (itlb, ITLB_SIZE, i);     /* move into order */
         }
     }
 fprintf (stderr, "%%ITLB entry not found, itlb_nlu = %d\n", itlb_nlu);
@@ -332,7 +402,7 @@ for (i = 0; i < DTLB_SIZE; i++) {
     if (dtlb[i].idx == dtlb_nlu) {
         TLBENT *tlbp = dtlb + i;
         dtlb_nlu = dtlb_nlu + 1;
-        if (dtlb_nlu >= ITLB_SIZE) dtlb_nlu = 0;
+        if (dtlb_nlu >= DTLB_SIZE) dtlb_nlu = 0;
         tlbp->tag = vpn;
         tlbp->pte = (uint32) (l3pte & PTE_MASK) ^ (PTE_FOR|PTE_FOR|PTE_FOE);
         tlbp->pfn = ((uint32) (l3pte >> PTE_V_PFN)) & PFN_MASK;
@@ -340,8 +410,8 @@ for (i = 0; i < DTLB_SIZE; i++) {
         gh = PTE_GETGH (tlbp->pte);
         tlbp->gh_mask = (1u << (3 * gh)) - 1;
         tlb_inval (&d_mini_tlb);
-        DTLB_SORT;
-        return tlbp;
+        dtlb_xc_flush ();
+        return tlb_reposition (dtlb, DTLB_SIZE, i);     /* move into order */
         }
     }
 fprintf (stderr, "%%DTLB entry not found, dtlb_nlu = %d\n", dtlb_nlu);
@@ -399,6 +469,7 @@ for (i = 0; i < ITLB_SIZE; i++) {
     }
 tlb_inval (&i_mini_tlb);
 ITLB_SORT;
+itlb_xc_flush ();
 return;
 } 
 
@@ -412,6 +483,7 @@ for (i = 0; i < DTLB_SIZE; i++) {
     }
 tlb_inval (&d_mini_tlb);
 DTLB_SORT;
+dtlb_xc_flush ();
 return;
 }
 
@@ -420,12 +492,14 @@ return;
 void itlb_set_spage (uint32 spage)
 {
 itlb_spage = spage;
+itlb_xc_flush ();
 return;
 }
 
 void dtlb_set_spage (uint32 spage)
 {
 dtlb_spage = spage;
+dtlb_xc_flush ();
 return;
 }
 
@@ -453,8 +527,10 @@ if (cm >= 0) {
     dtlb_set_cm (cm);
     return cm;
     }
-itlb_set_cm (itlb_cm);
+itlb_set_cm (itlb_cm);                                  /* resync, flush */
 dtlb_set_cm (dtlb_cm);
+itlb_xc_flush ();
+dtlb_xc_flush ();
 return dtlb_cm;
 }
 
@@ -484,6 +560,60 @@ if (t1->tag < t2->tag) return -1;
 return 0;
 }
 
+/* Sort TLB - insertion sort, since the TLB is always nearly in order */
+
+void tlb_sort (TLBENT *tlb, int32 size)
+{
+int32 i, j;
+TLBENT t;
+
+for (i = 1; i < size; i++) {
+    t = tlb[i];
+    for (j = i; (j > 0) && (tlb_comp (&tlb[j - 1], &t) > 0); j--)
+        tlb[j] = tlb[j - 1];
+    tlb[j] = t;
+    }
+return;
+}
+
+/* Move a single changed entry to its sorted position, return new pointer */
+
+TLBENT *tlb_reposition (TLBENT *tlb, int32 size, int32 p)
+{
+TLBENT t = tlb[p];
+
+while ((p > 0) && (tlb_comp (&tlb[p - 1], &t) > 0)) {   /* move down? */
+    tlb[p] = tlb[p - 1];
+    p--;
+    }
+while ((p < (size - 1)) && (tlb_comp (&tlb[p + 1], &t) < 0)) {  /* move up? */
+    tlb[p] = tlb[p + 1];
+    p++;
+    }
+tlb[p] = t;
+return tlb + p;
+}
+
+/* Flush translation caches */
+
+void itlb_xc_flush (void)
+{
+int32 i;
+
+for (i = 0; i < XC_SIZE; i++)
+    itlb_xc[i].tag = INV_TAG;
+return;
+}
+
+void dtlb_xc_flush (void)
+{
+int32 i;
+
+for (i = 0; i < XC_SIZE; i++)
+    dtlb_xc[i].tag = INV_TAG;
+return;
+}
+
 /* ITLB reset */
 
 t_stat itlb_reset (void)
@@ -500,6 +630,7 @@ for (i = 0; i < ITLB_SIZE; i++) {
     itlb[i].idx = i;
     }
 tlb_inval (&i_mini_tlb);
+itlb_xc_flush ();
 return SCPE_OK;
 }
 /* DTLB reset */
@@ -518,6 +649,7 @@ for (i = 0; i < DTLB_SIZE; i++) {
     dtlb[i].idx = i;
     }
 tlb_inval (&d_mini_tlb);
+dtlb_xc_flush ();
 return SCPE_OK;
 }
 
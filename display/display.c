@@ -336,6 +336,51 @@ static long queue_interval;
 /* convert X,Y to a "struct point *" */
 #define P(X,Y) (points + (X) + ((Y)*(size_t)xpixels))
 
+/*
+ * Dense decay model (DISPLAY_DECAY_DENSE)
+ *
+ * Programs like Spacewar! or Lunar Lander draw tens of thousands of
+ * points per frame, and every one of them goes through the delta queue
+ * above, and is painted, once per aging step.  In the dense model each
+ * pixel is just its TTL, level and color (2 bytes).  display_point()
+ * only updates the array; every refresh_interval display_age() makes
+ * one sequential pass which paints each lit pixel once, ages it and
+ * then syncs the window.  Each row keeps a count and span of lit
+ * pixels so dark parts of the screen are skipped.  The colors[] table
+ * is shared with the queue model, so both look the same on screen; the
+ * only difference is that all points age in step instead of each point
+ * aging refresh_interval after it was drawn.
+ */
+#ifndef DISPLAY_DECAY
+#define DISPLAY_DECAY DISPLAY_DECAY_QUEUE
+#endif
+
+struct dpoint {
+    unsigned char ttl;          /* zero means off */
+    unsigned char level : 7;    /* intensity level */
+    unsigned char color : 1;    /* for VR20 (two colors) */
+};
+
+static int decay_mode = DISPLAY_DECAY;
+struct drow {
+    unsigned short lit;         /* lit points in row */
+    unsigned short xmin, xmax;  /* span containing them */
+};
+
+static struct dpoint *dpoints;  /* allocated array (dense model) */
+static struct drow *drows;      /* per row summary */
+static long dense_elapsed;      /* simulated time not yet aged */
+
+#define DP(X,Y) (dpoints + (X) + ((Y)*(size_t)xpixels))
+
+/*
+ * color to paint a dense model pixel: a freshly drawn pixel (MAXTTL)
+ * and one aged once share the brightest shade, as in the queue model,
+ * and a pixel which has gone out (zero) is dark.
+ */
+#define DCOLOR(P) colors[(P)->color][(P)->level] \
+                        [(P)->ttl < MAXTTL ? (P)->ttl : MAXTTL-1]
+
 /* convert "struct point *" to X and Y */
 #define X(P) (((P) - points) % xpixels)
 #define Y(P) (((P) - points) / xpixels)
@@ -381,6 +426,23 @@ static float level_scale[NLEVELS];
  */
 void *colors[2][NLEVELS][NTTL];
 
+int
+display_set_decay(int mode)
+{
+    if (mode != DISPLAY_DECAY_QUEUE && mode != DISPLAY_DECAY_DENSE)
+        return 0;
+    if (initialized)            /* cannot change once started */
+        return mode == decay_mode;
+    decay_mode = mode;
+    return 1;
+}
+
+int
+display_get_decay(void)
+{
+    return decay_mode;
+}
+
 void
 display_lp_radius(int r)
 {
@@ -572,6 +634,69 @@ display_delay(int t, int slowdown)
      */
 } /* display_delay */
 
+/*
+ * dense model: age every lit pixel by "steps" TTL levels and paint it
+ * at its new age, which is the color the queue model would have
+ * painted after the same number of steps (index 0 is dark).
+ */
+static int
+dense_decay(int steps)
+{
+    struct dpoint *p;
+    struct drow *r;
+    int x, y, xmin, xmax, changed;
+
+    changed = 0;
+    for (r = drows, y = 0; y < ypixels; r++, y++) {
+        if (r->lit == 0)
+            continue;
+        changed = 1;
+        xmin = xpixels;
+        xmax = 0;
+        for (p = DP(r->xmin,y), x = r->xmin; x <= r->xmax; p++, x++) {
+            if (p->ttl == 0)
+                continue;
+            if (p->ttl > steps) {
+                p->ttl -= steps;
+                if (x < xmin)
+                    xmin = x;
+                xmax = x;
+                }
+            else {
+                p->ttl = 0;
+                r->lit--;
+                }
+            ws_display_point(x, y, DCOLOR(p));
+            }
+        r->xmin = xmin;
+        r->xmax = xmax;
+        }
+    return changed;
+}
+
+/*
+ * dense model: run one aging pass per refresh_interval of simulated
+ * time (catching up if called late) and then show the frame.
+ */
+static int
+dense_age(int t)
+{
+    long period = (long)refresh_interval * DELAY_UNIT;
+    long steps;
+    int changed;
+
+    dense_elapsed += t;
+    if (dense_elapsed < period)
+        return 0;
+    steps = dense_elapsed / period;
+    dense_elapsed %= period;
+    if (steps > MAXTTL)
+        steps = MAXTTL;
+    changed = dense_decay((int)steps);
+    display_sync ();
+    return changed;
+}
+
 /*
  * here periodically from simulator to age pixels.
  *
@@ -598,6 +723,9 @@ display_age(int t,          /* simulated us since last call */
     if (slowdown)
         display_delay(t, slowdown);
 
+    if (dpoints)
+        return dense_age(t);
+
     changed = 0;
 
     elapsed += t;
@@ -652,6 +780,17 @@ void
 display_repaint(void) {
     struct point *p;
     int x, y;
+
+    if (dpoints) {
+        struct dpoint *dp;
+
+        for (dp = dpoints, y = 0; y < ypixels; y++)
+            for (x = 0; x < xpixels; dp++, x++)
+                if (dp->ttl)
+                    ws_display_point(x, y, DCOLOR(dp));
+        ws_sync();
+        return;
+        }
     /*
      * bottom to top, left to right.
      */
@@ -717,6 +856,41 @@ intensify(int x,            /* 0..xpixels */
     return bleed;
 }
 
+/* dense model version of intensify() */
+static void
+dense_intensify(int x, int y, int level, int color)
+{
+    struct dpoint *p;
+
+    if (x < 0 || x >= xpixels || y < 0 || y >= ypixels)
+        return;             /* limit to display */
+
+    p = DP(x,y);
+    if (p->ttl == 0) {
+        struct drow *r = &drows[y];
+
+        if (r->lit++ == 0)
+            r->xmin = r->xmax = x;
+        else if (x < r->xmin)
+            r->xmin = x;
+        else if (x > r->xmax)
+            r->xmax = x;
+        }
+    /* if "recently" drawn, same or brighter, same color, make even brighter */
+    else if (p->ttl >= MAXTTL*2/3 && 
+             level >= p->level && 
+             p->color == color &&
+             level < MAXLEVEL)
+        level++;
+
+    if (p->ttl != MAXTTL || p->level != level || p->color != color) {
+        p->ttl = MAXTTL;
+        p->level = level;
+        p->color = color;
+        ws_display_point(x, y, DCOLOR(p));
+        }
+}
+
 int
 display_point(int x,        /* 0..xpixels (unscaled) */
           int y,            /* 0..ypixels (unscaled) */
@@ -744,7 +918,10 @@ display_point(int x,        /* 0..xpixels (unscaled) */
 #if DISPLAY_INT_MIN > 0
     level -= DISPLAY_INT_MIN;       /* make zero based */
 #endif
-    intensify(x, y, level, color);
+    if (dpoints)
+        dense_intensify(x, y, level, color);
+    else
+        intensify(x, y, level, color);
     /* no bleeding for now (used to recurse for neighbor points) */
 
     if (ws_lp_x == -1 || ws_lp_y == -1)
@@ -927,10 +1104,21 @@ display_init(enum display_type type, int sf, void *dptr)
     for (i = 0; i < NLEVELS; i++)
         level_scale[i] = ((float)i+1+BOOST)/(NLEVELS+BOOST);
 
-    points = (struct point *)calloc((size_t)xpixels,
-                    ypixels * sizeof(struct point));
-    if (!points)
-        goto failed;
+    if (decay_mode == DISPLAY_DECAY_DENSE) {
+        dpoints = (struct dpoint *)calloc((size_t)xpixels,
+                        ypixels * sizeof(struct dpoint));
+        drows = (struct drow *)calloc((size_t)ypixels,
+                        sizeof(struct drow));
+        if (!dpoints || !drows)
+            goto failed;
+        dense_elapsed = 0;
+        }
+    else {
+        points = (struct point *)calloc((size_t)xpixels,
+                        ypixels * sizeof(struct point));
+        if (!points)
+            goto failed;
+        }
 
     if (!ws_init(dp->name, xpixels, ypixels, ncolors, dptr))
         goto failed;
@@ -945,6 +1133,12 @@ display_init(enum display_type type, int sf, void *dptr)
     return 1;
 
  failed:
+    free(points);
+    points = NULL;
+    free(dpoints);
+    dpoints = NULL;
+    free(drows);
+    drows = NULL;
     fprintf(stderr, "Display initialization failed\r\n");
     return 0;
 }
@@ -955,6 +1149,23 @@ display_reset(void)
     /* XXX tear down window? just clear it? */
 }
 
+void
+display_close(void)
+{
+    if (!initialized)
+        return;
+    ws_shutdown();
+    free(points);
+    points = NULL;
+    free(dpoints);
+    dpoints = NULL;
+    free(drows);
+    drows = NULL;
+    dense_elapsed = 0;
+    queue_interval = 0;
+    initialized = 0;
+}
+
 void
 display_sync(void)
 {
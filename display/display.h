@@ -70,6 +70,32 @@ extern int display_ypoints(void);
 /* conversion factor from virtual points and displayed pixels */
 extern int display_scale(void);
 
+/*
+ * phosphor decay models:
+ * QUEUE ages each lit point individually through a delta queue;
+ * DENSE keeps age and intensity in a per-pixel array and ages the
+ * whole display in one pass per refresh, which is cheaper when
+ * programs draw many thousands of points per frame.
+ */
+#define DISPLAY_DECAY_QUEUE 0
+#define DISPLAY_DECAY_DENSE 1
+
+/*
+ * select the decay model; must be called before display_init()
+ * returns false (and changes nothing) once the display is running
+ */
+extern int display_set_decay(int);
+extern int display_get_decay(void);
+
+#ifdef SIM_DEFS_H_
+/*
+ * SET/SHOW DECAY={QUEUE|DENSE} handlers (sim_ws.c),
+ * for use in a simulator display device's MTAB
+ */
+extern t_stat sim_display_set_decay(UNIT *, int32, CONST char *, void *);
+extern t_stat sim_display_show_decay(FILE *, UNIT *, int32, CONST void *);
+#endif
+
 /*
  * simulate passage of time; first argument is simulated microseconds elapsed,
  * second argument is flag to slow down simulated speed
@@ -106,6 +132,12 @@ extern void display_sync(void);
  */
 extern void display_reset(void);
 
+/*
+ * close the window and free the point arrays;
+ * the next display_init() starts afresh
+ */
+extern void display_close(void);
+
 /*
  * ring the bell
  */
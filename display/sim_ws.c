@@ -332,6 +332,7 @@ ws_shutdown(void)
 {
 ws_free_cursor(arrow_cursor);
 ws_free_cursor(cross_cursor);
+arrow_cursor = cross_cursor = NULL;
 vid_close();
 }
 
@@ -420,3 +421,32 @@ else
 tnew = !tnew;                       /* Ecclesiastes III */
 return ret;
 }
+
+/* SET/SHOW DECAY for simulator display devices */
+t_stat
+sim_display_set_decay(UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+    char gbuf[CBUFSIZE];
+    int mode;
+
+    if (cptr == NULL)
+        return SCPE_ARG;
+    get_glyph(cptr, gbuf, 0);
+    if (strcmp(gbuf, "QUEUE") == 0)
+        mode = DISPLAY_DECAY_QUEUE;
+    else if (strcmp(gbuf, "DENSE") == 0)
+        mode = DISPLAY_DECAY_DENSE;
+    else
+        return SCPE_ARG;
+    if (!display_set_decay(mode))
+        return SCPE_ALATT;              /* display already running */
+    return SCPE_OK;
+}
+
+t_stat
+sim_display_show_decay(FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+    fprintf(st, "decay=%s",
+            display_get_decay() == DISPLAY_DECAY_DENSE ? "dense" : "queue");
+    return SCPE_OK;
+}
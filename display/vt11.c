@@ -1121,6 +1121,15 @@ vt11_reset(void *dev, int debug)
             memset(&stack[i], 0, sizeof(struct frame));
     }
 }
+
+void
+vt11_close(void)
+{
+    if (vt11_init) {
+        display_close();
+        vt11_init = 0;
+    }
+}
 
 /* VS60 display subroutine support (see stack layout for SDR, above) */
 
@@ -439,6 +439,7 @@ t_stat show_version (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char
 t_stat show_default (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat show_break (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat show_on (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
+t_stat show_do_scripts (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_send (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat sim_show_expect (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat show_device (FILE *st, DEVICE *dptr, int32 flag);
@@ -507,6 +508,16 @@ t_stat exdep_addr_loop (FILE *ofile, SCHTAB *schptr, int32 flag, const char *cpt
 t_stat ex_addr (FILE *ofile, int32 flag, t_addr addr, DEVICE *dptr, UNIT *uptr);
 t_stat dep_addr (int32 flag, const char *cptr, t_addr addr, DEVICE *dptr,
     UNIT *uptr, int32 dfltinc);
+static t_stat ex_addr_bulk (FILE *ofile, SCHTAB *schptr, t_addr low, t_addr high,
+    DEVICE *dptr, UNIT *uptr);
+static t_stat dep_addr_fill (t_value val, t_addr low, t_addr high, DEVICE *dptr,
+    UNIT *uptr);
+static SIM_INLINE int32 test_search_value (t_value val, t_value mask, t_value comp,
+    int32 logic, int32 boolop);
+static t_value *sim_aval_buffer (void);
+static t_stat sim_aval_get (t_value *vals, t_addr addr, uint32 *count, DEVICE *dptr, UNIT *uptr);
+static t_stat sim_aval_put (const t_value *vals, t_addr addr, uint32 *count, DEVICE *dptr, UNIT *uptr);
+#define SIM_AVAL_BLOCK  4096                            /* values per bulk transfer */
 void fprint_fields (FILE *stream, t_value before, t_value after, BITFIELD* bitdefs);
 t_stat step_svc (UNIT *ptr);
 t_stat expect_svc (UNIT *ptr);
@@ -517,6 +528,7 @@ t_stat set_message (int32 flag, CONST char *cptr);
 t_stat set_quiet (int32 flag, CONST char *cptr);
 t_stat set_asynch (int32 flag, CONST char *cptr);
 t_stat sim_show_asynch (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
+t_stat sim_set_iostats (int32 flag, CONST char *cptr);
 t_stat do_cmd_label (int32 flag, CONST char *cptr, CONST char *label);
 void int_handler (int signal);
 t_stat set_prompt (int32 flag, CONST char *cptr);
@@ -564,6 +576,7 @@ size_t *sim_sub_instr_off = NULL;
 static double sim_time;
 static uint32 sim_rtime;
 static int32 noqueue_time;
+static double sim_event_ops = 0;                        /* event queue operations */
 volatile int32 stop_cpu = 0;
 static char **sim_argv;
 t_value *sim_eval = NULL;
@@ -576,8 +589,58 @@ FILEREF *sim_deb_ref = NULL;                            /* debug file file refer
 int32 sim_deb_switches = 0;                             /* debug switches */
 struct timespec sim_deb_basetime;                       /* debug timestamp relative base time */
 char *sim_prompt = NULL;                                /* prompt string */
-static FILE *sim_gotofile;                              /* the currently open do file */
-static int32 sim_goto_line[MAX_DO_NEST_LVL+1];          /* the current line number in the currently open do file */
+
+/* DO command files are read once and kept in memory.  Each line is stored
+   with its leading blanks removed and already classified so that GOTO, CALL
+   and RETURN never go back to the file, and labels are found through a
+   sorted index rather than by rescanning the file.  Lines are not stored
+   pre-tokenized: each execution still copies the line and runs it through
+   sim_sub_args.  What is kept is a command lookup cache: the command of a
+   line which has no % substitutions is looked up the first time it
+   executes, and the CTAB entry and the offset of its arguments are
+   remembered for as long as substitution leaves the line unchanged.  A
+   cached script is reused for as long as the file's size, modification
+   time and serial number are unchanged. */
+
+#define DO_LINE_BLANK   0                               /* empty line */
+#define DO_LINE_COMMENT 1                               /* ; or # comment */
+#define DO_LINE_LABEL   2                               /* :label */
+#define DO_LINE_CMD     3                               /* command */
+
+typedef struct DO_LINE {
+    char                *text;                          /* line text (leading blanks removed) */
+    char                *label;                         /* label name (DO_LINE_LABEL) */
+    int32               type;                           /* line type */
+    CTAB                *cmdp;                          /* cached command lookup */
+    int32               args;                           /* offset of command arguments in text */
+    } DO_LINE;
+
+typedef struct DO_SCRIPT DO_SCRIPT;
+struct DO_SCRIPT {
+    DO_SCRIPT           *next;                          /* next cached script */
+    char                *path;                          /* file name as opened */
+    time_t              mtime;                          /* file modification time */
+    t_offset            size;                           /* file size */
+    t_uint64            ino;                            /* file serial number */
+    time_t              loaded;                         /* time the file was read */
+    uint32              hash;                           /* file contents hash */
+    int32               line_count;                     /* number of lines */
+    DO_LINE             *lines;                         /* line array */
+    int32               label_count;                    /* number of labels */
+    int32               *labels;                        /* label line indices, sorted by name */
+    int32               refs;                           /* active invocations */
+    t_bool              stale;                          /* superseded by a newer load */
+    uint32              loads;                          /* times read from the file */
+    uint32              hits;                           /* times found in the cache */
+    uint32              calls;                          /* DO and CALL invocations */
+    uint32              gotos;                          /* label lookups */
+    t_uint64            executed;                       /* command lines executed */
+    };
+
+static DO_SCRIPT *sim_do_scripts = NULL;                /* cached scripts */
+static void sim_do_script_flush (void);
+static DO_SCRIPT *sim_do_script[MAX_DO_NEST_LVL+1];     /* the currently executing do script */
+static int32 sim_goto_line[MAX_DO_NEST_LVL+1];          /* the current line number in the currently executing do script */
 static int32 sim_do_echo = 0;                           /* the echo status of the currently open do file */
 static int32 sim_show_message = 1;                      /* the message display status of the currently open do file */
 static int32 sim_on_inherit = 0;                        /* the inherit status of on state and conditions when executing do files */
@@ -835,6 +898,21 @@ static const char simh_help[] =
       "++DUMP <filename> {implementation options}\n\n"
       " The types of formats supported are implementation specific.  Options (such\n"
       " as dump within range) are also implementation specific.\n"
+#define HLP_RAWLOAD     "*Commands Loading_and_Saving_Programs RAWLOAD"
+#define HLP_RAWDUMP     "*Commands Loading_and_Saving_Programs RAWDUMP"
+      "3RAWDUMP\n"
+      " The RAWDUMP command writes a range of a device's address space to a file\n"
+      " without any formatting:\n\n"
+      "++RAWDUMP {<dev>} <filename> <range>\n\n"
+      " Each location is written as the number of bytes needed to hold the\n"
+      " device's data width, least significant byte first.  This is the same\n"
+      " layout used for the file attached to a memory or buffered unit.\n"
+      "3RAWLOAD\n"
+      " The RAWLOAD command loads a file written by RAWDUMP (or any file in the\n"
+      " same layout) into a device's address space:\n\n"
+      "++RAWLOAD {<dev>} <filename> {<address>|<range>}\n\n"
+      " Loading starts at the given address, or at 0 if none is given, and stops\n"
+      " at the end of the file or at the end of the given range.\n"
        /***************** 80 character line width template *************************/
       "2Saving and Restoring State\n"
 #define HLP_SAVE        "*Commands Saving_and_Restoring_State SAVE"
@@ -904,6 +982,17 @@ static const char simh_help[] =
       " The BOOT command (abbreviated BO) resets all devices and bootstraps the\n"
       " device and unit given by its argument.  If no unit is supplied, unit 0 is\n"
       " bootstrapped.  The specified unit must be attached.\n"
+#define HLP_BENCHMARK   "*Commands Running_A_Simulated_Program BENCHMARK"
+      "3BENCHMARK\n"
+      " The BENCHMARK command resumes execution at the current PC for the number\n"
+      " of instructions given by its argument (default 100000000) with throttling\n"
+      " and idling disabled.  When execution stops, it reports the number of\n"
+      " instructions executed, elapsed and host CPU time, the instruction rate\n"
+      " and the event queue operation rate as name=value lines:\n\n"
+      "++sim> BENCHMARK 50000000\n\n"
+      " The program being measured must already be loaded.  The make bench\n"
+      " target runs the VAX, PDP-11 and PDP-8 simulators on small built-in\n"
+      " instruction mix loops.\n"
        /***************** 80 character line width template *************************/
       "2Stopping The Simulator\n"
       " Programs run until the simulator detects an error or stop condition, or\n"
@@ -1184,6 +1273,15 @@ static const char simh_help[] =
       "3Asynch\n"
       "+set asynch                  enable asynchronous I/O\n"
       "+set noasynch                disable asynchronous I/O\n"
+#define HLP_SET_IOSTATS "*Commands SET IOstats"
+      "3IOstats\n"
+      "+set iostats reset           clear all disk, tape and ethernet I/O\n"
+      "++++++++                     statistics\n"
+      "+set iostats csv=file        append CSV statistics to file periodically\n"
+      "+set iostats json=file       append JSON statistics to file periodically\n"
+      "+set iostats interval=secs   set the periodic dump interval (default 10)\n"
+      "+set iostats dump            append the current statistics to file now\n"
+      "+set iostats nodump          stop periodic dumping\n"
 #define HLP_SET_ENVIRON "*Commands SET Environment"
       "3Environment\n"
       "4Explicitily Changing A Variable\n"
@@ -1233,6 +1331,31 @@ static const char simh_help[] =
 #define HLP_SET_PROMPT "*Commands SET Command_Prompt"
       "3Command Prompt\n"
       "+set prompt \"string\"        sets an alternate simulator prompt string\n"
+#if defined(USE_SIM_VIDEO)
+#define HLP_SET_VIDEO  "*Commands SET Video"
+      "3Video\n"
+      " The video display of simulators with bitmap displays can be drawn in\n"
+      " a window or kept in an offscreen frame buffer, which needs no window\n"
+      " system.  The backend is chosen before the display is opened:\n\n"
+      "+set video OFFSCREEN         use the offscreen frame buffer\n"
+      "+set video WINDOW            use a window (default)\n\n"
+      " The offscreen display can be saved with SCREENSHOT, and its frames\n"
+      " can be written as raw 32 bit ARGB pixels (host byte order) to a file\n"
+      " or, when the name starts with |, piped to a command:\n\n"
+      "+set video DUMP=file         dump frames to file\n"
+      "+set video DUMPRATE=n        dump every n'th frame\n"
+      "+set video NODUMP            stop dumping frames\n\n"
+      " Keyboard and mouse input to the offscreen display is given directly\n"
+      " or from an event script whose lines use the same syntax.  The script\n"
+      " is read as frames are displayed, DELAY=n waits n frames and\n"
+      " SCREENSHOT=file saves the display:\n\n"
+      "+set video KEY=name          press and release a key (A, ENTER, F1, ...)\n"
+      "+set video KEYDOWN=name      press a key\n"
+      "+set video KEYUP=name        release a key\n"
+      "+set video MOUSE=x,y{,b}     move the mouse, b is the button mask\n"
+      "+set video INPUT=file        read events from an event script\n"
+      "+set video NOINPUT           stop reading the event script\n"
+#endif
       "3Device and Unit\n"
       "+set <dev> OCT|DEC|HEX|BIN   set device display radix\n"
       "+set <dev> ENABLED           enable device\n"
@@ -1268,6 +1391,7 @@ static const char simh_help[] =
       "+sh{ow} <dev> MODIFIERS      show device modifiers\n"
       "+sh{ow} <dev> NAMES          show device logical name\n"
       "+sh{ow} <dev> SHOW           show device SHOW commands\n"
+      "+sh{ow} <dev> STATISTICS     show device I/O statistics\n"
       "+sh{ow} <dev> {arg,...}      show device parameters\n"
       "+sh{ow} <unit> {arg,...}     show unit parameters\n"
       "+sh{ow} ethernet             show ethernet devices\n"
@@ -1279,6 +1403,8 @@ static const char simh_help[] =
       "+sh{ow} clocks               show calibrated timer information\n"
       "+sh{ow} throttle             show throttle info\n"
       "+sh{ow} on                   show on condition actions\n"
+      "+sh{ow} io{stats}            show I/O statistics for all devices\n"
+      "+sh{ow} scr{ipts}            show cached DO script statistics\n"
       "+h{elp} <dev> show           displays the device specific show commands\n"
       "++++++++                     available\n"
 #define HLP_SHOW_CONFIG         "*Commands SHOW"
@@ -1298,12 +1424,14 @@ static const char simh_help[] =
 #define HLP_SHOW_DEBUG          "*Commands SHOW"
 #define HLP_SHOW_THROTTLE       "*Commands SHOW"
 #define HLP_SHOW_ASYNCH         "*Commands SHOW"
+#define HLP_SHOW_IOSTATS        "*Commands SHOW"
 #define HLP_SHOW_ETHERNET       "*Commands SHOW"
 #define HLP_SHOW_SERIAL         "*Commands SHOW"
 #define HLP_SHOW_MULTIPLEXER    "*Commands SHOW"
 #define HLP_SHOW_VIDEO          "*Commands SHOW"
 #define HLP_SHOW_CLOCKS         "*Commands SHOW"
 #define HLP_SHOW_ON             "*Commands SHOW"
+#define HLP_SHOW_SCRIPTS        "*Commands SHOW"
 #define HLP_SHOW_SEND           "*Commands SHOW"
 #define HLP_SHOW_EXPECT         "*Commands SHOW"
 #define HLP_HELP                "*Commands HELP"
@@ -1953,6 +2081,8 @@ static CTAB cmd_table[] = {
     { "GET",        &restore_cmd,   0,          NULL },
     { "LOAD",       &load_cmd,      0,          HLP_LOAD },
     { "DUMP",       &load_cmd,      1,          HLP_DUMP },
+    { "RAWLOAD",    &rawload_cmd,   0,          HLP_RAWLOAD },
+    { "RAWDUMP",    &rawload_cmd,   1,          HLP_RAWDUMP },
     { "EXIT",       &exit_cmd,      0,          HLP_EXIT },
     { "QUIT",       &exit_cmd,      0,          NULL },
     { "BYE",        &exit_cmd,      0,          NULL },
@@ -1984,6 +2114,7 @@ static CTAB cmd_table[] = {
     { "EXPECT",     &expect_cmd,    1,          HLP_EXPECT },
     { "NOEXPECT",   &expect_cmd,    0,          HLP_EXPECT },
     { "SLEEP",      &sleep_cmd,     0,          HLP_SLEEP },
+    { "BENCHMARK",  &benchmark_cmd, 0,          HLP_BENCHMARK },
     { "!",          &spawn_cmd,     0,          HLP_SPAWN },
     { "HELP",       &help_cmd,      0,          HLP_HELP },
 #if defined(USE_SIM_VIDEO)
@@ -2009,6 +2140,7 @@ static CTAB set_glob_tab[] = {
     { "CLOCKS",     &sim_set_timers,            1, HLP_SET_CLOCKS },
     { "ASYNCH",     &sim_set_asynch,            1, HLP_SET_ASYNCH },
     { "NOASYNCH",   &sim_set_asynch,            0, HLP_SET_ASYNCH },
+    { "IOSTATS",    &sim_set_iostats,           0, HLP_SET_IOSTATS },
     { "ENVIRONMENT", &sim_set_environment,      1, HLP_SET_ENVIRON },
     { "ON",         &set_on,                    1, HLP_SET_ON },
     { "NOON",       &set_on,                    0, HLP_SET_ON },
@@ -2021,6 +2153,9 @@ static CTAB set_glob_tab[] = {
     { "QUIET",      &set_quiet,                 1, HLP_SET_QUIET },
     { "NOQUIET",    &set_quiet,                 0, HLP_SET_QUIET },
     { "PROMPT",     &set_prompt,                0, HLP_SET_PROMPT },
+#if defined(USE_SIM_VIDEO)
+    { "VIDEO",      &vid_set,                   0, HLP_SET_VIDEO },
+#endif
     { NULL,         NULL,                       0 }
     };
 
@@ -2061,6 +2196,7 @@ static SHTAB show_glob_tab[] = {
     { "DEBUG",          &sim_show_debug,            0, HLP_SHOW_DEBUG },
     { "THROTTLE",       &sim_show_throt,            0, HLP_SHOW_THROTTLE },
     { "ASYNCH",         &sim_show_asynch,           0, HLP_SHOW_ASYNCH },
+    { "IOSTATS",        &sim_show_iostats,          0, HLP_SHOW_IOSTATS },
     { "ETHERNET",       &eth_show_devices,          0, HLP_SHOW_ETHERNET },
     { "SERIAL",         &sim_show_serial,           0, HLP_SHOW_SERIAL },
     { "MULTIPLEXER",    &tmxr_show_open_devices,    0, HLP_SHOW_MULTIPLEXER },
@@ -2072,6 +2208,7 @@ static SHTAB show_glob_tab[] = {
     { "SEND",           &sim_show_send,             0, HLP_SHOW_SEND },
     { "EXPECT",         &sim_show_expect,           0, HLP_SHOW_EXPECT },
     { "ON",             &show_on,                   0, HLP_SHOW_ON },
+    { "SCRIPTS",        &show_do_scripts,           0, HLP_SHOW_SCRIPTS },
     { NULL,             NULL,                       0 }
     };
 
@@ -2081,10 +2218,12 @@ static SHTAB show_dev_tab[] = {
     { "MODIFIERS",  &show_dev_modifiers,        0 },
     { "NAMES",      &show_dev_logicals,         0 },
     { "SHOW",       &show_dev_show_commands,    0 },
+    { "STATISTICS", &sim_show_iostats,          0 },
     { NULL,         NULL,                       0 }
     };
 
 static SHTAB show_unit_tab[] = {
+    { "STATISTICS", &sim_show_iostats,          1 },
     { NULL, NULL, 0 }
     };
 
@@ -2276,6 +2415,7 @@ vid_close ();                                           /* close video */
 sim_ttclose ();                                         /* close console */
 AIO_CLEANUP;                                            /* Asynch I/O */
 sim_cleanup_sock ();                                    /* cleanup sockets */
+sim_do_script_flush ();                                 /* release cached DO scripts */
 fclose (stdnul);                                        /* close bit bucket file handle */
 free (targv);                                           /* release any argv copy that was made */
 return 0;
@@ -2351,6 +2491,7 @@ if (gbuf[0] == '\0') {                                  /* Token started with qu
     }
 sim_prompt = (char *)realloc (sim_prompt, strlen (gbuf) + 2);   /* nul terminator and trailing blank */
 sprintf (sim_prompt, "%s ", gbuf);
+sim_rem_prompt_update ();                               /* tell the remote console */
 return SCPE_OK;
 }
 
@@ -2997,12 +3138,254 @@ sprintf (cbuf, "%s%s%s-%d", sim_do_filename[sim_do_depth], sim_do_label[sim_do_d
 return cbuf;
 }
 
+/* DO script cache routines
+
+   sim_do_script_get       return the in memory image of an open DO file,
+                           reading it only if it isn't already cached or has
+                           changed since it was cached
+   sim_do_script_release   release a reference obtained by sim_do_script_get
+   sim_do_script_flush     discard all cached scripts
+   sim_do_script_line      fetch the next line of a script into a buffer
+   sim_do_script_label     return the line index of a label, or -1
+*/
+
+static void sim_do_script_free (DO_SCRIPT *script)
+{
+int32 i;
+
+for (i = 0; i < script->line_count; i++) {
+    free (script->lines[i].text);
+    free (script->lines[i].label);
+    }
+free (script->lines);
+free (script->labels);
+free (script->path);
+free (script);
+}
+
+static DO_SCRIPT *sim_do_label_script;                  /* script being sorted */
+
+static int sim_do_label_compare (const void *pa, const void *pb)
+{
+int32 a = *((const int32 *)pa);
+int32 b = *((const int32 *)pb);
+int cmp = strcmp (sim_do_label_script->lines[a].label, sim_do_label_script->lines[b].label);
+
+if (cmp)
+    return cmp;
+return (a < b) ? -1 : (a > b);                          /* first definition sorts first */
+}
+
+static uint32 sim_do_script_hash_add (uint32 hash, const char *cptr)
+{
+while (*cptr)                                           /* FNV-1a */
+    hash = (hash ^ (uint8)*cptr++) * 16777619u;
+return hash;
+}
+
+#define DO_SCRIPT_HASH_INIT 2166136261u
+
+static DO_SCRIPT *sim_do_script_load (const char *path, FILE *fpin)
+{
+char lbuf[4*CBUFSIZE], gbuf[CBUFSIZE], *cptr;
+DO_SCRIPT *script;
+DO_LINE *line;
+int32 alloc = 0, i;
+
+script = (DO_SCRIPT *)calloc (1, sizeof (*script));
+if (script == NULL)
+    return NULL;
+script->path = (char *)malloc (1 + strlen (path));
+if (script->path == NULL) {
+    free (script);
+    return NULL;
+    }
+strcpy (script->path, path);
+script->hash = DO_SCRIPT_HASH_INIT;
+while (fgets (lbuf, sizeof (lbuf), fpin)) {             /* same line handling as read_line */
+    script->hash = sim_do_script_hash_add (script->hash, lbuf);
+    lbuf[strcspn (lbuf, "\r\n")] = '\0';                /* remove cr or nl */
+    if (0 == memcmp (lbuf, "\xEF\xBB\xBF", 3))          /* Skip/ignore UTF8_BOM */
+        memmove (lbuf, lbuf + 3, strlen (lbuf + 3) + 1);
+    for (cptr = lbuf; sim_isspace (*cptr); cptr++) ;    /* trim leading spc */
+    if (script->line_count == alloc) {
+        DO_LINE *lines;
+
+        alloc = alloc ? 2 * alloc : 64;
+        lines = (DO_LINE *)realloc (script->lines, alloc * sizeof (*lines));
+        if (lines == NULL) {
+            sim_do_script_free (script);
+            return NULL;
+            }
+        script->lines = lines;
+        }
+    line = &script->lines[script->line_count++];
+    memset (line, 0, sizeof (*line));
+    line->text = (char *)malloc (1 + strlen (cptr));
+    if (line->text == NULL) {
+        sim_do_script_free (script);
+        return NULL;
+        }
+    strcpy (line->text, cptr);
+    if (*cptr == '\0')
+        line->type = DO_LINE_BLANK;
+    else if ((*cptr == ';') || (*cptr == '#'))
+        line->type = DO_LINE_COMMENT;
+    else if (*cptr == ':') {
+        line->type = DO_LINE_LABEL;
+        for (++cptr; sim_isspace (*cptr); cptr++) ;     /* skip : and blanks */
+        get_glyph (cptr, gbuf, 0);                      /* get label glyph */
+        line->label = (char *)malloc (1 + strlen (gbuf));
+        if (line->label == NULL) {
+            sim_do_script_free (script);
+            return NULL;
+            }
+        strcpy (line->label, gbuf);
+        script->label_count += 1;
+        }
+    else
+        line->type = DO_LINE_CMD;
+    }
+if (script->label_count) {                              /* build label index */
+    script->labels = (int32 *)malloc (script->label_count * sizeof (*script->labels));
+    if (script->labels == NULL) {
+        sim_do_script_free (script);
+        return NULL;
+        }
+    for (i = alloc = 0; i < script->line_count; i++)
+        if (script->lines[i].type == DO_LINE_LABEL)
+            script->labels[alloc++] = i;
+    sim_do_label_script = script;
+    qsort (script->labels, script->label_count, sizeof (*script->labels), sim_do_label_compare);
+    }
+return script;
+}
+
+/* Modification times only have a resolution of a second, so a script
+   rewritten at the same size within the second it was read in (as generated
+   scripts often are) would look unchanged.  Only in that case is the file
+   read again and its contents hash compared; this reads it in the same
+   pieces as sim_do_script_load so the hashes agree. */
+
+static uint32 sim_do_script_hash (FILE *fpin)
+{
+char lbuf[4*CBUFSIZE];
+uint32 hash = DO_SCRIPT_HASH_INIT;
+
+while (fgets (lbuf, sizeof (lbuf), fpin))
+    hash = sim_do_script_hash_add (hash, lbuf);
+rewind (fpin);                                          /* load reads from the start */
+return hash;
+}
+
+static DO_SCRIPT *sim_do_script_get (const char *path, FILE *fpin)
+{
+DO_SCRIPT *script, *old, **pscript;
+struct stat filestat;
+time_t now = time (NULL);                               /* before stat, so later writes look newer */
+t_bool cacheable = (0 == stat (path, &filestat));
+
+for (pscript = &sim_do_scripts; (old = *pscript); pscript = &old->next)
+    if (0 == strcmp (old->path, path))
+        break;
+if (old && cacheable &&
+    (old->mtime == filestat.st_mtime) &&
+    (old->size == (t_offset)filestat.st_size) &&
+    (old->ino == (t_uint64)filestat.st_ino) &&
+    ((old->mtime < old->loaded) ||                      /* last written before it was read? */
+     (old->hash == sim_do_script_hash (fpin)))) {       /* unchanged since cached? */
+    old->loaded = now;                                  /* contents known current as of now */
+    old->hits += 1;
+    old->refs += 1;
+    return old;
+    }
+script = sim_do_script_load (path, fpin);
+if (script == NULL)
+    return NULL;
+script->loads = 1;
+script->refs = 1;
+if (old) {                                              /* replacing an older copy? */
+    script->loads += old->loads;                        /* keep accumulated statistics */
+    script->hits = old->hits;
+    script->calls = old->calls;
+    script->gotos = old->gotos;
+    script->executed = old->executed;
+    *pscript = old->next;                               /* unlink it */
+    old->stale = TRUE;
+    if (old->refs == 0)                                 /* free now unless still executing */
+        sim_do_script_free (old);
+    }
+if (cacheable) {
+    script->mtime = filestat.st_mtime;
+    script->size = (t_offset)filestat.st_size;
+    script->ino = (t_uint64)filestat.st_ino;
+    script->loaded = now;
+    script->next = sim_do_scripts;
+    sim_do_scripts = script;
+    }
+else
+    script->stale = TRUE;                               /* use once */
+return script;
+}
+
+static void sim_do_script_release (DO_SCRIPT *script)
+{
+if ((--script->refs == 0) && script->stale)
+    sim_do_script_free (script);
+}
+
+static void sim_do_script_flush (void)
+{
+DO_SCRIPT *script;
+
+while ((script = sim_do_scripts)) {
+    sim_do_scripts = script->next;
+    sim_do_script_free (script);
+    }
+}
+
+static char *sim_do_script_line (DO_SCRIPT *script, char *cbuf, size_t size)
+{
+DO_LINE *line;
+
+if (sim_goto_line[sim_do_depth] >= script->line_count)
+    return NULL;                                        /* EOF */
+line = &script->lines[sim_goto_line[sim_do_depth]];
+if (line->type == DO_LINE_COMMENT) {                    /* ignore comment */
+    if (sim_do_echo)                                    /* echo comments if -v */
+        sim_printf("%s> %s\n", do_position(), line->text);
+    *cbuf = '\0';
+    }
+else
+    strlcpy (cbuf, line->text, size);
+return cbuf;
+}
+
+static int32 sim_do_script_label (DO_SCRIPT *script, const char *label)
+{
+int32 lo = 0, hi = script->label_count - 1, mid, cmp, found = -1;
+
+while (lo <= hi) {                                      /* find first definition */
+    mid = (lo + hi) / 2;
+    cmp = strcmp (script->lines[script->labels[mid]].label, label);
+    if (cmp == 0)
+        found = script->labels[mid];
+    if (cmp < 0)
+        lo = mid + 1;
+    else
+        hi = mid - 1;
+    }
+return found;
+}
+
 t_stat do_cmd_label (int32 flag, CONST char *fcptr, CONST char *label)
 {
 char cbuf[4*CBUFSIZE], gbuf[CBUFSIZE], abuf[4*CBUFSIZE], quote, *c, *do_arg[11];
 CONST char *cptr;
 FILE *fpin;
+DO_SCRIPT *script;
 CTAB *cmdp = NULL;
+DO_LINE *line;
 int32 echo, nargs, errabort, i;
 int32 saved_sim_do_echo = sim_do_echo, 
       saved_sim_show_message = sim_show_message,
@@ -3053,6 +3436,11 @@ if ((fpin = fopen (do_arg[0], "r")) == NULL) {          /* file failed to open?
         return SCPE_OPENERR;                            /* return failure */
         }
     }
+else strlcpy (cbuf, do_arg[0], sizeof (cbuf));
+script = sim_do_script_get (cbuf, fpin);                /* load or find cached script */
+fclose (fpin);                                          /* file no longer needed */
+if (script == NULL)
+    return SCPE_MEM;
 if (flag >= 0) {                                        /* Only bump nesting from command or nested */
     ++sim_do_depth;
     if (sim_on_inherit) {                               /* inherit ON condition actions? */
@@ -3068,7 +3456,7 @@ if (flag >= 0) {                                        /* Only bump nesting fro
                     sim_on_check[sim_do_depth] = 0;
                     sim_brk_clract ();                  /* defang breakpoint actions */
                     --sim_do_depth;                     /* unwind nesting */
-                    fclose (fpin);
+                    sim_do_script_release (script);
                     return SCPE_MEM;
                     }
                 strcpy(sim_on_actions[sim_do_depth][i], sim_on_actions[sim_do_depth-1][i]);
@@ -3081,8 +3469,9 @@ strlcpy( sim_do_filename[sim_do_depth], do_arg[0],
          sizeof (sim_do_filename[sim_do_depth]));       /* stash away do file name for possible use by 'call' command */
 sim_do_label[sim_do_depth] = label;                     /* stash away do label for possible use in messages */
 sim_goto_line[sim_do_depth] = 0;
+sim_do_script[sim_do_depth] = script;
+script->calls += 1;
 if (label) {
-    sim_gotofile = fpin;
     sim_do_echo = echo;
     stat = goto_cmd (0, label);
     if (stat != SCPE_OK) {
@@ -3096,9 +3485,12 @@ if (errabort)                                           /* -e flag? */
     set_on (1, NULL);                                   /* equivalent to ON ERROR RETURN */
 
 do {
+    line = NULL;
     sim_do_ocptr[sim_do_depth] = cptr = sim_brk_getact (cbuf, sizeof(cbuf)); /* get bkpt action */
     if (!sim_do_ocptr[sim_do_depth]) {                  /* no pending action? */
-        sim_do_ocptr[sim_do_depth] = cptr = read_line (cbuf, sizeof(cbuf), fpin);/* get cmd line */
+        sim_do_ocptr[sim_do_depth] = cptr = sim_do_script_line (script, cbuf, sizeof(cbuf));/* get cmd line */
+        if (cptr)
+            line = &script->lines[sim_goto_line[sim_do_depth]];
         sim_goto_line[sim_do_depth] += 1;
         }
     sim_sub_args (cbuf, sizeof(cbuf), do_arg);          /* substitute args */
@@ -3113,11 +3505,26 @@ do {
     sim_cmd_echoed = echo;
     if (*cptr == ':')                                   /* ignore label */
         continue;
-    cptr = get_glyph_cmd (cptr, gbuf);                  /* get command glyph */
+    script->executed += 1;
+    if (line && line->cmdp &&                           /* command already looked up */
+        (0 == strcmp (cptr, line->text))) {             /* and line unchanged? */
+        cmdp = line->cmdp;
+        cptr += line->args;
+        }
+    else {
+        cptr = get_glyph_cmd (cptr, gbuf);              /* get command glyph */
+        cmdp = find_cmd (gbuf);                         /* lookup command */
+        if (line && cmdp &&                             /* script line which can't change? */
+            (line->type == DO_LINE_CMD) &&
+            (NULL == strchr (line->text, '%')) &&
+            (0 == strcmp (cbuf, line->text))) {         /* (first token not an env var) */
+            line->cmdp = cmdp;                          /* remember command */
+            line->args = (int32)(cptr - cbuf);
+            }
+        }
     sim_switches = 0;                                   /* init switches */
-    sim_gotofile = fpin;
     sim_do_echo = echo;
-    if ((cmdp = find_cmd (gbuf))) {                     /* lookup command */
+    if (cmdp) {                                         /* known command? */
         if (cmdp->action == &return_cmd)                /* RETURN command? */
             break;                                      /*    done! */
         if (cmdp->action == &do_cmd) {                  /* DO command? */
@@ -3187,8 +3594,8 @@ do {
         (*sim_vm_post) (TRUE);
     } while (staying);
 Cleanup_Return:
-fclose (fpin);                                          /* close file */
-sim_gotofile = NULL;
+sim_do_script[sim_do_depth] = NULL;
+sim_do_script_release (script);                         /* done with script */
 if (flag >= 0) {
     sim_do_echo = saved_sim_do_echo;                    /* restore echo state we entered with */
     sim_show_message = saved_sim_show_message;          /* restore message display state we entered with */
@@ -4017,44 +4424,23 @@ return SCPE_OK;
 
 t_stat goto_cmd (int32 flag, CONST char *fcptr)
 {
-char cbuf[CBUFSIZE], gbuf[CBUFSIZE], gbuf1[CBUFSIZE];
-const char *cptr;
-long fpos;
-int32 saved_do_echo = sim_do_echo;
-int32 saved_goto_line = sim_goto_line[sim_do_depth];
+char gbuf1[CBUFSIZE];
+DO_SCRIPT *script = sim_do_script[sim_do_depth];
+int32 line;
 
-if (NULL == sim_gotofile) return SCPE_UNK;              /* only valid inside of do_cmd */
+if (NULL == script) return SCPE_UNK;                    /* only valid inside of do_cmd */
 get_glyph (fcptr, gbuf1, 0);
 if ('\0' == gbuf1[0])                                   /* unspecified goto target */
     return sim_messagef (SCPE_ARG, "Missing goto target\n");
-fpos = ftell(sim_gotofile);                             /* Save start position */
-if (fpos < 0)
-    return sim_messagef (SCPE_IERR, "goto ftell error: %s\n", strerror (errno));
-rewind(sim_gotofile);                                   /* start search for label */
-sim_goto_line[sim_do_depth] = 0;                        /* reset line number */
-sim_do_echo = 0;                                        /* Don't echo while searching for label */
-while (1) {
-    cptr = read_line (cbuf, sizeof(cbuf), sim_gotofile);/* get cmd line */
-    if (cptr == NULL) break;                            /* exit on eof */
-    sim_goto_line[sim_do_depth] += 1;                   /* record line number */
-    if (*cptr == 0) continue;                           /* ignore blank */
-    if (*cptr != ':') continue;                         /* ignore non-labels */
-    ++cptr;                                             /* skip : */
-    while (sim_isspace (*cptr)) ++cptr;                 /* skip blanks */
-    get_glyph (cptr, gbuf, 0);                          /* get label glyph */
-    if (0 == strcmp(gbuf, gbuf1)) {
-        sim_brk_clract ();                              /* goto defangs current actions */
-        sim_do_echo = saved_do_echo;                    /* restore echo mode */
-        if (sim_do_echo)                                /* echo if -v */
-            sim_printf("%s> %s\n", do_position(), cbuf);
-        return SCPE_OK;
-        }
-    }
-sim_do_echo = saved_do_echo;                            /* restore echo mode */
-sim_goto_line[sim_do_depth] = saved_goto_line;          /* restore start line number */
-if (fseek(sim_gotofile, fpos, SEEK_SET))                /* restore start position */
-    return sim_messagef (SCPE_IERR, "goto seek error: %s\n", strerror (errno));
-return sim_messagef (SCPE_ARG, "goto target '%s' not found\n", gbuf1);
+script->gotos += 1;
+line = sim_do_script_label (script, gbuf1);             /* look up label */
+if (line < 0)
+    return sim_messagef (SCPE_ARG, "goto target '%s' not found\n", gbuf1);
+sim_goto_line[sim_do_depth] = line + 1;                 /* resume after label */
+sim_brk_clract ();                                      /* goto defangs current actions */
+if (sim_do_echo)                                        /* echo if -v */
+    sim_printf("%s> %s\n", do_position(), script->lines[line].text);
+return SCPE_OK;
 }
 
 /* Return command */
@@ -4091,7 +4477,7 @@ t_stat call_cmd (int32 flag, CONST char *fcptr)
 char cbuf[CBUFSIZE], gbuf[CBUFSIZE];
 const char *cptr;
 
-if (NULL == sim_gotofile) return SCPE_UNK;              /* only valid inside of do_cmd */
+if (NULL == sim_do_script[sim_do_depth]) return SCPE_UNK;/* only valid inside of do_cmd */
 cptr = get_glyph (fcptr, gbuf, 0);
 if ('\0' == gbuf[0]) return SCPE_ARG;                   /* unspecified goto target */
 sprintf(cbuf, "%s %s", sim_do_filename[sim_do_depth], cptr);
@@ -4267,6 +4653,398 @@ fprintf (st, "Asynchronous I/O is not available in this simulator\n");
 return SCPE_OK;
 }
 
+/* I/O statistics
+
+   Disk, tape and ethernet libraries register a SIM_IOSTATS block for
+   each unit (or device) they open and report each completed operation
+   with sim_iostat_done.  The blocks live on a simple registry list so
+   that SHOW <dev> STATISTICS, SHOW IOSTATS and the optional periodic
+   CSV or JSON dump can find them.  All routines accept a NULL block so
+   that callers never need to test whether statistics exist.  Counters
+   are updated from asynchronous I/O and ethernet threads, so they are
+   only touched while holding sim_iostat_lock. */
+
+#define SIM_IOS_DUMP_NONE   0                           /* no periodic dump */
+#define SIM_IOS_DUMP_CSV    1                           /* CSV rows */
+#define SIM_IOS_DUMP_JSON   2                           /* one JSON object per line */
+#define SIM_IOS_DFLT_INTVL  10                          /* default dump interval (secs) */
+
+static SIM_IOSTATS *sim_iostats = NULL;                 /* registry */
+static char *sim_iostat_file = NULL;                    /* dump file name */
+static int32 sim_iostat_fmt = SIM_IOS_DUMP_NONE;        /* dump format */
+static uint32 sim_iostat_interval = SIM_IOS_DFLT_INTVL; /* dump interval (secs) */
+static t_stat sim_iostat_svc (UNIT *uptr);
+static UNIT sim_iostat_unit = { UDATA (&sim_iostat_svc, 0, 0) };
+#if defined (SIM_ASYNCH_IO)
+static pthread_mutex_t sim_iostat_lock = PTHREAD_MUTEX_INITIALIZER;
+#define IOSTAT_LOCK     pthread_mutex_lock (&sim_iostat_lock)
+#define IOSTAT_UNLOCK   pthread_mutex_unlock (&sim_iostat_lock)
+#else
+#define IOSTAT_LOCK
+#define IOSTAT_UNLOCK
+#endif
+
+static const char *sim_iostat_ops[SIM_IOS_OPS] = {
+    "Read", "Write", "Position", "Other" };
+static const char *sim_iostat_buckets[SIM_IOS_HIST] = {
+    "<4us", "<16us", "<64us", "<256us", "<1ms", "<4ms", 
+    "<16ms", "<66ms", "<262ms", "<1s", "<4s", ">=4s" };
+
+SIM_IOSTATS *sim_iostat_open (DEVICE *dptr, UNIT *uptr, const char *type)
+{
+SIM_IOSTATS *ios = (SIM_IOSTATS *)calloc (1, sizeof (*ios));
+SIM_IOSTATS **pios = &sim_iostats;
+
+if (ios == NULL)
+    return NULL;
+ios->dptr = dptr;
+ios->uptr = uptr;
+ios->type = type;
+while (*pios)                                           /* append to preserve attach order */
+    pios = &(*pios)->next;
+*pios = ios;
+return ios;
+}
+
+void sim_iostat_close (SIM_IOSTATS *ios)
+{
+SIM_IOSTATS **pios;
+
+if (ios == NULL)
+    return;
+for (pios = &sim_iostats; *pios; pios = &(*pios)->next) {
+    if (*pios == ios) {
+        *pios = ios->next;
+        break;
+        }
+    }
+free (ios);
+}
+
+/* Host time in microseconds, used as the start time of an operation.
+   Only differences are used, so a monotonic clock is preferred; where
+   there isn't one the millisecond timer is used. */
+
+t_uint64 sim_iostat_time (void)
+{
+#if defined (CLOCK_MONOTONIC) && !defined (NEED_CLOCK_GETTIME)
+struct timespec now;
+
+if (0 == clock_gettime (CLOCK_MONOTONIC, &now))
+    return (((t_uint64)now.tv_sec) * 1000000) + (now.tv_nsec / 1000);
+#endif
+return ((t_uint64)sim_os_msec ()) * 1000;
+}
+
+static void _sim_iostat_add (SIM_IOSTAT *s, t_uint64 start)
+{
+t_uint64 now = sim_iostat_time ();
+t_uint64 usecs = (now > start) ? now - start : 0;
+t_uint64 limit = 4;
+int b = 0;
+
+while ((b < SIM_IOS_HIST - 1) && (usecs >= limit)) {    /* find bucket */
+    ++b;
+    limit <<= 2;
+    }
+++s->hist[b];
+++s->count;
+s->usecs += usecs;
+if (usecs > s->max_usecs)
+    s->max_usecs = (usecs > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)usecs;
+}
+
+void sim_iostat_done (SIM_IOSTATS *ios, int op, t_uint64 start, t_uint64 bytes, t_bool error)
+{
+SIM_IOSTAT *s;
+
+if ((ios == NULL) || (op < 0) || (op >= SIM_IOS_OPS))
+    return;
+s = &ios->op[op];
+IOSTAT_LOCK;
+_sim_iostat_add (s, start);
+s->bytes += bytes;
+if (error)
+    ++s->errors;
+IOSTAT_UNLOCK;
+}
+
+/* Record the delay between an I/O thread finishing a request (start)
+   and the simulator thread consuming its completion */
+
+void sim_iostat_async (SIM_IOSTATS *ios, t_uint64 start)
+{
+if ((ios == NULL) || (start == 0))
+    return;
+IOSTAT_LOCK;
+_sim_iostat_add (&ios->async, start);
+IOSTAT_UNLOCK;
+}
+
+void sim_iostat_queue (SIM_IOSTATS *ios, uint32 depth)
+{
+if (ios == NULL)
+    return;
+IOSTAT_LOCK;
+ios->queue_depth = depth;
+if (depth > ios->queue_max)
+    ios->queue_max = depth;
+ios->queue_sum += depth;
+++ios->queue_samples;
+IOSTAT_UNLOCK;
+}
+
+static void _sim_iostat_reset (SIM_IOSTATS *ios)
+{
+IOSTAT_LOCK;
+memset (ios->op, 0, sizeof (ios->op));
+memset (&ios->async, 0, sizeof (ios->async));
+ios->queue_max = ios->queue_depth;
+ios->queue_sum = ios->queue_samples = 0;
+IOSTAT_UNLOCK;
+}
+
+/* Consistent copy of a block's counters for reporting */
+
+static void _sim_iostat_snapshot (SIM_IOSTATS *ios, SIM_IOSTATS *copy)
+{
+IOSTAT_LOCK;
+*copy = *ios;
+IOSTAT_UNLOCK;
+}
+
+static const char *_sim_iostat_name (SIM_IOSTATS *ios)
+{
+return ios->uptr ? sim_uname (ios->uptr) : sim_dname (ios->dptr);
+}
+
+static double _sim_iostat_avg (t_uint64 sum, t_uint64 count)
+{
+return count ? ((double)sum) / count : 0.0;
+}
+
+static void _sim_iostat_show_one (FILE *st, SIM_IOSTATS *live)
+{
+SIM_IOSTATS copy, *ios = &copy;
+SIM_IOSTAT *s;
+int op, b, shown = 0;
+
+_sim_iostat_snapshot (live, &copy);
+fprintf (st, "%s (%s):\n", _sim_iostat_name (ios), ios->type);
+for (op = 0; op < SIM_IOS_OPS; op++) {
+    s = &ios->op[op];
+    if (s->count == 0)
+        continue;
+    if (++shown == 1)
+        fprintf (st, "  Operation         Count            Bytes   Errors   Avg usecs   Max usecs\n");
+    fprintf (st, "  %-9s %13" LL_FMT "u %16" LL_FMT "u %8" LL_FMT "u %11.1f %11u\n", sim_iostat_ops[op],
+                 (unsigned LL_TYPE)s->count, (unsigned LL_TYPE)s->bytes, (unsigned LL_TYPE)s->errors,
+                 _sim_iostat_avg (s->usecs, s->count), s->max_usecs);
+    fprintf (st, "    Latency:");
+    for (b = 0; b < SIM_IOS_HIST; b++)
+        if (s->hist[b])
+            fprintf (st, " %s:%u", sim_iostat_buckets[b], s->hist[b]);
+    fprintf (st, "\n");
+    }
+if (shown == 0)
+    fprintf (st, "  No operations recorded\n");
+if (ios->async.count)
+    fprintf (st, "  Async completion delay: %" LL_FMT "u completions, avg %.1f usecs, max %u usecs\n",
+                 (unsigned LL_TYPE)ios->async.count, _sim_iostat_avg (ios->async.usecs, ios->async.count), ios->async.max_usecs);
+if (ios->queue_samples)
+    fprintf (st, "  Queue depth: current %u, max %u, avg %.2f\n", 
+                 ios->queue_depth, ios->queue_max, _sim_iostat_avg (ios->queue_sum, ios->queue_samples));
+}
+
+/* SHOW IOSTATS (dptr == NULL), SHOW <dev> STATISTICS (flag == 0) and 
+   SHOW <unit> STATISTICS (flag == 1) */
+
+t_stat sim_show_iostats (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr)
+{
+SIM_IOSTATS *ios;
+int32 shown = 0;
+
+if ((dptr == NULL) && cptr && (*cptr != 0))
+    return SCPE_2MARG;
+for (ios = sim_iostats; ios; ios = ios->next) {
+    if ((dptr != NULL) && (ios->dptr != dptr))
+        continue;
+    if ((dptr != NULL) && flag && (ios->uptr != uptr))
+        continue;
+    _sim_iostat_show_one (st, ios);
+    ++shown;
+    }
+if (shown == 0) {
+    if (dptr == NULL)
+        fprintf (st, "No I/O statistics are being collected\n");
+    else
+        fprintf (st, "No I/O statistics for %s\n", flag ? sim_uname (uptr) : sim_dname (dptr));
+    }
+if ((dptr == NULL) && (sim_iostat_fmt != SIM_IOS_DUMP_NONE))
+    fprintf (st, "Dumping %s statistics to %s every %u seconds\n", 
+                 (sim_iostat_fmt == SIM_IOS_DUMP_CSV) ? "CSV" : "JSON", sim_iostat_file, sim_iostat_interval);
+return SCPE_OK;
+}
+
+static void _sim_iostat_csv_row (FILE *f, const char *when, SIM_IOSTATS *ios, const char *op, SIM_IOSTAT *s)
+{
+int b;
+
+fprintf (f, "%s,%s,%s,%s,%" LL_FMT "u,%" LL_FMT "u,%" LL_FMT "u,%.1f,%u", when, _sim_iostat_name (ios), ios->type, op,
+            (unsigned LL_TYPE)s->count, (unsigned LL_TYPE)s->bytes, (unsigned LL_TYPE)s->errors, 
+            _sim_iostat_avg (s->usecs, s->count), s->max_usecs);
+for (b = 0; b < SIM_IOS_HIST; b++)
+    fprintf (f, ",%u", s->hist[b]);
+fprintf (f, ",%u,%.2f\n", ios->queue_max, _sim_iostat_avg (ios->queue_sum, ios->queue_samples));
+}
+
+static void _sim_iostat_json_op (FILE *f, const char *op, SIM_IOSTAT *s)
+{
+int b;
+
+fprintf (f, "\"%s\":{\"count\":%" LL_FMT "u,\"bytes\":%" LL_FMT "u,\"errors\":%" LL_FMT "u,\"usecs\":%" LL_FMT "u,\"max_usecs\":%u,\"hist\":[",
+            op, (unsigned LL_TYPE)s->count, (unsigned LL_TYPE)s->bytes, (unsigned LL_TYPE)s->errors, 
+            (unsigned LL_TYPE)s->usecs, s->max_usecs);
+for (b = 0; b < SIM_IOS_HIST; b++)
+    fprintf (f, "%s%u", b ? "," : "", s->hist[b]);
+fprintf (f, "]}");
+}
+
+static void _sim_iostat_json_str (FILE *f, const char *str)
+{
+fputc ('"', f);
+for (; *str; str++) {
+    if ((*str == '"') || (*str == '\\'))
+        fprintf (f, "\\%c", *str);
+    else if ((uint8)*str < 0x20)
+        fprintf (f, "\\u%04x", (uint8)*str);
+    else
+        fputc (*str, f);
+    }
+fputc ('"', f);
+}
+
+static t_stat _sim_iostat_dump (void)
+{
+FILE *f;
+SIM_IOSTATS *live, copy, *ios = &copy;
+char when[64];
+int op, b;
+
+if ((sim_iostat_fmt == SIM_IOS_DUMP_NONE) || (sim_iostat_file == NULL))
+    return SCPE_OK;
+f = sim_fopen (sim_iostat_file, "a");
+if (f == NULL)
+    return sim_messagef (SCPE_OPENERR, "Can't open I/O statistics file %s: %s\n", sim_iostat_file, strerror (errno));
+sprintf (when, "%" LL_FMT "d,%.0f", (LL_TYPE)time (NULL), sim_gtime ());
+fseek (f, 0, SEEK_END);
+if (sim_iostat_fmt == SIM_IOS_DUMP_CSV) {
+    if (ftell (f) == 0) {                               /* new file? write header */
+        fprintf (f, "wall_time,sim_time,name,type,op,count,bytes,errors,avg_usecs,max_usecs");
+        for (b = 0; b < SIM_IOS_HIST; b++)
+            fprintf (f, ",%s", sim_iostat_buckets[b]);
+        fprintf (f, ",queue_max,queue_avg\n");
+        }
+    for (live = sim_iostats; live; live = live->next) {
+        _sim_iostat_snapshot (live, &copy);
+        for (op = 0; op < SIM_IOS_OPS; op++)
+            _sim_iostat_csv_row (f, when, ios, sim_iostat_ops[op], &ios->op[op]);
+        _sim_iostat_csv_row (f, when, ios, "Async", &ios->async);
+        }
+    }
+else {
+    fprintf (f, "{\"wall_time\":%" LL_FMT "d,\"sim_time\":%.0f,\"devices\":[", (LL_TYPE)time (NULL), sim_gtime ());
+    for (live = sim_iostats; live; live = live->next) {
+        _sim_iostat_snapshot (live, &copy);
+        fprintf (f, "%s{\"name\":", (live == sim_iostats) ? "" : ",");
+        _sim_iostat_json_str (f, _sim_iostat_name (ios));
+        fprintf (f, ",\"type\":");
+        _sim_iostat_json_str (f, ios->type);
+        fprintf (f, ",");
+        for (op = 0; op < SIM_IOS_OPS; op++) {
+            _sim_iostat_json_op (f, sim_iostat_ops[op], &ios->op[op]);
+            fprintf (f, ",");
+            }
+        _sim_iostat_json_op (f, "Async", &ios->async);
+        fprintf (f, ",\"queue\":{\"depth\":%u,\"max\":%u,\"avg\":%.2f}}", 
+                    ios->queue_depth, ios->queue_max, _sim_iostat_avg (ios->queue_sum, ios->queue_samples));
+        }
+    fprintf (f, "]}\n");
+    }
+fclose (f);
+return SCPE_OK;
+}
+
+static t_stat sim_iostat_svc (UNIT *uptr)
+{
+_sim_iostat_dump ();
+if (sim_iostat_fmt != SIM_IOS_DUMP_NONE)
+    sim_activate_after_d (uptr, 1000000.0 * sim_iostat_interval);
+return SCPE_OK;
+}
+
+/* SET IOSTATS RESET|DUMP|NODUMP|CSV=file|JSON=file|INTERVAL=secs{,...} */
+
+t_stat sim_set_iostats (int32 flag, CONST char *cptr)
+{
+char gbuf[CBUFSIZE];
+char *cvptr;
+SIM_IOSTATS *ios;
+uint32 interval;
+t_stat r;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+while (*cptr != 0) {
+    cptr = get_glyph_nc (cptr, gbuf, ',');
+    if ((cvptr = strchr (gbuf, '=')))
+        *cvptr++ = 0;
+    if (MATCH_CMD (gbuf, "RESET") == 0) {
+        for (ios = sim_iostats; ios; ios = ios->next)
+            _sim_iostat_reset (ios);
+        }
+    else if (MATCH_CMD (gbuf, "DUMP") == 0) {
+        r = _sim_iostat_dump ();
+        if (r != SCPE_OK)
+            return r;
+        }
+    else if (MATCH_CMD (gbuf, "NODUMP") == 0) {
+        sim_iostat_fmt = SIM_IOS_DUMP_NONE;
+        sim_cancel (&sim_iostat_unit);
+        }
+    else if ((MATCH_CMD (gbuf, "CSV") == 0) || (MATCH_CMD (gbuf, "JSON") == 0)) {
+        if ((cvptr == NULL) || (*cvptr == 0))
+            return sim_messagef (SCPE_2FARG, "Missing %s file name\n", gbuf);
+        free (sim_iostat_file);
+        sim_iostat_file = (char *)malloc (1 + strlen (cvptr));
+        if (sim_iostat_file == NULL) {
+            sim_iostat_fmt = SIM_IOS_DUMP_NONE;
+            sim_cancel (&sim_iostat_unit);
+            return SCPE_MEM;
+            }
+        strcpy (sim_iostat_file, cvptr);
+        sim_iostat_fmt = (MATCH_CMD (gbuf, "CSV") == 0) ? SIM_IOS_DUMP_CSV : SIM_IOS_DUMP_JSON;
+        sim_cancel (&sim_iostat_unit);
+        sim_activate_after_d (&sim_iostat_unit, 1000000.0 * sim_iostat_interval);
+        }
+    else if (MATCH_CMD (gbuf, "INTERVAL") == 0) {
+        if ((cvptr == NULL) || (*cvptr == 0))
+            return SCPE_2FARG;
+        interval = (uint32) get_uint (cvptr, 10, 86400, &r);
+        if ((r != SCPE_OK) || (interval == 0))
+            return sim_messagef (SCPE_ARG, "Invalid interval: %s\n", cvptr);
+        sim_iostat_interval = interval;
+        if (sim_iostat_fmt != SIM_IOS_DUMP_NONE) {
+            sim_cancel (&sim_iostat_unit);
+            sim_activate_after_d (&sim_iostat_unit, 1000000.0 * sim_iostat_interval);
+            }
+        }
+    else
+        return sim_messagef (SCPE_ARG, "Unknown IOSTATS option: %s\n", gbuf);
+    }
+return SCPE_OK;
+}
+
 /* Set environment routine */
 
 t_stat sim_set_environment (int32 flag, CONST char *cptr)
@@ -5086,13 +5864,16 @@ else {
             if (uptr == &sim_expect_unit)
                 fprintf (st, "  Expect fired");
             else
-                if ((dptr = find_dev_from_unit (uptr)) != NULL) {
-                    fprintf (st, "  %s", sim_dname (dptr));
-                    if (dptr->numunits > 1)
-                        fprintf (st, " unit %d", (int32) (uptr - dptr->units));
-                    }
+                if (uptr == &sim_iostat_unit)
+                    fprintf (st, "  I/O statistics dump");
                 else
-                    fprintf (st, "  Unknown");
+                    if ((dptr = find_dev_from_unit (uptr)) != NULL) {
+                        fprintf (st, "  %s", sim_dname (dptr));
+                        if (dptr->numunits > 1)
+                            fprintf (st, " unit %d", (int32) (uptr - dptr->units));
+                        }
+                    else
+                        fprintf (st, "  Unknown");
         tim = sim_fmt_secs(((accum + uptr->time) / sim_timer_inst_per_sec ()) + (uptr->usecs_remaining / 1000000.0));
         if (uptr->usecs_remaining)
             fprintf (st, " at %d plus %.0f usecs%s%s%s%s\n", accum + uptr->time, uptr->usecs_remaining,
@@ -5262,6 +6043,31 @@ for (mptr = dptr->modifiers; mptr->mask != 0; mptr++) {
 return SCPE_OK;
 }
 
+/* Show DO script cache statistics */
+
+t_stat show_do_scripts (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr)
+{
+DO_SCRIPT *script;
+
+if (cptr && (*cptr != 0))
+    return SCPE_2MARG;
+if (sim_do_scripts == NULL) {
+    fprintf (st, "No DO scripts have been executed\n");
+    return SCPE_OK;
+    }
+for (script = sim_do_scripts; script; script = script->next) {
+    fprintf (st, "%s%s\n", script->path, script->refs ? " (executing)" : "");
+    fprintf (st, "  Lines:              %d\n", script->line_count);
+    fprintf (st, "  Labels:             %d\n", script->label_count);
+    fprintf (st, "  File Reads:         %u\n", script->loads);
+    fprintf (st, "  Cache Hits:         %u\n", script->hits);
+    fprintf (st, "  Invocations:        %u\n", script->calls);
+    fprintf (st, "  Label Lookups:      %u\n", script->gotos);
+    fprintf (st, "  Commands Executed:  %s\n", sim_fmt_numeric ((double)script->executed));
+    }
+return SCPE_OK;
+}
+
 t_stat show_one_mod (FILE *st, DEVICE *dptr, UNIT *uptr, MTAB *mptr,
     CONST char *cptr, int32 flag)
 {
@@ -5971,6 +6777,103 @@ if (loadfile)
 return reason;
 }
 
+/* Raw dump/load commands
+
+   rawd{ump} {dev} file range   write range to file, one value per location
+   rawl{oad} {dev} file {addr}  load file starting at addr
+
+   Values are stored in SZ_D bytes each, least significant byte first (the
+   layout of an attached memory image), and pass through sim_aval_get and
+   sim_aval_put a block at a time without any symbolic formatting.
+*/
+
+t_stat rawload_cmd (int32 flag, CONST char *cptr)
+{
+char gbuf[CBUFSIZE], rbuf[CBUFSIZE];
+DEVICE *dptr;
+UNIT *uptr;
+FILE *rawfile;
+t_value *blk;
+uint8 *buf;
+t_addr low, high, left, mask;
+size_t sz;
+uint32 i, n, cnt;
+t_stat reason;
+
+cptr = get_sim_opt (CMD_OPT_SW|CMD_OPT_DFT, cptr, &reason);
+if (!cptr)                                              /* error? */
+    return reason;
+if (*cptr == 0)                                         /* must be more */
+    return SCPE_2FARG;
+dptr = sim_dfdev;
+uptr = sim_dfunit;
+if (uptr == NULL)                                       /* got a unit? */
+    return SCPE_NXUN;
+if (uptr->flags & UNIT_DIS)                             /* disabled? */
+    return SCPE_UDIS;
+mask = (t_addr) width_mask[dptr->awidth];
+cptr = get_glyph_nc (cptr, gbuf, 0);                    /* get file name */
+cptr = get_glyph (cptr, rbuf, 0);                       /* get range */
+if (*cptr != 0)
+    return SCPE_2MARG;
+low = 0;
+high = mask;
+if (rbuf[0]) {
+    if ((get_range (dptr, rbuf, &low, &high, dptr->aradix,
+                    (uptr->capac == 0) ? 0 : uptr->capac - dptr->aincr, 0) == NULL))
+        return SCPE_ARG;
+    if (!flag && (strpbrk (rbuf, "-:/") == NULL))       /* load with just a start address? */
+        high = mask;
+    }
+else if (flag)                                          /* dump needs a range */
+    return SCPE_2FARG;
+if ((low > mask) || (high > mask) || (low > high))
+    return SCPE_ARG;
+sz = SZ_D (dptr);
+blk = sim_aval_buffer ();
+buf = (uint8 *)malloc (SIM_AVAL_BLOCK * sz);
+if ((blk == NULL) || (buf == NULL)) {
+    free (buf);
+    return SCPE_MEM;
+    }
+rawfile = sim_fopen (gbuf, flag ? "wb" : "rb");         /* open for wr/rd */
+if (rawfile == NULL) {
+    free (buf);
+    return SCPE_OPENERR;
+    }
+while (1) {
+    left = (high - low) / dptr->aincr;
+    n = (left < SIM_AVAL_BLOCK) ? (uint32)left + 1 : SIM_AVAL_BLOCK;
+    if (flag) {                                         /* dump? */
+        cnt = n;
+        reason = sim_aval_get (blk, low, &cnt, dptr, uptr);
+        for (i = 0; i < cnt; i++) {
+            SZ_STORE (sz, blk[i], buf, i);
+            }
+        if (sim_fwrite (buf, sz, cnt, rawfile) != cnt)
+            reason = SCPE_IOERR;
+        }
+    else {                                              /* load */
+        n = (uint32)sim_fread (buf, sz, n, rawfile);
+        if (n == 0) {
+            reason = ferror (rawfile) ? SCPE_IOERR : SCPE_OK;
+            break;
+            }
+        for (i = 0; i < n; i++) {
+            SZ_LOAD (sz, blk[i], buf, i);
+            }
+        cnt = n;
+        reason = sim_aval_put (blk, low, &cnt, dptr, uptr);
+        }
+    if ((reason != SCPE_OK) || (left < SIM_AVAL_BLOCK))
+        break;
+    low = low + n * dptr->aincr;
+    }
+fclose (rawfile);
+free (buf);
+return reason;
+}
+
 /* Attach command
 
    at[tach] unit file   attach specified unit to file
@@ -6217,6 +7120,9 @@ if ((uptr->flags & UNIT_BUF) && (uptr->filebuf)) {
         }
     uptr->flags = uptr->flags & ~UNIT_BUF;
     }
+if ((uptr->stream_ctx) &&                               /* buffered stream? */
+    (sim_ustream_close (uptr) != SCPE_OK))
+    sim_printf ("%s: I/O error - %s", sim_dname (dptr), strerror (errno));
 uptr->flags = uptr->flags & ~(UNIT_ATT | UNIT_RO);
 free (uptr->filename);
 uptr->filename = NULL;
@@ -7117,6 +8023,73 @@ UPDATE_SIM_TIME;                                        /* update sim time */
 return r | ((sim_switches & SWMASK ('Q')) ? SCPE_NOMESSAGE : 0);
 }
 
+/* Benchmark command
+
+   Runs the loaded program from the current PC for a fixed number of
+   instructions with throttling and idling disabled, then reports the
+   results as name=value lines so that scripts can collect them.
+*/
+
+t_stat benchmark_cmd (int32 flag, CONST char *cptr)
+{
+char gbuf[CBUFSIZE];
+int32 inst = 100000000;
+t_bool idle_enab = sim_idle_enab;
+double start_time, start_ops, insts, ops, cpu_ms;
+uint32 start_ms, wall_ms;
+clock_t start_clk;
+const char *status;
+t_stat r;
+
+GET_SWITCHES (cptr);                                    /* get switches */
+if (*cptr != 0) {                                       /* argument? */
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (*cptr != 0)                                     /* should be end */
+        return SCPE_2MARG;
+    inst = (int32) get_uint (gbuf, 10, INT_MAX, &r);
+    if ((r != SCPE_OK) || (inst <= 0))
+        return sim_messagef (SCPE_ARG, "Invalid instruction count: %s\n", gbuf);
+    }
+sprintf (gbuf, "%d", inst);
+sim_switches = 0;
+sim_idle_enab = FALSE;                                  /* no idling */
+sim_throt_suspend (TRUE);                               /* no throttling */
+start_time = sim_gtime ();
+start_ops = sim_event_ops;
+start_clk = clock ();
+start_ms = sim_os_msec ();
+r = run_cmd (RU_STEP, gbuf);
+wall_ms = sim_os_msec () - start_ms;
+cpu_ms = ((double)(clock () - start_clk) * 1000.0) / CLOCKS_PER_SEC;
+insts = sim_gtime () - start_time;
+ops = sim_event_ops - start_ops;
+sim_throt_suspend (FALSE);
+sim_idle_enab = idle_enab;
+if (SCPE_BARE_STATUS(r) == SCPE_STEP)
+    status = "complete";
+else {
+    run_cmd_message (NULL, r);                          /* say why it stopped */
+    if (SCPE_BARE_STATUS(r) >= SCPE_BASE)
+        status = sim_error_text (r);
+    else if (sim_stop_messages[SCPE_BARE_STATUS(r)])
+        status = sim_stop_messages[SCPE_BARE_STATUS(r)];
+    else status = "stopped";
+    }
+if (wall_ms == 0)
+    wall_ms = 1;
+sim_printf ("simulator=%s\n", sim_name);
+sim_printf ("status=%s\n", status);
+sim_printf ("instructions=%.0f\n", insts);
+sim_printf ("wall_ms=%u\n", wall_ms);
+sim_printf ("cpu_ms=%.0f\n", cpu_ms);
+sim_printf ("mips=%.3f\n", insts / (wall_ms * 1000.0));
+sim_printf ("event_ops=%.0f\n", ops);
+sim_printf ("event_ops_per_sec=%.0f\n", (ops * 1000.0) / wall_ms);
+if ((SCPE_BARE_STATUS(r) >= SCPE_BASE) && (SCPE_BARE_STATUS(r) != SCPE_STEP))
+    return r | SCPE_NOMESSAGE;                          /* error, already reported */
+return SCPE_OK;
+}
+
 /* run command message handler */
 
 void
@@ -7462,6 +8435,30 @@ if (uptr->flags & UNIT_DIS)                             /* disabled? */
 mask = (t_addr) width_mask[dptr->awidth];
 if ((low > mask) || (high > mask) || (low > high))
     return SCPE_ARG;
+if ((flag == EX_E) &&                                   /* plain examine? */
+    ((schptr == NULL) || (schptr->count == 1)))         /* single value search? */
+    return ex_addr_bulk (ofile, schptr, low, high, dptr, uptr);
+if ((flag == EX_D) && (schptr == NULL) && (low < high)) {/* deposit to range? */
+    t_value val;
+    t_stat r;
+    int32 rdx;
+
+    if (uptr->flags & UNIT_RO)                          /* read only? */
+        return SCPE_RO;
+    GET_RADIX (rdx, dptr->dradix);
+    reason = parse_sym ((CONST char *)cptr, low, uptr, sim_eval, sim_switches);
+    sim_switches = saved_switches;
+    val = get_uint (cptr, rdx, width_mask[dptr->dwidth], &r);
+    if (reason > 0) {                                   /* not symbolic? */
+        if (r != SCPE_OK)
+            return r;
+        return dep_addr_fill (val, low, high, dptr, uptr);/* same value everywhere */
+        }
+    if ((r == SCPE_OK) &&                               /* plain number */
+        (reason == (t_stat)(1 - (int32)dptr->aincr)) && /* parsed as one location */
+        ((sim_eval[0] & width_mask[dptr->dwidth]) == val))/* with the same value? */
+        return dep_addr_fill (val, low, high, dptr, uptr);
+    }
 for (i = low; i <= high; ) {                            /* all paths must incr!! */
     reason = get_aval (i, dptr, uptr);                  /* get data */
     sim_switches = saved_switches;
@@ -7833,6 +8830,260 @@ if ((reason != SCPE_OK) && (i == 0))
 return SCPE_OK;
 }
 
+/* Bulk address space access
+
+   sim_aval_get         get consecutive values
+   sim_aval_put         put consecutive values
+
+   Both transfer up to *count values at addr, addr+aincr, ... through the
+   device's examine_range/deposit_range routine when it has one, and
+   otherwise through its examine/deposit routine or directly from or to the
+   attached file or unit buffer.  On return *count holds the number of
+   values transferred and the status is that of the first one which could
+   not be.
+*/
+
+static t_value *sim_aval_blk = NULL;                    /* bulk transfer buffer */
+
+static t_value *sim_aval_buffer (void)
+{
+if (sim_aval_blk == NULL)
+    sim_aval_blk = (t_value *)calloc (SIM_AVAL_BLOCK + sim_emax, sizeof (*sim_aval_blk));
+return sim_aval_blk;
+}
+
+static t_stat sim_aval_get (t_value *vals, t_addr addr, uint32 *count, DEVICE *dptr, UNIT *uptr)
+{
+t_value mask = width_mask[dptr->dwidth];
+uint32 i, n = *count;
+t_addr j, avail;
+size_t sz, got;
+uint8 *buf;
+t_stat reason = SCPE_OK;
+
+*count = 0;
+if (dptr->examine_range != NULL)
+    reason = dptr->examine_range (vals, addr, &n, uptr, sim_switches);
+else if (dptr->examine != NULL) {
+    for (i = 0, j = addr; i < n; i++, j = j + dptr->aincr) {
+        vals[i] = 0;
+        reason = dptr->examine (&vals[i], j, uptr, sim_switches);
+        if (reason != SCPE_OK)
+            break;
+        }
+    n = i;
+    }
+else {
+    if (!(uptr->flags & UNIT_ATT))
+        return SCPE_UNATT;
+    if (uptr->dynflags & UNIT_NO_FIO)
+        return SCPE_NOFNC;
+    if (uptr->flags & UNIT_FIX) {                       /* clip to capacity */
+        if (addr >= uptr->capac)
+            return SCPE_NXM;
+        avail = (uptr->capac - addr + dptr->aincr - 1) / dptr->aincr;
+        if (avail < n) {
+            n = (uint32)avail;
+            reason = SCPE_NXM;
+            }
+        }
+    sz = SZ_D (dptr);
+    j = addr / dptr->aincr;
+    if (uptr->flags & UNIT_BUF) {
+        for (i = 0; i < n; i++) {
+            SZ_LOAD (sz, vals[i], uptr->filebuf, j + i);
+            }
+        }
+    else {
+        if ((buf = (uint8 *)calloc (n, sz)) == NULL)
+            return SCPE_MEM;
+        if (sim_fseek (uptr->fileref, (t_addr)(sz * j), SEEK_SET)) {
+            clearerr (uptr->fileref);
+            free (buf);
+            return SCPE_IOERR;
+            }
+        got = sim_fread (buf, sz, n, uptr->fileref);
+        if (ferror (uptr->fileref)) {
+            clearerr (uptr->fileref);
+            free (buf);
+            return SCPE_IOERR;
+            }
+        if ((got < n) && !(uptr->flags & UNIT_FIX)) {   /* past end of file? */
+            n = (uint32)got;
+            reason = SCPE_EOF;
+            }                                           /* (fixed units read as zero) */
+        for (i = 0; i < n; i++) {
+            SZ_LOAD (sz, vals[i], buf, i);
+            }
+        free (buf);
+        }
+    }
+for (i = 0; i < n; i++)
+    vals[i] = vals[i] & mask;
+*count = n;
+return reason;
+}
+
+static t_stat sim_aval_put (const t_value *vals, t_addr addr, uint32 *count, DEVICE *dptr, UNIT *uptr)
+{
+t_value mask = width_mask[dptr->dwidth];
+uint32 i, n = *count;
+t_addr j, avail;
+size_t sz;
+uint8 *buf;
+t_stat reason = SCPE_OK;
+
+*count = 0;
+if (uptr->flags & UNIT_RO)                              /* read only? */
+    return SCPE_RO;
+if (dptr->deposit_range != NULL)
+    reason = dptr->deposit_range (vals, addr, &n, uptr, sim_switches);
+else if (dptr->deposit != NULL) {
+    for (i = 0, j = addr; i < n; i++, j = j + dptr->aincr) {
+        reason = dptr->deposit (vals[i] & mask, j, uptr, sim_switches);
+        if (reason != SCPE_OK)
+            break;
+        }
+    n = i;
+    }
+else {
+    if (!(uptr->flags & UNIT_ATT))
+        return SCPE_UNATT;
+    if (uptr->dynflags & UNIT_NO_FIO)
+        return SCPE_NOFNC;
+    if (uptr->flags & UNIT_FIX) {                       /* clip to capacity */
+        if (addr >= uptr->capac)
+            return SCPE_NXM;
+        avail = (uptr->capac - addr + dptr->aincr - 1) / dptr->aincr;
+        if (avail < n) {
+            n = (uint32)avail;
+            reason = SCPE_NXM;
+            }
+        }
+    sz = SZ_D (dptr);
+    j = addr / dptr->aincr;
+    if (uptr->flags & UNIT_BUF) {
+        for (i = 0; i < n; i++) {
+            SZ_STORE (sz, vals[i] & mask, uptr->filebuf, j + i);
+            }
+        if ((n > 0) && ((j + n) > uptr->hwmark))
+            uptr->hwmark = (uint32) (j + n);
+        }
+    else {
+        if ((buf = (uint8 *)calloc (n, sz)) == NULL)
+            return SCPE_MEM;
+        for (i = 0; i < n; i++) {
+            SZ_STORE (sz, vals[i] & mask, buf, i);
+            }
+        if (sim_fseek (uptr->fileref, (t_addr)(sz * j), SEEK_SET)) {
+            clearerr (uptr->fileref);
+            free (buf);
+            return SCPE_IOERR;
+            }
+        sim_fwrite (buf, sz, n, uptr->fileref);
+        free (buf);
+        if (ferror (uptr->fileref)) {
+            clearerr (uptr->fileref);
+            return SCPE_IOERR;
+            }
+        }
+    }
+*count = n;
+return reason;
+}
+
+/* Bulk examine
+
+   Examine (and optionally search) a range of addresses a block at a time.
+   Values are fetched SIM_AVAL_BLOCK at a time, a single value search is
+   applied across the block without formatting anything, and only matching
+   locations are passed to ex_addr.  Each block extends sim_emax - 1 values
+   past the range so that instructions starting near its end can be
+   displayed; values which can't be fetched there read as zero, exactly as
+   they do in get_aval.
+*/
+
+static t_stat ex_addr_bulk (FILE *ofile, SCHTAB *schptr, t_addr low, t_addr high,
+    DEVICE *dptr, UNIT *uptr)
+{
+t_value *blk = sim_aval_buffer ();
+t_addr i, base = 0, left, off;
+uint32 j, k, lim, n = 0, want = 0;
+int32 saved_switches = sim_switches;
+t_stat reason;
+
+if (blk == NULL)
+    return SCPE_MEM;
+for (i = low; i <= high; ) {                            /* all paths must incr!! */
+    off = (i - base) / dptr->aincr;
+    if ((n == 0) || (i < base) ||                       /* outside of block? */
+        ((i - base) % dptr->aincr) || (off >= n) ||
+        ((off + sim_emax > n) && (n == want))) {        /* need more lookahead? */
+        left = (high - i) / dptr->aincr;
+        want = ((left < SIM_AVAL_BLOCK) ? (uint32)left + 1 : SIM_AVAL_BLOCK) + sim_emax - 1;
+        n = want;
+        reason = sim_aval_get (blk, i, &n, dptr, uptr);
+        sim_switches = saved_switches;
+        if (n == 0)                                     /* nothing there? */
+            return reason;
+        base = i;
+        off = 0;
+        }
+    k = (uint32)off;
+    if (schptr) {                                       /* searching? */
+        left = (high - i) / dptr->aincr;
+        lim = ((n - k) > left) ? k + (uint32)left + 1 : n;
+        for (j = k; j < lim; j++)
+            if (test_search_value (blk[j], schptr->mask[0], schptr->comp[0],
+                                   schptr->logic, schptr->boolop))
+                break;
+        if (j != k) {                                   /* skipped some? */
+            if ((j == lim) && (lim < n))                /* none left in range? */
+                break;
+            i = base + j * dptr->aincr;
+            continue;
+            }
+        }
+    for (j = 0; j < (uint32)sim_emax; j++)              /* same as get_aval */
+        sim_eval[j] = (k + j < n) ? blk[k + j] : 0;
+    sim_last_val = blk[((k + sim_emax) < n) ? k + sim_emax - 1 : n - 1];
+    reason = ex_addr (ofile, EX_E, i, dptr, uptr);
+    sim_switches = saved_switches;
+    if (reason > SCPE_OK)
+        return reason;
+    i = i + (1 - reason);                               /* incr */
+    }
+return SCPE_OK;
+}
+
+/* Bulk deposit of a single value to a range of addresses */
+
+static t_stat dep_addr_fill (t_value val, t_addr low, t_addr high, DEVICE *dptr,
+    UNIT *uptr)
+{
+t_value *blk = sim_aval_buffer ();
+t_addr left;
+uint32 i, n, cnt;
+t_stat reason;
+
+if (blk == NULL)
+    return SCPE_MEM;
+for (i = 0; i < SIM_AVAL_BLOCK; i++)
+    blk[i] = val;
+while (1) {
+    left = (high - low) / dptr->aincr;
+    n = (left < SIM_AVAL_BLOCK) ? (uint32)left + 1 : SIM_AVAL_BLOCK;
+    cnt = n;
+    reason = sim_aval_put (blk, low, &cnt, dptr, uptr);
+    if (reason != SCPE_OK)
+        return reason;
+    if (left < SIM_AVAL_BLOCK)
+        break;
+    low = low + n * dptr->aincr;
+    }
+return SCPE_OK;
+}
+
 /* Deposit address routine
 
    Inputs:
@@ -9038,6 +10289,7 @@ while (*cptr) {                                         /* loop through modifier
             *st = SCPE_OPENERR;
             return NULL;
             }
+        setvbuf (sim_ofile, NULL, _IOFBF, 65536);       /* large ranges produce a lot of output */
         sim_opt_out |= CMD_OPT_OF;                      /* got output file */
         continue;
         }
@@ -9291,78 +10543,83 @@ return schptr;
 
 int32 test_search (t_value *values, SCHTAB *schptr)
 {
-t_value *val = NULL;
-int32 i, updown;
-int32 ret = 0;
+int32 i;
 
 if (schptr == NULL)
-    return ret;
+    return 0;
+if (schptr->count == 1)                                 /* single value? */
+    return test_search_value (values[0], schptr->mask[0], schptr->comp[0],
+                              schptr->logic, schptr->boolop);
+if ((schptr->boolop == SCH_N) || (schptr->boolop == SCH_NE)) {
+    for (i = (int32)schptr->count - 1; i >= 0; i--) {   /* any word differing passes */
+        if (!test_search_value (values[i], schptr->mask[i], schptr->comp[i],
+                                schptr->logic, SCH_E))
+            return 1;
+        }
+    return 0;
+    }
+for (i = (int32)schptr->count - 1; i >= 0; i--) {       /* all words must pass */
+    if (!test_search_value (values[i], schptr->mask[i], schptr->comp[i],
+                            schptr->logic, schptr->boolop))
+        return 0;
+    }
+return 1;
+}
 
-val = (t_value *)malloc (schptr->count * sizeof (*values));
+/* Test one value against a search specification
 
-for (i=0; i<(int32)schptr->count; i++) {
-    val[i] = values[i];
-    switch (schptr->logic) {                            /* case on logical */
+   Inputs:
+        val    =        value to test
+        mask   =        logical operand
+        comp   =        comparison operand
+        logic  =        logical operator
+        boolop =        comparison operator
+   Outputs:
+        return =        1 if value passes search criteria, 0 if not
 
-        case SCH_OR:
-            val[i] = val[i] | schptr->mask[i];
-            break;
+   The bulk examine path calls this for each value of a block in a plain
+   loop, without formatting the values that don't match.
+*/
 
-        case SCH_AND:
-            val[i] = val[i] & schptr->mask[i];
-            break;
+static SIM_INLINE int32 test_search_value (t_value val, t_value mask, t_value comp,
+    int32 logic, int32 boolop)
+{
+switch (logic) {                                        /* case on logical */
 
-        case SCH_XOR:
-            val[i] = val[i] ^ schptr->mask[i];
-            break;
-            }
-    }
+    case SCH_OR:
+        val = val | mask;
+        break;
 
-ret = 1;
-if (1) {    /* Little Endian VM */
-    updown = -1;
-    i=schptr->count-1;
-    }
-else {      /* Big Endian VM */
-    updown = 1;
-    i=0;
-    }
-for (; (i>=0) && (i<(int32)schptr->count) && ret; i += updown) {
-    switch (schptr->boolop) {                           /* case on comparison */
+    case SCH_AND:
+        val = val & mask;
+        break;
 
-        case SCH_E: case SCH_EE:
-            if (val[i] != schptr->comp[i])
-                ret = 0;
-            break;
+    case SCH_XOR:
+        val = val ^ mask;
+        break;
+        }
 
-        case SCH_N: case SCH_NE:
-            if (val[i] != schptr->comp[i])
-                ret = 0;
-            break;
+switch (boolop) {                                       /* case on comparison */
 
-        case SCH_G:
-            if (val[i] <= schptr->comp[i])
-                ret = 0;
-            break;
+    case SCH_E: case SCH_EE:
+        return (val == comp);
 
-        case SCH_GE:
-            if (val[i] < schptr->comp[i])
-                ret = 0;
-            break;
+    case SCH_N: case SCH_NE:
+        return (val != comp);
 
-        case SCH_L:
-            if (val[i] >= schptr->comp[i])
-                ret = 0;
-            break;
+    case SCH_G:
+        return (val > comp);
 
-        case SCH_LE:
-            if (val[i] > schptr->comp[i])
-                ret = 0;
-            break;
+    case SCH_GE:
+        return (val >= comp);
+
+    case SCH_L:
+        return (val < comp);
+
+    case SCH_LE:
+        return (val <= comp);
         }
-    }
-free (val);
-return ret;
+return 1;
 }
 
 /* Radix independent input/output package
@@ -9674,6 +10931,7 @@ do {
     else
         sim_interval = noqueue_time = NOQUEUE_WAIT;
     sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Processing Event for %s\n", sim_uname (uptr));
+    sim_event_ops = sim_event_ops + 1;
     AIO_EVENT_BEGIN(uptr);
     if (uptr->usecs_remaining)
         reason = sim_timer_activate_after (uptr, uptr->usecs_remaining);
@@ -9750,6 +11008,7 @@ uptr->time = event_time - accum;
 if (cptr != QUEUE_LIST_END)
     cptr->time = cptr->time - uptr->time;
 sim_interval = sim_clock_queue->time;
+sim_event_ops = sim_event_ops + 1;
 return SCPE_OK;
 }
 
@@ -9863,6 +11122,7 @@ sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Canceling Event for %s\n", sim_uname(up
 UPDATE_SIM_TIME;                                        /* update sim time */
 if (!sim_is_active (uptr))
     return SCPE_OK;
+sim_event_ops = sim_event_ops + 1;
 nptr = QUEUE_LIST_END;
 
 if (sim_clock_queue == uptr) {
@@ -11359,6 +12619,7 @@ while (1) {                                         /* format passed string, arg
 if (sim_is_running) {
     char *c, *remnant = buf;
 
+    sim_flush_console ();                           /* keep order with console output */
     while ((c = strchr (remnant, '\n'))) {
         if ((c != buf) && (*(c - 1) != '\r'))
             fprintf (stdout, "%.*s\r\n", (int)(c-remnant), remnant);
@@ -11443,6 +12704,7 @@ if (sim_do_ocptr[sim_do_depth]) {
 if (sim_is_running && !inhibit_message) {
     char *c, *remnant = buf;
 
+    sim_flush_console ();                       /* keep order with console output */
     while ((c = strchr(remnant, '\n'))) {
         if ((c != buf) && (*(c - 1) != '\r'))
             fprintf (stdout, "%.*s\r\n", (int)(c-remnant), remnant);
@@ -11711,7 +12973,7 @@ if (sim_mfile) {
 else {
     va_start (args, fmt);
     if (sim_oline)
-        tmxr_linemsgvf (sim_oline, fmt, args);
+        sim_rem_oline_vprintf (fmt, args);
     else
         ret = vfprintf (f, fmt, args);
     va_end (args);
@@ -75,6 +75,7 @@ t_stat reset_cmd (int32 flag, CONST char *ptr);
 t_stat exdep_cmd (int32 flag, CONST char *ptr);
 t_stat eval_cmd (int32 flag, CONST char *ptr);
 t_stat load_cmd (int32 flag, CONST char *ptr);
+t_stat rawload_cmd (int32 flag, CONST char *ptr);
 t_stat run_cmd (int32 flag, CONST char *ptr);
 void run_cmd_message (const char *unechod_cmdline, t_stat r);
 t_stat attach_cmd (int32 flag, CONST char *ptr);
@@ -104,6 +105,7 @@ t_stat assert_cmd (int32 flag, CONST char *ptr);
 t_stat send_cmd (int32 flag, CONST char *ptr);
 t_stat expect_cmd (int32 flag, CONST char *ptr);
 t_stat sleep_cmd (int32 flag, CONST char *ptr);
+t_stat benchmark_cmd (int32 flag, CONST char *ptr);
 t_stat help_cmd (int32 flag, CONST char *ptr);
 t_stat screenshot_cmd (int32 flag, CONST char *ptr);
 t_stat spawn_cmd (int32 flag, CONST char *ptr);
@@ -276,6 +278,13 @@ void sim_brk_setact (const char *action);
 const char *sim_brk_message(void);
 t_stat sim_send_input (SEND *snd, uint8 *data, size_t size, uint32 after, uint32 delay);
 t_stat sim_show_send_input (FILE *st, const SEND *snd);
+SIM_IOSTATS *sim_iostat_open (DEVICE *dptr, UNIT *uptr, const char *type);
+void sim_iostat_close (SIM_IOSTATS *ios);
+t_uint64 sim_iostat_time (void);
+void sim_iostat_done (SIM_IOSTATS *ios, int op, t_uint64 start, t_uint64 bytes, t_bool error);
+void sim_iostat_async (SIM_IOSTATS *ios, t_uint64 start);
+void sim_iostat_queue (SIM_IOSTATS *ios, uint32 depth);
+t_stat sim_show_iostats (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_bool sim_send_poll_data (SEND *snd, t_stat *stat);
 t_stat sim_send_clear (SEND *snd);
 t_stat sim_set_expect (EXPECT *exp, CONST char *cptr);
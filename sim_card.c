@@ -504,31 +504,30 @@ sim_read_card(UNIT * uptr)
             (data->cbuff)[start++] = (data->cbuff)[ptr++];
         data->len -= data->ptr;
         /* On eof, just return */
-        if (!feof(uptr->fileref) && data->len < 512)
-            len = sim_fread(&data->cbuff[start], 1,
-                            sizeof(data->cbuff) - start, uptr->fileref);
+        if (!sim_ustream_eof(uptr) && data->len < 512)
+            len = sim_ustream_read(uptr, &data->cbuff[start],
+                            sizeof(data->cbuff) - start);
         else
             len = 0;
         data->len += len;
         size = data->len;
     } else {
         /* Load rest of buffer */
-        if (!feof(uptr->fileref)) {
-            len = sim_fread(&data->cbuff[0], 1, sizeof(data->cbuff), uptr->fileref);
+        if (!sim_ustream_eof(uptr)) {
+            len = sim_ustream_read(uptr, &data->cbuff[0], sizeof(data->cbuff));
             size = len;
         } else 
             len = size = 0;
         data->len = size;
     }
 
-    if ((len < 0 || size == 0) && feof(uptr->fileref)) {
+    if ((len < 0 || size == 0) && sim_ustream_eof(uptr)) {
         sim_debug(DEBUG_CARD, dptr, "EOF\n");
         return SCPE_EOF;
     }
 
-    if (ferror(uptr->fileref)) {        /* error? */
+    if (sim_ustream_error(uptr)) {      /* error? */
         perror("Card reader I/O error");
-        clearerr(uptr->fileref);
         return SCPE_IOERR;
     }
 
@@ -814,10 +813,10 @@ sim_card_eof(UNIT *uptr)
     data = (struct _card_data *)uptr->up7;
         
     if (data->ptr > 0) {
-        if ((data->ptr - data->len) == 0 && feof(uptr->fileref))
+        if ((data->ptr - data->len) == 0 && sim_ustream_eof(uptr))
             return 1;
     } else {
-        if (feof(uptr->fileref)) 
+        if (sim_ustream_eof(uptr)) 
            return 1;
     }
     return 0;
@@ -842,7 +841,7 @@ sim_punch_card(UNIT * uptr, UNIT *stkuptr)
     uint8               out[512];
     int                 i;
     int                 outp;
-    FILE                *fo = uptr->fileref;
+    UNIT                *fo = uptr;
     int                 mode = uptr->flags & UNIT_CARD_MODE;
     int                 ok = 1;
     struct _card_data   *data;
@@ -850,7 +849,7 @@ sim_punch_card(UNIT * uptr, UNIT *stkuptr)
 
     if ((uptr->flags & UNIT_ATT) == 0) {
         if (stkuptr != NULL && stkuptr->flags & UNIT_ATT) {
-              fo = stkuptr->fileref;
+              fo = stkuptr;
               if ((stkuptr->flags & UNIT_CARD_MODE) != MODE_AUTO)
                   mode = stkuptr->flags & UNIT_CARD_MODE;
         } else
@@ -986,7 +985,7 @@ sim_punch_card(UNIT * uptr, UNIT *stkuptr)
         }
         break;
     }
-    sim_fwrite(out, 1, outp, fo);
+    sim_ustream_write(fo, out, outp);
     memset(&data->image[0], 0, sizeof(data->image));
     return SCPE_OK;
 }
@@ -131,6 +131,7 @@
 #include "sim_tmxr.h"
 #include "sim_serial.h"
 #include "sim_timer.h"
+#include "sim_frontpanel_shm.h"
 #include <ctype.h>
 #include <math.h>
 
@@ -143,6 +144,7 @@
 static t_stat sim_os_poll_kbd (void);
 static t_bool sim_os_poll_kbd_ready (int ms_timeout);
 static t_stat sim_os_putchar (int32 out);
+static t_stat sim_os_putchars (const char *buf, size_t len);
 static t_stat sim_os_ttinit (void);
 static t_stat sim_os_ttrun (void);
 static t_stat sim_os_ttcmd (void);
@@ -181,9 +183,13 @@ static t_stat sim_con_poll_svc (UNIT *uptr);                /* console connectio
 static t_stat sim_con_reset (DEVICE *dptr);                 /* console reset routine */
 static t_stat sim_con_attach (UNIT *uptr, CONST char *ptr); /* console attach routine (save,restore) */
 static t_stat sim_con_detach (UNIT *uptr);                  /* console detach routine (save,restore) */
+static t_stat sim_con_out_svc (UNIT *uptr);                 /* console output flush routine */
 
-UNIT sim_con_units[2] = {{ UDATA (&sim_con_poll_svc, UNIT_ATTABLE, 0)}}; /* console connection unit */
+UNIT sim_con_units[3] = {{ UDATA (&sim_con_poll_svc, UNIT_ATTABLE, 0)}, /* console connection unit */
+                         { 0 },
+                         { UDATA (&sim_con_out_svc, 0, 0)}};            /* console output flush unit */
 #define sim_con_unit sim_con_units[0]
+#define sim_con_out_unit sim_con_units[2]
 
 /* debugging bitmaps */
 #define DBG_TRC  TMXR_DBG_TRC                           /* trace routine calls */
@@ -226,7 +232,7 @@ return "Console telnet support";
 
 DEVICE sim_con_telnet = {
     "CON-TELNET", sim_con_units, sim_con_reg, sim_con_mod, 
-    2, 0, 0, 0, 0, 0, 
+    3, 0, 0, 0, 0, 0, 
     NULL, NULL, sim_con_reset, NULL, sim_con_attach, sim_con_detach, 
     NULL, DEV_DEBUG | DEV_NOSAVE, 0, sim_con_debug,
     NULL, NULL, NULL, NULL, NULL, sim_con_telnet_description};
@@ -430,12 +436,14 @@ t_stat sim_rem_con_poll_svc (UNIT *uptr);               /* remote console connec
 t_stat sim_rem_con_data_svc (UNIT *uptr);               /* remote console connection data routine */
 t_stat sim_rem_con_repeat_svc (UNIT *uptr);             /* remote auto repeat command console timing routine */
 t_stat sim_rem_con_smp_collect_svc (UNIT *uptr);        /* remote remote register data sampling routine */
+t_stat sim_rem_con_publish_svc (UNIT *uptr);            /* remote register shared memory publishing routine */
 t_stat sim_rem_con_reset (DEVICE *dptr);                /* remote console reset routine */
 #define rem_con_poll_unit (&sim_remote_console.units[0])
 #define rem_con_data_unit (&sim_remote_console.units[1])
 #define REM_CON_BASE_UNITS 2
 #define rem_con_repeat_units (&sim_remote_console.units[REM_CON_BASE_UNITS])
 #define rem_con_smp_smpl_units (&sim_remote_console.units[REM_CON_BASE_UNITS+sim_rem_con_tmxr.lines])
+#define rem_con_pub_units (&sim_remote_console.units[REM_CON_BASE_UNITS+(2*sim_rem_con_tmxr.lines)])
 
 #define DBG_MOD  0x00000004                             /* Remote Console Mode activities */
 #define DBG_REP  0x00000008                             /* Remote Console Repeat activities */
@@ -486,7 +494,18 @@ struct BITSAMPLE_REG {
     uint32          width;          /* number of bits to sample */
     BITSAMPLE       *bits;
     };
+typedef struct PUBLISH_REG PUBLISH_REG;
+struct PUBLISH_REG {
+    REG             *reg;           /* Register to be published */
+    t_bool          indirect;       /* Register value points at memory */
+    DEVICE          *dptr;          /* Device register is part of */
+    UNIT            *uptr;          /* Unit Register is related to */
+    uint32          count;          /* number of array elements */
+    };
 typedef struct REMOTE REMOTE;
+#define REM_CMDQ_MAX    16                      /* max queued commands per session */
+#define REM_EV_INTERRUPT 1                      /* interrupt character (^E) received */
+#define REM_EV_EOF      2                       /* EOF character (^D or ^Z) received */
 struct REMOTE {
     int32           buf_size;
     int32           buf_ptr;
@@ -506,6 +525,21 @@ struct REMOTE {
     int             smp_sample_dither_pct;  /* dithering of cycles interval */
     uint32          smp_reg_count;          /* sample register count */
     BITSAMPLE_REG   *smp_regs;              /* registers being sampled */
+    uint32          pub_interval;           /* usecs between publish updates */
+    uint32          pub_reg_count;          /* published register count */
+    PUBLISH_REG     *pub_regs;              /* registers being published */
+    SHMEM           *pub_shmem;             /* publish shared memory segment */
+    SIM_PANEL_SHM   *pub_shm;               /* published data */
+    char            *outq;                  /* output not yet in the line buffer */
+    size_t          outq_size;              /* allocated size of outq */
+    size_t          outq_len;               /* bytes waiting in outq */
+    uint32          outq_dropped;           /* bytes discarded due to outq overflow */
+    char            *cmdq[REM_CMDQ_MAX];    /* complete command lines awaiting execution */
+    int32           cmdq_head;              /* index of oldest queued command */
+    int32           cmdq_count;             /* number of queued commands */
+    uint32          cmdq_dropped;           /* commands discarded due to cmdq overflow */
+    int32           cmdq_event;             /* interrupt or EOF character received */
+    uint32          input_time;             /* msec time of most recent input */
     };
 REMOTE *sim_rem_consoles = NULL;
 
@@ -522,6 +556,551 @@ static t_bool sim_rem_master_was_enabled = FALSE; /* Master was Enabled */
 static t_bool sim_rem_master_was_connected = FALSE; /* Master Mode has been connected */
 static t_offset sim_rem_cmd_log_start = 0;  /* Log File saved position */
 
+/* Remote console output delivery
+
+   Output destined for a remote console session is appended to a per
+   session queue rather than written directly into the line's transmit
+   buffer.  The queue is moved into the transmit buffer only as space
+   becomes available, so command output larger than the line buffer is
+   no longer silently overwritten, and the simulator never has to sleep
+   waiting for a slow remote client to read its output.
+
+   Input is echoed and edited as it arrives, and complete command lines
+   are placed on a per session command queue which holds at most
+   REM_CMDQ_MAX commands.  Lines arriving when the queue is full are
+   discarded and the client is told so.  The interrupt and EOF characters
+   are reported as a session event which stops further line assembly
+   until sim_rem_con_data_svc has acted on it.
+
+   When asynchronous I/O is available, a separate thread does the socket
+   side of this work: it reads, echoes and assembles input lines and
+   drains the output queues onto the sockets, and schedules the data poll
+   unit as soon as a command or event is waiting rather than after its
+   next 100ms poll interval.  Without the thread, the same work is done
+   each time the data poll unit runs.  Command handling is not moved off
+   the simulator thread: commands are still parsed and executed
+   synchronously in sim_rem_con_data_svc and in sim_remote_process_command
+   (which runs when sim_instr has exited with SCPE_REMOTE), so they only
+   ever run between instructions.  The thread only touches the session
+   queues, the line buffers and the copies of simulator state below, and
+   all such access from either thread (including tests of a line's
+   connection state) is serialized by sim_rem_io_lock.
+*/
+
+#define REM_OUTQ_MAX    (1024*1024)             /* max queued output per session */
+#define REM_IO_POLL_MS  10                      /* I/O thread poll interval */
+
+#if defined(SIM_ASYNCH_IO)
+static pthread_mutex_t sim_rem_io_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_rem_io_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t sim_rem_io_thread;             /* Remote console I/O thread Id */
+static t_bool sim_rem_io_running = FALSE;       /* I/O thread active */
+static t_bool sim_rem_io_wake_pending = FALSE;  /* data poll unit activation requested */
+#define REM_IO_LOCK     pthread_mutex_lock (&sim_rem_io_lock)
+#define REM_IO_UNLOCK   pthread_mutex_unlock (&sim_rem_io_lock)
+#define REM_IO_SIGNAL   pthread_cond_signal (&sim_rem_io_cond)
+#else
+#define REM_IO_LOCK
+#define REM_IO_UNLOCK
+#define REM_IO_SIGNAL
+#endif
+
+/* Simulator state used by the I/O thread.  It can't look at sim_prompt
+   (which SET PROMPT reallocates), sim_is_running, the master mode flag or
+   the active command line while the simulator changes them, so the main
+   thread publishes a copy here, under sim_rem_io_lock, whenever they may
+   have changed. */
+
+static char sim_rem_io_prompt[CBUFSIZE] = "sim> ";  /* copy of sim_prompt */
+static t_bool sim_rem_io_master = FALSE;            /* copy of sim_rem_master_mode */
+static t_bool sim_rem_io_sim_running = FALSE;       /* copy of sim_is_running */
+static t_bool sim_rem_io_cmd_active = FALSE;        /* sim_rem_cmd_active_line != -1 */
+
+void sim_rem_prompt_update (void)
+{
+REM_IO_LOCK;
+strlcpy (sim_rem_io_prompt, sim_prompt ? sim_prompt : "sim> ", sizeof (sim_rem_io_prompt));
+sim_rem_io_master = sim_rem_master_mode;
+sim_rem_io_sim_running = (sim_is_running != 0);
+sim_rem_io_cmd_active = (sim_rem_cmd_active_line != -1);
+REM_IO_UNLOCK;
+}
+
+/* Append data to a session's output queue (caller holds sim_rem_io_lock) */
+
+static void _sim_rem_enqueue (REMOTE *rem, const char *buf, size_t len)
+{
+if (!rem->lp->conn)                                     /* nobody listening? */
+    return;
+if (rem->outq_len + len > REM_OUTQ_MAX) {               /* too much backlog? */
+    rem->outq_dropped += (uint32)len;                   /* discard new data */
+    return;
+    }
+if (rem->outq_len + len > rem->outq_size) {
+    size_t size = rem->outq_size ? rem->outq_size : 4096;
+    char *outq;
+
+    while (size < rem->outq_len + len)
+        size *= 2;
+    outq = (char *)realloc (rem->outq, size);
+    if (outq == NULL) {                                 /* no memory? */
+        rem->outq_dropped += (uint32)len;               /* discard new data */
+        return;
+        }
+    rem->outq = outq;
+    rem->outq_size = size;
+    }
+memcpy (rem->outq + rem->outq_len, buf, len);
+rem->outq_len += len;
+}
+
+/* Move queued output into the line buffer and onto the wire (caller holds
+   sim_rem_io_lock).  Returns the number of bytes still waiting in the queue. */
+
+static size_t _sim_rem_drain (REMOTE *rem)
+{
+TMLN *lp = rem->lp;
+size_t done = 0;
+int32 before;
+
+if (!lp->conn) {                                        /* connection gone? */
+    rem->outq_len = 0;                                  /* nothing to deliver */
+    return 0;
+    }
+while (1) {
+    while ((done < rem->outq_len) &&                    /* room for char (+ IAC)? */
+           (tmxr_tqln (lp) < lp->txbsz - 2))
+        tmxr_putc_ln (lp, (u_char)rem->outq[done++]);
+    before = tmxr_tqln (lp);
+    if ((before == 0) ||
+        (tmxr_send_buffered_data (lp) == before) ||     /* socket not accepting? */
+        (done == rem->outq_len))
+        break;
+    }
+if (done) {
+    rem->outq_len -= done;
+    memmove (rem->outq, rem->outq + done, rem->outq_len);
+    }
+return rem->outq_len;
+}
+
+static REMOTE *_sim_rem_from_line (TMLN *lp)
+{
+return &sim_rem_consoles[(int)(lp - sim_rem_con_tmxr.ldsc)];
+}
+
+static size_t _sim_rem_flush (TMLN *lp)
+{
+size_t pending;
+
+REM_IO_LOCK;
+pending = _sim_rem_drain (_sim_rem_from_line (lp));
+if (pending)
+    REM_IO_SIGNAL;                                      /* let the I/O thread finish */
+REM_IO_UNLOCK;
+return pending;
+}
+
+static void _sim_rem_linemsg (TMLN *lp, const char *msg)
+{
+REM_IO_LOCK;
+_sim_rem_enqueue (_sim_rem_from_line (lp), msg, strlen (msg));
+REM_IO_UNLOCK;
+}
+
+/* Formatted output with the same newline expansion as tmxr_linemsgvf */
+
+static void _sim_rem_linemsgvf (TMLN *lp, const char *fmt, va_list arglist)
+{
+char stackbuf[STACKBUFSIZE];
+int32 bufsize = sizeof(stackbuf);
+char *buf = stackbuf;
+REMOTE *rem = _sim_rem_from_line (lp);
+int32 i, start, len;
+
+buf[bufsize-1] = '\0';
+while (1) {                                         /* format passed string, args */
+    va_list args;
+
+    va_copy (args, arglist);
+#if defined(NO_vsnprintf)
+    len = vsprintf (buf, fmt, args);
+#else                                               /* !defined(NO_vsnprintf) */
+    len = vsnprintf (buf, bufsize-1, fmt, args);
+#endif                                              /* NO_vsnprintf */
+    va_end (args);
+    if ((len < 0) || (len >= bufsize-1)) {
+        if (buf != stackbuf)
+            free (buf);
+        bufsize = bufsize * 2;
+        if (bufsize < len + 2)
+            bufsize = len + 2;
+        buf = (char *) malloc (bufsize);
+        if (buf == NULL)                            /* out of memory */
+            return;
+        buf[bufsize-1] = '\0';
+        continue;
+        }
+    break;
+    }
+REM_IO_LOCK;
+for (i = start = 0; i < len; ++i) {
+    if (('\n' == buf[i]) && ((i == 0) || ('\r' != buf[i-1]))) {
+        _sim_rem_enqueue (rem, buf + start, i - start);
+        _sim_rem_enqueue (rem, "\r", 1);
+        start = i;
+        }
+    }
+_sim_rem_enqueue (rem, buf + start, len - start);
+REM_IO_SIGNAL;
+REM_IO_UNLOCK;
+if (buf != stackbuf)
+    free (buf);
+}
+
+static void _sim_rem_linemsgf (TMLN *lp, const char *fmt, ...)
+{
+va_list arglist;
+
+va_start (arglist, fmt);
+_sim_rem_linemsgvf (lp, fmt, arglist);
+va_end (arglist);
+}
+
+/* Output directed at sim_oline by sim_printf and friends */
+
+void sim_rem_oline_vprintf (const char *fmt, va_list arglist)
+{
+if ((sim_oline >= sim_rem_con_tmxr.ldsc) &&
+    (sim_oline < sim_rem_con_tmxr.ldsc + sim_rem_con_tmxr.lines))
+    _sim_rem_linemsgvf (sim_oline, fmt, arglist);
+else
+    tmxr_linemsgvf (sim_oline, fmt, arglist);
+}
+
+/* Discard queued commands, events and partial input (caller holds
+   sim_rem_io_lock) */
+
+static void _sim_rem_cmdq_clear (REMOTE *rem)
+{
+while (rem->cmdq_count) {
+    free (rem->cmdq[rem->cmdq_head]);
+    rem->cmdq_head = (rem->cmdq_head + 1) % REM_CMDQ_MAX;
+    --rem->cmdq_count;
+    }
+rem->cmdq_head = 0;
+rem->cmdq_event = 0;
+rem->buf_ptr = 0;
+}
+
+/* Queue the assembled input line as a command (caller holds sim_rem_io_lock) */
+
+static void _sim_rem_cmdq_put (REMOTE *rem)
+{
+static const char *full = "Command queue full.  Command ignored\r\n";
+char *cmd = NULL;
+
+rem->buf[rem->buf_ptr] = '\0';
+rem->buf_ptr = 0;
+if (rem->cmdq_count < REM_CMDQ_MAX)
+    cmd = (char *)malloc (strlen (rem->buf) + 1);
+if (cmd == NULL) {                                      /* queue full or no memory? */
+    ++rem->cmdq_dropped;
+    _sim_rem_enqueue (rem, full, strlen (full));
+    return;
+    }
+strcpy (cmd, rem->buf);
+rem->cmdq[(rem->cmdq_head + rem->cmdq_count) % REM_CMDQ_MAX] = cmd;
+++rem->cmdq_count;
+}
+
+/* Echo, edit and assemble arriving input into command lines (caller holds
+   sim_rem_io_lock).  Assembly stops while an event is pending so that
+   input which follows an interrupt or EOF character is interpreted in
+   the session mode which results from it. */
+
+static void _sim_rem_collect (REMOTE *rem)
+{
+TMLN *lp = rem->lp;
+int32 c;
+char ch;
+
+while (lp->conn && (rem->cmdq_event == 0)) {
+    c = tmxr_getc_ln (lp);
+    if (!(TMXR_VALID & c))
+        break;
+    c = c & ~TMXR_VALID;
+    rem->input_time = sim_os_msec ();
+    if (rem->buf_ptr + 2 >= rem->buf_size) {
+        char *buf = (char *)realloc (rem->buf, rem->buf_size + 1024);
+
+        if (buf == NULL)                                /* no memory? */
+            break;
+        rem->buf = buf;
+        rem->buf_size += 1024;
+        }
+    if (rem->single_mode && (rem->buf_ptr == 0)) {      /* first character of a single command? */
+        if (c == sim_int_char) {                        /* ^E (the interrupt character) starts multi command mode */
+            rem->cmdq_event = REM_EV_INTERRUPT;
+            break;
+            }
+        if ((c == '\n') ||                              /* Ignore bare LF between commands (Microsoft Telnet bug) */
+            (c == '\r'))                                /* Ignore empty commands */
+            continue;
+        if ((c != '\004') && (c != '\032')) {
+            const char *prompt = sim_rem_io_prompt;
+
+            if (sim_rem_io_master && (rem->line == 0))
+                prompt = sim_rem_io_sim_running ? "SIM> " : "sim> ";
+            _sim_rem_enqueue (rem, "\r\n", 2);
+            _sim_rem_enqueue (rem, prompt, strlen (prompt));
+            }
+        }
+    switch (c) {
+        case 0:     /* no data */
+            break;
+        case '\b':  /* Backspace */
+        case 127:   /* Rubout */
+            if (rem->buf_ptr > 0) {
+                _sim_rem_enqueue (rem, "\b \b", 3);
+                --rem->buf_ptr;
+                }
+            break;
+        case 27:   /* escape */
+        case 21:   /* ^U */
+            while (rem->buf_ptr > 0) {
+                _sim_rem_enqueue (rem, "\b \b", 3);
+                --rem->buf_ptr;
+                }
+            break;
+        case '\n':
+            if (rem->buf_ptr == 0)
+                break;
+        case '\r':
+            _sim_rem_enqueue (rem, "\r\n", 2);
+            _sim_rem_cmdq_put (rem);
+            break;
+        case '\004': /* EOF (^D) */
+        case '\032': /* EOF (^Z) */
+            while (rem->buf_ptr > 0) {                  /* Erase current input line */
+                _sim_rem_enqueue (rem, "\b \b", 3);
+                --rem->buf_ptr;
+                }
+            rem->cmdq_event = REM_EV_EOF;
+            break;
+        default:
+            ch = (char)c;
+            _sim_rem_enqueue (rem, &ch, 1);
+            rem->buf[rem->buf_ptr++] = ch;
+            if (rem->buf_ptr >= 4*CBUFSIZE)             /* command too long */
+                _sim_rem_cmdq_put (rem);
+            break;
+        }
+    }
+}
+
+/* Take the next queued command.  The caller frees the result. */
+
+static char *_sim_rem_cmdq_get (REMOTE *rem)
+{
+char *cmd = NULL;
+
+REM_IO_LOCK;
+if (rem->cmdq_count) {
+    cmd = rem->cmdq[rem->cmdq_head];
+    rem->cmdq_head = (rem->cmdq_head + 1) % REM_CMDQ_MAX;
+    --rem->cmdq_count;
+    }
+REM_IO_UNLOCK;
+return cmd;
+}
+
+static t_bool _sim_rem_cmdq_pending (REMOTE *rem)
+{
+t_bool pending;
+
+REM_IO_LOCK;
+pending = (rem->cmdq_count != 0);
+REM_IO_UNLOCK;
+return pending;
+}
+
+/* Take a pending event once every command queued ahead of it is done.
+   The interrupt event switches the session to multi command mode before
+   line assembly resumes. */
+
+static int32 _sim_rem_cmdq_event (REMOTE *rem)
+{
+int32 event = 0;
+
+REM_IO_LOCK;
+if (rem->cmdq_count == 0) {
+    event = rem->cmdq_event;
+    rem->cmdq_event = 0;
+    if (event == REM_EV_INTERRUPT)
+        rem->single_mode = FALSE;
+    }
+REM_IO_UNLOCK;
+return event;
+}
+
+/* Erase any partially entered input line */
+
+static void _sim_rem_erase_input (REMOTE *rem)
+{
+REM_IO_LOCK;
+while (rem->buf_ptr > 0) {
+    _sim_rem_enqueue (rem, "\b \b", 3);
+    --rem->buf_ptr;
+    }
+REM_IO_UNLOCK;
+}
+
+/* Milliseconds since start or since the most recent input, whichever is less */
+
+static uint32 _sim_rem_idle_msec (REMOTE *rem, uint32 start)
+{
+uint32 now = sim_os_msec ();
+uint32 idle;
+
+REM_IO_LOCK;
+idle = now - rem->input_time;
+REM_IO_UNLOCK;
+return (idle < (now - start)) ? idle : (now - start);
+}
+
+static void _sim_rem_single_mode (REMOTE *rem, t_bool single)
+{
+REM_IO_LOCK;
+rem->single_mode = single;
+REM_IO_UNLOCK;
+}
+
+static t_bool _sim_rem_connected (TMLN *lp)
+{
+t_bool conn;
+
+REM_IO_LOCK;
+conn = (lp->conn != 0);
+REM_IO_UNLOCK;
+return conn;
+}
+
+/* Poll for input, assemble commands and move along any queued output */
+
+static void _sim_rem_poll_rx (void)
+{
+int32 i;
+
+REM_IO_LOCK;
+tmxr_poll_rx (&sim_rem_con_tmxr);
+for (i = 0; i < sim_rem_con_tmxr.lines; i++) {
+    REMOTE *rem = &sim_rem_consoles[i];
+
+    if (!rem->lp->conn)
+        continue;
+    _sim_rem_collect (rem);
+    if (rem->outq_len || tmxr_tqln (rem->lp))
+        _sim_rem_drain (rem);
+    }
+REM_IO_UNLOCK;
+}
+
+/* Deliver what can be delivered and then drop the session */
+
+static void _sim_rem_reset_ln (TMLN *lp)
+{
+REMOTE *rem = _sim_rem_from_line (lp);
+
+REM_IO_LOCK;
+_sim_rem_drain (rem);
+rem->outq_len = 0;
+_sim_rem_cmdq_clear (rem);
+tmxr_reset_ln (lp);
+REM_IO_UNLOCK;
+}
+
+#if defined(SIM_ASYNCH_IO)
+static void *_sim_rem_io_svc (void *arg)
+{
+struct timespec deadline;
+int32 i;
+
+REM_IO_LOCK;
+while (sim_rem_io_running) {
+    t_bool input = FALSE;
+
+    tmxr_poll_rx (&sim_rem_con_tmxr);                   /* poll input */
+    for (i = 0; i < sim_rem_con_tmxr.lines; i++) {
+        REMOTE *rem = &sim_rem_consoles[i];
+
+        if (!rem->lp->conn)
+            continue;
+        _sim_rem_collect (rem);
+        if (rem->outq_len || tmxr_tqln (rem->lp))
+            _sim_rem_drain (rem);
+        if (rem->cmdq_count || rem->cmdq_event)
+            input = TRUE;
+        }
+    if (input && sim_rem_io_sim_running &&              /* command while running and */
+        !sim_rem_io_cmd_active &&                       /* no command in progress and */
+        !sim_rem_io_wake_pending) {                     /* not already requested? */
+        sim_rem_io_wake_pending = TRUE;
+        REM_IO_UNLOCK;
+        sim_activate_abs (rem_con_data_unit, 0);        /* process input now */
+        REM_IO_LOCK;
+        }
+    clock_gettime (CLOCK_REALTIME, &deadline);       /* wait for work or timeout */
+    deadline.tv_nsec += REM_IO_POLL_MS * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_nsec -= 1000000000;
+        ++deadline.tv_sec;
+        }
+    if (sim_rem_io_running)
+        pthread_cond_timedwait (&sim_rem_io_cond, &sim_rem_io_lock, &deadline);
+    }
+for (i = 0; i < sim_rem_con_tmxr.lines; i++)            /* last chance delivery */
+    _sim_rem_drain (&sim_rem_consoles[i]);
+REM_IO_UNLOCK;
+return NULL;
+}
+#endif
+
+static void _sim_rem_io_start (void)
+{
+#if defined(SIM_ASYNCH_IO)
+pthread_attr_t attr;
+
+sim_rem_prompt_update ();
+REM_IO_LOCK;
+if (!sim_rem_io_running) {
+    sim_rem_io_running = TRUE;
+    sim_rem_io_wake_pending = FALSE;
+    pthread_attr_init (&attr);
+    pthread_attr_setscope (&attr, PTHREAD_SCOPE_SYSTEM);
+    if (pthread_create (&sim_rem_io_thread, &attr, _sim_rem_io_svc, NULL))
+        sim_rem_io_running = FALSE;                     /* fall back to polled delivery */
+    pthread_attr_destroy (&attr);
+    }
+REM_IO_UNLOCK;
+#endif
+}
+
+static void _sim_rem_io_stop (void)
+{
+#if defined(SIM_ASYNCH_IO)
+REM_IO_LOCK;
+if (sim_rem_io_running) {
+    sim_rem_io_running = FALSE;
+    REM_IO_SIGNAL;
+    REM_IO_UNLOCK;
+    pthread_join (sim_rem_io_thread, NULL);
+    return;
+    }
+REM_IO_UNLOCK;
+#endif
+}
+
 static t_stat sim_rem_sample_output (FILE *st, int32 line)
 {
 REMOTE *rem = &sim_rem_consoles[line];
@@ -592,15 +1171,37 @@ if (!sim_rem_con_tmxr.master)
 else {
     fprintf (st, "Remote Console Command Input listening on TCP port: %s\n", rem_con_poll_unit->filename);
     fprintf (st, "Remote Console Per Command Output buffer size:      %d bytes\n", sim_rem_con_tmxr.buffered);
+#if defined(SIM_ASYNCH_IO)
+    if (sim_rem_io_running)
+        fprintf (st, "Remote Console Output is delivered by a background thread\n");
+#endif
     }
 for (i=connections=0; i<sim_rem_con_tmxr.lines; i++) {
+    t_bool conn;
+    size_t outq_len;
+    uint32 outq_dropped, cmdq_dropped;
+    int32 cmdq_count;
+
     rem = &sim_rem_consoles[i];
-    if (!rem->lp->conn)
+    REM_IO_LOCK;
+    conn = (rem->lp->conn != 0);
+    if (conn) {
+        ++connections;
+        if (connections == 1)
+            fprintf (st, "Remote Console Connections:\n");
+        tmxr_fconns (st, rem->lp, i);
+        }
+    outq_len = rem->outq_len;
+    outq_dropped = rem->outq_dropped;
+    cmdq_count = rem->cmdq_count;
+    cmdq_dropped = rem->cmdq_dropped;
+    REM_IO_UNLOCK;
+    if (!conn)
         continue;
-    ++connections;
-    if (connections == 1)
-        fprintf (st, "Remote Console Connections:\n");
-    tmxr_fconns (st, rem->lp, i);
+    if (outq_len || outq_dropped)
+        fprintf (st, "Remote Console Output pending: %d bytes, discarded: %u bytes\n", (int)outq_len, outq_dropped);
+    if (cmdq_count || cmdq_dropped)
+        fprintf (st, "Remote Console Commands queued: %d, discarded: %u\n", cmdq_count, cmdq_dropped);
     if (rem->read_timeout != sim_rem_read_timeout) {
         if (rem->read_timeout)
             fprintf (st, "Remote Console Input on connection %d automatically continues after %d seconds\n", i, rem->read_timeout);
@@ -632,6 +1233,19 @@ for (i=connections=0; i<sim_rem_con_tmxr.lines; i++) {
         if (sim_switches & SWMASK ('D'))
             sim_rem_sample_output (st, rem->line);
         }
+    if (rem->pub_shm) {
+        uint32 reg;
+
+        fprintf (st, "Registers are published to shared memory every %s\n", sim_fmt_secs (rem->pub_interval / 1000000.0));
+        fprintf (st, " Registers being published are: ");
+        for (reg = 0; reg < rem->pub_reg_count; reg++) {
+            fprintf (st, "%s%s %s", rem->pub_regs[reg].indirect ? "indirect " : "", rem->pub_regs[reg].dptr->name, rem->pub_regs[reg].reg->name);
+            if (rem->pub_regs[reg].count > 1)
+                fprintf (st, "[%d]", rem->pub_regs[reg].count);
+            fprintf (st, "%s", ((reg + 1) < rem->pub_reg_count) ? ", " : "");
+            }
+        fprintf (st, "%s\n", rem->smp_reg_count ? " plus bit sample totals" : "");
+        }
     }
 return SCPE_OK;
 }
@@ -642,16 +1256,24 @@ t_stat sim_rem_con_poll_svc (UNIT *uptr)
 {
 int32 c;
 
+REM_IO_LOCK;
 c = tmxr_poll_conn (&sim_rem_con_tmxr);
+if (c >= 0) {                                           /* new session starts */
+    REMOTE *rem = &sim_rem_consoles[c];
+
+    rem->outq_len = 0;                                  /*  with an empty output queue */
+    rem->outq_dropped = 0;
+    _sim_rem_cmdq_clear (rem);                          /*  and empty command queue */
+    rem->cmdq_dropped = 0;
+    rem->single_mode = !(sim_rem_master_mode && (c == 0));/* master session starts in multi-command mode */
+    }
+REM_IO_UNLOCK;
 if (c >= 0) {                                           /* poll connect */
     REMOTE *rem = &sim_rem_consoles[c];
     TMLN *lp = rem->lp;
     char wru_name[8];
 
     sim_activate_after(uptr+1, 1000000);                /* start data poll after 1 second */
-    lp->rcve = 1;                                       /* rcv enabled */
-    rem->buf_ptr = 0;                                   /* start with empty command buffer */
-    rem->single_mode = TRUE;                            /* start in single command mode */
     rem->read_timeout = sim_rem_read_timeout;           /* Start with default timeout */
     if (isprint(sim_int_char&0xFF))
         sprintf(wru_name, "'%c'", sim_int_char&0xFF);
@@ -660,14 +1282,15 @@ if (c >= 0) {                                           /* poll connect */
             sprintf(wru_name, "^%c", '@' + (sim_int_char&0xFF));
         else
             sprintf(wru_name, "'\\%03o'", sim_int_char&0xFF);
-    tmxr_linemsgf (lp, "%s Remote Console\r\n"
+    _sim_rem_linemsgf (lp, "%s Remote Console\r\n"
                        "Enter single commands or to enter multiple command mode enter the %s character\r"
                        "%s",
                        sim_name, wru_name, 
                        ((sim_rem_master_mode && (c == 0)) ? "" : "\nSimulator Running..."));
-    if (sim_rem_master_mode && (c == 0))                /* Master Mode session? */
-        rem->single_mode = FALSE;                       /*  start in multi-command mode */
-    tmxr_send_buffered_data (lp);                       /* flush buffered data */
+    REM_IO_LOCK;
+    lp->rcve = 1;                                       /* rcv enabled */
+    REM_IO_UNLOCK;
+    _sim_rem_flush (lp);                                /* flush buffered data */
     }
 sim_activate_after(uptr, 1000000);                      /* check again in 1 second */
 if (sim_con_ldsc.conn)
@@ -705,6 +1328,11 @@ static t_stat x_run_cmd (int32 flag, CONST char *cptr)
 return 6+SCPE_IERR;         /* This routine should never be called */
 }
 
+static t_stat x_publish_cmd (int32 flag, CONST char *cptr)
+{
+return 7+SCPE_IERR;         /* This routine should never be called */
+}
+
 static t_stat x_help_cmd (int32 flag, CONST char *cptr);
 
 static CTAB allowed_remote_cmds[] = {
@@ -719,6 +1347,7 @@ static CTAB allowed_remote_cmds[] = {
     { "REPEAT",   &x_repeat_cmd,      0 },
     { "COLLECT",  &x_collect_cmd,     0 },
     { "SAMPLEOUT",&x_sampleout_cmd,   0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { "STEP",     &x_step_cmd,        0 },
     { "PWD",      &pwd_cmd,           0 },
     { "SAVE",     &save_cmd,          0 },
@@ -743,6 +1372,7 @@ static CTAB allowed_master_remote_cmds[] = {
     { "REPEAT",   &x_repeat_cmd,      0 },
     { "COLLECT",  &x_collect_cmd,     0 },
     { "SAMPLEOUT",&x_sampleout_cmd,   0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { "STEP",     &x_step_cmd,        0 },
     { "PWD",      &pwd_cmd,           0 },
     { "SAVE",     &save_cmd,          0 },
@@ -774,6 +1404,7 @@ static CTAB allowed_single_remote_cmds[] = {
     { "REPEAT",   &x_repeat_cmd,      0 },
     { "COLLECT",  &x_collect_cmd,     0 },
     { "SAMPLEOUT",&x_sampleout_cmd,   0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { "PWD",      &pwd_cmd,           0 },
     { "DIR",      &dir_cmd,           0 },
     { "LS",       &dir_cmd,           0 },
@@ -787,6 +1418,7 @@ static CTAB remote_only_cmds[] = {
     { "REPEAT",   &x_repeat_cmd,      0 },
     { "COLLECT",  &x_collect_cmd,     0 },
     { "SAMPLEOUT",&x_sampleout_cmd,   0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { NULL,       NULL }
     };
 
@@ -835,27 +1467,17 @@ static void _sim_rem_log_out (TMLN *lp)
 {
 char cbuf[4*CBUFSIZE];
 REMOTE *rem = &sim_rem_consoles[(int)(lp - sim_rem_con_tmxr.ldsc)];
-int line = rem->line;
 
 if ((!sim_oline) && (sim_log)) {
     fflush (sim_log);
     sim_fseeko (sim_log, sim_rem_cmd_log_start, SEEK_SET);
     cbuf[sizeof(cbuf)-1] = '\0';
     while (fgets (cbuf, sizeof(cbuf)-1, sim_log))
-        tmxr_linemsgf (lp, "%s", cbuf);
+        _sim_rem_linemsgf (lp, "%s", cbuf);
     }
 sim_oline = NULL;
-if ((rem->act == NULL) && 
-    (!tmxr_input_pending_ln (lp))) {
-    int32 unwritten;
-
-    do {
-        unwritten = tmxr_send_buffered_data (lp);
-        if (unwritten == lp->txbsz)
-            sim_os_ms_sleep (100);
-        } while (unwritten == lp->txbsz);
-    }
-
+if (rem->act == NULL)                           /* start output on its way, the rest */
+    _sim_rem_flush (lp);                        /*  is sent as the line accepts it */
 }
 
 void sim_remote_process_command (void)
@@ -895,7 +1517,7 @@ static char *sim_rem_clract (int32 line)
 {
 REMOTE *rem = &sim_rem_consoles[line];
 
-tmxr_send_buffered_data (rem->lp);              /* flush any buffered data */
+_sim_rem_flush (rem->lp);                       /* flush any buffered data */
 return rem->act = NULL;
 }
 
@@ -1191,6 +1813,20 @@ else {
         sim_rem_collect_cmd_setup (line, &cptr);/* Cleanup mess */
         return stat;
         }
+    if (rem->pub_shm != NULL) {                 /* publishing? segment size is fixed */
+        uint32 i, slots = 0;
+
+        for (i = 0; i < rem->pub_reg_count; i++)
+            slots += rem->pub_regs[i].count;
+        for (i = 0; i < rem->smp_reg_count; i++)
+            slots += 1 + rem->smp_regs[i].width;
+        if (slots > rem->pub_shm->count) {
+            *iptr = cptr;
+            cptr = strcpy (gbuf, "STOP");
+            sim_rem_collect_cmd_setup (line, &cptr);/* Cleanup mess */
+            return sim_messagef (SCPE_ARG, "Bit sample totals don't fit the published segment, PUBLISH STOP first\n");
+            }
+        }
     if (rem->smp_sample_dither_pct)
         event_time = (((rand() % (2 * rem->smp_sample_dither_pct)) - rem->smp_sample_dither_pct) * event_time) / 100;
     sim_activate (&rem_con_smp_smpl_units[rem->line], event_time);
@@ -1282,6 +1918,187 @@ if (rem->smp_sample_interval && (rem->smp_reg_count != 0)) {
 return SCPE_OK;
 }
 
+static void sim_rem_publish_registers (REMOTE *rem)
+{
+SIM_PANEL_SHM *shm = rem->pub_shm;
+uint32 i, j, slot = 0;
+
+if (shm == NULL)
+    return;
+++shm->sequence;                                /* odd: update in progress */
+SIM_PANEL_SHM_BARRIER ();
+shm->simulation_time = (unsigned long long)sim_gtime ();
+for (i = 0; i < rem->pub_reg_count; i++) {
+    PUBLISH_REG *preg = &rem->pub_regs[i];
+
+    for (j = 0; j < preg->count; j++) {
+        t_value val = get_rval (preg->reg, j);
+
+        if (preg->indirect)                     /* memory value pointed to */
+            val = (SCPE_OK == get_aval ((t_addr)val, preg->dptr, preg->uptr)) ? sim_eval[0] : 0;
+        shm->values[slot++] = (unsigned long long)val;
+        }
+    }
+for (i = 0; i < rem->smp_reg_count; i++) {      /* append bit sample totals */
+    BITSAMPLE_REG *sreg = &rem->smp_regs[i];
+
+    if ((slot + 1 + sreg->width) > shm->count)  /* collection changed since PUBLISH? */
+        break;
+    shm->values[slot++] = sreg->width;
+    for (j = 0; j < sreg->width; j++)
+        shm->values[slot++] = (unsigned long long)sreg->bits[j].tot;
+    }
+SIM_PANEL_SHM_BARRIER ();
+++shm->sequence;                                /* even: update complete */
+}
+
+/* 
+    Parse and setup Remote Console PUBLISH command:
+       PUBLISH EVERY nnn USECS name {-I }{dev }reg{[count]}{,...}
+       PUBLISH STOP
+ */
+static t_stat sim_rem_publish_cmd_setup (int32 line, CONST char **iptr)
+{
+char gbuf[CBUFSIZE], name[CBUFSIZE];
+int32 usecs;
+uint32 i, count;
+t_stat stat = SCPE_OK;
+CONST char *cptr = *iptr;
+CONST char *tptr;
+REMOTE *rem = &sim_rem_consoles[line];
+void *shmaddr;
+
+sim_debug (DBG_REP, &sim_remote_console, "Publish Setup: %s\n", cptr);
+if (*cptr == 0)         /* required argument? */
+    return SCPE_2FARG;
+cptr = get_glyph (cptr, gbuf, 0);               /* get next glyph */
+if (MATCH_CMD (gbuf, "STOP") == 0) {
+    *iptr = cptr;
+    if (*cptr != 0)
+        return SCPE_2MARG;
+    sim_cancel (&rem_con_pub_units[line]);
+    rem->pub_interval = 0;
+    free (rem->pub_regs);
+    rem->pub_regs = NULL;
+    rem->pub_reg_count = 0;
+    sim_shmem_close (rem->pub_shmem);
+    rem->pub_shmem = NULL;
+    rem->pub_shm = NULL;
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "EVERY") != 0) {
+    *iptr = cptr;
+    return sim_messagef (SCPE_ARG, "Expected EVERY or STOP found: %s\n", gbuf);
+    }
+cptr = get_glyph (cptr, gbuf, 0);               /* get next glyph */
+usecs = (int32) get_uint (gbuf, 10, INT_MAX, &stat);
+if ((stat != SCPE_OK) || (usecs <= 0)) {        /* error? */
+    *iptr = cptr;
+    return sim_messagef (SCPE_ARG, "Expected value found: %s\n", gbuf);
+    }
+cptr = get_glyph (cptr, gbuf, 0);               /* get next glyph */
+if ((MATCH_CMD (gbuf, "USECS") != 0) || (*cptr == 0)) {
+    *iptr = cptr;
+    return sim_messagef (SCPE_ARG, "Expected USECS found: %s\n", gbuf);
+    }
+cptr = get_glyph_nc (cptr, name, 0);            /* segment name (case sensitive) */
+tptr = strcpy (gbuf, "STOP");                   /* Start from a clean slate */
+sim_rem_publish_cmd_setup (line, &tptr);
+while (*cptr) {
+    const char *comma = strchr (cptr, ',');
+    char tbuf[2*CBUFSIZE];
+    REG *reg;
+    DEVICE *dptr = sim_dflt_dev;
+    UNIT *uptr = sim_dflt_dev->units;
+    int32 saved_switches = sim_switches;
+    t_bool indirect = FALSE;
+    PUBLISH_REG *pub_regs;
+
+    if (comma) {
+        strncpy (tbuf, cptr, comma - cptr);
+        tbuf[comma - cptr] = '\0';
+        cptr = comma + 1;
+        }
+    else {
+        strcpy (tbuf, cptr);
+        cptr += strlen (cptr);
+        }
+    tptr = tbuf;
+    if (strchr (tbuf, ' ')) {
+        tptr = get_sim_opt (CMD_OPT_SW|CMD_OPT_DFT, tbuf, &stat); /* get switches and device */
+        indirect = ((sim_switches & SWMASK('I')) != 0);
+        sim_switches = saved_switches;
+        dptr = sim_dfdev;
+        uptr = sim_dfunit;
+        }
+    if (stat != SCPE_OK)
+        break;
+    tptr = get_glyph (tptr, gbuf, 0);           /* get next glyph */
+    reg = find_reg (gbuf, &tptr, dptr);
+    if (reg == NULL) {
+        stat = sim_messagef (SCPE_NXREG, "Nonexistent Register: %s\n", gbuf);
+        break;
+        }
+    count = 1;
+    if (*tptr == '[') {                         /* array element count? */
+        count = (uint32) strtotv (tptr + 1, &tptr, 10);
+        if ((*tptr != ']') || (count == 0) || (count > reg->depth)) {
+            stat = sim_messagef (SCPE_SUB, "Invalid Register Array Count: %s\n", gbuf);
+            break;
+            }
+        }
+    pub_regs = (PUBLISH_REG *)realloc (rem->pub_regs, (rem->pub_reg_count + 1) * sizeof(*pub_regs));
+    if (pub_regs == NULL) {
+        stat = SCPE_MEM;
+        break;
+        }
+    rem->pub_regs = pub_regs;
+    pub_regs[rem->pub_reg_count].reg = reg;
+    pub_regs[rem->pub_reg_count].dptr = dptr;
+    pub_regs[rem->pub_reg_count].uptr = uptr;
+    pub_regs[rem->pub_reg_count].indirect = indirect;
+    pub_regs[rem->pub_reg_count].count = count;
+    rem->pub_reg_count += 1;
+    }
+if (stat == SCPE_OK) {
+    for (i = count = 0; i < rem->pub_reg_count; i++)
+        count += rem->pub_regs[i].count;
+    for (i = 0; i < rem->smp_reg_count; i++)
+        count += 1 + rem->smp_regs[i].width;
+    stat = sim_shmem_open (name, SIM_PANEL_SHM_SIZE (count), &rem->pub_shmem, &shmaddr);
+    if (stat != SCPE_OK)
+        stat = sim_messagef (stat, "Can't create shared memory segment: %s\n", name);
+    }
+if (stat != SCPE_OK) {                          /* Error? */
+    *iptr = cptr;
+    cptr = strcpy (gbuf, "STOP");
+    sim_rem_publish_cmd_setup (line, &cptr);    /* Cleanup mess */
+    return stat;
+    }
+rem->pub_shm = (SIM_PANEL_SHM *)shmaddr;
+rem->pub_shm->sequence = 0;
+rem->pub_shm->count = count;
+rem->pub_shm->version = SIM_PANEL_SHM_VERSION;
+rem->pub_shm->magic = SIM_PANEL_SHM_MAGIC;
+rem->pub_interval = usecs;
+sim_rem_publish_registers (rem);                /* initial contents */
+sim_activate_after (&rem_con_pub_units[line], rem->pub_interval);
+*iptr = cptr;
+return stat;
+}
+
+t_stat sim_rem_con_publish_svc (UNIT *uptr)
+{
+int line = uptr - rem_con_pub_units;
+REMOTE *rem = &sim_rem_consoles[line];
+
+if (rem->pub_interval) {
+    sim_rem_publish_registers (rem);
+    sim_activate_after (uptr, rem->pub_interval);           /* reschedule */
+    }
+return SCPE_OK;
+}
+
 /* Unit service for remote console data polling */
 
 t_stat sim_rem_con_data_svc (UNIT *uptr)
@@ -1300,7 +2117,13 @@ CTAB *cmdp = NULL;
 CTAB *basecmdp = NULL;
 uint32 read_start_time = 0;
 
-tmxr_poll_rx (&sim_rem_con_tmxr);                      /* poll input */
+#if defined(SIM_ASYNCH_IO)
+REM_IO_LOCK;
+sim_rem_io_wake_pending = FALSE;                       /* I/O thread may request again */
+REM_IO_UNLOCK;
+#endif
+sim_rem_prompt_update ();                              /* publish the current state */
+_sim_rem_poll_rx ();                                   /* poll input */
 for (i=(was_active_command ? sim_rem_cmd_active_line : 0); 
      (i < sim_rem_con_tmxr.lines) && (!active_command); 
      i++) {
@@ -1308,7 +2131,7 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
     t_bool master_session = (sim_rem_master_mode && (i == 0));
 
     lp = rem->lp;
-    if (!lp->conn) {
+    if (!_sim_rem_connected (lp)) {
         if (rem->repeat_interval) {                 /* was repeated enabled? */
             cptr = strcpy (gbuf, "STOP");
             sim_rem_repeat_cmd_setup (i, &cptr);    /* make sure it is now disabled */
@@ -1317,11 +2140,15 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
             cptr = strcpy (gbuf, "STOP");
             sim_rem_collect_cmd_setup (i, &cptr);   /* make sure it is now disabled */
             }
+        if (rem->pub_interval) {                    /* were registers being published? */
+            cptr = strcpy (gbuf, "STOP");
+            sim_rem_publish_cmd_setup (i, &cptr);   /* make sure it is now disabled */
+            }
         continue;
         }
     if (master_session && !sim_rem_master_was_connected) {
-        tmxr_linemsgf (lp, "\nMaster Mode Session\r\n");
-        tmxr_send_buffered_data (lp);               /* flush any buffered data */
+        _sim_rem_linemsgf (lp, "\nMaster Mode Session\r\n");
+        _sim_rem_flush (lp);                        /* flush any buffered data */
         }
     sim_rem_master_was_connected |= master_session; /* Remember if master ever connected */
     stat = SCPE_OK;
@@ -1346,225 +2173,135 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
             sim_stop_timer_services ();
             for (j=0; j < sim_rem_con_tmxr.lines; j++) {
                 TMLN *lpj = &sim_rem_con_tmxr.ldsc[j];
-                if ((i == j) || (!lpj->conn))
+                if ((i == j) || (!_sim_rem_connected (lpj)))
                     continue;
-                tmxr_linemsgf (lpj, "\nRemote Master Console(%s) Entering Commands\n", lp->ipad);
-                tmxr_send_buffered_data (lpj);     /* flush any buffered data */
+                _sim_rem_linemsgf (lpj, "\nRemote Master Console(%s) Entering Commands\n", lp->ipad);
+                _sim_rem_flush (lpj);              /* flush any buffered data */
                 }
             }
         }
     else {
-        if ((!rem->repeat_pending) || (rem->buf_ptr != 0)) {
-            c = tmxr_getc_ln (lp);
-            if (!(TMXR_VALID & c))
+        if ((rem->single_mode) &&                   /* nothing to execute? */
+            (!rem->repeat_pending) &&
+            (!_sim_rem_cmdq_pending (rem))) {
+            c = _sim_rem_cmdq_event (rem);
+            if (c == REM_EV_EOF) {                  /* EOF character (^D or ^Z) ? */
+                _sim_rem_linemsgf (lp, "\r\nGoodbye\r\n");
+                _sim_rem_flush (lp);                /* flush any buffered data */
+                _sim_rem_reset_ln (lp);
                 continue;
-            c = c & ~TMXR_VALID;
-            if (rem->single_mode) {
-                if (c == sim_int_char) {            /* ^E (the interrupt character) must start continue mode console interaction */
-                    rem->single_mode = FALSE;       /* enter multi command mode */
-                    sim_is_running = 0;
-                    sim_rem_collect_all_registers ();
-                    sim_stop_timer_services ();
-                    stat = SCPE_STOP;
-                    _sim_rem_message ("RUN", stat);
-                    _sim_rem_log_out (lp);
-                    for (j=0; j < sim_rem_con_tmxr.lines; j++) {
-                        TMLN *lpj = &sim_rem_con_tmxr.ldsc[j];
-                        if ((i == j) || (!lpj->conn))
-                            continue;
-                        tmxr_linemsgf (lpj, "\nRemote Console %d(%s) Entering Commands\n", i, lp->ipad);
-                        tmxr_send_buffered_data (lpj);  /* flush any buffered data */
-                        }
-                    lp = &sim_rem_con_tmxr.ldsc[i];
-                    if (!master_session)
-                        tmxr_linemsg (lp, "\r\nSimulator paused.\r\n");
-                    if (!master_session && rem->read_timeout) {
-                        tmxr_linemsgf (lp, "Simulation will resume automatically if input is not received in %d seconds\n", rem->read_timeout);
-                        tmxr_linemsgf (lp, "\r\n");
-                        tmxr_send_buffered_data (lp);   /* flush any buffered data */
-                        }
-                    }
-                else {
-                    if ((rem->buf_ptr == 0) &&          /* At beginning of input line */
-                        ((c == '\n') ||                 /* Ignore bare LF between commands (Microsoft Telnet bug) */
-                         (c == '\r')))                  /* Ignore empty commands */
-                        continue;
-                    if ((c == '\004') || (c == '\032')) {/* EOF character (^D or ^Z) ? */
-                        tmxr_linemsgf (lp, "\r\nGoodbye\r\n");
-                        tmxr_send_buffered_data (lp);   /* flush any buffered data */
-                        tmxr_reset_ln (lp);
-                        continue;
-                        }
-                    if (rem->buf_ptr == 0) {
-                        /* we just picked up the first character on a command line */
-                        if (!master_session)
-                            tmxr_linemsgf (lp, "\r\n%s", sim_prompt);
-                        else
-                            tmxr_linemsgf (lp, "\r\n%s", sim_is_running ? "SIM> " : "sim> ");
-                        sim_debug (DBG_XMT, &sim_remote_console, "Prompt Written: %s\n", sim_is_running ? "SIM> " : "sim> ");
-                        if ((rem->act == NULL) && (!tmxr_input_pending_ln (lp)))
-                            tmxr_send_buffered_data (lp);/* flush any buffered data */
-                        }
-                    }
+                }
+            if (c != REM_EV_INTERRUPT)
+                continue;
+            /* ^E (the interrupt character) has started multi command mode */
+            sim_is_running = 0;
+            sim_rem_collect_all_registers ();
+            sim_stop_timer_services ();
+            stat = SCPE_STOP;
+            _sim_rem_message ("RUN", stat);
+            _sim_rem_log_out (lp);
+            for (j=0; j < sim_rem_con_tmxr.lines; j++) {
+                TMLN *lpj = &sim_rem_con_tmxr.ldsc[j];
+                if ((i == j) || (!_sim_rem_connected (lpj)))
+                    continue;
+                _sim_rem_linemsgf (lpj, "\nRemote Console %d(%s) Entering Commands\n", i, lp->ipad);
+                _sim_rem_flush (lpj);               /* flush any buffered data */
+                }
+            lp = &sim_rem_con_tmxr.ldsc[i];
+            if (!master_session)
+                _sim_rem_linemsg (lp, "\r\nSimulator paused.\r\n");
+            if (!master_session && rem->read_timeout) {
+                _sim_rem_linemsgf (lp, "Simulation will resume automatically if input is not received in %d seconds\n", rem->read_timeout);
+                _sim_rem_linemsgf (lp, "\r\n");
+                _sim_rem_flush (lp);                /* flush any buffered data */
                 }
             }
         }
     got_command = FALSE;
     while (1) {
+        t_bool too_long = FALSE;
+
         if (stat == SCPE_EXIT)
             return stat|SCPE_NOMESSAGE;
         if (!rem->single_mode) {
             read_start_time = sim_os_msec();
             if (master_session)
-                tmxr_linemsg (lp, "sim> ");
+                _sim_rem_linemsg (lp, "sim> ");
             else
-                tmxr_linemsg (lp, sim_prompt);
-            tmxr_send_buffered_data (lp);               /* flush any buffered data */
+                _sim_rem_linemsg (lp, sim_prompt);
+            _sim_rem_flush (lp);                        /* flush any buffered data */
             }
-        do {
-            if (rem->buf_ptr == 0) {
-                if (sim_rem_getact (i, rem->buf, rem->buf_size)) {
-                    if (!master_session)
-                        tmxr_linemsgf (lp, "%s%s\n", sim_prompt, rem->buf);
-                    else
-                        tmxr_linemsgf (lp, "%s%s\n", sim_is_running ? "SIM> " : "sim> ", rem->buf);
-                    rem->buf_ptr = strlen (rem->repeat_action);
-                    got_command = TRUE;
-                    break;
-                    }
-                else {
-                    if (rem->repeat_pending) {
-                        rem->repeat_pending = FALSE;
-                        sim_rem_setact (i, rem->repeat_action);
-                        sim_rem_getact (i, rem->buf, rem->buf_size);
-                        if (!master_session)
-                            tmxr_linemsgf (lp, "%s%s\n", sim_prompt, rem->buf);
-                        else
-                            tmxr_linemsgf (lp, "%s%s\n", sim_is_running ? "SIM> " : "sim> ", rem->buf);
-                        rem->buf_ptr = strlen (rem->repeat_action);
-                        got_command = TRUE;
-                        break;
-                        }
-                    }
+        if (sim_rem_getact (i, cbuf, sizeof (cbuf)))
+            got_command = TRUE;
+        else {
+            if (rem->repeat_pending) {
+                rem->repeat_pending = FALSE;
+                sim_rem_setact (i, rem->repeat_action);
+                got_command = (sim_rem_getact (i, cbuf, sizeof (cbuf)) != NULL);
                 }
-            if (!rem->single_mode) {
-                c = tmxr_getc_ln (lp);
-                if (!(TMXR_VALID & c)) {
-                    tmxr_send_buffered_data (lp);       /* flush any buffered data */
-                    if (!master_session && 
-                        rem->read_timeout &&
-                        ((sim_os_msec() - read_start_time)/1000 >= rem->read_timeout)) {
-                        while (rem->buf_ptr > 0) {      /* Erase current input line */
-                            tmxr_linemsg (lp, "\b \b");
-                            --rem->buf_ptr;
-                            }
-                        if (rem->buf_ptr+80 >= rem->buf_size) {
-                            rem->buf_size += 1024;
-                            rem->buf = (char *)realloc (rem->buf, rem->buf_size);
-                            }
-                        strcpy (rem->buf, "CONTINUE         ! Automatic continue due to timeout");
-                        tmxr_linemsgf (lp, "%s\n", rem->buf);
-                        got_command = TRUE;
-                        break;
-                        }
-                    sim_os_ms_sleep (50);
-                    tmxr_poll_rx (&sim_rem_con_tmxr);   /* poll input */
-                    if (!lp->conn) {                    /* if connection lost? */
-                        rem->single_mode = TRUE;        /* No longer multi-command more */
-                        break;                          /* done waiting */
-                        }
-                    continue;
-                    }
-                read_start_time = sim_os_msec();
-                c = c & ~TMXR_VALID;
+            }
+        if (got_command) {
+            if (!master_session)
+                _sim_rem_linemsgf (lp, "%s%s\n", sim_prompt, cbuf);
+            else
+                _sim_rem_linemsgf (lp, "%s%s\n", sim_is_running ? "SIM> " : "sim> ", cbuf);
+            }
+        while (!got_command) {
+            char *cmd = _sim_rem_cmdq_get (rem);
+
+            if (cmd) {
+                sim_debug (DBG_RCV, &sim_remote_console, "Got Command: %s\n", cmd);
+                too_long = (strlen (cmd) >= sizeof (cbuf));
+                strlcpy (cbuf, cmd, sizeof (cbuf));
+                free (cmd);
+                got_command = TRUE;
+                break;
                 }
-            switch (c) {
-                case 0:     /* no data */
-                    break;
-                case '\b':  /* Backspace */
-                case 127:   /* Rubout */
-                    if (rem->buf_ptr > 0) {
-                        tmxr_linemsg (lp, "\b \b");
-                        --rem->buf_ptr;
-                        }
-                    break;
-                case 27:   /* escape */
-                case 21:   /* ^U */
-                    while (rem->buf_ptr > 0) {
-                        tmxr_linemsg (lp, "\b \b");
-                        --rem->buf_ptr;
-                        }
-                    break;
-                case '\n':
-                    if (rem->buf_ptr == 0)
-                        break;
-                case '\r':
-                    tmxr_linemsg (lp, "\r\n");
-                    if (rem->buf_ptr+1 >= rem->buf_size) {
-                        rem->buf_size += 1024;
-                        rem->buf = (char *)realloc (rem->buf, rem->buf_size);
-                        }
-                    rem->buf[rem->buf_ptr++] = '\0';
-                    sim_debug (DBG_RCV, &sim_remote_console, "Got Command (%d bytes still in buffer): %s\n", tmxr_input_pending_ln (lp), rem->buf);
-                    got_command = TRUE;
-                    break;
-                case '\004': /* EOF (^D) */
-                case '\032': /* EOF (^Z) */
-                    while (rem->buf_ptr > 0) {          /* Erase current input line */
-                        tmxr_linemsg (lp, "\b \b");
-                        --rem->buf_ptr;
-                        }
-                    if (!rem->single_mode) {
-                        if (rem->buf_ptr+80 >= rem->buf_size) {
-                            rem->buf_size += 1024;
-                            rem->buf = (char *)realloc (rem->buf, rem->buf_size);
-                            }
-                        strcpy (rem->buf, "CONTINUE         ! Automatic continue before close");
-                        tmxr_linemsgf (lp, "%s\n", rem->buf);
-                        got_command = TRUE;
-                        }
-                    close_session = TRUE;
-                    break;
-                default:
-                    tmxr_putc_ln (lp, c);
-                    if (rem->buf_ptr+2 >= rem->buf_size) {
-                        rem->buf_size += 1024;
-                        rem->buf = (char *)realloc (rem->buf, rem->buf_size);
-                        }
-                    rem->buf[rem->buf_ptr++] = (char)c;
-                    rem->buf[rem->buf_ptr] = '\0';
-                    if (((size_t)rem->buf_ptr) >= sizeof(cbuf))
-                        got_command = TRUE;             /* command too long */
-                    break;
+            if (rem->single_mode)                       /* nothing more now? */
+                break;
+            if (_sim_rem_cmdq_event (rem) == REM_EV_EOF) {/* EOF character (^D or ^Z) ? */
+                strcpy (cbuf, "CONTINUE         ! Automatic continue before close");
+                _sim_rem_linemsgf (lp, "%s\n", cbuf);
+                got_command = TRUE;
+                close_session = TRUE;
+                break;
+                }
+            _sim_rem_flush (lp);                        /* flush any buffered data */
+            if (!master_session && 
+                rem->read_timeout &&
+                (_sim_rem_idle_msec (rem, read_start_time)/1000 >= rem->read_timeout)) {
+                _sim_rem_erase_input (rem);             /* Erase current input line */
+                strcpy (cbuf, "CONTINUE         ! Automatic continue due to timeout");
+                _sim_rem_linemsgf (lp, "%s\n", cbuf);
+                got_command = TRUE;
+                break;
                 }
-            c = 0;
-            if ((!got_command) && (rem->single_mode) && (tmxr_input_pending_ln (lp))) {
-                c = tmxr_getc_ln (lp);
-                c = c & ~TMXR_VALID;
+            sim_os_ms_sleep (50);
+            _sim_rem_poll_rx ();                        /* poll input */
+            if (!_sim_rem_connected (lp)) {             /* if connection lost? */
+                _sim_rem_single_mode (rem, TRUE);       /* No longer multi-command more */
+                break;                                  /* done waiting */
                 }
-            } while ((!got_command) && ((!rem->single_mode) || c));
-        if ((rem->act == NULL) && (!tmxr_input_pending_ln (lp)))
-            tmxr_send_buffered_data (lp);               /* flush any buffered data */
+            }
+        if (rem->act == NULL)
+            _sim_rem_flush (lp);                        /* flush any buffered data */
         if ((rem->single_mode) && !got_command) {
             break;
             }
         if (!sim_rem_master_mode)
-            sim_printf ("Remote Console Command from %s> %s\r\n", lp->ipad, rem->buf);
+            sim_printf ("Remote Console Command from %s> %s\r\n", lp->ipad, cbuf);
         got_command = FALSE;
-        if (strlen(rem->buf) >= sizeof(cbuf)) {
+        if (too_long) {
             sim_printf ("\r\nLine too long. Ignored.  Continuing Simulator execution\r\n");
-            tmxr_linemsgf (lp, "\nLine too long. Ignored.  Continuing Simulator execution\n");
-            tmxr_send_buffered_data (lp);               /* try to flush any buffered data */
+            _sim_rem_linemsgf (lp, "\nLine too long. Ignored.  Continuing Simulator execution\n");
+            _sim_rem_flush (lp);                        /* try to flush any buffered data */
             break;
             }
-        strcpy (cbuf, rem->buf);
-        rem->buf_ptr = 0;
-        rem->buf[rem->buf_ptr] = '\0';
         while (isspace(cbuf[0]))
             memmove (cbuf, cbuf+1, strlen(cbuf+1)+1);   /* skip leading whitespace */
         if (cbuf[0] == '\0') {
             if (rem->single_mode) {
-                rem->single_mode = FALSE;
+                _sim_rem_single_mode (rem, FALSE);
                 break;
                 }
             else
@@ -1657,6 +2394,10 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
                                         sim_debug (DBG_CMD, &sim_remote_console, "sample_cmd executing\n");
                                         stat = sim_rem_collect_cmd_setup (i, &cptr);
                                         }
+                                    else if (cmdp->action == &x_publish_cmd) {
+                                        sim_debug (DBG_CMD, &sim_remote_console, "publish_cmd executing\n");
+                                        stat = sim_rem_publish_cmd_setup (i, &cptr);
+                                        }
                                     else {
                                         if (sim_con_stable_registers && 
                                             sim_rem_master_mode) {  /* can we process command now? */
@@ -1684,7 +2425,7 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
             stat = _sim_rem_message (gbuf, stat);
         _sim_rem_log_out (lp);
         if (master_session && !sim_rem_master_mode) {
-            rem->single_mode = TRUE;
+            _sim_rem_single_mode (rem, TRUE);
             return SCPE_STOP;
             }
         if (cmdp && (cmdp->action == &x_continue_cmd)) {
@@ -1704,27 +2445,27 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
                 sim_rem_cmd_log_start = sim_ftell (sim_log);
                 }
             if (!rem->single_mode) {
-                tmxr_linemsg (lp, "Simulator Running...");
-                tmxr_send_buffered_data (lp);
+                _sim_rem_linemsg (lp, "Simulator Running...");
+                _sim_rem_flush (lp);
                 for (j=0; j < sim_rem_con_tmxr.lines; j++) {
                     TMLN *lpj = &sim_rem_con_tmxr.ldsc[j];
-                    if ((i == j) || (!lpj->conn))
+                    if ((i == j) || (!_sim_rem_connected (lpj)))
                         continue;
-                    tmxr_linemsg (lpj, "Simulator Running...");
-                    tmxr_send_buffered_data (lpj);
+                    _sim_rem_linemsg (lpj, "Simulator Running...");
+                    _sim_rem_flush (lpj);
                     }
                 sim_is_running = 1;
                 sim_start_timer_services ();
                 }
             if (cmdp && (cmdp->action == &x_continue_cmd))
-                rem->single_mode = TRUE;
+                _sim_rem_single_mode (rem, TRUE);
             else {
                 if (!rem->single_mode) {
                     if (master_session)
-                        tmxr_linemsgf (lp, "%s", "sim> ");
+                        _sim_rem_linemsgf (lp, "%s", "sim> ");
                     else
-                        tmxr_linemsgf (lp, "%s", sim_prompt);
-                    tmxr_send_buffered_data (lp);
+                        _sim_rem_linemsgf (lp, "%s", sim_prompt);
+                    _sim_rem_flush (lp);
                     }
                 }
             break;
@@ -1736,15 +2477,16 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
             }
         }
     if (close_session) {
-        tmxr_linemsgf (lp, "\r\nGoodbye\r\n");
-        tmxr_send_buffered_data (lp);                       /* flush any buffered data */
-        tmxr_reset_ln (lp);
-        rem->single_mode = FALSE;
+        _sim_rem_linemsgf (lp, "\r\nGoodbye\r\n");
+        _sim_rem_flush (lp);                                /* flush any buffered data */
+        _sim_rem_reset_ln (lp);
+        _sim_rem_single_mode (rem, FALSE);
         }
     }
 if (sim_rem_master_was_connected &&                         /* Master mode ever connected? */
-    !sim_rem_con_tmxr.ldsc[0].sock)                         /* Master Connection lost? */
+    !_sim_rem_connected (&sim_rem_con_tmxr.ldsc[0]))        /* Master Connection lost? */
     return SCPE_EXIT;                                       /* simulator has been 'unplugged' */
+sim_rem_prompt_update ();                                   /* publish active command line */
 if (sim_rem_cmd_active_line != -1) {
     if (steps)
         sim_activate(uptr, steps);                          /* check again after 'steps' instructions */
@@ -1755,8 +2497,8 @@ else
     sim_activate_after(uptr, 100000);                       /* check again in 100 milliaeconds */
 if (sim_rem_master_was_enabled && !sim_rem_master_mode) {   /* Transitioning out of master mode? */
     lp = &sim_rem_con_tmxr.ldsc[0];
-    tmxr_linemsgf (lp, "Non Master Mode Session...");       /* report transition */
-    tmxr_send_buffered_data (lp);                           /* flush any buffered data */
+    _sim_rem_linemsgf (lp, "Non Master Mode Session...");   /* report transition */
+    _sim_rem_flush (lp);                                    /* flush any buffered data */
     return SCPE_STOP|SCPE_NOMESSAGE;                        /* Unwind to the normal input path */
     }
 else
@@ -1772,13 +2514,15 @@ if (sim_rem_con_tmxr.lines) {
     for (i=0; i<sim_rem_con_tmxr.lines; i++) {
         REMOTE *rem = &sim_rem_consoles[i];
 
-        if (!sim_rem_con_tmxr.ldsc[i].conn)
+        if (!_sim_rem_connected (&sim_rem_con_tmxr.ldsc[i]))
             continue;
         sim_debug (DBG_REP, &sim_remote_console, "sim_rem_con_reset(line=%d, usecs=%d)\n", i, rem->repeat_interval);
         if (rem->repeat_interval)
             sim_activate_after (&rem_con_repeat_units[rem->line], rem->repeat_interval);    /* schedule */
         if (rem->smp_reg_count)
             sim_activate (&rem_con_smp_smpl_units[rem->line], rem->smp_sample_interval);    /* schedule */
+        if (rem->pub_interval)
+            sim_activate_after (&rem_con_pub_units[rem->line], rem->pub_interval);      /* schedule */
         }
     if (i != sim_rem_con_tmxr.lines)
         sim_activate_after (rem_con_data_unit, 100000);     /* continue polling for open sessions */
@@ -1801,8 +2545,10 @@ if (flag) {
         sim_rem_con_tmxr.buffered = 8192;                   /* Use big enough buffers */
         sim_register_internal_device (&sim_remote_console);
         r = tmxr_attach (&sim_rem_con_tmxr, rem_con_poll_unit, cptr);/* open master socket */
-        if (r == SCPE_OK)
+        if (r == SCPE_OK) {
             sim_activate_after(rem_con_poll_unit, 1000000);/* check for connection in 1 second */
+            _sim_rem_io_start ();                           /* start output delivery */
+            }
         return r;
         }
     return SCPE_NOPARAM;
@@ -1811,14 +2557,19 @@ else {
     if (sim_rem_con_tmxr.master) {
         int32 i;
 
+        _sim_rem_io_stop ();                                /* deliver what we can */
         tmxr_detach (&sim_rem_con_tmxr, rem_con_poll_unit);
         for (i=0; i<sim_rem_con_tmxr.lines; i++) {
             REMOTE *rem = &sim_rem_consoles[i];
+            _sim_rem_cmdq_clear (rem);
             free (rem->buf);
             rem->buf = NULL;
             rem->buf_size = 0;
             rem->buf_ptr = 0;
             rem->single_mode = TRUE;
+            free (rem->outq);
+            rem->outq = NULL;
+            rem->outq_size = rem->outq_len = 0;
             }
         }
     }
@@ -1845,19 +2596,24 @@ if (sim_rem_con_tmxr.lines) {
     }
 for (i=0; i<sim_rem_con_tmxr.lines; i++) {
     rem = &sim_rem_consoles[i];
+    _sim_rem_cmdq_clear (rem);
     free (rem->buf);
     free (rem->act_buf);
     free (rem->act);
     free (rem->repeat_action);
+    free (rem->outq);
     sim_cancel (&rem_con_repeat_units[i]);
     sim_cancel (&rem_con_smp_smpl_units[i]);
+    sim_cancel (&rem_con_pub_units[i]);
+    free (rem->pub_regs);
+    sim_shmem_close (rem->pub_shmem);
     }
 sim_rem_con_tmxr.lines = lines;
 sim_rem_con_tmxr.ldsc = (TMLN *)realloc (sim_rem_con_tmxr.ldsc, sizeof(*sim_rem_con_tmxr.ldsc)*lines);
 memset (sim_rem_con_tmxr.ldsc, 0, sizeof(*sim_rem_con_tmxr.ldsc)*lines);
-sim_remote_console.units = (UNIT *)realloc (sim_remote_console.units, sizeof(*sim_remote_console.units)*((2 * lines) + REM_CON_BASE_UNITS));
-memset (sim_remote_console.units, 0, sizeof(*sim_remote_console.units)*((2 * lines) + REM_CON_BASE_UNITS));
-sim_remote_console.numunits = (2 * lines) + REM_CON_BASE_UNITS;
+sim_remote_console.units = (UNIT *)realloc (sim_remote_console.units, sizeof(*sim_remote_console.units)*((3 * lines) + REM_CON_BASE_UNITS));
+memset (sim_remote_console.units, 0, sizeof(*sim_remote_console.units)*((3 * lines) + REM_CON_BASE_UNITS));
+sim_remote_console.numunits = (3 * lines) + REM_CON_BASE_UNITS;
 rem_con_poll_unit->action = &sim_rem_con_poll_svc;/* remote console connection polling unit */
 rem_con_poll_unit->flags |= UNIT_IDLE;
 rem_con_data_unit->action = &sim_rem_con_data_svc;/* console data handling unit */
@@ -1871,6 +2627,8 @@ for (i=0; i<lines; i++) {
     rem_con_repeat_units[i].action = &sim_rem_con_repeat_svc;
     rem_con_smp_smpl_units[i].flags = UNIT_DIS;
     rem_con_smp_smpl_units[i].action = &sim_rem_con_smp_collect_svc;
+    rem_con_pub_units[i].flags = UNIT_DIS;
+    rem_con_pub_units[i].action = &sim_rem_con_publish_svc;
     rem = &sim_rem_consoles[i];
     rem->line = i;
     rem->lp = &sim_rem_con_tmxr.ldsc[i];
@@ -1910,7 +2668,10 @@ if (r != SCPE_OK)
 if (bufsize < 1400)
     return sim_messagef (SCPE_ARG, "%d is too small.  Minimum size is 1400\n", bufsize);
 sprintf(cmdbuf, "BUFFERED=%d", bufsize);
-return tmxr_open_master (&sim_rem_con_tmxr, cmdbuf);        /* open master socket */
+REM_IO_LOCK;                                                /* line buffers are reallocated */
+r = tmxr_open_master (&sim_rem_con_tmxr, cmdbuf);           /* open master socket */
+REM_IO_UNLOCK;
+return r;
 }
 
 /* Enable or disable Remote Console master mode */
@@ -1948,7 +2709,7 @@ if (sim_rem_master_mode) {
     sim_rem_master_was_enabled = TRUE;
     sim_last_cmd_stat = SCPE_OK;
     while (sim_rem_master_mode) {
-        sim_rem_consoles[0].single_mode = FALSE;
+        _sim_rem_single_mode (&sim_rem_consoles[0], FALSE);
         sim_cancel (rem_con_data_unit);
         sim_activate (rem_con_data_unit, -1);
         stat = run_cmd (RU_GO, "");
@@ -1960,13 +2721,14 @@ if (sim_rem_master_mode) {
         if (stat == SCPE_EXIT)
             sim_rem_master_mode = FALSE;
         sim_rem_cmd_active_line = 0;                    /* Make it look like */
-        sim_rem_consoles[0].single_mode = FALSE;
+        _sim_rem_single_mode (&sim_rem_consoles[0], FALSE);
         if (stat != SCPE_STEP)
             sim_rem_active_command = &allowed_single_remote_cmds[0];/* Dummy */
         sim_last_cmd_stat = SCPE_BARE_STATUS(stat);     /* make exit status available to remote console */
         }
     sim_rem_master_was_enabled = FALSE;
     sim_rem_master_was_connected = FALSE;
+    sim_rem_prompt_update ();
     if (sim_log_temp) {                                     /* If we setup a temporary log, clean it now  */
         int32 save_quiet = sim_quiet;
 
@@ -1979,7 +2741,7 @@ if (sim_rem_master_mode) {
     stat |= stat_nomessage;
     }
 else {
-    sim_rem_consoles[0].single_mode = TRUE;                 /* Force remote session into single command mode */
+    _sim_rem_single_mode (&sim_rem_consoles[0], TRUE);      /* Force remote session into single command mode */
     }
 return stat;
 }
@@ -2578,7 +3340,7 @@ int32 c, trys = 0;
 if (sim_rem_master_mode) {
     for (;trys < sec; ++trys) {
         sim_rem_con_poll_svc (rem_con_poll_unit);
-        if (sim_rem_con_tmxr.ldsc[0].conn)
+        if (_sim_rem_connected (&sim_rem_con_tmxr.ldsc[0]))
             break;
         if ((trys % 10) == 0) {                         /* Status every 10 sec */
             sim_printf ("Waiting for Remote Console connection\r\n");
@@ -2588,16 +3350,16 @@ if (sim_rem_master_mode) {
             }
         sim_os_sleep (1);                               /* wait 1 second */
         }
-    if ((sim_rem_con_tmxr.ldsc[0].conn) &&
+    if ((_sim_rem_connected (&sim_rem_con_tmxr.ldsc[0])) &&
         (!sim_con_ldsc.serport) &&
         (sim_con_tmxr.master == 0) &&
         (sim_con_console_port)) {
-        tmxr_linemsgf (&sim_rem_con_tmxr.ldsc[0], "\r\nConsole port must be Telnet or Serial with Master Remote Console\r\n");
-        tmxr_linemsgf (&sim_rem_con_tmxr.ldsc[0], "Goodbye\r\n");
-        while (tmxr_send_buffered_data (&sim_rem_con_tmxr.ldsc[0]))
-            sim_os_ms_sleep (100);
+        _sim_rem_linemsgf (&sim_rem_con_tmxr.ldsc[0], "\r\nConsole port must be Telnet or Serial with Master Remote Console\r\n");
+        _sim_rem_linemsgf (&sim_rem_con_tmxr.ldsc[0], "Goodbye\r\n");
+        for (c = 0; (c < 10) && _sim_rem_flush (&sim_rem_con_tmxr.ldsc[0]); c++)
+            sim_os_ms_sleep (100);                      /* give the message up to a second */
         sim_os_ms_sleep (100);
-        tmxr_reset_ln (&sim_rem_con_tmxr.ldsc[0]);
+        _sim_rem_reset_ln (&sim_rem_con_tmxr.ldsc[0]);
         sim_printf ("Console port must be Telnet or Serial with Master Remote Console\r\n");
         return SCPE_EXIT;
         }
@@ -2676,6 +3438,7 @@ t_stat sim_poll_kbd (void)
 {
 t_stat c;
 
+sim_flush_console ();                                       /* show output before input */
 if (sim_send_poll_data (&sim_con_send, &c))                 /* injected input characters available? */
     return c;
 if (!sim_rem_master_mode) {
@@ -2714,26 +3477,101 @@ if ((c = (t_stat)tmxr_getc_ln (&sim_con_ldsc)))             /* any char? */
 return SCPE_OK;
 }
 
-/* Output character */
+/* Console output coalescing
 
-t_stat sim_putchar (int32 c)
+   While the simulator is running, characters written to the in-window
+   console are accumulated in sim_con_obuf and are written to the
+   terminal and the log file with a single write.  Characters written to
+   a Telnet console are left in the line's transmit buffer rather than
+   being sent one per packet.  Pending output is flushed when the buffer
+   fills, when the keyboard is polled, when the simulator stops and
+   otherwise within SIM_CON_OFLUSH_USEC of the first pending character.
+   Output while at the command prompt is written immediately.
+*/
+
+#define SIM_CON_OBUF_SIZE   4096                        /* in-window output buffer size */
+#define SIM_CON_OFLUSH_USEC 10000                       /* max output hold time */
+
+static char sim_con_obuf[SIM_CON_OBUF_SIZE];            /* pending in-window output */
+static size_t sim_con_optr = 0;                         /* bytes in sim_con_obuf */
+static t_bool sim_con_txpend = FALSE;                   /* Telnet output not yet sent */
+
+t_stat sim_flush_console (void)
 {
-sim_exp_check (&sim_con_expect, c);
-if ((sim_con_tmxr.master == 0) &&                       /* not Telnet? */
-    (sim_con_ldsc.serport == 0)) {                      /* and not serial port */
+t_stat r = SCPE_OK;
+
+if (sim_con_optr) {
+    if (sim_log)                                        /* log file? */
+        fwrite (sim_con_obuf, 1, sim_con_optr, sim_log);
+    r = sim_os_putchars (sim_con_obuf, sim_con_optr);
+    sim_con_optr = 0;
+    }
+if (sim_con_txpend) {
+    sim_con_txpend = FALSE;
+    tmxr_poll_tx (&sim_con_tmxr);                       /* poll xmt */
+    }
+return r;
+}
+
+static t_stat sim_con_out_svc (UNIT *uptr)
+{
+return sim_flush_console ();
+}
+
+static void sim_con_out_hold (void)
+{
+if (!sim_is_active (&sim_con_out_unit))
+    sim_activate_after (&sim_con_out_unit, SIM_CON_OFLUSH_USEC);
+}
+
+static t_stat sim_con_out_window (int32 c)
+{
+sim_debug (DBG_XMT, &sim_con_telnet, "sim_putchar('%c' (0x%02X)\n", sim_isprint (c) ? c : '.', c);
+if (!sim_is_running) {                                  /* at the command prompt? */
+    sim_flush_console ();
     if (sim_log)                                        /* log file? */
         fputc (c, sim_log);
-    sim_debug (DBG_XMT, &sim_con_telnet, "sim_putchar('%c' (0x%02X)\n", sim_isprint (c) ? c : '.', c);
     return sim_os_putchar (c);                          /* in-window version */
     }
+if (sim_con_optr == 0)                                  /* first pending char? */
+    sim_con_out_hold ();
+sim_con_obuf[sim_con_optr++] = (char)c;
+if (sim_con_optr == sizeof (sim_con_obuf))              /* full? */
+    return sim_flush_console ();
+return SCPE_OK;
+}
+
+static void sim_con_out_telnet (void)
+{
+if (sim_con_ldsc.serport ||                             /* serial port holds just a char */
+    !sim_is_running) {
+    tmxr_poll_tx (&sim_con_tmxr);                       /* poll xmt */
+    return;
+    }
+if (!sim_con_txpend) {
+    sim_con_txpend = TRUE;
+    sim_con_out_hold ();
+    }
+}
+
+/* Output character */
+
+t_stat sim_putchar (int32 c)
+{
+sim_exp_check (&sim_con_expect, c);
+if ((sim_con_tmxr.master == 0) &&                       /* not Telnet? */
+    (sim_con_ldsc.serport == 0))                        /* and not serial port */
+    return sim_con_out_window (c);
 if (!sim_con_ldsc.conn) {                               /* no Telnet or serial connection? */
     if (!sim_con_ldsc.txbfd)                            /* unbuffered? */
         return SCPE_LOST;                               /* connection lost */
     if (tmxr_poll_conn (&sim_con_tmxr) >= 0)            /* poll connect */
         sim_con_ldsc.rcve = 1;                          /* rcv enabled */
     }
+if (sim_con_ldsc.xmte == 0)                             /* line buffer full? */
+    tmxr_poll_tx (&sim_con_tmxr);                       /* make room */
 tmxr_putc_ln (&sim_con_ldsc, c);                        /* output char */
-tmxr_poll_tx (&sim_con_tmxr);                           /* poll xmt */
+sim_con_out_telnet ();
 return SCPE_OK;
 }
 
@@ -2743,12 +3581,8 @@ t_stat r;
 
 sim_exp_check (&sim_con_expect, c);
 if ((sim_con_tmxr.master == 0) &&                       /* not Telnet? */
-    (sim_con_ldsc.serport == 0)) {                      /* and not serial port */
-    if (sim_log)                                        /* log file? */
-        fputc (c, sim_log);
-    sim_debug (DBG_XMT, &sim_con_telnet, "sim_putchar('%c' (0x%02X)\n", sim_isprint (c) ? c : '.', c);
-    return sim_os_putchar (c);                          /* in-window version */
-    }
+    (sim_con_ldsc.serport == 0))                        /* and not serial port */
+    return sim_con_out_window (c);
 if (!sim_con_ldsc.conn) {                               /* no Telnet or serial connection? */
     if (!sim_con_ldsc.txbfd)                            /* non-buffered Telnet connection? */
         return SCPE_LOST;                               /* lost */
@@ -2756,9 +3590,11 @@ if (!sim_con_ldsc.conn) {                               /* no Telnet or serial c
         sim_con_ldsc.rcve = 1;                          /* rcv enabled */
     }
 if (sim_con_ldsc.xmte == 0)                             /* xmt disabled? */
+    tmxr_poll_tx (&sim_con_tmxr);                       /* try to make room */
+if (sim_con_ldsc.xmte == 0)                             /* still disabled? */
     r = SCPE_STALL;
 else r = tmxr_putc_ln (&sim_con_ldsc, c);               /* no, Telnet output */
-tmxr_poll_tx (&sim_con_tmxr);                           /* poll xmt */
+sim_con_out_telnet ();
 return r;                                               /* return status */
 }
 
@@ -2963,6 +3799,7 @@ return sim_os_ttinit ();
 
 t_stat sim_ttrun (void)
 {
+sim_rem_prompt_update ();                               /* remote console input sees running */
 if (!sim_con_tmxr.ldsc->uptr) {                         /* If simulator didn't declare its input polling unit */
     sim_con_unit.dynflags &= ~UNIT_TM_POLL;             /* we can't poll asynchronously */
     sim_con_unit.dynflags |= TMUF_NOASYNCH;             /* disable asynchronous behavior */
@@ -2997,6 +3834,8 @@ return sim_os_ttrun ();
 
 t_stat sim_ttcmd (void)
 {
+sim_flush_console ();                                   /* deliver pending output */
+sim_rem_prompt_update ();                               /* remote console input sees stopped */
 #if defined(SIM_ASYNCH_IO) && defined(SIM_ASYNCH_MUX)
 pthread_mutex_lock (&sim_tmxr_poll_lock);
 if (sim_console_poll_running) {
@@ -3014,7 +3853,11 @@ return sim_os_ttcmd ();
 
 t_stat sim_ttclose (void)
 {
-t_stat r1 = tmxr_shutdown ();
+t_stat r1;
+
+sim_flush_console ();                                   /* deliver pending output */
+_sim_rem_io_stop ();                                    /* stop remote console output thread */
+r1 = tmxr_shutdown ();
 t_stat r2 = sim_os_ttclose ();
 
 if (r1 != SCPE_OK)
@@ -3199,6 +4042,18 @@ if ((status != SS$_NORMAL) || (iosb.status != SS$_NORMAL))
 return SCPE_OK;
 }
 
+static t_stat sim_os_putchars (const char *buf, size_t len)
+{
+unsigned int status;
+IOSB iosb;
+
+status = sys$qiow (EFN, tty_chan, IO$_WRITELBLK | IO$M_NOFORMAT,
+    &iosb, 0, 0, buf, len, 0, 0, 0, 0);
+if ((status != SS$_NORMAL) || (iosb.status != SS$_NORMAL))
+    return SCPE_TTOERR;
+return SCPE_OK;
+}
+
 /* Win32 routines */
 
 #elif defined (_WIN32)
@@ -3440,6 +4295,13 @@ if (c != 0177) {
 return SCPE_OK;
 }
 
+static t_stat sim_os_putchars (const char *buf, size_t len)
+{
+while (len--)                                   /* escape sequences need per char handling */
+    sim_os_putchar ((u_char)*buf++);
+return SCPE_OK;
+}
+
 /* OS/2 routines, from Bruce Ray and Holger Veit */
 
 #elif defined (__OS2__)
@@ -3521,6 +4383,13 @@ if (c != 0177) {
 return SCPE_OK;
 }
 
+static t_stat sim_os_putchars (const char *buf, size_t len)
+{
+while (len--)
+    sim_os_putchar ((u_char)*buf++);
+return SCPE_OK;
+}
+
 /* Metrowerks CodeWarrior Macintosh routines, from Louis Chretien and
    Peter Schorn */
 
@@ -3707,6 +4576,13 @@ if (c != 0177) {
 return SCPE_OK;
 }
 
+static t_stat sim_os_putchars (const char *buf, size_t len)
+{
+while (len--)
+    sim_os_putchar ((u_char)*buf++);
+return SCPE_OK;
+}
+
 /* BSD UNIX routines */
 
 #elif defined (BSDTTY)
@@ -3823,6 +4699,12 @@ write (1, &c, 1);
 return SCPE_OK;
 }
 
+static t_stat sim_os_putchars (const char *buf, size_t len)
+{
+write (1, buf, len);
+return SCPE_OK;
+}
+
 /* POSIX UNIX routines, from Leendert Van Doorn */
 
 #else
@@ -3952,6 +4834,22 @@ c = out;
 return SCPE_OK;
 }
 
+static t_stat sim_os_putchars (const char *buf, size_t len)
+{
+while (len > 0) {
+    ssize_t sbytes = write (1, buf, len);
+
+    if (sbytes <= 0) {
+        if ((sbytes < 0) && (errno == EINTR))
+            continue;
+        break;                                  /* drop it, as sim_os_putchar does */
+        }
+    buf += sbytes;
+    len -= sbytes;
+    }
+return SCPE_OK;
+}
+
 #endif
 
 /* Decode a string.
@@ -74,6 +74,8 @@ extern "C" {
 t_stat sim_set_console (int32 flag, CONST char *cptr);
 t_stat sim_set_remote_console (int32 flag, CONST char *cptr);
 void sim_remote_process_command (void);
+void sim_rem_oline_vprintf (const char *fmt, va_list arglist);
+void sim_rem_prompt_update (void);
 t_stat sim_set_kmap (int32 flag, CONST char *cptr);
 t_stat sim_set_telnet (int32 flag, CONST char *cptr);
 t_stat sim_set_notelnet (int32 flag, CONST char *cptr);
@@ -117,6 +119,7 @@ t_stat sim_set_stable_registers_state (void);
 t_stat sim_poll_kbd (void);
 t_stat sim_putchar (int32 c);
 t_stat sim_putchar_s (int32 c);
+t_stat sim_flush_console (void);
 t_stat sim_ttinit (void);
 t_stat sim_ttrun (void);
 t_stat sim_ttcmd (void);
@@ -451,6 +451,8 @@ typedef struct SEND SEND;
 typedef struct DEBTAB DEBTAB;
 typedef struct FILEREF FILEREF;
 typedef struct MEMFILE MEMFILE;
+typedef struct SIM_IOSTAT SIM_IOSTAT;
+typedef struct SIM_IOSTATS SIM_IOSTATS;
 typedef struct BITFIELD BITFIELD;
 
 typedef t_stat (*ACTIVATE_API)(UNIT *unit, int32 interval);
@@ -494,6 +496,10 @@ struct DEVICE {
     void *help_ctx;                                     /* Context available to help routines */
     const char          *(*description)(DEVICE *dptr);  /* Device Description */
     BRKTYPTAB           *brk_types;                     /* Breakpoint types */
+    t_stat              (*examine_range)(t_value *v, t_addr a, uint32 *count,
+                            UNIT *up, int32 sw);        /* bulk examine routine (optional) */
+    t_stat              (*deposit_range)(const t_value *v, t_addr a, uint32 *count,
+                            UNIT *up, int32 sw);        /* bulk deposit routine (optional) */
     };
 
 /* Device flags */
@@ -572,6 +578,7 @@ struct UNIT {
     t_bool              (*cancel)(UNIT *);
     double              usecs_remaining;                /* time balance for long delays */
     char                *uname;                         /* Unit name */
+    void                *stream_ctx;                    /* buffered unit record stream */
 #ifdef SIM_ASYNCH_IO
     void                (*a_check_completion)(UNIT *);
     t_bool              (*a_is_active)(UNIT *);
@@ -848,6 +855,44 @@ struct MEMFILE {
     size_t              size;                        /* size */
     size_t              pos;                         /* data used */
     };
+
+/* I/O statistics
+
+   One SIM_IOSTATS block exists for each attached disk or tape unit and
+   each open ethernet device.  Operations are classified as reads,
+   writes, positioning (seeks, spacing, rewinds) and other.  Host
+   latencies are kept in a histogram of power of 4 microsecond buckets
+   (<4us, <16us, ... , >=4s).  The async entry records the delay between
+   an I/O thread completing a request and the simulator consuming it. */
+
+#define SIM_IOS_READ    0                               /* read */
+#define SIM_IOS_WRITE   1                               /* write */
+#define SIM_IOS_POSN    2                               /* position */
+#define SIM_IOS_OTHER   3                               /* other */
+#define SIM_IOS_OPS     4                               /* number of op classes */
+#define SIM_IOS_HIST    12                              /* latency histogram buckets */
+
+struct SIM_IOSTAT {
+    t_uint64            count;                          /* operations */
+    t_uint64            bytes;                          /* bytes transferred */
+    t_uint64            errors;                         /* operations failed */
+    t_uint64            usecs;                          /* total host usecs */
+    uint32              max_usecs;                      /* longest operation */
+    uint32              hist[SIM_IOS_HIST];             /* latency histogram */
+    };
+
+struct SIM_IOSTATS {
+    SIM_IOSTATS         *next;                          /* registry link */
+    DEVICE              *dptr;                          /* device */
+    UNIT                *uptr;                          /* unit (NULL for device wide) */
+    const char          *type;                          /* "disk", "tape", "ethernet" */
+    SIM_IOSTAT          op[SIM_IOS_OPS];                /* per operation class */
+    SIM_IOSTAT          async;                          /* async completion delay */
+    uint32              queue_depth;                    /* last sampled queue depth */
+    uint32              queue_max;                      /* peak queue depth */
+    t_uint64            queue_sum;                      /* sum of samples */
+    t_uint64            queue_samples;                  /* number of samples */
+    };
 /* 
    The following macros exist to help populate structure contents
 
@@ -73,12 +73,18 @@ Internal routines:
 */
 
 #define _FILE_OFFSET_BITS 64    /* 64 bit file offset for raw I/O operations  */
+#if (defined (__linux) || defined (__linux__)) && !defined (_GNU_SOURCE)
+#define _GNU_SOURCE             /* fallocate() to punch holes in sparse files */
+#endif
 
 #include "sim_defs.h"
 #include "sim_disk.h"
 #include "sim_ether.h"
 #include <ctype.h>
 #include <sys/stat.h>
+#if defined (__linux) || defined (__linux__)
+#include <fcntl.h>
+#endif
 
 #ifdef _WIN32
 #include <windows.h>
@@ -96,6 +102,15 @@ struct disk_context {
     uint32              storage_sector_size;/* Sector size of the containing storage */
     uint32              removable;          /* Removable device flag */
     uint32              auto_format;        /* Format determined dynamically */
+    SIM_IOSTATS         *iostats;           /* I/O statistics */
+    FILE                *ovl_file;          /* copy-on-write overlay data (sparse temp file) */
+    uint32              *ovl_map;           /* overlay sector map (1 bit per sector) */
+    t_lba               ovl_sectors;        /* sectors covered by overlay map */
+    t_lba               ovl_dirty;          /* sectors held in overlay */
+    uint32              no_holes;           /* host file can't have holes punched */
+    uint8               *map_base;          /* memory mapped container */
+    t_offset            map_size;           /* bytes mapped */
+    t_bool              map_ro;             /* mapping is read only */
 #if defined _WIN32
     HANDLE              disk_handle;        /* OS specific Raw device handle */
 #endif
@@ -115,11 +130,18 @@ struct disk_context {
     t_lba               lba;
     DISK_PCALLBACK      callback;
     t_stat              io_status;
+    t_uint64            io_done_time;       /* when the I/O thread completed the request */
 #endif
     };
 
 #define disk_ctx up8                        /* Field in Unit structure which points to the disk_context */
 
+#define OVL_DIRTY(ctx,lba)  (((lba) < (ctx)->ovl_sectors) && ((ctx)->ovl_map[(lba) >> 5] & (1u << ((lba) & 31))))
+#define OVL_RUN             256                 /* max sectors per overlay transfer on commit */
+
+#define DK_HOLE_ALIGN       4096                /* host file hole granularity */
+#define DK_HOLE_MIN         (16*1024)           /* smallest zero write turned into a hole */
+
 #if defined SIM_ASYNCH_IO
 #define AIO_CALLSETUP                                               \
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;   \
@@ -191,6 +213,7 @@ while (ctx->asynch_io) {
         }
     pthread_mutex_lock (&ctx->io_lock);
     ctx->io_dop = DOP_DONE;
+    ctx->io_done_time = sim_iostat_time ();
     pthread_cond_signal (&ctx->io_done);
     sim_activate (uptr, ctx->asynch_io_latency);
     }
@@ -224,6 +247,7 @@ if (ctx->io_dop != DOP_DONE)
 
 if (ctx->callback && ctx->io_dop == DOP_DONE) {
     ctx->callback = NULL;
+    sim_iostat_async (ctx->iostats, ctx->io_done_time);
     callback (uptr, ctx->io_status);
     }
 }
@@ -273,6 +297,8 @@ static void sim_vhd_disk_flush (FILE *f);
 static t_offset sim_vhd_disk_size (FILE *f);
 static t_stat sim_vhd_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects);
 static t_stat sim_vhd_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects);
+static t_stat sim_vhd_disk_rdsect_f (FILE *f, t_lba lba, uint8 *buf, t_seccnt sects, uint32 sector_size);
+static t_stat sim_vhd_disk_wrsect_f (FILE *f, t_lba lba, uint8 *buf, t_seccnt sects, uint32 sector_size);
 static t_stat sim_vhd_disk_clearerr (UNIT *uptr);
 static t_stat sim_vhd_disk_set_dtype (FILE *f, const char *dtype);
 static const char *sim_vhd_disk_get_dtype (FILE *f);
@@ -286,6 +312,10 @@ static t_bool sim_os_disk_isavailable_raw (FILE *f);
 static t_stat sim_os_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects);
 static t_stat sim_os_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects);
 static t_stat sim_os_disk_info_raw (FILE *f, uint32 *sector_size, uint32 *removable);
+static t_stat _sim_disk_map (UNIT *uptr);
+static void _sim_disk_unmap (UNIT *uptr);
+static void _sim_disk_map_flush (UNIT *uptr);
+static t_bool _sim_disk_map_io (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt sects, size_t elem, t_bool write);
 static char *HostPathToVhdPath (const char *szHostPath, char *szVhdPath, size_t VhdPathSize);
 static char *VhdPathToHostPath (const char *szVhdPath, char *szHostPath, size_t HostPathSize);
 static t_offset get_filesystem_size (UNIT *uptr);
@@ -523,6 +553,11 @@ struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 sim_debug (ctx->dbit, ctx->dptr, "_sim_disk_rdsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
+if (_sim_disk_map_io (uptr, lba, buf, sects, ctx->xfer_element_size, FALSE)) {
+    if (sectsread)
+        *sectsread = sects;
+    return SCPE_OK;
+    }
 da = ((t_offset)lba) * ctx->sector_size;
 tbc = sects * ctx->sector_size;
 if (sectsread)
@@ -539,7 +574,7 @@ if (!err) {
 return err;
 }
 
-t_stat sim_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
+static t_stat _sim_disk_rdsect_fmt (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
 {
 t_stat r;
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
@@ -619,6 +654,105 @@ else { /* Unaligned and/or partial sector transfers */
     }
 }
 
+/* Copy-on-write overlay (ATTACH -S)
+
+   The base container is opened read only.  Sectors written are kept in
+   host byte order in an anonymous temporary file at their natural offset
+   (so the file stays sparse) and a bit per sector records which sectors
+   the overlay holds.  Reads are assembled from runs of overlay and base
+   sectors.  Nothing is allocated until the first write.
+*/
+
+static t_stat _sim_disk_ovl_io (struct disk_context *ctx, t_lba lba, uint8 *buf, t_seccnt sects, t_bool write)
+{
+size_t c;
+
+if (sim_fseeko (ctx->ovl_file, ((t_offset)lba)*ctx->sector_size, SEEK_SET))
+    return SCPE_IOERR;
+if (write)
+    c = fwrite (buf, ctx->sector_size, sects, ctx->ovl_file);
+else
+    c = fread (buf, ctx->sector_size, sects, ctx->ovl_file);
+return (c == sects) ? SCPE_OK : SCPE_IOERR;
+}
+
+static t_stat _sim_disk_ovl_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_seccnt done = 0, run, sread;
+t_bool dirty;
+t_stat r = SCPE_OK;
+
+while ((done < sects) && (r == SCPE_OK)) {
+    dirty = OVL_DIRTY (ctx, lba + done);
+    for (run = 1; (done + run < sects) && (OVL_DIRTY (ctx, lba + done + run) == dirty); ++run)
+        ;
+    if (dirty)
+        r = _sim_disk_ovl_io (ctx, lba + done, buf + done*ctx->sector_size, run, FALSE);
+    else {
+        sread = 0;
+        r = _sim_disk_rdsect_fmt (uptr, lba + done, buf + done*ctx->sector_size, &sread, run);
+        if (r != SCPE_OK)
+            run = sread;
+        }
+    if ((r == SCPE_OK) || !dirty)
+        done += run;
+    }
+if (sectsread)
+    *sectsread = done;
+return r;
+}
+
+static t_stat _sim_disk_ovl_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_lba sect;
+t_stat r;
+
+if (sectswritten)
+    *sectswritten = 0;
+if (lba + sects > ctx->ovl_sectors) {                   /* grow sector map */
+    t_lba words = (lba + sects + 31) >> 5;
+    t_lba old_words = ctx->ovl_sectors >> 5;
+    uint32 *map = (uint32 *)realloc (ctx->ovl_map, words*sizeof (*map));
+
+    if (map == NULL)
+        return SCPE_MEM;
+    memset (map + old_words, 0, (words - old_words)*sizeof (*map));
+    ctx->ovl_map = map;
+    ctx->ovl_sectors = words << 5;
+    }
+r = _sim_disk_ovl_io (ctx, lba, buf, sects, TRUE);
+if (r != SCPE_OK)
+    return r;
+for (sect = lba; sect < lba + sects; ++sect) {
+    if (!OVL_DIRTY (ctx, sect)) {
+        ctx->ovl_map[sect >> 5] |= (1u << (sect & 31));
+        ++ctx->ovl_dirty;
+        }
+    }
+if (sectswritten)
+    *sectswritten = sects;
+return SCPE_OK;
+}
+
+t_stat sim_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_uint64 start = sim_iostat_time ();
+t_seccnt sread = 0;
+t_stat r;
+
+if (ctx->ovl_file)
+    r = _sim_disk_ovl_rdsect (uptr, lba, buf, &sread, sects);
+else
+    r = _sim_disk_rdsect_fmt (uptr, lba, buf, &sread, sects);
+if (sectsread)
+    *sectsread = sread;
+sim_iostat_done (ctx->iostats, SIM_IOS_READ, start, ((t_uint64)sread) * ctx->sector_size, r != SCPE_OK);
+return r;
+}
+
 t_stat sim_disk_rdsect_a (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects, DISK_PCALLBACK callback)
 {
 t_stat r = SCPE_OK;
@@ -630,9 +764,63 @@ return r;
 
 /* Write Sectors */
 
+/* Return TRUE if a buffer contains only zeros (compared a word at a time) */
+
+static t_bool _sim_disk_is_zero (const uint8 *buf, size_t size)
+{
+const t_uint64 *wbuf;
+size_t i, words;
+
+while (size && ((size_t)buf & (sizeof (*wbuf) - 1))) {  /* leading unaligned bytes */
+    if (*buf++)
+        return FALSE;
+    --size;
+    }
+wbuf = (const t_uint64 *)buf;
+words = size / sizeof (*wbuf);
+for (i = 0; i < words; i++)
+    if (wbuf[i])
+        return FALSE;
+buf += words * sizeof (*wbuf);
+for (i = 0; i < size % sizeof (*wbuf); i++)
+    if (buf[i])
+        return FALSE;
+return TRUE;
+}
+
+/* Turn the aligned middle of an all zero write to a SIMH format file into
+   a hole.  Only done within the current file size (a hole doesn't extend
+   the file, and writes past the end are how new disks get preallocated).
+   On success the caller writes the unaligned ends [da, *hole_start) and
+   [*hole_end, da + tbc). */
+
+static t_bool _sim_disk_punch_zeros (UNIT *uptr, const uint8 *buf, t_offset da, size_t tbc, t_offset *hole_start, t_offset *hole_end)
+{
+#if defined (FALLOC_FL_PUNCH_HOLE) && defined (FALLOC_FL_KEEP_SIZE)
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+*hole_start = (da + DK_HOLE_ALIGN - 1) & ~((t_offset)(DK_HOLE_ALIGN - 1));
+*hole_end = (da + tbc) & ~((t_offset)(DK_HOLE_ALIGN - 1));
+if (ctx->no_holes ||
+    (*hole_end < *hole_start + DK_HOLE_MIN) ||
+    !_sim_disk_is_zero (buf, tbc))
+    return FALSE;
+fflush (uptr->fileref);
+if (*hole_end > sim_fsize_ex (uptr->fileref))
+    return FALSE;
+if (fallocate (fileno (uptr->fileref), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)*hole_start, (off_t)(*hole_end - *hole_start))) {
+    ctx->no_holes = TRUE;                           /* not supported, stop trying */
+    return FALSE;
+    }
+return TRUE;
+#else
+return FALSE;
+#endif
+}
+
 static t_stat _sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
 {
-t_offset da;
+t_offset da, hole_start, hole_end;
 uint32 err, tbc;
 size_t i;
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
@@ -643,9 +831,34 @@ da = ((t_offset)lba) * ctx->sector_size;
 tbc = sects * ctx->sector_size;
 if (sectswritten)
     *sectswritten = 0;
+if (_sim_disk_punch_zeros (uptr, buf, da, tbc, &hole_start, &hole_end)) {
+    err = sim_fseeko (uptr->fileref, da, SEEK_SET);     /* write the unaligned ends */
+    if (!err) {
+        sim_fwrite (buf, ctx->xfer_element_size, (size_t)((hole_start - da)/ctx->xfer_element_size), uptr->fileref);
+        err = ferror (uptr->fileref);
+        }
+    if (!err)
+        err = sim_fseeko (uptr->fileref, hole_end, SEEK_SET);
+    if (!err) {
+        sim_fwrite (buf, ctx->xfer_element_size, (size_t)((da + tbc - hole_end)/ctx->xfer_element_size), uptr->fileref);
+        err = ferror (uptr->fileref);
+        }
+    if (ctx->map_base)                                  /* keep the mapping current */
+        fflush (uptr->fileref);
+    if ((!err) && (sectswritten))
+        *sectswritten = sects;
+    return err;
+    }
+if (_sim_disk_map_io (uptr, lba, buf, sects, ctx->xfer_element_size, TRUE)) {
+    if (sectswritten)
+        *sectswritten = sects;
+    return SCPE_OK;
+    }
 err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
 if (!err) {
     i = sim_fwrite (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
+    if (ctx->map_base)                                  /* keep the mapping current */
+        fflush (uptr->fileref);
     err = ferror (uptr->fileref);
     if ((!err) && (sectswritten))
         *sectswritten = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
@@ -653,7 +866,7 @@ if (!err) {
 return err;
 }
 
-t_stat sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
+static t_stat _sim_disk_wrsect_fmt (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
 {
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 uint32 f = DK_GET_FMT (uptr);
@@ -789,6 +1002,23 @@ free (tbuf);
 return r;
 }
 
+t_stat sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_uint64 start = sim_iostat_time ();
+t_seccnt swritten = 0;
+t_stat r;
+
+if (ctx->ovl_file)
+    r = _sim_disk_ovl_wrsect (uptr, lba, buf, &swritten, sects);
+else
+    r = _sim_disk_wrsect_fmt (uptr, lba, buf, &swritten, sects);
+if (sectswritten)
+    *sectswritten = swritten;
+sim_iostat_done (ctx->iostats, SIM_IOS_WRITE, start, ((t_uint64)swritten) * ctx->sector_size, r != SCPE_OK);
+return r;
+}
+
 t_stat sim_disk_wrsect_a (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects, DISK_PCALLBACK callback)
 {
 t_stat r = SCPE_OK;
@@ -827,6 +1057,7 @@ sim_disk_clr_async (uptr);
 if (sim_asynch_enabled)
     sim_disk_set_async (uptr, ctx->asynch_io_latency);
 #endif
+_sim_disk_map_flush (uptr);
 switch (f) {                                            /* case on format */
     case DKUF_F_STD:                                    /* Simh */
         fflush (uptr->fileref);
@@ -842,8 +1073,16 @@ switch (f) {                                            /* case on format */
 
 static t_stat _err_return (UNIT *uptr, t_stat stat)
 {
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
 free (uptr->filename);
 uptr->filename = NULL;
+if (ctx) {
+    sim_iostat_close (ctx->iostats);
+    if (ctx->ovl_file)                                  /* discard any overlay */
+        fclose (ctx->ovl_file);
+    free (ctx->ovl_map);
+    }
 free (uptr->disk_ctx);
 uptr->disk_ctx = NULL;
 return stat;
@@ -1296,6 +1535,136 @@ for (i = 0; checks[i] != NULL; i++) {
 return ret_val;
 }
 
+/* ATTACH -C copy pipeline
+
+   While the source unit is read on the calling thread, the previously
+   read chunk is written to (or, when verifying, the same chunk is read
+   back from) the new VHD by a helper thread, so that source and target
+   I/O overlap.  Without asynchronous I/O support, or with it disabled,
+   the helper's work is done inline and the copy runs sequentially.
+*/
+
+#define DK_COPY_BUFSIZE (8*1024*1024)                   /* copy chunk size */
+
+struct disk_copy_pipe {
+    FILE                *vhd;                           /* target VHD */
+    uint32              sector_size;
+    t_bool              write;                          /* helper op: write or read */
+    uint8               *buf;                           /* helper op: buffer */
+    t_lba               lba;                            /* helper op: start */
+    t_seccnt            sects;                          /* helper op: count */
+    t_stat              r;                              /* helper op: status */
+#if defined (SIM_ASYNCH_IO)
+    t_bool              threaded;
+    t_bool              busy;
+    t_bool              shutdown;
+    pthread_t           thread;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+#endif
+    };
+
+static void _disk_copy_io (struct disk_copy_pipe *pipe)
+{
+if (pipe->write)
+    pipe->r = sim_vhd_disk_wrsect_f (pipe->vhd, pipe->lba, pipe->buf, pipe->sects, pipe->sector_size);
+else
+    pipe->r = sim_vhd_disk_rdsect_f (pipe->vhd, pipe->lba, pipe->buf, pipe->sects, pipe->sector_size);
+}
+
+#if defined (SIM_ASYNCH_IO)
+static void *_disk_copy_thread (void *arg)
+{
+struct disk_copy_pipe *pipe = (struct disk_copy_pipe *)arg;
+
+pthread_mutex_lock (&pipe->lock);
+while (1) {
+    while (!pipe->busy && !pipe->shutdown)
+        pthread_cond_wait (&pipe->cond, &pipe->lock);
+    if (pipe->shutdown)
+        break;
+    pthread_mutex_unlock (&pipe->lock);
+    _disk_copy_io (pipe);
+    pthread_mutex_lock (&pipe->lock);
+    pipe->busy = FALSE;
+    pthread_cond_broadcast (&pipe->cond);
+    }
+pthread_mutex_unlock (&pipe->lock);
+return NULL;
+}
+#endif
+
+static void _disk_copy_open (struct disk_copy_pipe *pipe, FILE *vhd, uint32 sector_size)
+{
+memset (pipe, 0, sizeof (*pipe));
+pipe->vhd = vhd;
+pipe->sector_size = sector_size;
+pipe->r = SCPE_OK;
+#if defined (SIM_ASYNCH_IO)
+if (sim_asynch_enabled) {
+    pthread_mutex_init (&pipe->lock, NULL);
+    pthread_cond_init (&pipe->cond, NULL);
+    pipe->threaded = (0 == pthread_create (&pipe->thread, NULL, _disk_copy_thread, (void *)pipe));
+    if (!pipe->threaded) {
+        pthread_cond_destroy (&pipe->cond);
+        pthread_mutex_destroy (&pipe->lock);
+        }
+    }
+#endif
+}
+
+/* Wait for the outstanding helper operation (if any) and return its status */
+
+static t_stat _disk_copy_wait (struct disk_copy_pipe *pipe)
+{
+#if defined (SIM_ASYNCH_IO)
+if (pipe->threaded) {
+    pthread_mutex_lock (&pipe->lock);
+    while (pipe->busy)
+        pthread_cond_wait (&pipe->cond, &pipe->lock);
+    pthread_mutex_unlock (&pipe->lock);
+    }
+#endif
+return pipe->r;
+}
+
+/* Start a helper operation; the previous one must have been waited for */
+
+static void _disk_copy_start (struct disk_copy_pipe *pipe, t_bool write, uint8 *buf, t_lba lba, t_seccnt sects)
+{
+pipe->write = write;
+pipe->buf = buf;
+pipe->lba = lba;
+pipe->sects = sects;
+#if defined (SIM_ASYNCH_IO)
+if (pipe->threaded) {
+    pthread_mutex_lock (&pipe->lock);
+    pipe->busy = TRUE;
+    pthread_cond_broadcast (&pipe->cond);
+    pthread_mutex_unlock (&pipe->lock);
+    return;
+    }
+#endif
+_disk_copy_io (pipe);
+}
+
+static void _disk_copy_close (struct disk_copy_pipe *pipe)
+{
+_disk_copy_wait (pipe);
+#if defined (SIM_ASYNCH_IO)
+if (pipe->threaded) {
+    pthread_mutex_lock (&pipe->lock);
+    pipe->shutdown = TRUE;
+    pthread_cond_broadcast (&pipe->cond);
+    pthread_mutex_unlock (&pipe->lock);
+    pthread_join (pipe->thread, NULL);
+    pthread_cond_destroy (&pipe->cond);
+    pthread_mutex_destroy (&pipe->lock);
+    pipe->threaded = FALSE;
+    }
+#endif
+}
+
 t_stat sim_disk_attach (UNIT *uptr, const char *cptr, size_t sector_size, size_t xfer_element_size, t_bool dontautosize,
                         uint32 dbit, const char *dtype, uint32 pdp11tracksize, int completion_delay)
 {
@@ -1369,68 +1738,74 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
         return sim_messagef (r, "%s%d: can't create virtual disk '%s'\n", sim_dname (dptr), (int)(uptr-dptr->units), gbuf);
         }
     else {
-        uint8 *copy_buf = (uint8*) malloc (1024*1024);
-        t_lba lba;
-        t_seccnt sectors_per_buffer = (t_seccnt)((1024*1024)/sector_size);
+        struct disk_copy_pipe pipe;
+        uint8 *copy_buf[2];
+        t_lba lba, chunk_lba = 0;
+        t_seccnt sectors_per_buffer = (t_seccnt)(DK_COPY_BUFSIZE/sector_size);
         t_lba total_sectors = (t_lba)((uptr->capac*capac_factor)/(sector_size/((dptr->flags & DEV_SECTORS) ? 512 : 1)));
         t_seccnt sects = sectors_per_buffer;
+        int which = 0;
 
-        if (!copy_buf) {
+        copy_buf[0] = (uint8*) malloc (DK_COPY_BUFSIZE);
+        copy_buf[1] = (uint8*) malloc (DK_COPY_BUFSIZE);
+        if (!copy_buf[0] || !copy_buf[1]) {
+            free (copy_buf[0]);
+            free (copy_buf[1]);
             sim_vhd_disk_close(vhd);
             (void)remove (gbuf);
             return SCPE_MEM;
             }
+        /* Read chunk N from the source while chunk N-1 is written to the VHD.
+           Data read from the source is put back in on-disk byte order so that
+           it can be written to the VHD as is. */
+        _disk_copy_open (&pipe, vhd, (uint32)sector_size);
         for (lba = 0; (lba < total_sectors) && (r == SCPE_OK); lba += sects) {
             sim_messagef (SCPE_OK, "%s%d: Copied %dMB.  %d%% complete.\r", sim_dname (dptr), (int)(uptr-dptr->units), (int)((((float)lba)*sector_size)/1000000), (int)((((float)lba)*100)/total_sectors));
             sects = sectors_per_buffer;
             if (lba + sects > total_sectors)
                 sects = total_sectors - lba;
-            r = sim_disk_rdsect (uptr, lba, copy_buf, NULL, sects);
+            r = sim_disk_rdsect (uptr, lba, copy_buf[which], NULL, sects);
             if (r == SCPE_OK) {
-                uint32 saved_unit_flags = uptr->flags;
-                FILE *save_unit_fileref = uptr->fileref;
-
-                sim_disk_set_fmt (uptr, 0, "VHD", NULL);
-                uptr->fileref = vhd;
-                r = sim_disk_wrsect (uptr, lba, copy_buf, NULL, sects);
-                uptr->fileref = save_unit_fileref;
-                uptr->flags = saved_unit_flags;
+                sim_buf_swap_data (copy_buf[which], xfer_element_size, (sects * sector_size) / xfer_element_size);
+                r = _disk_copy_wait (&pipe);            /* previous chunk written */
+                }
+            if (r == SCPE_OK) {
+                _disk_copy_start (&pipe, TRUE, copy_buf[which], lba, sects);
+                which ^= 1;
                 }
             }
+        _disk_copy_close (&pipe);
+        if (r == SCPE_OK)
+            r = pipe.r;
         if (r == SCPE_OK)
             sim_messagef (SCPE_OK, "\n%s%d: Copied %dMB. Done.\n", sim_dname (dptr), (int)(uptr-dptr->units), (int)(((t_offset)lba*sector_size)/1000000));
         else
             sim_messagef (r, "\n%s%d: Error copying: %s.\n", sim_dname (dptr), (int)(uptr-dptr->units), sim_error_text (r));
         if ((r == SCPE_OK) && (sim_switches & SWMASK ('V'))) {
-            uint8 *verify_buf = (uint8*) malloc (1024*1024);
+            uint8 *verify_buf = copy_buf[1];
 
-            if (!verify_buf) {
-                sim_vhd_disk_close(vhd);
-                (void)remove (gbuf);
-                free (copy_buf);
-                return SCPE_MEM;
-                }
+            /* Read each chunk back from the VHD while the source is re-read */
+            _disk_copy_open (&pipe, vhd, (uint32)sector_size);
             for (lba = 0; (lba < total_sectors) && (r == SCPE_OK); lba += sects) {
+                t_stat vr;
+
                 sim_messagef (SCPE_OK, "%s%d: Verified %dMB.  %d%% complete.\r", sim_dname (dptr), (int)(uptr-dptr->units), (int)((((float)lba)*sector_size)/1000000), (int)((((float)lba)*100)/total_sectors));
                 sects = sectors_per_buffer;
                 if (lba + sects > total_sectors)
                     sects = total_sectors - lba;
-                r = sim_disk_rdsect (uptr, lba, copy_buf, NULL, sects);
+                chunk_lba = lba;
+                _disk_copy_start (&pipe, FALSE, verify_buf, lba, sects);
+                r = sim_disk_rdsect (uptr, lba, copy_buf[0], NULL, sects);
+                vr = _disk_copy_wait (&pipe);
+                if (r == SCPE_OK)
+                    r = vr;
                 if (r == SCPE_OK) {
-                    uint32 saved_unit_flags = uptr->flags;
-                    FILE *save_unit_fileref = uptr->fileref;
-
-                    sim_disk_set_fmt (uptr, 0, "VHD", NULL);
-                    uptr->fileref = vhd;
-                    r = sim_disk_rdsect (uptr, lba, verify_buf, NULL, sects);
-                    uptr->fileref = save_unit_fileref;
-                    uptr->flags = saved_unit_flags;
-                    if (r == SCPE_OK) {
-                        if (0 != memcmp (copy_buf, verify_buf, 1024*1024))
-                            r = SCPE_IOERR;
-                        }
+                    sim_buf_swap_data (copy_buf[0], xfer_element_size, (sects * sector_size) / xfer_element_size);
+                    if (0 != memcmp (copy_buf[0], verify_buf, sects * sector_size))
+                        r = SCPE_IOERR;
                     }
                 }
+            _disk_copy_close (&pipe);
             if (!sim_quiet) {
                 if (r == SCPE_OK)
                     sim_messagef (r, "\n%s%d: Verified %dMB. Done.\n", sim_dname (dptr), (int)(uptr-dptr->units), (int)(((t_offset)lba*sector_size)/1000000));
@@ -1439,21 +1814,25 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
                     uint32 save_dctrl = dptr->dctrl;
                     FILE *save_sim_deb = sim_deb;
 
-                    for (i = 0; i < (1024*1024/sector_size); ++i)
-                        if (0 != memcmp (copy_buf+i*sector_size, verify_buf+i*sector_size, sector_size))
+                    for (i = 0; i < sects; ++i)
+                        if (0 != memcmp (copy_buf[0]+i*sector_size, verify_buf+i*sector_size, sector_size))
                             break;
-                    sim_printf ("\n%s%d: Verification Error on lbn %d.\n", sim_dname (dptr), (int)(uptr-dptr->units), lba+i);
+                    if (i == sects)                     /* I/O error rather than mismatch */
+                        i = 0;
+                    sim_buf_swap_data (copy_buf[0], xfer_element_size, (sects * sector_size) / xfer_element_size);
+                    sim_buf_swap_data (verify_buf, xfer_element_size, (sects * sector_size) / xfer_element_size);
+                    sim_printf ("\n%s%d: Verification Error on lbn %d.\n", sim_dname (dptr), (int)(uptr-dptr->units), chunk_lba+i);
                     dptr->dctrl = 0xFFFFFFFF;
                     sim_deb = stdout;
-                    sim_disk_data_trace (uptr,   copy_buf+i*sector_size, lba+i, sector_size, "Expected", TRUE, 1);
-                    sim_disk_data_trace (uptr, verify_buf+i*sector_size, lba+i, sector_size,    "Found", TRUE, 1);
+                    sim_disk_data_trace (uptr, copy_buf[0]+i*sector_size, chunk_lba+i, sector_size, "Expected", TRUE, 1);
+                    sim_disk_data_trace (uptr,   verify_buf+i*sector_size, chunk_lba+i, sector_size,    "Found", TRUE, 1);
                     dptr->dctrl = save_dctrl;
                     sim_deb = save_sim_deb;
                     }
                 }
-            free (verify_buf);
             }
-        free (copy_buf);
+        free (copy_buf[0]);
+        free (copy_buf[1]);
         sim_vhd_disk_close (vhd);
         sim_disk_detach (uptr);
         if (r == SCPE_OK) {
@@ -1526,10 +1905,20 @@ ctx->capac_factor = ((dptr->dwidth / dptr->aincr) == 16) ? 2 : 1; /* save capaci
 ctx->xfer_element_size = (uint32)xfer_element_size;     /* save xfer_element_size */
 ctx->dptr = dptr;                                       /* save DEVICE pointer */
 ctx->dbit = dbit;                                       /* save debug bit */
+ctx->iostats = sim_iostat_open (dptr, uptr, "disk");    /* register I/O statistics */
 sim_debug (ctx->dbit, ctx->dptr, "sim_disk_attach(unit=%d,filename='%s')\n", (int)(uptr-ctx->dptr->units), uptr->filename);
 ctx->auto_format = auto_format;                         /* save that we auto selected format */
 ctx->storage_sector_size = (uint32)sector_size;         /* Default */
-if ((sim_switches & SWMASK ('R')) ||                    /* read only? */
+if (sim_switches & SWMASK ('S')) {                      /* copy-on-write overlay? */
+    ctx->ovl_file = tmpfile ();                         /* overlay data */
+    if (ctx->ovl_file == NULL)
+        return _err_return (uptr, SCPE_OPENERR);
+    uptr->fileref = open_function (cptr, "rb");         /* base is only read */
+    if (uptr->fileref == NULL)                          /* open fail? */
+        return _err_return (uptr, SCPE_OPENERR);        /* yes, error */
+    sim_messagef (SCPE_OK, "%s%d: writes go to a scratch overlay\n", sim_dname (dptr), (int)(uptr-dptr->units));
+    }
+else if ((sim_switches & SWMASK ('R')) ||               /* read only? */
     ((uptr->flags & UNIT_RO) != 0)) {
     if (((uptr->flags & UNIT_ROABLE) == 0) &&           /* allowed? */
         ((uptr->flags & UNIT_RO) == 0))
@@ -1741,6 +2130,11 @@ if (capac && (capac != (t_offset)-1)) {
         }
     }
 
+if (sim_switches & SWMASK ('P')) {                      /* memory mapped access? */
+    if (_sim_disk_map (uptr) != SCPE_OK)
+        sim_messagef (SCPE_OK, "%s%d: can't map '%s' into memory, using file I/O\n", sim_dname (dptr), (int)(uptr-dptr->units), cptr);
+    }
+
 #if defined (SIM_ASYNCH_IO)
 sim_disk_set_async (uptr, completion_delay);
 #endif
@@ -1749,6 +2143,72 @@ uptr->io_flush = _sim_disk_io_flush;
 return SCPE_OK;
 }
 
+/* Write the sectors held in a copy-on-write overlay back to the base container */
+
+static t_stat _sim_disk_ovl_commit (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+FILE *(*open_function)(const char *filename, const char *mode);
+int (*close_function)(FILE *f);
+FILE *base = uptr->fileref;
+uint8 *map_base = ctx->map_base;                        /* read only mapping of base */
+uint8 *buf;
+t_lba lba = 0;
+t_seccnt run;
+t_stat r = SCPE_OK;
+
+switch (DK_GET_FMT (uptr)) {                            /* case on format */
+    case DKUF_F_STD:                                    /* Simh */
+        open_function = sim_fopen;
+        close_function = fclose;
+        break;
+    case DKUF_F_VHD:                                    /* Virtual Disk */
+        open_function = sim_vhd_disk_open;
+        close_function = sim_vhd_disk_close;
+        break;
+    case DKUF_F_RAW:                                    /* Physical */
+        open_function = sim_os_disk_open_raw;
+        close_function = sim_os_disk_close_raw;
+        break;
+    default:
+        return SCPE_IERR;
+        }
+buf = (uint8 *)malloc (OVL_RUN*ctx->sector_size);
+if (buf == NULL)
+    return SCPE_MEM;
+uptr->fileref = open_function (uptr->filename, "rb+");
+if (uptr->fileref == NULL) {
+    uptr->fileref = base;
+    free (buf);
+    return sim_messagef (SCPE_OPENERR, "%s%d: can't write '%s', overlay not committed\n", sim_dname (ctx->dptr), (int)(uptr-ctx->dptr->units), uptr->filename);
+    }
+ctx->map_base = NULL;                                   /* write through the new handle */
+while ((lba < ctx->ovl_sectors) && (r == SCPE_OK)) {
+    if (ctx->ovl_map[lba >> 5] == 0) {                  /* skip clean words */
+        lba = (lba | 31) + 1;
+        continue;
+        }
+    if (!OVL_DIRTY (ctx, lba)) {
+        ++lba;
+        continue;
+        }
+    for (run = 1; (run < OVL_RUN) && OVL_DIRTY (ctx, lba + run); ++run)
+        ;
+    r = _sim_disk_ovl_io (ctx, lba, buf, run, FALSE);
+    if (r == SCPE_OK)
+        r = _sim_disk_wrsect_fmt (uptr, lba, buf, NULL, run);
+    lba += run;
+    }
+if ((close_function (uptr->fileref) == EOF) && (r == SCPE_OK))
+    r = SCPE_IOERR;
+uptr->fileref = base;
+ctx->map_base = map_base;
+free (buf);
+if (r != SCPE_OK)
+    return sim_messagef (r, "%s%d: error committing overlay to '%s': %s\n", sim_dname (ctx->dptr), (int)(uptr-ctx->dptr->units), uptr->filename, sim_error_text (r));
+return sim_messagef (SCPE_OK, "%s%d: committed %u overlay sectors to '%s'\n", sim_dname (ctx->dptr), (int)(uptr-ctx->dptr->units), (uint32)ctx->ovl_dirty, uptr->filename);
+}
+
 t_stat sim_disk_detach (UNIT *uptr)
 {
 struct disk_context *ctx;
@@ -1788,6 +2248,18 @@ auto_format = ctx->auto_format;
 if (uptr->io_flush)
     uptr->io_flush (uptr);                              /* flush buffered data */
 
+if (ctx->ovl_file) {                                    /* copy-on-write overlay? */
+    if (sim_switches & SWMASK ('W')) {                  /* commit it? */
+        t_stat r = _sim_disk_ovl_commit (uptr);
+
+        if (r != SCPE_OK)
+            return r;                                   /* stay attached */
+        }
+    fclose (ctx->ovl_file);                             /* discard */
+    free (ctx->ovl_map);
+    }
+_sim_disk_unmap (uptr);
+
 sim_disk_clr_async (uptr);
 
 uptr->flags &= ~(UNIT_ATT | UNIT_RO);
@@ -1795,6 +2267,7 @@ uptr->dynflags &= ~(UNIT_NO_FIO | UNIT_DISK_CHK);
 free (uptr->filename);
 uptr->filename = NULL;
 uptr->fileref = NULL;
+sim_iostat_close (ctx->iostats);
 free (uptr->disk_ctx);
 uptr->disk_ctx = NULL;
 uptr->io_flush = NULL;
@@ -1860,6 +2333,14 @@ fprintf (st, "    -V          Perform a verification pass to confirm successful
 fprintf (st, "                operation.\n");
 fprintf (st, "    -X          When creating a VHD, create a fixed sized VHD (vs a Dynamically\n");
 fprintf (st, "                expanding one).\n");
+fprintf (st, "    -S          Attach with a scratch copy-on-write overlay.  The disk container\n");
+fprintf (st, "                is opened read only and is never changed while attached;\n");
+fprintf (st, "                writes are kept in a temporary overlay which is discarded on\n");
+fprintf (st, "                DETACH, or written back to the container by DETACH -W.  Any\n");
+fprintf (st, "                number of simulators may share one container this way.\n");
+fprintf (st, "    -P          Access a SIMH format or RAW disk container through a memory\n");
+fprintf (st, "                mapping of the file rather than with file I/O (falls back to\n");
+fprintf (st, "                file I/O if the container can't be mapped).\n");
 fprintf (st, "    -D          Create a Differencing VHD (relative to an already existing VHD\n");
 fprintf (st, "                disk)\n");
 fprintf (st, "    -M          Merge a Differencing VHD into its parent VHD disk\n");
@@ -2552,6 +3033,8 @@ return SCPE_IOERR;
 #include <fcntl.h>
 #include <unistd.h>
 
+#define SIM_OS_DISK_RAW_FD(f) ((int)((long)(f)))    /* raw device FILE * is really a file descriptor */
+
 static t_stat sim_os_disk_implemented_raw (void)
 {
 return sim_toffset_64 ? SCPE_OK : SCPE_NOFNC;
@@ -2614,6 +3097,11 @@ ssize_t bytesread;
 
 sim_debug (ctx->dbit, ctx->dptr, "sim_os_disk_rdsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
+if (_sim_disk_map_io (uptr, lba, buf, sects, 1, FALSE)) {
+    if (sectsread)
+        *sectsread = sects;
+    return SCPE_OK;
+    }
 addr = ((off_t)lba) * ctx->sector_size;
 bytesread = pread((int)((long)uptr->fileref), buf, sects * ctx->sector_size, addr);
 if (bytesread < 0) {
@@ -2634,6 +3122,11 @@ ssize_t byteswritten;
 
 sim_debug (ctx->dbit, ctx->dptr, "sim_os_disk_wrsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
+if (_sim_disk_map_io (uptr, lba, buf, sects, 1, TRUE)) {
+    if (sectswritten)
+        *sectswritten = sects;
+    return SCPE_OK;
+    }
 addr = ((off_t)lba) * ctx->sector_size;
 byteswritten = pwrite((int)((long)uptr->fileref), buf, sects * ctx->sector_size, addr);
 if (byteswritten < 0) {
@@ -2711,6 +3204,114 @@ return SCPE_NOFNC;
 
 #endif
 
+/* Memory mapped access to SIMH format and RAW containers (ATTACH -P)
+
+   The container is mapped shared so that transfers become copies to and
+   from the host's page cache.  Transfers reaching beyond the mapped size
+   (e.g. a SIMH format file shorter than the simulated drive) use file I/O,
+   which is flushed at once so that the mapping never sees stale data.  A
+   read only mapping leaves writes to file I/O, which then reports the error.
+*/
+
+#if !defined (_WIN32) && !defined (VMS)
+
+#include <sys/mman.h>
+
+static t_stat _sim_disk_map (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_offset size, capac;
+void *base;
+int fd;
+
+switch (DK_GET_FMT (uptr)) {                            /* case on format */
+    case DKUF_F_STD:                                    /* SIMH format */
+        fflush (uptr->fileref);
+        fd = fileno (uptr->fileref);
+        size = sim_fsize_ex (uptr->fileref);
+        break;
+#if defined (SIM_OS_DISK_RAW_FD)
+    case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
+        fd = SIM_OS_DISK_RAW_FD (uptr->fileref);
+        size = sim_os_disk_size_raw (uptr->fileref);
+        break;
+#endif
+    default:
+        return SCPE_NOFNC;
+    }
+capac = ((t_offset)uptr->capac)*ctx->capac_factor*((ctx->dptr->flags & DEV_SECTORS) ? 512 : 1);
+if ((size == (t_offset)-1) || (size > capac))
+    size = capac;
+size -= size % ctx->sector_size;
+if (size <= 0)
+    return SCPE_NOFNC;
+if ((t_offset)((size_t)size) != size)                   /* larger than the address space? */
+    return SCPE_MEM;
+ctx->map_ro = ((uptr->flags & UNIT_RO) || ctx->ovl_file);
+base = mmap (NULL, (size_t)size, ctx->map_ro ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+if (base == MAP_FAILED)
+    return SCPE_MEM;
+ctx->map_base = (uint8 *)base;
+ctx->map_size = size;
+return SCPE_OK;
+}
+
+static void _sim_disk_unmap (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+if (ctx->map_base == NULL)
+    return;
+msync (ctx->map_base, (size_t)ctx->map_size, MS_SYNC);
+munmap (ctx->map_base, (size_t)ctx->map_size);
+ctx->map_base = NULL;
+ctx->map_size = 0;
+}
+
+static void _sim_disk_map_flush (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+if (ctx->map_base)
+    msync (ctx->map_base, (size_t)ctx->map_size, MS_ASYNC);
+}
+
+#else
+
+static t_stat _sim_disk_map (UNIT *uptr)
+{
+return SCPE_NOFNC;
+}
+
+static void _sim_disk_unmap (UNIT *uptr)
+{
+}
+
+static void _sim_disk_map_flush (UNIT *uptr)
+{
+}
+
+#endif
+
+/* Transfer via the mapping if it covers the request and allows it; returns
+   FALSE if the caller must use file I/O.  Data is swapped in units of elem
+   bytes. */
+
+static t_bool _sim_disk_map_io (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt sects, size_t elem, t_bool write)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_offset da = ((t_offset)lba) * ctx->sector_size;
+size_t tbc = ((size_t)sects) * ctx->sector_size;
+
+if ((ctx->map_base == NULL) || (da + tbc > ctx->map_size) || (write && ctx->map_ro))
+    return FALSE;
+if (write)
+    sim_buf_copy_swapped (ctx->map_base + (size_t)da, buf, elem, tbc/elem);
+else
+    sim_buf_copy_swapped (buf, ctx->map_base + (size_t)da, elem, tbc/elem);
+return TRUE;
+}
+
 /* OS Independent Disk Virtual Disk (VHD) I/O support */
 
 #if (defined (VMS) && !(defined (__ALPHA) || defined (__ia64)))
@@ -2778,6 +3379,16 @@ static t_stat sim_vhd_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *
 return SCPE_IOERR;
 }
 
+static t_stat sim_vhd_disk_rdsect_f (FILE *f, t_lba lba, uint8 *buf, t_seccnt sects, uint32 sector_size)
+{
+return SCPE_IOERR;
+}
+
+static t_stat sim_vhd_disk_wrsect_f (FILE *f, t_lba lba, uint8 *buf, t_seccnt sects, uint32 sector_size)
+{
+return SCPE_IOERR;
+}
+
 static t_stat sim_vhd_disk_set_dtype (FILE *f, const char *dtype)
 {
 return SCPE_NOFNC;
@@ -4320,6 +4931,19 @@ struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 return ReadVirtualDiskSectors(hVHD, buf, sects, sectsread, ctx->sector_size, lba);
 }
 
+/* Sector I/O on an open VHD without a unit (used by the ATTACH -C copier).
+   Data is in on-disk byte order. */
+
+static t_stat sim_vhd_disk_rdsect_f (FILE *f, t_lba lba, uint8 *buf, t_seccnt sects, uint32 sector_size)
+{
+return ReadVirtualDiskSectors((VHDHANDLE)f, buf, sects, NULL, sector_size, lba);
+}
+
+static t_stat sim_vhd_disk_wrsect_f (FILE *f, t_lba lba, uint8 *buf, t_seccnt sects, uint32 sector_size)
+{
+return WriteVirtualDiskSectors((VHDHANDLE)f, buf, sects, NULL, sector_size, lba);
+}
+
 static t_stat sim_vhd_disk_clearerr (UNIT *uptr)
 {
 VHDHANDLE hVHD = (VHDHANDLE)uptr->fileref;
@@ -4331,13 +4955,7 @@ return SCPE_OK;
 static t_bool
 BufferIsZeros(void *Buffer, size_t BufferSize)
 {
-size_t i;
-char *c = (char *)Buffer;
-
-for (i=0; i<BufferSize; ++i)
-    if (c[i])
-        return FALSE;
-return TRUE;
+return _sim_disk_is_zero ((const uint8 *)Buffer, BufferSize);
 }
 
 static t_stat
@@ -4396,9 +5014,32 @@ while (sects) {
         uint8 *BATUpdateBufferAddress;
         uint32 BATUpdateBufferSize;
         uint64 BATUpdateStorageAddress;
-
-        if (!hVHD->Parent && BufferIsZeros(buf, SectorSize))
+        uint8 *BlockFill = NULL;
+
+        /* A write covering the whole block supplies its initial contents
+           (saving a second write of the block), or leaves the block
+           unallocated when it is all zeros */
+        if (!hVHD->Parent &&
+            (0 == lba%SectorsPerBlock) &&
+            (sects >= SectorsPerBlock) &&
+            (BitMapBytes == BitMapSectors*SectorSize)) {
+            if (BufferIsZeros(buf, SectorsPerBlock*SectorSize)) {
+                SectorsInWrite = SectorsPerBlock;
+                goto IO_Done;
+                }
+            BlockFill = buf;
+            }
+        if (!hVHD->Parent && BufferIsZeros(buf, SectorSize)) {
+            /* Leave the block unallocated for the whole run of zero sectors */
+            uint32 SectorsInBlock = SectorsPerBlock - lba%SectorsPerBlock;
+
+            if (SectorsInBlock > sects)
+                SectorsInBlock = sects;
+            while ((SectorsInWrite < SectorsInBlock) &&
+                   BufferIsZeros(buf + SectorsInWrite*SectorSize, SectorSize))
+                ++SectorsInWrite;
             goto IO_Done;
+            }
         /* Need to allocate a new Data Block. */
         BlockOffset = sim_fsize_ex (hVHD->File);
         if (((int64)BlockOffset) == -1)
@@ -4414,6 +5055,8 @@ while (sects) {
         BlockOffset -= sizeof(hVHD->Footer);
         if (0 == (BlockOffset & ~(VHD_DATA_BLOCK_ALIGNMENT-1)))
             {  // Already aligned, so use padded BitMapBuffer
+            if (BlockFill)
+                memcpy(BitMapBuffer + BitMapBufferSize, BlockFill, SectorSize*SectorsPerBlock);
             if (WriteFilePosition(hVHD->File,
                                   BitMapBuffer,
                                   BitMapBufferSize + SectorSize*SectorsPerBlock,
@@ -4433,6 +5076,8 @@ while (sects) {
             BlockOffset += VHD_DATA_BLOCK_ALIGNMENT-1;
             BlockOffset &= ~(VHD_DATA_BLOCK_ALIGNMENT-1);
             BlockOffset -= BitMapSectors*SectorSize;
+            if (BlockFill)
+                memcpy(BitMap + BitMapSectors*SectorSize, BlockFill, SectorSize*SectorsPerBlock);
             if (WriteFilePosition(hVHD->File,
                                   BitMap,
                                   SectorSize * (BitMapSectors + SectorsPerBlock),
@@ -4504,6 +5149,10 @@ while (sects) {
                 goto Fatal_IO_Error;
             free(BlockData);
             }
+        if (BlockFill) {
+            SectorsInWrite = SectorsPerBlock;
+            goto IO_Done;
+            }
         continue;
 Fatal_IO_Error:
         free (BitMap);
@@ -919,6 +919,7 @@ void ethq_insert_data(ETH_QUE* que, int32 type, const uint8 *data, int used, siz
       memcpy(&item->packet.oversize[len], crc_data, ETH_CRC_SIZE);
     }
   item->packet.status = status;
+  item->queued = 0;
 }
 
 void ethq_insert(ETH_QUE* que, int32 type, ETH_PACK* pack, int32 status)
@@ -2300,6 +2301,7 @@ strcpy(dev->name, savname);
 /* save debugging information */
 dev->dptr = dptr;
 dev->dbit = dbit;
+dev->iostats = sim_iostat_open (dptr, NULL, "ethernet");
 
 #if defined (USE_READER_THREAD)
 if (1) {
@@ -2402,6 +2404,7 @@ _eth_close_port (dev->eth_api, pcap, pcap_fd);
 sim_printf ("Eth: closed %s\r\n", dev->name);
 
 /* clean up the mess */
+sim_iostat_close (dev->iostats);
 free(dev->name);
 free(dev->bpf_filter);
 eth_zero(dev);
@@ -2678,6 +2681,7 @@ static
 t_stat _eth_write(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
 {
 int status = 1;   /* default to failure */
+t_uint64 start;
 
 /* make sure device exists */
 if ((!dev) || (dev->eth_api == ETH_API_NONE)) return SCPE_UNATT;
@@ -2712,6 +2716,7 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
   }
 
     /* dispatch write request (synchronous; no need to save write info to dev) */
+  start = sim_iostat_time ();
   switch (dev->eth_api) {
 #ifdef HAVE_PCAP_NETWORK
     case ETH_API_PCAP:
@@ -2749,6 +2754,7 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
       break;
     }
   ++dev->packets_sent;              /* basic bookkeeping */
+  sim_iostat_done (dev->iostats, SIM_IOS_WRITE, start, packet->len, (status != 0));
   /* On error, correct loopback bookkeeping */
   if ((status != 0) && loopback_self_frame) {
 #ifdef USE_READER_THREAD
@@ -3444,6 +3450,7 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
 
     pthread_mutex_lock (&dev->lock);
     ethq_insert_data(&dev->read_queue, ETH_ITM_NORMAL, data, 0, len, crc_len, crc_data, 0);
+    dev->read_queue.item[dev->read_queue.tail].queued = sim_iostat_time ();
     ++dev->packets_received;
     pthread_mutex_unlock (&dev->lock);
     free(moved_data);
@@ -3483,6 +3490,7 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
 int eth_read(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
 {
 int status;
+t_uint64 start;
 
 /* make sure device exists */
 
@@ -3492,6 +3500,7 @@ if ((!dev) || (dev->eth_api == ETH_API_NONE)) return 0;
 if (!packet) return 0;
 
 packet->len = 0;
+start = sim_iostat_time ();
 #if !defined (USE_READER_THREAD)
 /* set read packet */
 dev->read_packet = packet;
@@ -3580,18 +3589,23 @@ if (status < 0) {
   ++dev->receive_packet_errors;
   _eth_error (dev, "eth_reader");
   }
+if (packet->len)
+  sim_iostat_done (dev->iostats, SIM_IOS_READ, start, packet->len, FALSE);
 
 #else /* USE_READER_THREAD */
 
   status = 0;
   pthread_mutex_lock (&dev->lock);
+  sim_iostat_queue (dev->iostats, dev->read_queue.count);
   if (dev->read_queue.count > 0) {
     ETH_ITEM* item = &dev->read_queue.item[dev->read_queue.head];
+    sim_iostat_async (dev->iostats, item->queued);
     packet->len = item->packet.len;
     packet->crc_len = item->packet.crc_len;
     memcpy(packet->msg, item->packet.msg, ((packet->len > packet->crc_len) ? packet->len : packet->crc_len));
     status = 1;
     ethq_remove(&dev->read_queue);
+    sim_iostat_done (dev->iostats, SIM_IOS_READ, start, packet->len, FALSE);
   }
   pthread_mutex_unlock (&dev->lock);  
   if ((status) && (routine))
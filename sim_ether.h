@@ -217,6 +217,7 @@ struct eth_item {
 #define ETH_ITM_LOOPBACK 1
 #define ETH_ITM_NORMAL   2
   struct eth_packet   packet;
+  t_uint64            queued;                           /* host time queued (usecs) */
 };
 
 struct eth_queue {
@@ -306,6 +307,7 @@ struct eth_device {
   uint32        throttle_events;                        /* keeps track of packet arrival values */
   uint32        throttle_packet_time;                   /* time last packet was transmitted */
   uint32        throttle_count;                         /* Total Throttle Delays */
+  SIM_IOSTATS*  iostats;                                /* I/O statistics */
 #if defined (USE_READER_THREAD)
   int           asynch_io;                              /* Asynchronous Interrupt scheduling enabled */
   int           asynch_io_latency;                      /* instructions to delay pending interrupt */
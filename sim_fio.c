@@ -52,6 +52,12 @@
    sim_buf_swap_data -       swap data elements inplace in buffer
    sim_shmem_open            create or attach to a shared memory region
    sim_shmem_close           close a shared memory region
+   sim_ustream_close         finish buffered unit record I/O on a unit
+   sim_ustream_read/write    buffered unit record transfers
+   sim_ustream_getc/putc/puts  buffered character and string transfers
+   sim_ustream_gets/ungetc   buffered line reads and character push back
+   sim_ustream_eof           end of file reached by buffered reads
+   sim_ustream_error         pending error for buffered transfers
 
 
    sim_fopen and sim_fseek are OS-dependent.  The other routines are not.
@@ -599,3 +605,537 @@ free (shmem);
 }
 
 #endif
+
+/* Buffered unit record streams
+
+   Line printers, card readers and punches and paper tape devices move
+   their data a character or a line at a time.  Done directly with stdio
+   on the attached file, that costs a library call (and frequently a
+   system call) per character on the simulation thread.  A unit record
+   stream moves the data through a pair of large buffers instead: the
+   simulator fills (or drains) one while the other is being written out
+   (or read ahead) by a helper thread when asynchronous I/O is enabled, or
+   directly when it is not.
+
+   A stream is set up by the first sim_ustream transfer on an attached
+   unit, and is closed by detach_unit.  The stream keeps the logical
+   position in uptr->pos, and notices a changed uptr->pos (from the user
+   or a REWIND) on its next transfer.
+   Whenever the simulator stops, the unit's io_flush routine writes out
+   any buffered output and abandons any read ahead, leaving the file
+   positioned at uptr->pos exactly as unbuffered I/O would.  Output that
+   sits in a partly filled buffer is also written out by a short timer
+   (USTREAM_FLUSH_USEC after it was buffered) so that someone watching
+   the output file while the simulator runs or idles sees it promptly.
+   Host errors on writes done in the background are reported by the next
+   write or flush.  If a stream can't be set up, the sim_ustream routines
+   fall back to plain stdio on the attached file.  That is also the case
+   for a file which isn't a regular file (a pipe, FIFO or device): it
+   can't be repositioned to abandon a read ahead, and a read ahead could
+   block waiting for input that hasn't been typed yet.
+*/
+
+#define USTREAM_BUFSIZE (256 * 1024)
+#define USTREAM_FLUSH_USEC 500000                       /* partial buffer write out delay */
+
+#define USTREAM_IDLE    0
+#define USTREAM_READ    1
+#define USTREAM_WRITE   2
+
+struct sim_ustream {
+    struct sim_ustream  *next;              /* list of open streams */
+    FILE                *file;
+    int                 mode;               /* current direction */
+    uint8               *buf[2];
+    int                 cur;                /* buffer in use by the simulator */
+    size_t              len;                /* bytes in (read) or added to (write) it */
+    size_t              idx;                /* next byte to return (read) */
+    t_offset            pos;                /* logical position */
+    t_bool              eof;                /* read hit end of file */
+    t_bool              direct;             /* not a regular file, use stdio */
+    int                 err;                /* pending host error (errno) */
+    t_bool              busy;               /* transfer outstanding */
+    t_bool              ahead;              /*   it is a read ahead */
+    int                 job_buf;            /*   buffer being transferred */
+    size_t              job_len;            /*   bytes to write, bytes read */
+    int                 job_err;            /*   errno if it failed */
+#if defined (SIM_ASYNCH_IO)
+    t_bool              threaded;
+    t_bool              shutdown;
+    pthread_t           thread;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+#endif
+    };
+
+static struct sim_ustream *ustream_list = NULL;
+
+static t_stat _ustream_timer_svc (UNIT *uptr);
+
+static UNIT sim_ustream_unit = { UDATA (&_ustream_timer_svc, 0, 0) };
+
+static DEVICE sim_ustream_dev = {
+    "INT-USTREAM", &sim_ustream_unit, NULL, NULL,
+    1, 0, 0, 0, 0, 0,
+    NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, DEV_NOSAVE};
+
+/* The unit's stream, NULL if it has none or uses stdio */
+
+static struct sim_ustream *_ustream_ctx (UNIT *uptr)
+{
+struct sim_ustream *s = (struct sim_ustream *)uptr->stream_ctx;
+
+return (s && !s->direct) ? s : NULL;
+}
+
+static void _ustream_io (struct sim_ustream *s)
+{
+if (s->mode == USTREAM_WRITE) {
+    if ((fwrite (s->buf[s->job_buf], 1, s->job_len, s->file) != s->job_len) ||
+        (fflush (s->file) == EOF))                      /* make it visible in the file */
+        s->job_err = errno ? errno : EIO;
+    }
+else {
+    clearerr (s->file);                                 /* see data appended since EOF */
+    s->job_len = fread (s->buf[s->job_buf], 1, USTREAM_BUFSIZE, s->file);
+    if (ferror (s->file))
+        s->job_err = errno ? errno : EIO;
+    }
+}
+
+#if defined (SIM_ASYNCH_IO)
+static void *_ustream_thread (void *arg)
+{
+struct sim_ustream *s = (struct sim_ustream *)arg;
+
+pthread_mutex_lock (&s->lock);
+while (1) {
+    while (!s->busy && !s->shutdown)
+        pthread_cond_wait (&s->cond, &s->lock);
+    if (s->shutdown)
+        break;
+    pthread_mutex_unlock (&s->lock);
+    _ustream_io (s);
+    pthread_mutex_lock (&s->lock);
+    s->busy = FALSE;
+    pthread_cond_broadcast (&s->cond);
+    }
+pthread_mutex_unlock (&s->lock);
+return NULL;
+}
+#endif
+
+/* Start a transfer of buffer b; done on the spot without a helper thread */
+
+static void _ustream_start (struct sim_ustream *s, int b, size_t len)
+{
+s->job_buf = b;
+s->job_len = len;
+s->job_err = 0;
+#if defined (SIM_ASYNCH_IO)
+if (s->threaded) {
+    pthread_mutex_lock (&s->lock);
+    s->busy = TRUE;
+    pthread_cond_signal (&s->cond);
+    pthread_mutex_unlock (&s->lock);
+    return;
+    }
+#endif
+s->busy = TRUE;
+_ustream_io (s);
+s->busy = FALSE;
+}
+
+/* Wait for the outstanding transfer (if any) and pick up its error */
+
+static void _ustream_wait (struct sim_ustream *s)
+{
+#if defined (SIM_ASYNCH_IO)
+if (s->threaded) {
+    pthread_mutex_lock (&s->lock);
+    while (s->busy)
+        pthread_cond_wait (&s->cond, &s->lock);
+    pthread_mutex_unlock (&s->lock);
+    }
+#endif
+if (s->job_err && !s->err)
+    s->err = s->job_err;
+s->job_err = 0;
+}
+
+/* Start or stop the helper thread to match the asynchronous I/O setting */
+
+static void _ustream_set_async (struct sim_ustream *s)
+{
+#if defined (SIM_ASYNCH_IO)
+if (sim_asynch_enabled && !s->threaded) {
+    s->shutdown = FALSE;
+    pthread_mutex_init (&s->lock, NULL);
+    pthread_cond_init (&s->cond, NULL);
+    s->threaded = (0 == pthread_create (&s->thread, NULL, _ustream_thread, (void *)s));
+    if (!s->threaded) {
+        pthread_cond_destroy (&s->cond);
+        pthread_mutex_destroy (&s->lock);
+        }
+    }
+else if (!sim_asynch_enabled && s->threaded) {
+    pthread_mutex_lock (&s->lock);
+    s->shutdown = TRUE;
+    pthread_cond_signal (&s->cond);
+    pthread_mutex_unlock (&s->lock);
+    pthread_join (s->thread, NULL);
+    pthread_cond_destroy (&s->cond);
+    pthread_mutex_destroy (&s->lock);
+    s->threaded = FALSE;
+    }
+#endif
+}
+
+/* Hand the filled output buffer to the writer and switch to the other one */
+
+static void _ustream_submit (struct sim_ustream *s)
+{
+_ustream_wait (s);                                      /* previous write done */
+_ustream_start (s, s->cur, s->len);
+s->cur ^= 1;
+s->len = 0;
+}
+
+/* Finish everything in flight and leave the file at the logical position */
+
+static void _ustream_quiesce (struct sim_ustream *s)
+{
+if (s->mode == USTREAM_WRITE) {
+    if (s->len)
+        _ustream_submit (s);
+    _ustream_wait (s);
+    if (fflush (s->file) == EOF)
+        s->err = s->err ? s->err : (errno ? errno : EIO);
+    }
+else if (s->mode == USTREAM_READ) {
+    _ustream_wait (s);                                  /* abandon the read ahead */
+    sim_fseeko (s->file, s->pos, SEEK_SET);
+    s->len = s->idx = 0;
+    s->ahead = FALSE;
+    }
+s->mode = USTREAM_IDLE;
+}
+
+/* Get ready to transfer in the given direction at uptr->pos */
+
+static void _ustream_setup (UNIT *uptr, struct sim_ustream *s, int mode)
+{
+if ((s->mode == mode) && ((t_offset)uptr->pos == s->pos))
+    return;
+_ustream_quiesce (s);
+if ((t_offset)uptr->pos != s->pos) {                    /* repositioned? */
+    s->pos = (t_offset)uptr->pos;
+    sim_fseeko (s->file, s->pos, SEEK_SET);
+    s->eof = FALSE;
+    }
+s->mode = mode;
+}
+
+/* Make the next input buffer current; returns the number of bytes in it */
+
+static size_t _ustream_fill (struct sim_ustream *s)
+{
+if (!s->ahead)                                          /* nothing read ahead? */
+    _ustream_start (s, s->cur ^ 1, 0);
+_ustream_wait (s);
+s->ahead = FALSE;
+if (s->err)
+    return 0;
+s->cur ^= 1;
+s->len = s->job_len;
+s->idx = 0;
+s->eof = (s->len == 0);
+#if defined (SIM_ASYNCH_IO)
+if (s->threaded && !s->eof) {                           /* read the next one meanwhile */
+    _ustream_start (s, s->cur ^ 1, 0);
+    s->ahead = TRUE;
+    }
+#endif
+return s->len;
+}
+
+/* Timer: write out output that has been sitting in a partly filled buffer */
+
+static t_stat _ustream_timer_svc (UNIT *uptr)
+{
+struct sim_ustream *s;
+
+for (s = ustream_list; s != NULL; s = s->next)
+    if ((s->mode == USTREAM_WRITE) && s->len)
+        _ustream_submit (s);
+return SCPE_OK;
+}
+
+static void _ustream_flush (UNIT *uptr)
+{
+struct sim_ustream *s = _ustream_ctx (uptr);
+
+if (s == NULL)
+    return;
+_ustream_quiesce (s);
+_ustream_set_async (s);                                 /* asynch I/O may have changed */
+}
+
+/* Find the unit's stream, setting one up if need be; NULL if it can't be */
+
+static struct sim_ustream *_ustream_get (UNIT *uptr)
+{
+struct sim_ustream *s = (struct sim_ustream *)uptr->stream_ctx;
+struct stat statb;
+
+if (s || !(uptr->flags & UNIT_ATT) || (uptr->fileref == NULL) ||
+    (uptr->io_flush && (uptr->io_flush != _ustream_flush)))
+    return _ustream_ctx (uptr);
+s = (struct sim_ustream *)calloc (1, sizeof (*s));
+if (s == NULL)
+    return NULL;
+if (fstat (fileno (uptr->fileref), &statb) ||
+    ((statb.st_mode & S_IFMT) != S_IFREG)) {            /* pipe, FIFO or device? */
+    s->direct = TRUE;                                   /* remember to use stdio */
+    uptr->stream_ctx = (void *)s;
+    return NULL;
+    }
+s->buf[0] = (uint8 *)malloc (USTREAM_BUFSIZE);
+s->buf[1] = (uint8 *)malloc (USTREAM_BUFSIZE);
+if ((s->buf[0] == NULL) || (s->buf[1] == NULL)) {
+    free (s->buf[0]);
+    free (s->buf[1]);
+    free (s);
+    return NULL;
+    }
+s->file = uptr->fileref;
+s->pos = (t_offset)uptr->pos;
+sim_fseeko (s->file, s->pos, SEEK_SET);
+_ustream_set_async (s);
+s->next = ustream_list;
+ustream_list = s;
+sim_register_internal_device (&sim_ustream_dev);
+uptr->stream_ctx = (void *)s;
+uptr->io_flush = _ustream_flush;
+return s;
+}
+
+t_stat sim_ustream_close (UNIT *uptr)
+{
+struct sim_ustream *s = (struct sim_ustream *)uptr->stream_ctx;
+struct sim_ustream **sp;
+int err;
+
+if (s == NULL)
+    return SCPE_OK;
+_ustream_quiesce (s);
+err = s->err;
+for (sp = &ustream_list; *sp != NULL; sp = &(*sp)->next)
+    if (*sp == s) {
+        *sp = s->next;
+        break;
+        }
+if (ustream_list == NULL)
+    sim_cancel (&sim_ustream_unit);
+#if defined (SIM_ASYNCH_IO)
+if (s->threaded) {
+    pthread_mutex_lock (&s->lock);
+    s->shutdown = TRUE;
+    pthread_cond_signal (&s->cond);
+    pthread_mutex_unlock (&s->lock);
+    pthread_join (s->thread, NULL);
+    pthread_cond_destroy (&s->cond);
+    pthread_mutex_destroy (&s->lock);
+    }
+#endif
+free (s->buf[0]);
+free (s->buf[1]);
+free (s);
+uptr->stream_ctx = NULL;
+if (uptr->io_flush == _ustream_flush)
+    uptr->io_flush = NULL;
+if (err) {
+    errno = err;
+    return SCPE_IOERR;
+    }
+return SCPE_OK;
+}
+
+/* Write len bytes; returns the number written, short (with errno set) if
+   an error has occurred */
+
+size_t sim_ustream_write (UNIT *uptr, const void *bptr, size_t len)
+{
+struct sim_ustream *s = _ustream_get (uptr);
+const uint8 *p = (const uint8 *)bptr;
+size_t n, done = 0;
+
+if (s == NULL) {
+    n = fwrite (bptr, 1, len, uptr->fileref);
+    uptr->pos = (t_addr)sim_ftell (uptr->fileref);
+    return n;
+    }
+_ustream_setup (uptr, s, USTREAM_WRITE);
+if (s->err) {                                           /* report a background error */
+    errno = s->err;
+    s->err = 0;
+    return 0;
+    }
+if ((s->len == 0) && (len != 0))                        /* buffer getting its first data? */
+    sim_activate_after (&sim_ustream_unit, USTREAM_FLUSH_USEC);
+while (done < len) {
+    n = USTREAM_BUFSIZE - s->len;
+    if (n > len - done)
+        n = len - done;
+    memcpy (s->buf[s->cur] + s->len, p + done, n);
+    s->len += n;
+    done += n;
+    if (s->len == USTREAM_BUFSIZE)
+        _ustream_submit (s);
+    }
+s->pos += len;
+uptr->pos = (t_addr)s->pos;
+return len;
+}
+
+int sim_ustream_putc (int c, UNIT *uptr)
+{
+struct sim_ustream *s = _ustream_ctx (uptr);
+uint8 ch = (uint8)c;
+
+if (s && (s->mode == USTREAM_WRITE) && !s->err &&       /* common case */
+    (s->len != 0) && (s->len < USTREAM_BUFSIZE - 1) && ((t_offset)uptr->pos == s->pos)) {
+    s->buf[s->cur][s->len++] = ch;
+    uptr->pos = (t_addr)++s->pos;
+    return ch;
+    }
+return (sim_ustream_write (uptr, &ch, 1) == 1) ? ch : EOF;
+}
+
+int sim_ustream_puts (const char *str, UNIT *uptr)
+{
+size_t len = strlen (str);
+
+return (sim_ustream_write (uptr, str, len) == len) ? 0 : EOF;
+}
+
+/* Read up to len bytes; returns the number read, short at end of file
+   (sim_ustream_eof is TRUE) or on an error */
+
+size_t sim_ustream_read (UNIT *uptr, void *bptr, size_t len)
+{
+struct sim_ustream *s = _ustream_get (uptr);
+uint8 *p = (uint8 *)bptr;
+size_t n, done = 0;
+
+if (s == NULL) {
+    n = fread (bptr, 1, len, uptr->fileref);
+    uptr->pos = (t_addr)sim_ftell (uptr->fileref);
+    return n;
+    }
+_ustream_setup (uptr, s, USTREAM_READ);
+while (done < len) {
+    if (s->idx == s->len) {
+        if (s->err || (_ustream_fill (s) == 0))
+            break;
+        }
+    n = s->len - s->idx;
+    if (n > len - done)
+        n = len - done;
+    memcpy (p + done, s->buf[s->cur] + s->idx, n);
+    s->idx += n;
+    done += n;
+    }
+s->pos += done;
+uptr->pos = (t_addr)s->pos;
+return done;
+}
+
+int sim_ustream_getc (UNIT *uptr)
+{
+struct sim_ustream *s = _ustream_ctx (uptr);
+uint8 ch;
+
+if (s && (s->mode == USTREAM_READ) &&                   /* common case */
+    (s->idx < s->len) && ((t_offset)uptr->pos == s->pos)) {
+    uptr->pos = (t_addr)++s->pos;
+    return s->buf[s->cur][s->idx++];
+    }
+if ((s = _ustream_get (uptr)) == NULL) {
+    int c = getc (uptr->fileref);
+
+    uptr->pos = (t_addr)sim_ftell (uptr->fileref);
+    return c;
+    }
+return (sim_ustream_read (uptr, &ch, 1) == 1) ? ch : EOF;
+}
+
+/* Push back the character just returned by sim_ustream_getc */
+
+int sim_ustream_ungetc (int c, UNIT *uptr)
+{
+struct sim_ustream *s = _ustream_ctx (uptr);
+
+if (c == EOF)
+    return EOF;
+if (s == NULL) {
+    c = ungetc (c, uptr->fileref);
+    uptr->pos = (t_addr)sim_ftell (uptr->fileref);
+    return c;
+    }
+if ((s->mode != USTREAM_READ) || (s->idx == 0) ||
+    ((t_offset)uptr->pos != s->pos) || (s->buf[s->cur][s->idx - 1] != (uint8)c))
+    return EOF;
+s->idx--;
+uptr->pos = (t_addr)--s->pos;
+return c;
+}
+
+/* Read a line, like fgets; returns NULL if nothing could be read */
+
+char *sim_ustream_gets (char *buf, int size, UNIT *uptr)
+{
+int c, i = 0;
+
+while (i < size - 1) {
+    if ((c = sim_ustream_getc (uptr)) == EOF)
+        break;
+    buf[i++] = (char)c;
+    if (c == '\n')
+        break;
+    }
+if (size > 0)
+    buf[i] = 0;
+return (i == 0) ? NULL : buf;
+}
+
+/* TRUE if the last read stopped at end of file */
+
+t_bool sim_ustream_eof (UNIT *uptr)
+{
+struct sim_ustream *s = _ustream_ctx (uptr);
+
+if (s == NULL)
+    return feof (uptr->fileref) != 0;
+return s->eof && (s->idx == s->len);
+}
+
+/* Return (and clear) the pending host error, 0 if none */
+
+int sim_ustream_error (UNIT *uptr)
+{
+struct sim_ustream *s = _ustream_ctx (uptr);
+int err;
+
+if (s == NULL) {
+    err = ferror (uptr->fileref) ? (errno ? errno : EIO) : 0;
+    clearerr (uptr->fileref);
+    return err;
+    }
+err = s->err;
+s->err = 0;
+if (err)
+    errno = err;
+return err;
+}
@@ -72,6 +72,16 @@ void sim_buf_copy_swapped (void *dptr, const void *bptr, size_t size, size_t cou
 typedef struct SHMEM SHMEM;
 t_stat sim_shmem_open (const char *name, size_t size, SHMEM **shmem, void **addr);
 void sim_shmem_close (SHMEM *shmem);
+t_stat sim_ustream_close (UNIT *uptr);
+size_t sim_ustream_read (UNIT *uptr, void *bptr, size_t len);
+size_t sim_ustream_write (UNIT *uptr, const void *bptr, size_t len);
+int sim_ustream_getc (UNIT *uptr);
+int sim_ustream_putc (int c, UNIT *uptr);
+int sim_ustream_puts (const char *str, UNIT *uptr);
+int sim_ustream_ungetc (int c, UNIT *uptr);
+char *sim_ustream_gets (char *buf, int size, UNIT *uptr);
+t_bool sim_ustream_eof (UNIT *uptr);
+int sim_ustream_error (UNIT *uptr);
 
 extern t_bool sim_taddr_64;         /* t_addr is > 32b and Large File Support available */
 extern t_bool sim_toffset_64;       /* Large File (>2GB) file I/O support */
@@ -47,6 +47,7 @@ extern "C" {
 #endif
 
 #include "sim_frontpanel.h"
+#include "sim_frontpanel_shm.h"
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -83,6 +84,10 @@ return 0;
 #include <unistd.h>
 #define msleep(n) usleep(1000*n)
 #include <sys/wait.h>
+#if defined(HAVE_SHM_OPEN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 #if defined (__APPLE__)
 #define HAVE_STRUCT_TIMESPEC 1   /* OSX defined the structure but doesn't tell us */
 #endif
@@ -172,7 +177,11 @@ struct PANEL {
     char                    *simulator_version;
     int                     radix;
     FILE                    *Debug;
+    SIM_PANEL_SHM           *shm;           /* published register data */
+    size_t                  shm_size;
+    int                     shm_pending;    /* register list changed since publish */
 #if defined(_WIN32)
+    HANDLE                  hShm;
     HANDLE                  hProcess;
 #else
     pid_t                   pidProcess;
@@ -215,6 +224,9 @@ static const char *register_collect_mid1 = " samples every ";
 static const char *register_collect_mid2 = " cycles dither ";
 static const char *register_collect_mid3 = " percent ";
 static const char *register_get_postfix = "sampleout";
+static const char *register_publish_prefix = "publish every ";
+static const char *register_publish_stop = "publish stop";
+#define SIM_PANEL_PUBLISH_USECS 10000   /* publish interval when no display callback is used */
 static const char *register_get_echo = "# REGISTERS-DONE";
 static const char *register_repeat_echo = "# REGISTERS-REPEAT-DONE";
 static const char *register_dev_echo = "# REGISTERS-FOR-DEVICE:";
@@ -566,6 +578,199 @@ free (buf);
 return 0;
 }
 
+/*
+ * Shared memory register transport:
+ *
+ * When the simulator supports it, registers are published by the 
+ * simulator into a shared memory segment (see sim_frontpanel_shm.h) 
+ * and are read from there while the simulator is running, rather than 
+ * being fetched with EXAMINE commands over the remote console session.
+ * If the segment can't be established, the text protocol is used.
+ */
+static unsigned int panel_shm_generation = 0;
+
+static void
+_panel_shm_unmap (PANEL *panel)
+{
+if (panel->shm == NULL)
+    return;
+#if defined(_WIN32)
+UnmapViewOfFile ((void *)panel->shm);
+CloseHandle (panel->hShm);
+panel->hShm = NULL;
+#elif defined(HAVE_SHM_OPEN)
+munmap ((void *)panel->shm, panel->shm_size);
+#endif
+panel->shm = NULL;
+panel->shm_size = 0;
+}
+
+static int
+_panel_shm_map (PANEL *panel, const char *name, size_t slots)
+{
+SIM_PANEL_SHM *shm = NULL;
+#if defined(_WIN32)
+panel->hShm = OpenFileMappingA (FILE_MAP_READ, FALSE, name);
+if (panel->hShm == NULL)
+    return -1;
+shm = (SIM_PANEL_SHM *)MapViewOfFile (panel->hShm, FILE_MAP_READ, 0, 0, 0);
+if (shm == NULL) {
+    CloseHandle (panel->hShm);
+    panel->hShm = NULL;
+    return -1;
+    }
+panel->shm_size = SIM_PANEL_SHM_SIZE (slots);
+#elif defined(HAVE_SHM_OPEN)
+struct stat statb;
+int fd = shm_open (name, O_RDONLY, 0);
+void *addr;
+
+if (fd == -1)
+    return -1;
+if ((fstat (fd, &statb)) || 
+    ((size_t)statb.st_size < SIM_PANEL_SHM_SIZE (slots))) {
+    close (fd);
+    shm_unlink (name);
+    return -1;
+    }
+addr = mmap (NULL, (size_t)statb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+close (fd);
+shm_unlink (name);                      /* both sides have it mapped, the name isn't needed */
+if (addr == MAP_FAILED)
+    return -1;
+shm = (SIM_PANEL_SHM *)addr;
+panel->shm_size = (size_t)statb.st_size;
+#else
+return -1;
+#endif
+panel->shm = shm;
+if ((shm->magic != SIM_PANEL_SHM_MAGIC) || 
+    (shm->version != SIM_PANEL_SHM_VERSION) ||
+    (shm->count < slots)) {
+    _panel_shm_unmap (panel);
+    return -1;
+    }
+return 0;
+}
+
+static int
+_panel_establish_register_publish (PANEL *panel, int usecs)
+{
+size_t i, buf_data, buf_needed = 0, slots = 0;
+int cmd_stat;
+char name[64];
+char *buf;
+
+pthread_mutex_lock (&panel->io_lock);
+_panel_shm_unmap (panel);
+panel->shm_pending = 0;
+for (i=0; i<panel->reg_count; i++) {
+    if (panel->regs[i].bits)
+        continue;
+    buf_needed += 20 + strlen (panel->regs[i].name) + (panel->regs[i].device_name ? strlen (panel->regs[i].device_name) : 0);
+    slots += (panel->regs[i].element_count > 0) ? panel->regs[i].element_count : 1;
+    }
+buf = (char *)_panel_malloc (buf_needed + 1);
+if (!buf) {
+    panel->State = Error;
+    pthread_mutex_unlock (&panel->io_lock);
+    return -1;
+    }
+*buf = '\0';
+buf_data = 0;
+for (i=0; i<panel->reg_count; i++) {
+    if (panel->regs[i].bits)
+        continue;
+    sprintf (buf + buf_data, "%s%s", (buf_data != 0) ? "," : "", panel->regs[i].indirect ? "-I " : "");
+    buf_data += strlen (buf + buf_data);
+    if (panel->regs[i].device_name) {
+        sprintf (buf + buf_data, "%s ", panel->regs[i].device_name);
+        buf_data += strlen (buf + buf_data);
+        }
+    if (panel->regs[i].element_count > 0)
+        sprintf (buf + buf_data, "%s[%d]", panel->regs[i].name, (int)panel->regs[i].element_count);
+    else
+        sprintf (buf + buf_data, "%s", panel->regs[i].name);
+    buf_data += strlen (buf + buf_data);
+    }
+#if defined(_WIN32)
+sprintf (name, "simh-panel-%d-%u", (int)GetCurrentProcessId (), ++panel_shm_generation);
+#else
+sprintf (name, "/simh-panel-%d-%u", (int)getpid (), ++panel_shm_generation);
+#endif
+pthread_mutex_unlock (&panel->io_lock);
+if (_panel_sendf (panel, &cmd_stat, NULL, "%s%d%s%s %s\r", register_publish_prefix, usecs, 
+                                                           register_repeat_units, name, buf)) {
+    free (buf);
+    return -1;
+    }
+free (buf);
+/* A simulator which can't publish (or doesn't know how) won't have created the segment */
+pthread_mutex_lock (&panel->io_lock);
+if (_panel_shm_map (panel, name, slots)) {
+    pthread_mutex_unlock (&panel->io_lock);
+    _panel_debug (panel, DBG_RSP, "Shared memory register transport unavailable", NULL, 0);
+    _panel_sendf (panel, &cmd_stat, NULL, "%s", register_publish_stop);
+    return -1;
+    }
+pthread_mutex_unlock (&panel->io_lock);
+_panel_debug (panel, DBG_RSP, "Registers published in shared memory segment %s", NULL, 0, name);
+return 0;
+}
+
+/* Called with io_lock held */
+static int
+_panel_shm_read_registers (PANEL *panel)
+{
+SIM_PANEL_SHM *shm = panel->shm;
+unsigned int sequence;
+int tries;
+
+for (tries = 0; tries < 1000; tries++) {
+    size_t i, j, slot = 0;
+
+    sequence = shm->sequence;
+    SIM_PANEL_SHM_BARRIER ();
+    if (sequence & 1)                   /* update in progress? */
+        continue;
+    panel->simulation_time = shm->simulation_time;
+    for (i=0; i<panel->reg_count; i++) {
+        REG *r = &panel->regs[i];
+        size_t elements = (r->element_count > 0) ? r->element_count : 1;
+
+        if (r->bits)
+            continue;
+        for (j=0; j<elements; j++) {
+            unsigned long long data = shm->values[slot++];
+
+            if (little_endian)
+                memcpy ((char *)(r->addr) + (j * r->size), &data, r->size);
+            else
+                memcpy ((char *)(r->addr) + (j * r->size), ((char *)&data) + sizeof(data)-r->size, r->size);
+            }
+        }
+    for (i=0; i<panel->reg_count; i++) {
+        REG *r = &panel->regs[i];
+        size_t width;
+
+        if (r->bits == NULL)
+            continue;
+        if (slot >= shm->count)
+            break;
+        width = (size_t)shm->values[slot++];
+        if (slot + width > shm->count)
+            break;
+        for (j=0; (j<width) && (j<r->bit_count); j++)
+            r->bits[j] = (int)shm->values[slot + j];
+        slot += width;
+        }
+    SIM_PANEL_SHM_BARRIER ();
+    if (sequence == shm->sequence)
+        return 0;
+    }
+return -1;
+}
+
 static PANEL **panels = NULL;
 static int panel_count = 0;
 
@@ -1015,6 +1220,7 @@ if (panel) {
         }
     free (panel->regs);
     free (panel->reg_query);
+    _panel_shm_unmap (panel);
     free (panel->io_response);
     free (panel->simulator_version);
     if ((panel->Debug) && (!panel->parent))
@@ -1170,12 +1376,19 @@ pthread_mutex_lock (&panel->io_lock);
 free (panel->regs);
 panel->regs = regs;
 panel->new_register = 1;
+panel->shm_pending = 1;
 pthread_mutex_unlock (&panel->io_lock);
 /* Now build the register query string for the whole register list */
 if (_panel_register_query_string (panel, &panel->reg_query, &panel->reg_query_size))
     return -1;
 if (bits) {
     memset (bits, 0, sizeof (*bits) * bit_count);
+    if (panel->shm) {       /* published segment has no room for the new totals */
+        pthread_mutex_lock (&panel->io_lock);
+        _panel_shm_unmap (panel);
+        pthread_mutex_unlock (&panel->io_lock);
+        _panel_sendf (panel, &cmd_stat, NULL, "%s", register_publish_stop);
+        }
     if (_panel_establish_register_bits_collection (panel))
         return -1;
     }
@@ -1249,8 +1462,18 @@ if (!panel->reg_count) {
     sim_panel_set_error ("No registers specified");
     return -1;
     }
+if ((!calledback) && (panel->shm_pending))
+    _panel_establish_register_publish (panel, SIM_PANEL_PUBLISH_USECS);
 pthread_mutex_lock (&panel->io_command_lock);
 pthread_mutex_lock (&panel->io_lock);
+if ((panel->shm) && (panel->State == Run) &&        /* published data current? */
+    (0 == _panel_shm_read_registers (panel))) {
+    if (simulation_time)
+        *simulation_time = panel->simulation_time;
+    pthread_mutex_unlock (&panel->io_lock);
+    pthread_mutex_unlock (&panel->io_command_lock);
+    return 0;
+    }
 if (panel->reg_query_size != _panel_send (panel, panel->reg_query, panel->reg_query_size)) {
     pthread_mutex_unlock (&panel->io_lock);
     pthread_mutex_unlock (&panel->io_command_lock);
@@ -2186,6 +2409,7 @@ char *buf = NULL;
 size_t buf_data = 0;
 unsigned int callback_count = 0;
 int cmd_stat;
+int halt_poll_msecs = 0;
 
 /* 
    Boost Priority for timer thread so it doesn't compete 
@@ -2219,9 +2443,27 @@ while ((p->sock != INVALID_SOCKET) &&
     /*  1) update the query string if it has changed                            */
     /*     (only really happens at startup)                                     */
     /*  2) update register state by polling if the simulator is halted          */
-    msleep (500);
+    /* when registers are published in shared memory, wake up every interval    */
+    /* to read them and deliver the callback                                    */
+    if (p->shm && (interval >= 1000) && (interval < 500000)) {
+        msleep (interval/1000);
+        halt_poll_msecs += interval/1000;
+        }
+    else {
+        msleep (500);
+        halt_poll_msecs = 500;
+        }
     pthread_mutex_lock (&p->io_lock);
     if (new_register) {
+        if (p->io_reg_query_pending == 0) {
+            pthread_mutex_unlock (&p->io_lock);
+            if (0 == _panel_establish_register_publish (p, interval)) {
+                _panel_sendf (p, &cmd_stat, NULL, "%s", register_repeat_stop);
+                pthread_mutex_lock (&p->io_lock);
+                continue;
+                }
+            pthread_mutex_lock (&p->io_lock);
+            }
         if (p->io_reg_query_pending == 0) {
             size_t repeat_data = strlen (register_repeat_prefix) +  /* prefix */
                                  20                              +  /* max int width */
@@ -2257,9 +2499,18 @@ while ((p->sock != INVALID_SOCKET) &&
             _panel_debug (p, DBG_XMT, "Waiting on prior command completion before specifying repeat interval", NULL, 0);
             }
         }
+    if (p->shm && (p->State == Run)) {
+        if ((0 == _panel_shm_read_registers (p)) && p->callback) {
+            pthread_mutex_unlock (&p->io_lock);
+            p->callback (p, p->simulation_time_base + p->simulation_time, p->callback_context);
+            pthread_mutex_lock (&p->io_lock);
+            }
+        continue;
+        }
     /* when halted, we directly poll the halted system to get updated */
     /* register state which may have changed due to panel activities */
-    if (p->State == Halt) {
+    if ((p->State == Halt) && (halt_poll_msecs >= 500)) {
+        halt_poll_msecs = 0;
         pthread_mutex_unlock (&p->io_lock);
         if (_panel_get_registers (p, 1, NULL)) {
             pthread_mutex_lock (&p->io_lock);
@@ -210,6 +210,12 @@ sim_panel_add_register_indirect_bits (PANEL *panel,
            or frontpanel interactions with the simulator may be disrupted.  
            Setting a flag, signaling an event or posting a message are 
            reasonable activities to perform in a callback routine.
+   Note 3: When the host supports shared memory, a running simulator 
+           publishes the register set into a shared memory segment and
+           both of the above methods read it from there without a 
+           command exchange with the simulator.  Otherwise (or while the
+           simulator is halted) the register set is requested over the 
+           remote console connection.
  */
 
 int
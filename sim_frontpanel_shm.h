@@ -0,0 +1,84 @@
+/* sim_frontpanel_shm.h: simulator frontpanel shared memory register transport
+
+   Copyright (c) 2026, The authors of this file, as recorded in its
+   revision history
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+   THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   Except as contained in this notice, the names of the authors shall not be
+   used in advertising or otherwise to promote the sale, use or other dealings
+   in this Software without prior written authorization from the authors.
+
+   This file describes the layout of the shared memory segment which a
+   simulator's remote console PUBLISH command fills with register values
+   and which sim_frontpanel.c reads without a round trip through the 
+   remote console text protocol.  It is private to the simulator and the
+   sim_frontpanel module; front panel applications don't use it directly.
+
+   The panel picks a unique segment name and sends:
+
+        PUBLISH EVERY nnn USECS name {-I }{dev }reg{[count]}{,...}
+
+   The simulator creates the segment and, every nnn usecs while running,
+   stores each listed register (count elements for arrays, the memory 
+   value the register points at for -I) in a slot of values[], in list 
+   order.  The bit sample totals of any registers established with the
+   COLLECT command on the same session follow: one slot containing the
+   sampled bit width and then that many slots of totals.  The segment is
+   sized when it is published, so a COLLECT which would need more slots
+   than it has is rejected; the panel stops publishing before changing
+   its collection and publishes again afterwards.
+
+   Updates are bracketed by incrementing sequence, so it is odd while an
+   update is in progress.  A reader copies the data and retries if 
+   sequence was odd or changed while copying.
+*/
+
+#ifndef SIM_FRONTPANEL_SHM_H_
+#define SIM_FRONTPANEL_SHM_H_     0
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define SIM_PANEL_SHM_MAGIC     0x4C4E5053u     /* "SPNL" */
+#define SIM_PANEL_SHM_VERSION   1
+
+typedef struct SIM_PANEL_SHM SIM_PANEL_SHM;
+struct SIM_PANEL_SHM {
+    unsigned int                magic;          /* SIM_PANEL_SHM_MAGIC */
+    unsigned int                version;        /* SIM_PANEL_SHM_VERSION */
+    volatile unsigned int       sequence;       /* odd while being updated */
+    unsigned int                count;          /* number of values[] slots */
+    volatile unsigned long long simulation_time;/* simulation time of the update */
+    volatile unsigned long long values[1];      /* register values, then bit sample totals */
+    };
+
+#define SIM_PANEL_SHM_SIZE(count) (sizeof (SIM_PANEL_SHM) + ((count) ? ((count) - 1) : 0) * sizeof (unsigned long long))
+
+#if defined(__GNUC__)
+#define SIM_PANEL_SHM_BARRIER() __sync_synchronize ()
+#else                               /* MSVC volatile accesses are ordered */
+#define SIM_PANEL_SHM_BARRIER()
+#endif
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* SIM_FRONTPANEL_SHM_H_ */
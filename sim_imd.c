@@ -58,6 +58,12 @@
 static t_stat commentParse(DISK_INFO *myDisk, uint8 comment[], uint32 buffLen);
 static t_stat diskParse(DISK_INFO *myDisk, uint32 isVerbose);
 static t_stat diskFormat(DISK_INFO *myDisk);
+static t_stat imdParseTracks(DISK_INFO *myDisk, uint8 *image, uint32 size, uint32 base);
+static t_stat imdLoadTrack(DISK_INFO *myDisk, TRACK_INFO *trk);
+static void imdFreeTracks(DISK_INFO *myDisk);
+static void imdUnitFlush(UNIT *uptr);
+
+static DISK_INFO *imd_disks = NULL;     /* Open disks, for imdUnitFlush */
 
 /* Open an existing IMD disk image.  It will be opened and parsed, and after this
  * call, will be ready for sector read/write. The result is the corresponding
@@ -66,17 +72,40 @@ static t_stat diskFormat(DISK_INFO *myDisk);
 DISK_INFO *diskOpenEx(FILE *fileref, uint32 isVerbose, DEVICE *device, uint32 debugmask, uint32 verbosedebugmask)
 {
     DISK_INFO *myDisk = NULL;
+    uint32 i;
 
-    myDisk = (DISK_INFO *)malloc(sizeof(DISK_INFO));
+    myDisk = (DISK_INFO *)calloc(1, sizeof(DISK_INFO));
+    if (myDisk == NULL)
+        return NULL;
     myDisk->file = fileref;
     myDisk->device = device;
     myDisk->debugmask = debugmask;
     myDisk->verbosedebugmask = verbosedebugmask;
 
     if (diskParse(myDisk, isVerbose) != SCPE_OK) {
+        imdFreeTracks(myDisk);
         free(myDisk);
-        myDisk = NULL;
+        return NULL;
+    }
+
+    /* Have the unit's io_flush save written tracks whenever the simulator stops.
+     * A unit attached read only can't save them, so its writes are refused.
+     */
+    for (i = 0; (device != NULL) && (i < device->numunits); i++) {
+        UNIT *uptr = &device->units[i];
+
+        if (!(uptr->flags & UNIT_ATT) || (uptr->fileref != fileref))
+            continue;
+        if (uptr->flags & UNIT_RO)
+            myDisk->flags |= FD_FLAG_WRITELOCK;
+        if ((uptr->io_flush == NULL) || (uptr->io_flush == imdUnitFlush)) {
+            uptr->io_flush = imdUnitFlush;
+            myDisk->uptr = uptr;
+            break;
+        }
     }
+    myDisk->next = imd_disks;
+    imd_disks = myDisk;
 
     return myDisk;
 }
@@ -122,24 +151,24 @@ static uint32 headerOk(IMD_HEADER imd) {
 
 /* Parse an IMD image.  This sets up sim_imd to be able to do sector read/write and
  * track write.
+ *
+ * Only the track headers and sector maps are decoded here, from a single read of
+ * the image; the sector data of each track is read in when the track is first
+ * accessed (imdLoadTrack).  Tracks that have been written are held in memory and
+ * saved by diskFlush.
  */
 static t_stat diskParse(DISK_INFO *myDisk, uint32 isVerbose)
 {
     uint8 comment[256];
-    uint8 sectorMap[256];
-    uint8 sectorHeadMap[256];
-    uint8 sectorCylMap[256];
-    uint32 sectorSize, sectorHeadwithFlags, sectRecordType;
-    uint32 i;
-    uint8 start_sect;
-
-    uint32 TotalSectorCount = 0;
-    IMD_HEADER imd;
+    uint8 *image;
+    uint32 base, size;
+    t_stat r;
 
     if(myDisk == NULL) {
         return (SCPE_OPENERR);
     }
 
+    imdFreeTracks(myDisk);
     memset(myDisk->track, 0, (sizeof(TRACK_INFO)*MAX_CYL*MAX_HEAD));
 
     if (commentParse(myDisk, comment, sizeof(comment)) != SCPE_OK) {
@@ -158,12 +187,42 @@ static t_stat diskParse(DISK_INFO *myDisk, uint32 isVerbose)
         return (SCPE_OPENERR);
     }
 
-    do {
-        sim_debug(myDisk->debugmask, myDisk->device, "start of track %d at file offset %ld\n", myDisk->ntracks, ftell(myDisk->file));
+    base = ftell(myDisk->file);
+    size = sim_fsize(myDisk->file) - base;
+    image = (uint8 *)malloc(size + 1);
+    if (image == NULL)
+        return (SCPE_MEM);
+    sim_fseek(myDisk->file, base, SEEK_SET);
+    size = sim_fread(image, 1, size, myDisk->file);
+    r = imdParseTracks(myDisk, image, size, base);
+    free(image);
+    return r;
+}
+
+/* Index the tracks of the image held in image[0..size), which starts at file offset base */
+static t_stat imdParseTracks(DISK_INFO *myDisk, uint8 *image, uint32 size, uint32 base)
+{
+    uint8 *p = image, *end = image + size, *trackStart;
+    uint8 *sectorMap, *sectorHeadMap, *sectorCylMap;
+    uint32 sectorSize, sectorHeadwithFlags, sectRecordType;
+    uint32 i;
+    uint8 start_sect;
+    TRACK_INFO *trk;
 
-        sim_fread(&imd, 1, 5, myDisk->file);
-        if (feof(myDisk->file))
+    uint32 TotalSectorCount = 0;
+    IMD_HEADER imd;
+
+    while (p < end) {
+        sim_debug(myDisk->debugmask, myDisk->device, "start of track %d at file offset %d\n", myDisk->ntracks, base + (uint32)(p - image));
+
+        if (end - p < 5)
             break;
+        trackStart = p;
+        imd.mode = *p++;
+        imd.cyl = *p++;
+        imd.head = *p++;
+        imd.nsects = *p++;
+        imd.sectsize = *p++;
         sectorSize = 128 << imd.sectsize;
         sectorHeadwithFlags = imd.head; /*AGN save the head and flags */
         imd.head &= 1 ; /*AGN mask out flag bits to head 0 or 1 */
@@ -171,7 +230,7 @@ static t_stat diskParse(DISK_INFO *myDisk, uint32 isVerbose)
         sim_debug(myDisk->debugmask, myDisk->device, "Track %d:\n", myDisk->ntracks);
         sim_debug(myDisk->debugmask, myDisk->device, "\tMode=%d, Cyl=%d, Head=%d(%d), #sectors=%d, sectsize=%d (%d bytes)\n", imd.mode, imd.cyl, sectorHeadwithFlags, imd.head, imd.nsects, imd.sectsize, sectorSize);
 
-        if (!headerOk(imd)) {
+        if (!headerOk(imd) || (imd.nsects > MAX_SPT) || (imd.sectsize > 6)) {
             sim_printf("SIM_IMD: Corrupt header.\n");
             return (SCPE_OPENERR);
         }
@@ -180,154 +239,392 @@ static t_stat diskParse(DISK_INFO *myDisk, uint32 isVerbose)
             myDisk->nsides = imd.head + 1;
         }
 
-        myDisk->track[imd.cyl][imd.head].mode = imd.mode;
-        myDisk->track[imd.cyl][imd.head].nsects = imd.nsects;
-        myDisk->track[imd.cyl][imd.head].sectsize = sectorSize;
+        trk = &myDisk->track[imd.cyl][imd.head];
+        trk->mode = imd.mode;
+        trk->nsects = imd.nsects;
+        trk->sectsize = sectorSize;
+        trk->headFlags = sectorHeadwithFlags & (IMD_FLAG_SECT_HEAD_MAP | IMD_FLAG_SECT_CYL_MAP);
+        trk->fileOffset = base + (uint32)(trackStart - image);
+        memset(trk->recType, SECT_ABSENT, sizeof(trk->recType));
 
-        if (sim_fread(sectorMap, 1, imd.nsects, myDisk->file) != imd.nsects) {
+        if (end - p < imd.nsects) {
             sim_printf("SIM_IMD: Corrupt file [Sector Map].\n");
             return (SCPE_OPENERR);
         }
-        myDisk->track[imd.cyl][imd.head].start_sector = imd.nsects;
+        sectorMap = p;
+        p += imd.nsects;
+        memcpy(trk->sectorMap, sectorMap, imd.nsects);
+        trk->start_sector = imd.nsects;
         sim_debug(myDisk->debugmask, myDisk->device, "\tSector Map: ");
         for(i=0;i<imd.nsects;i++) {
             sim_debug(myDisk->debugmask, myDisk->device, "%d ", sectorMap[i]);
-            if(sectorMap[i] < myDisk->track[imd.cyl][imd.head].start_sector) {
-                myDisk->track[imd.cyl][imd.head].start_sector = sectorMap[i];
+            if(sectorMap[i] < trk->start_sector) {
+                trk->start_sector = sectorMap[i];
             }
         }
-        sim_debug(myDisk->debugmask, myDisk->device, ", Start Sector=%d", myDisk->track[imd.cyl][imd.head].start_sector);
+        sim_debug(myDisk->debugmask, myDisk->device, ", Start Sector=%d", trk->start_sector);
 
         if(sectorHeadwithFlags & IMD_FLAG_SECT_HEAD_MAP) {
-            if (sim_fread(sectorHeadMap, 1, imd.nsects, myDisk->file) != imd.nsects) {
+            if (end - p < imd.nsects) {
                 sim_printf("SIM_IMD: Corrupt file [Sector Head Map].\n");
                 return (SCPE_OPENERR);
             }
+            sectorHeadMap = p;
+            p += imd.nsects;
             sim_debug(myDisk->debugmask, myDisk->device, "\tSector Head Map: ");
             for(i=0;i<imd.nsects;i++) {
                 sim_debug(myDisk->debugmask, myDisk->device, "%d ", sectorHeadMap[i]);
             }
             sim_debug(myDisk->debugmask, myDisk->device, "\n");
         } else {
-            /* Default Head is physical head for each sector */
-            for(i=0;i<imd.nsects;i++) {
-                sectorHeadMap[i] = imd.head;
-            };
+            sectorHeadMap = NULL;
         }
 
         if(sectorHeadwithFlags & IMD_FLAG_SECT_CYL_MAP) {
-            if (sim_fread(sectorCylMap, 1, imd.nsects, myDisk->file) != imd.nsects) {
+            if (end - p < imd.nsects) {
                 sim_printf("SIM_IMD: Corrupt file [Sector Cyl Map].\n");
                 return (SCPE_OPENERR);
             }
+            sectorCylMap = p;
+            p += imd.nsects;
             sim_debug(myDisk->debugmask, myDisk->device, "\tSector Cyl Map: ");
             for(i=0;i<imd.nsects;i++) {
                 sim_debug(myDisk->debugmask, myDisk->device, "%d ", sectorCylMap[i]);
             }
             sim_debug(myDisk->debugmask, myDisk->device, "\n");
         } else {
-            /* Default Cyl Map is physical cylinder for each sector */
-            for(i=0;i<imd.nsects;i++) {
-                sectorCylMap[i] = imd.cyl;
-            }
+            sectorCylMap = NULL;
         }
 
-        sim_debug(myDisk->debugmask, myDisk->device, "\nSector data at offset 0x%08lx\n", ftell(myDisk->file));
+        sim_debug(myDisk->debugmask, myDisk->device, "\nSector data at offset 0x%08x\n", base + (uint32)(p - image));
 
         /* Build the table with location 0 being the start sector. */
-        start_sect = myDisk->track[imd.cyl][imd.head].start_sector;
+        start_sect = trk->start_sector;
 
-        /* Now read each sector */
+        /* Now index each sector */
         for(i=0;i<imd.nsects;i++) {
             TotalSectorCount++;
             sim_debug(myDisk->debugmask, myDisk->device, "Sector Phys: %d/Logical: %d: %d bytes: ", i, sectorMap[i], sectorSize);
-            sectRecordType = fgetc(myDisk->file);
-            /* AGN Logical head mapping */
-            myDisk->track[imd.cyl][imd.head].logicalHead[i] = sectorHeadMap[i];
-            /* AGN Logical cylinder mapping */
-            myDisk->track[imd.cyl][imd.head].logicalCyl[i] = sectorCylMap[i];
+            sectRecordType = (p < end) ? *p++ : 0xFF;
+            /* AGN Logical head mapping, default is physical head for each sector */
+            trk->logicalHead[i] = sectorHeadMap ? sectorHeadMap[i] : imd.head;
+            /* AGN Logical cylinder mapping, default is physical cylinder for each sector */
+            trk->logicalCyl[i] = sectorCylMap ? sectorCylMap[i] : imd.cyl;
+            if ((sectRecordType <= SECT_RECORD_NORM_DAM_COMP_ERR) && (sectorMap[i]-start_sect >= MAX_SPT)) {
+                sim_printf("SIM_IMD: ERROR: Illegal sector offset %d\n", sectorMap[i]-start_sect);
+                return (SCPE_OPENERR);
+            }
             switch(sectRecordType) {
                 case SECT_RECORD_UNAVAILABLE:   /* Data could not be read from the original media */
-                    if (sectorMap[i]-start_sect < MAX_SPT)
-                        myDisk->track[imd.cyl][imd.head].sectorOffsetMap[sectorMap[i]-start_sect] = 0xBADBAD;
-                    else {
-                        sim_printf("SIM_IMD: ERROR: Illegal sector offset %d\n", sectorMap[i]-start_sect);
-                        return (SCPE_OPENERR);
-                    }
                     break;
                 case SECT_RECORD_NORM:          /* Normal Data */
                 case SECT_RECORD_NORM_DAM:      /* Normal Data with deleted address mark */
                 case SECT_RECORD_NORM_ERR:      /* Normal Data with read error */
                 case SECT_RECORD_NORM_DAM_ERR:  /* Normal Data with deleted address mark with read error */
-/*                  sim_debug(myDisk->debugmask, myDisk->device, "Uncompressed Data\n"); */
-                    if (sectorMap[i]-start_sect < MAX_SPT) {
-                        myDisk->track[imd.cyl][imd.head].sectorOffsetMap[sectorMap[i]-start_sect] = ftell(myDisk->file);
-                        sim_fseek(myDisk->file, sectorSize, SEEK_CUR);
-                    }
-                    else {
-                        sim_printf("SIM_IMD: ERROR: Illegal sector offset %d\n", sectorMap[i]-start_sect);
+                    if ((uint32)(end - p) < sectorSize) {
+                        sim_printf("SIM_IMD: Corrupt file [Sector Data].\n");
                         return (SCPE_OPENERR);
                     }
+                    p += sectorSize;
                     break;
                 case SECT_RECORD_NORM_COMP:     /* Compressed Normal Data */
                 case SECT_RECORD_NORM_DAM_COMP: /* Compressed Normal Data with deleted address mark */
                 case SECT_RECORD_NORM_COMP_ERR: /* Compressed Normal Data */
                 case SECT_RECORD_NORM_DAM_COMP_ERR: /* Compressed Normal Data with deleted address mark */
-                    if (sectorMap[i]-start_sect < MAX_SPT) {
-                        myDisk->track[imd.cyl][imd.head].sectorOffsetMap[sectorMap[i]-start_sect] = ftell(myDisk->file);
-                        myDisk->flags |= FD_FLAG_WRITELOCK; /* Write-protect the disk if any sectors are compressed. */
-                        if (1) {
-                            uint8 cdata = fgetc(myDisk->file);
-
-                            sim_debug(myDisk->debugmask, myDisk->device, "Compressed Data = 0x%02x\n", cdata);
-                            }
-                    }
-                    else {
-                        sim_printf("SIM_IMD: ERROR: Illegal sector offset %d\n", sectorMap[i]-start_sect);
+                    if (p >= end) {
+                        sim_printf("SIM_IMD: Corrupt file [Sector Data].\n");
                         return (SCPE_OPENERR);
                     }
+                    sim_debug(myDisk->debugmask, myDisk->device, "Compressed Data = 0x%02x\n", *p);
+                    p++;
                     break;
                 default:
                     sim_printf("SIM_IMD: ERROR: unrecognized sector record type %d\n", sectRecordType);
                     return (SCPE_OPENERR);
                     break;
             }
+            trk->recType[sectorMap[i]-start_sect] = sectRecordType;
             sim_debug(myDisk->debugmask, myDisk->device, "\n");
         }
+        trk->fileLen = (uint32)(p - trackStart);
 
         myDisk->ntracks++;
-    } while (!feof(myDisk->file));
+    }
 
     sim_debug(myDisk->debugmask, myDisk->device, "Processed %d sectors\n", TotalSectorCount);
 
     for(i=0;i<myDisk->ntracks;i++) {
-        uint8 j;
-        sim_debug(myDisk->verbosedebugmask, myDisk->device, "Track %02d: ", i);
-        for(j=0;j<imd.nsects;j++) {
-            sim_debug(myDisk->verbosedebugmask, myDisk->device, "0x%06x ", myDisk->track[i][0].sectorOffsetMap[j]);
+        sim_debug(myDisk->verbosedebugmask, myDisk->device, "Track %02d: offset 0x%06x, %d bytes\n", i, myDisk->track[i][0].fileOffset, myDisk->track[i][0].fileLen);
+    }
+
+    return SCPE_OK;
+}
+
+/* Read in the sector data of a track */
+static t_stat imdLoadTrack(DISK_INFO *myDisk, TRACK_INFO *trk)
+{
+    uint8 *raw, *p, *end;
+    uint32 i, idx;
+
+    if (trk->data != NULL)
+        return SCPE_OK;
+    raw = (uint8 *)malloc(trk->fileLen);
+    trk->data = (uint8 *)calloc(MAX_SPT, trk->sectsize);
+    if ((raw == NULL) || (trk->data == NULL)) {
+        free(raw);
+        free(trk->data);
+        trk->data = NULL;
+        return SCPE_MEM;
+    }
+    if ((sim_fseek(myDisk->file, trk->fileOffset, SEEK_SET) != 0) ||
+        (sim_fread(raw, 1, trk->fileLen, myDisk->file) != trk->fileLen)) {
+        sim_printf("SIM_IMD[%s]: error reading track at offset 0x%08x.\n", __FUNCTION__, trk->fileOffset);
+        free(raw);
+        free(trk->data);
+        trk->data = NULL;
+        return SCPE_IOERR;
+    }
+    /* Skip the header and maps */
+    p = raw + 5 + trk->nsects;
+    if (trk->headFlags & IMD_FLAG_SECT_HEAD_MAP)
+        p += trk->nsects;
+    if (trk->headFlags & IMD_FLAG_SECT_CYL_MAP)
+        p += trk->nsects;
+    end = raw + trk->fileLen;
+    for (i = 0; (i < trk->nsects) && (p < end); i++) {
+        idx = trk->sectorMap[i] - trk->start_sector;
+        switch(*p++) {
+            case SECT_RECORD_NORM:
+            case SECT_RECORD_NORM_DAM:
+            case SECT_RECORD_NORM_ERR:
+            case SECT_RECORD_NORM_DAM_ERR:
+                memcpy(trk->data + idx * trk->sectsize, p, trk->sectsize);
+                p += trk->sectsize;
+                break;
+            case SECT_RECORD_NORM_COMP:
+            case SECT_RECORD_NORM_DAM_COMP:
+            case SECT_RECORD_NORM_COMP_ERR:
+            case SECT_RECORD_NORM_DAM_COMP_ERR:
+                memset(trk->data + idx * trk->sectsize, *p++, trk->sectsize);
+                break;
+            default:
+                break;
         }
-        sim_debug(myDisk->verbosedebugmask, myDisk->device, "\n");
     }
-    if(myDisk->flags & FD_FLAG_WRITELOCK) {
-        sim_printf("Disk write-protected because the image contains compressed sectors. Use IMDU to uncompress.\n");
+    free(raw);
+    return SCPE_OK;
+}
+
+/* Drop the in-memory sector data of all tracks */
+static void imdFreeTracks(DISK_INFO *myDisk)
+{
+    uint32 cyl, head;
+
+    for (cyl = 0; cyl < MAX_CYL; cyl++)
+        for (head = 0; head < MAX_HEAD; head++) {
+            free(myDisk->track[cyl][head].data);
+            myDisk->track[cyl][head].data = NULL;
+        }
+}
+
+/* Serialize a track into buffer p, returning its size.  A sector whose bytes are
+ * all the same is stored compressed, as the ImageDisk utilities do.
+ */
+static uint32 imdPutTrack(TRACK_INFO *trk, uint32 cyl, uint32 head, uint8 *p)
+{
+    uint8 *start = p, *sect, type;
+    uint32 i, j, sizeCode;
+
+    for (sizeCode = 0; (128u << sizeCode) < trk->sectsize; sizeCode++)
+        ;
+    *p++ = trk->mode;
+    *p++ = (uint8)cyl;
+    *p++ = (uint8)(head | trk->headFlags);
+    *p++ = trk->nsects;
+    *p++ = (uint8)sizeCode;
+    memcpy(p, trk->sectorMap, trk->nsects);
+    p += trk->nsects;
+    if (trk->headFlags & IMD_FLAG_SECT_HEAD_MAP) {
+        memcpy(p, trk->logicalHead, trk->nsects);
+        p += trk->nsects;
+    }
+    if (trk->headFlags & IMD_FLAG_SECT_CYL_MAP) {
+        memcpy(p, trk->logicalCyl, trk->nsects);
+        p += trk->nsects;
+    }
+    for (i = 0; i < trk->nsects; i++) {
+        uint32 idx = trk->sectorMap[i] - trk->start_sector;
+
+        type = trk->recType[idx];
+        if ((type == SECT_RECORD_UNAVAILABLE) || (type > SECT_RECORD_NORM_DAM_COMP_ERR)) {
+            *p++ = SECT_RECORD_UNAVAILABLE;
+            continue;
+        }
+        if ((type & 1) == 0)                    /* compressed variant */
+            type--;
+        sect = trk->data + idx * trk->sectsize;
+        for (j = 1; (j < trk->sectsize) && (sect[j] == sect[0]); j++)
+            ;
+        if (j == trk->sectsize) {
+            *p++ = type + 1;
+            *p++ = sect[0];
+        } else {
+            *p++ = type;
+            memcpy(p, sect, trk->sectsize);
+            p += trk->sectsize;
+        }
     }
+    return (uint32)(p - start);
+}
 
+/* Replace the contents of the image file with image[0..len).  The file is
+ * rewritten in place, so that links, mode and ownership of the image are kept.
+ */
+static t_stat imdWriteImage(DISK_INFO *myDisk, uint8 *image, uint32 len)
+{
+    if ((sim_fseek(myDisk->file, 0, SEEK_SET) != 0) ||
+        (sim_fwrite(image, 1, len, myDisk->file) != len) ||
+        (fflush(myDisk->file) != 0) ||
+        (sim_set_fsize(myDisk->file, (t_addr)len) == -1))
+        return SCPE_IOERR;
     return SCPE_OK;
 }
 
+/* Save the tracks that have been written.  The image is rebuilt with the written
+ * tracks serialized again, since the size of a track changes when sectors become
+ * (un)compressed; everything else, such as tracks that haven't been written or
+ * track headers without sectors, is copied as it is.  Tracks created by trackWrite
+ * are appended at the end.
+ */
+t_stat diskFlush(DISK_INFO *myDisk)
+{
+    TRACK_INFO *order[MAX_CYL * MAX_HEAD], *trk;
+    uint32 orderCyl[MAX_CYL * MAX_HEAD], orderHead[MAX_CYL * MAX_HEAD];
+    uint32 newOffset[MAX_CYL * MAX_HEAD], newLen[MAX_CYL * MAX_HEAD];
+    uint32 pos, fileSize, outLen, n = 0;
+    int32 delta;
+    uint32 cyl, head, i, j;
+    uint8 *image, *out;
+    t_stat r = SCPE_OK;
+
+    if ((myDisk == NULL) || !(myDisk->flags & FD_FLAG_DIRTY))
+        return SCPE_OK;
+    fileSize = sim_fsize(myDisk->file);
+    outLen = 0;
+    for (cyl = 0; cyl < MAX_CYL; cyl++)         /* written tracks, in file order */
+        for (head = 0; head < MAX_HEAD; head++) {
+            trk = &myDisk->track[cyl][head];
+            if (!trk->dirty)
+                continue;
+            for (i = n; (i > 0) && (order[i - 1]->fileOffset > trk->fileOffset); i--) {
+                order[i] = order[i - 1];
+                orderCyl[i] = orderCyl[i - 1];
+                orderHead[i] = orderHead[i - 1];
+            }
+            order[i] = trk;
+            orderCyl[i] = cyl;
+            orderHead[i] = head;
+            n++;
+            outLen += 5 + 3 * trk->nsects + trk->nsects * (1 + trk->sectsize);
+        }
+    if (n == 0) {
+        myDisk->flags &= ~FD_FLAG_DIRTY;
+        return SCPE_OK;
+    }
+    outLen += fileSize;
+    image = (uint8 *)malloc(fileSize + 1);
+    out = (uint8 *)malloc(outLen + 1);
+    if ((image == NULL) || (out == NULL))
+        r = SCPE_MEM;
+    else if ((sim_fseek(myDisk->file, 0, SEEK_SET) != 0) ||
+             (sim_fread(image, 1, fileSize, myDisk->file) != fileSize))
+        r = SCPE_IOERR;
+    else {
+        outLen = 0;
+        pos = 0;
+        for (i = 0; i < n; i++) {
+            trk = order[i];
+            j = trk->fileOffset - pos;          /* bytes up to the track, unchanged */
+            memcpy(out + outLen, image + pos, j);
+            outLen += j;
+            newOffset[i] = outLen;
+            newLen[i] = imdPutTrack(trk, orderCyl[i], orderHead[i], out + outLen);
+            outLen += newLen[i];
+            pos = trk->fileOffset + trk->fileLen;
+        }
+        memcpy(out + outLen, image + pos, fileSize - pos);
+        outLen += fileSize - pos;
+        r = imdWriteImage(myDisk, out, outLen);
+        if (r == SCPE_OK) {
+            /* Move the unchanged tracks by the growth of the written ones before them */
+            for (cyl = 0; cyl < MAX_CYL; cyl++)
+                for (head = 0; head < MAX_HEAD; head++) {
+                    trk = &myDisk->track[cyl][head];
+                    if (trk->dirty || (trk->fileLen == 0))
+                        continue;
+                    delta = 0;
+                    for (i = 0; (i < n) && (order[i]->fileOffset < trk->fileOffset); i++)
+                        delta += (int32)newLen[i] - (int32)order[i]->fileLen;
+                    trk->fileOffset += delta;
+                }
+            for (i = 0; i < n; i++) {
+                order[i]->fileOffset = newOffset[i];
+                order[i]->fileLen = newLen[i];
+                order[i]->dirty = 0;
+            }
+            myDisk->flags &= ~FD_FLAG_DIRTY;
+        }
+    }
+    if (r != SCPE_OK)
+        sim_printf("SIM_IMD: Error saving written tracks: %s\n", sim_error_text(r));
+    free(image);
+    free(out);
+    return r;
+}
+
+/* Unit flush routine, called whenever the simulator stops */
+static void imdUnitFlush(UNIT *uptr)
+{
+    DISK_INFO *myDisk;
+
+    for (myDisk = imd_disks; myDisk != NULL; myDisk = myDisk->next) {
+        if (myDisk->uptr == uptr) {
+            diskFlush(myDisk);
+            break;
+        }
+    }
+    fflush(uptr->fileref);
+}
+
 /*
  * This function closes the IMD image.  After closing, the sector read/write operations are not
- * possible.
+ * possible.  Tracks that have been written are saved first; if that fails the image is left
+ * open and the error returned, so that the close can be retried.
  *
  * The IMD file is not actually closed, we leave that to SIMH.
  */
 t_stat diskClose(DISK_INFO **myDisk)
 {
+    DISK_INFO **pp;
+    t_stat r;
+
     if(*myDisk == NULL)
         return SCPE_OPENERR;
+    r = diskFlush(*myDisk);
+    if (r != SCPE_OK)                           /* keep the disk so the close can be retried */
+        return r;
+    for (pp = &imd_disks; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == *myDisk) {
+            *pp = (*myDisk)->next;
+            break;
+        }
+    }
+    if (((*myDisk)->uptr != NULL) && ((*myDisk)->uptr->io_flush == imdUnitFlush))
+        (*myDisk)->uptr->io_flush = NULL;
+    imdFreeTracks(*myDisk);
     free(*myDisk);
     *myDisk = NULL;
-    return SCPE_OK;
+    return r;
 }
 
 #define MAX_COMMENT_LEN 256
@@ -487,9 +784,9 @@ t_stat sectRead(DISK_INFO *myDisk,
              uint32 *flags,
              uint32 *readlen)
 {
-    uint32 sectorFileOffset;
+    TRACK_INFO *trk;
+    uint32 idx;
     uint8 sectRecordType;
-    uint8 start_sect;
     *readlen = 0;
     *flags = 0;
 
@@ -516,17 +813,20 @@ t_stat sectRead(DISK_INFO *myDisk,
         return(SCPE_IOERR);
     }
 
-    start_sect = myDisk->track[Cyl][Head].start_sector;
-
-    sectorFileOffset = myDisk->track[Cyl][Head].sectorOffsetMap[Sector-start_sect];
+    trk = &myDisk->track[Cyl][Head];
+    idx = Sector - trk->start_sector;
 
-    sim_debug(myDisk->debugmask, myDisk->device, "Reading C:%d/H:%d/S:%d, len=%d, offset=0x%08x\n", Cyl, Head, Sector, buflen, sectorFileOffset);
+    sim_debug(myDisk->debugmask, myDisk->device, "Reading C:%d/H:%d/S:%d, len=%d\n", Cyl, Head, Sector, buflen);
 
-    sim_fseek(myDisk->file, sectorFileOffset-1, SEEK_SET);
+    if((idx >= MAX_SPT) || (imdLoadTrack(myDisk, trk) != SCPE_OK)) {
+        *flags |= IMD_DISK_IO_ERROR_GENERAL;
+        return(SCPE_IOERR);
+    }
 
-    sectRecordType = fgetc(myDisk->file);
+    sectRecordType = trk->recType[idx];
     switch(sectRecordType) {
         case SECT_RECORD_UNAVAILABLE:   /* Data could not be read from the original media */
+        case SECT_ABSENT:               /* No such sector on the track */
             *flags |= IMD_DISK_IO_ERROR_GENERAL;
             break;
         case SECT_RECORD_NORM_ERR:      /* Normal Data with read error */
@@ -534,21 +834,16 @@ t_stat sectRead(DISK_INFO *myDisk,
             *flags |= IMD_DISK_IO_ERROR_CRC;
         case SECT_RECORD_NORM:          /* Normal Data */
         case SECT_RECORD_NORM_DAM:      /* Normal Data with deleted address mark */
-
-/*          sim_debug(myDisk->debugmask, myDisk->device, "Uncompressed Data\n"); */
-            if (sim_fread(buf, 1, myDisk->track[Cyl][Head].sectsize, myDisk->file) != myDisk->track[Cyl][Head].sectsize) {
-                sim_printf("SIM_IMD[%s]: sim_fread error for SECT_RECORD_NORM_DAM.\n", __FUNCTION__);
-            }
-            *readlen = myDisk->track[Cyl][Head].sectsize;
+            memcpy(buf, trk->data + idx * trk->sectsize, trk->sectsize);
+            *readlen = trk->sectsize;
             break;
         case SECT_RECORD_NORM_COMP_ERR: /* Compressed Normal Data */
         case SECT_RECORD_NORM_DAM_COMP_ERR: /* Compressed Normal Data with deleted address mark */
             *flags |= IMD_DISK_IO_ERROR_CRC;
         case SECT_RECORD_NORM_COMP:     /* Compressed Normal Data */
         case SECT_RECORD_NORM_DAM_COMP: /* Compressed Normal Data with deleted address mark */
-/*          sim_debug(myDisk->debugmask, myDisk->device, "Compressed Data\n"); */
-            memset(buf, fgetc(myDisk->file), myDisk->track[Cyl][Head].sectsize);
-            *readlen = myDisk->track[Cyl][Head].sectsize;
+            memcpy(buf, trk->data + idx * trk->sectsize, trk->sectsize);
+            *readlen = trk->sectsize;
             *flags |= IMD_DISK_IO_COMPRESSED;
             break;
         default:
@@ -580,9 +875,9 @@ t_stat sectWrite(DISK_INFO *myDisk,
               uint32 *flags,
               uint32 *writelen)
 {
-    uint32 sectorFileOffset;
+    TRACK_INFO *trk;
+    uint32 idx;
     uint8 sectRecordType;
-    uint8 start_sect;
     *writelen = 0;
 
     sim_debug(myDisk->debugmask, myDisk->device, "Writing C:%d/H:%d/S:%d, len=%d\n", Cyl, Head, Sector, buflen);
@@ -605,7 +900,7 @@ t_stat sectWrite(DISK_INFO *myDisk,
     }
 
     if(myDisk->flags & FD_FLAG_WRITELOCK) {
-        sim_printf("Disk write-protected because the image contains compressed sectors. Use IMDU to uncompress.\n");
+        sim_printf("Disk write-protected.\n");
         *flags = IMD_DISK_IO_ERROR_WPROT;
         return(SCPE_IOERR);
     }
@@ -617,11 +912,19 @@ t_stat sectWrite(DISK_INFO *myDisk,
         return(SCPE_IOERR);
     }
 
-    start_sect = myDisk->track[Cyl][Head].start_sector;
+    trk = &myDisk->track[Cyl][Head];
+    idx = Sector - trk->start_sector;
 
-    sectorFileOffset = myDisk->track[Cyl][Head].sectorOffsetMap[Sector-start_sect];
+    if((idx >= MAX_SPT) || (imdLoadTrack(myDisk, trk) != SCPE_OK)) {
+        *flags = IMD_DISK_IO_ERROR_GENERAL;
+        return(SCPE_IOERR);
+    }
 
-    sim_fseek(myDisk->file, sectorFileOffset-1, SEEK_SET);
+    if(trk->recType[idx] == SECT_ABSENT) {      /* not in the sector map, can't be saved */
+        sim_debug(myDisk->debugmask, myDisk->device, "%s: sector not on track\n", __FUNCTION__);
+        *flags = IMD_DISK_IO_ERROR_GENERAL;
+        return(SCPE_IOERR);
+    }
 
     if (*flags & IMD_DISK_IO_ERROR_GENERAL) {
         sectRecordType = SECT_RECORD_UNAVAILABLE;
@@ -637,9 +940,12 @@ t_stat sectWrite(DISK_INFO *myDisk,
         sectRecordType = SECT_RECORD_NORM;
     }
 
-    fputc(sectRecordType, myDisk->file);
-    sim_fwrite(buf, 1, myDisk->track[Cyl][Head].sectsize, myDisk->file);
-    *writelen = myDisk->track[Cyl][Head].sectsize;
+    /* Update the track in memory, it is written to the file by diskFlush */
+    trk->recType[idx] = sectRecordType;
+    memcpy(trk->data + idx * trk->sectsize, buf, trk->sectsize);
+    trk->dirty = 1;
+    myDisk->flags |= FD_FLAG_DIRTY;
+    *writelen = trk->sectsize;
 
     return(SCPE_OK);
 }
@@ -655,6 +961,8 @@ t_stat sectWrite(DISK_INFO *myDisk,
  * format a disk image, then format program must format tracks starting with Cyl 0, Head 0,
  * and proceed sequentially through all tracks/heads on the disk.
  *
+ * sectorLen may be given either as an IMD sector size code (0-6) or in bytes.
+ *
  * Format programs that are known to work include:
  * Cromemco CDOS "INIT.COM"
  * ADC Super-Six (CP/M-80) "FMT8.COM"
@@ -672,10 +980,8 @@ t_stat trackWrite(DISK_INFO *myDisk,
                uint32 *flags)
 {
     FILE *fileref;
-    IMD_HEADER track_header;
-    uint8 *sectorData;
+    TRACK_INFO *trk;
     unsigned long i;
-    unsigned long dataLen;
 
     *flags = 0;
 
@@ -693,6 +999,24 @@ t_stat trackWrite(DISK_INFO *myDisk,
 
     fileref = myDisk->file;
 
+    /* Convert a sector length given in bytes to the IMD sector size code */
+    if (sectorLen > 6) {
+        for (i = 0; (i <= 6) && ((128UL << i) != sectorLen); i++)
+            ;
+        if (i > 6) {
+            sim_printf("SIM_IMD: ERROR: Illegal sector length %d.\n", sectorLen);
+            *flags |= IMD_DISK_IO_ERROR_GENERAL;
+            return(SCPE_IOERR);
+        }
+        sectorLen = i;
+    }
+
+    if ((numSectors > MAX_SPT) || (Cyl >= MAX_CYL) || (Head >= MAX_HEAD)) {
+        sim_printf("SIM_IMD: ERROR: Illegal track C:%d/H:%d/N:%d.\n", Cyl, Head, numSectors);
+        *flags |= IMD_DISK_IO_ERROR_GENERAL;
+        return(SCPE_IOERR);
+    }
+
     sim_debug(myDisk->debugmask, myDisk->device, "Formatting C:%d/H:%d/N:%d, len=%d, Fill=0x%02x\n", Cyl, Head, numSectors, sectorLen, fillbyte);
 
     /* Truncate the IMD file when formatting Cyl 0, Head 0 */
@@ -707,9 +1031,14 @@ t_stat trackWrite(DISK_INFO *myDisk,
             *flags |= IMD_DISK_IO_ERROR_GENERAL;
             return(SCPE_IOERR);
         }
-        /* Flush and re-parse the IMD file. */
         fflush(fileref);
-        diskParse(myDisk, 0);
+
+        /* All tracks are gone, including any written ones not yet saved. */
+        imdFreeTracks(myDisk);
+        memset(myDisk->track, 0, (sizeof(TRACK_INFO)*MAX_CYL*MAX_HEAD));
+        myDisk->ntracks = 0;
+        myDisk->nsides = 1;
+        myDisk->flags &= ~FD_FLAG_DIRTY;
     }
 
     /* Check to make sure the Cyl / Head is not already formatted. */
@@ -719,37 +1048,45 @@ t_stat trackWrite(DISK_INFO *myDisk,
         return(SCPE_IOERR);
     }
 
-    track_header.mode = mode;
-    track_header.cyl = Cyl;
-    track_header.head = Head;
-    track_header.nsects = numSectors;
-    track_header.sectsize = sectorLen;
-
-    /* Forward to end of the file, write track header and sector map. */
-    sim_fseek(myDisk->file, 0, SEEK_END);
-    sim_fwrite(&track_header, 1, sizeof(IMD_HEADER), fileref);
-    sim_fwrite(sectorMap, 1, numSectors, fileref);
-
-    /* Compute data length, and fill a sector buffer with the
-     * sector record type as the first byte, and fill the sector
-     * data with the fillbyte.
+    /* Set up the new track in memory, filled with fillbyte.  It is appended to
+     * the file by diskFlush, as are the sector writes that follow the format.
      */
-    dataLen = sectorLen + 1;
-    sectorData = (uint8 *)malloc(dataLen);
-    memset(sectorData, fillbyte, dataLen);
-    sectorData[0] = SECT_RECORD_NORM;
-
-    /* For each sector on the track, write the record type and sector data. */
-    for(i=0;i<numSectors;i++) {
-        sim_fwrite(sectorData, 1, dataLen, fileref);
+    trk = &myDisk->track[Cyl][Head];
+    free(trk->data);
+    memset(trk, 0, sizeof(*trk));
+    trk->start_sector = MAX_SPT;
+    for (i = 0; i < numSectors; i++)
+        if (sectorMap[i] < trk->start_sector)
+            trk->start_sector = sectorMap[i];
+    for (i = 0; i < numSectors; i++)
+        if (sectorMap[i] - trk->start_sector >= MAX_SPT) {
+            sim_printf("SIM_IMD: ERROR: Illegal sector offset %d\n", sectorMap[i] - trk->start_sector);
+            *flags |= IMD_DISK_IO_ERROR_GENERAL;
+            return(SCPE_IOERR);
+        }
+    trk->data = (uint8 *)malloc(MAX_SPT * (128UL << sectorLen));
+    if (trk->data == NULL) {
+        *flags |= IMD_DISK_IO_ERROR_GENERAL;
+        return(SCPE_MEM);
     }
-
-    /* Flush the file, and free the sector buffer. */
-    fflush(fileref);
-    free(sectorData);
-
-    /* Now that the disk track/sector layout has been modified, re-parse the disk image. */
-    diskParse(myDisk, 0);
+    trk->mode = mode;
+    trk->nsects = numSectors;
+    trk->sectsize = 128UL << sectorLen;
+    memcpy(trk->sectorMap, sectorMap, numSectors);
+    memset(trk->logicalHead, Head, numSectors);
+    memset(trk->logicalCyl, Cyl, numSectors);
+    memset(trk->recType, SECT_ABSENT, sizeof(trk->recType));
+    for (i = 0; i < numSectors; i++)
+        trk->recType[sectorMap[i] - trk->start_sector] = SECT_RECORD_NORM;
+    memset(trk->data, fillbyte, MAX_SPT * trk->sectsize);
+    trk->fileOffset = sim_fsize(fileref);
+    trk->fileLen = 0;
+    trk->dirty = 1;
+    myDisk->flags |= FD_FLAG_DIRTY;
+
+    myDisk->ntracks++;
+    if ((Head + 1) > myDisk->nsides)
+        myDisk->nsides = Head + 1;
 
     return(SCPE_OK);
 }
@@ -77,11 +77,12 @@ typedef struct {
 #define MAX_SPT     26
 
 #define FD_FLAG_WRITELOCK   1
+#define FD_FLAG_DIRTY       2   /* Tracks have been written in memory only */
 
 #define IMD_DISK_IO_ERROR_GENERAL       (1 << 0)    /* General data error. */
 #define IMD_DISK_IO_ERROR_CRC           (1 << 1)    /* Data read/written, but got a CRC error. */
 #define IMD_DISK_IO_DELETED_ADDR_MARK   (1 << 2)    /* Sector had a deleted address mark */
-#define IMD_DISK_IO_COMPRESSED          (1 << 3)    /* Sector is compressed in the IMD file (Read Only) */
+#define IMD_DISK_IO_COMPRESSED          (1 << 3)    /* Sector is compressed in the IMD file */
 #define IMD_DISK_IO_ERROR_WPROT         (1 << 4)    /* Disk is write protected */
 
 #define IMD_MODE_500K_FM        0
@@ -98,17 +99,25 @@ typedef struct {
 #define IMAGE_TYPE_IMD          2               /* ImageDisk "IMD" image file.              */
 #define IMAGE_TYPE_CPT          3               /* CP/M Transfer "CPT" image file.          */
 
+#define SECT_ABSENT     0xFF    /* recType of a sector not on the track */
+
 typedef struct {
     uint8 mode;
     uint8 nsects;
     uint32 sectsize;
-    uint32 sectorOffsetMap[MAX_SPT];
     uint8 start_sector;
     uint8 logicalHead[MAX_SPT];
     uint8 logicalCyl[MAX_SPT];
+    uint8 sectorMap[MAX_SPT];       /* Sector numbers in physical order */
+    uint8 headFlags;                /* IMD_FLAG_SECT_HEAD_MAP/CYL_MAP in the track header */
+    uint8 recType[MAX_SPT];         /* Sector record types, by sector - start_sector */
+    uint32 fileOffset;              /* Position of the track in the IMD file */
+    uint32 fileLen;                 /* Size of the track in the IMD file */
+    uint8 *data;                    /* Sector data once loaded, by sector - start_sector */
+    uint8 dirty;                    /* Written since it was last saved */
 } TRACK_INFO;
 
-typedef struct {
+typedef struct DISK_INFO {
     FILE *file;
     uint32 ntracks;
     uint8 nsides;
@@ -117,11 +126,14 @@ typedef struct {
     uint32 debugmask;
     uint32 verbosedebugmask;
     TRACK_INFO track[MAX_CYL][MAX_HEAD];
+    UNIT *uptr;                     /* Unit whose io_flush saves the tracks */
+    struct DISK_INFO *next;         /* Next open disk */
 } DISK_INFO;
 
 extern DISK_INFO *diskOpen(FILE *fileref, uint32 isVerbose);
 extern DISK_INFO *diskOpenEx(FILE *fileref, uint32 isVerbose, DEVICE *device, uint32 debugmask, uint32 verbosedebugmask);
 extern t_stat diskClose(DISK_INFO **myDisk);
+extern t_stat diskFlush(DISK_INFO *myDisk);
 extern t_stat diskCreate(FILE *fileref, const char *ctlr_comment);
 extern uint32 imdGetSides(DISK_INFO *myDisk);
 extern uint32 imdIsWriteLocked(DISK_INFO *myDisk);
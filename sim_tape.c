@@ -93,10 +93,14 @@
 #include "sim_defs.h"
 #include "sim_tape.h"
 #include <ctype.h>
+#include <sys/stat.h>
 
 #if defined SIM_ASYNCH_IO
 #include <pthread.h>
 #endif
+#if defined (HAVE_ZLIB)
+#include <zlib.h>
+#endif
 
 struct sim_tape_fmt {
     const char          *name;                          /* name */
@@ -110,9 +114,17 @@ static struct sim_tape_fmt fmts[MTUF_N_FMT] = {
     { "TPC",  UNIT_RO, sizeof (t_tpclnt) - 1 },
     { "P7B",  0,       0 },
 /*  { "TPF",  UNIT_RO, 0 }, */
+    { NULL,   0,       0 },
+    { "TPZ",  0,       sizeof (t_mtrlnt) - 1 },
     { NULL,   0,       0 }
     };
 
+/* A TPZ container holds a SIMH format image, which is read and written
+   through a block cache while the tape is attached; the record layout is
+   therefore that of SIMH format */
+
+#define MT_GET_LAYOUT(u) ((MT_GET_FMT (u) == MTUF_F_TPZ) ? MTUF_F_STD : MT_GET_FMT (u))
+
 static const uint32 bpi [] = {                          /* tape density table, indexed by MT_DENS constants */
     0,                                                  /*   0 = MT_DENS_NONE -- density not set */
     200,                                                /*   1 = MT_DENS_200  -- 200 bpi NRZI */
@@ -133,12 +145,112 @@ static t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map);
 static void sim_tape_data_trace (UNIT *uptr, const uint8 *data, size_t len, const char* txt, int detail, uint32 reason);
 static t_stat tape_erase_fwd (UNIT *uptr, t_mtrlnt gap_size);
 static t_stat tape_erase_rev (UNIT *uptr, t_mtrlnt gap_size);
+static void _sim_tape_iostat (UNIT *uptr, int op, t_uint64 start, t_mtrlnt bytes, t_stat st);
+static t_stat sim_tape_rdlntf (UNIT *uptr, t_mtrlnt *bc);
+static void _tape_idx_need (UNIT *uptr);
+static t_bool _tape_idx_load (UNIT *uptr);
+static void _tape_idx_save (UNIT *uptr);
+static t_bool _tape_idx_lookup (UNIT *uptr, t_bool reverse, t_mtrlnt *bc, t_stat *status);
+static void _tape_idx_insert (UNIT *uptr, t_addr pos, t_mtrlnt bc, t_bool tmk);
+static void _tape_idx_remove (UNIT *uptr, t_addr from, t_addr to);
+static t_addr _tape_idx_extent (UNIT *uptr, t_mtrlnt bc, t_bool tmk);
+static t_stat _tape_idx_seek_data (UNIT *uptr);
+static void _tape_idx_seek_cancel (UNIT *uptr);
+#if defined (SIM_ASYNCH_IO)
+static void _tape_ra_flush (UNIT *uptr);
+static t_bool _tape_ra_get (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max, t_stat *status);
+static void _tape_ra_note (UNIT *uptr, t_addr opos, t_stat st);
+static void _tape_ra_stop (UNIT *uptr);
+#else
+#define _tape_ra_flush(uptr)
+#define _tape_ra_get(uptr, buf, bc, max, status) FALSE
+#define _tape_ra_note(uptr, opos, st) (void)(opos)
+#define _tape_ra_stop(uptr)
+#endif
 
 
+typedef struct {
+    t_addr              pos;                /* position of the object */
+    t_addr              next;               /* position following the object */
+    t_mtrlnt            bc;                 /* length marker as returned by rdlntf/rdlntr */
+    uint32              tmk;                /* object is a tape mark */
+    } TAPE_INDEX;
+
+#define TAPE_RA_RECS    16                              /* records read ahead */
+#define TAPE_RA_BYTES   (4 * 1024 * 1024)               /*   up to this much data */
+
+typedef struct {
+    t_addr              pos;                /* position of the object */
+    t_addr              next;               /* position following the object */
+    t_mtrlnt            bc;                 /* length marker */
+    uint32              tmk;                /* object is a tape mark */
+    uint8               *buf;               /* record data */
+    uint32              size;               /* buffer size */
+    } TAPE_RA;
+
+typedef struct {
+    t_uint64            offset;             /* container position of the stored data */
+    uint32              clen;               /* stored length (== len if not compressed) */
+    uint32              len;                /* uncompressed length */
+    uint32              crc;                /* CRC-32 of the uncompressed data */
+    } TAPE_TPZ_BLK;
+
+typedef struct {
+    TAPE_TPZ_BLK        blk;                /* a stored copy of block data */
+    uint32              next;               /* next object with the same hash */
+    } TAPE_TPZ_OBJ;
+
+#define TPZ_CACHE       8                               /* blocks held expanded */
+#define TPZ_HASH        4096                            /* deduplication hash buckets */
+
+typedef struct {
+    uint32              blk;                /* block held, TPZ_NOBLK if none */
+    uint32              used;               /* time of last use */
+    t_bool              dirty;              /* changed since it was stored */
+    uint8               *data;              /* expanded block */
+    } TAPE_TPZ_SLOT;
+
+typedef struct {
+    FILE                *file;              /* the container */
+    uint32              blksize;            /* uncompressed bytes per block */
+    uint32              nblks;              /* blocks in the block table */
+    uint32              blk_size;           /* block table entries allocated */
+    TAPE_TPZ_BLK        *blk;               /* block table */
+    t_uint64            size;               /* image size */
+    t_uint64            tbl;                /* container position of the block table */
+    t_uint64            ridx;               /*   and of the record index entries */
+    uint32              nrecs;              /*   record index entries stored */
+    t_uint64            end;                /* container position for new data */
+    t_uint64            pos;                /* image position for the next transfer */
+    t_bool              eof;                /* a read reached the end of the image */
+    t_bool              error;              /* a transfer failed */
+    t_bool              changed;            /* the image was written */
+    uint32              clock;              /* cache use counter */
+    TAPE_TPZ_SLOT       cache[TPZ_CACHE];   /* expanded blocks */
+    uint8               *cbuf;              /* compressed data buffer */
+    uint8               *vbuf;              /* deduplication compare buffer */
+    TAPE_TPZ_OBJ        *obj;               /* stored copies, for deduplication */
+    uint32              nobjs;              /*   entries in use */
+    uint32              obj_size;           /*   entries allocated */
+    uint32              hash[TPZ_HASH];     /*   first object by CRC */
+    } TAPE_TPZ;
+
 struct tape_context {
     DEVICE              *dptr;              /* Device for unit (access to debug flags) */
     uint32              dbit;               /* debugging bit for trace */
     uint32              auto_format;        /* Format determined dynamically */
+    SIM_IOSTATS         *iostats;           /* I/O statistics */
+    TAPE_INDEX          *idx;               /* record index, in position order */
+    uint32              idx_count;          /* entries in use */
+    uint32              idx_size;           /* entries allocated */
+    uint32              idx_hint;           /* most recently used entry */
+    t_bool              idx_built;          /* whole tape has been indexed */
+    t_addr              idx_scan;           /* where the indexing scan stopped */
+    t_bool              idx_dirty;          /* index differs from the cache file */
+    t_bool              idx_cache;          /* keep the index in tapefile.idx */
+    t_bool              idx_seek;           /* record data not yet positioned */
+    t_addr              idx_data;           /*   position of that data */
+    TAPE_TPZ            *tpz;               /* TPZ container, if any */
 #if defined SIM_ASYNCH_IO
     int                 asynch_io;          /* Asynchronous Interrupt scheduling enabled */
     int                 asynch_io_latency;  /* instructions to delay pending interrupt */
@@ -159,6 +271,21 @@ struct tape_context {
     uint32              *objupdate;
     TAPE_PCALLBACK      callback;
     t_stat              io_status;
+    t_uint64            io_done_time;       /* when the I/O thread completed the request */
+    TAPE_RA             ra[TAPE_RA_RECS];   /* read-ahead ring */
+    uint32              ra_head;            /* oldest record in the ring */
+    uint32              ra_count;           /* records in the ring */
+    uint32              ra_bytes;           /* data bytes in the ring */
+    uint32              ra_gen;             /* discard generation */
+    t_addr              ra_next;            /* position the worker reads next */
+    t_addr              ra_expect;          /* position after the last forward read */
+    t_bool              ra_active;          /* worker is reading ahead */
+    t_bool              ra_started;         /* worker thread exists */
+    t_bool              ra_exit;            /* worker should exit */
+    FILE                *ra_file;           /* worker's container stream */
+    pthread_t           ra_thread;
+    pthread_mutex_t     ra_lock;
+    pthread_cond_t      ra_cond;
 #endif
     };
 #define tape_ctx up8                        /* Field in Unit structure which points to the tape_context */
@@ -293,6 +420,7 @@ struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
             }
         pthread_mutex_lock (&ctx->io_lock);
         ctx->io_top = TOP_DONE;
+        ctx->io_done_time = sim_iostat_time ();
         pthread_cond_signal (&ctx->io_done);
         sim_activate (uptr, ctx->asynch_io_latency);
     }
@@ -329,6 +457,7 @@ if (ctx->callback) {
     ctx->callback = NULL;
     if (ctx->asynch_io)
         pthread_mutex_unlock (&ctx->io_lock);
+    sim_iostat_async (ctx->iostats, ctx->io_done_time);
     callback (uptr, ctx->io_status);
     }
 else {
@@ -448,6 +577,763 @@ if (sim_asynch_enabled)
 fflush (uptr->fileref);
 }
 
+/* TPZ compressed tape containers
+
+   A TPZ container holds a SIMH format tape image cut into fixed size
+   blocks, each compressed independently (or stored as is when it doesn't
+   compress), followed by a block table and the record index:
+
+       header       "SIMTPZ01", block size, block count, image size,
+                    table offset (little endian, 32 bytes)
+       block data
+       block table  per block: data offset, stored length, length, CRC-32
+                    of the uncompressed data (24 bytes each)
+       record index entry count (8 bytes), then per record or tape mark:
+                    image position, following position, length marker,
+                    flags (bit 0 set for a tape mark) (24 bytes each)
+
+   Blocks with identical contents share one copy of the stored data.  The
+   record index is the one described under "Record index" below; it is
+   loaded at attach so that spacing over the records of an archived tape
+   expands no blocks.  It is only stored once it is complete, and an entry
+   count of 0 (or a container that ends with the block table) means there
+   is none.
+
+   While attached, the unit's file I/O goes through _tape_fseek,
+   _tape_fread, _tape_fwrite and friends, which for a TPZ unit expand the
+   blocks on demand into a small cache.  A changed block is compressed
+   again when it leaves the cache and is appended after the data already
+   in the container.  On detach the remaining changed blocks and a new
+   block table are appended and then the header is rewritten to refer to
+   them, so the container stays consistent if the update is interrupted.
+   Once more than half of the stored data is no longer referenced, the
+   container is copied without it into a temporary file which then
+   replaces the original.
+*/
+
+#define TPZ_MAGIC       "SIMTPZ01"
+#define TPZ_HDRSIZE     32
+#define TPZ_ENTSIZE     24
+#define TPZ_RECSIZE     24                              /* record index entry */
+#define TPZ_BLKSIZE     (256 * 1024)                    /* default block size */
+#define TPZ_MAXBLKSIZE  (16 * 1024 * 1024)
+#define TPZ_NOBLK       0xFFFFFFFF
+
+static void _tape_tpz_free (TAPE_TPZ *tpz)
+{
+uint32 i;
+
+if (tpz) {
+    for (i = 0; i < TPZ_CACHE; i++)
+        free (tpz->cache[i].data);
+    free (tpz->cbuf);
+    free (tpz->vbuf);
+    free (tpz->obj);
+    free (tpz->blk);
+    free (tpz);
+    }
+}
+
+#if defined (HAVE_ZLIB)
+
+static void _tpz_put32 (uint8 *p, uint32 v)
+{
+p[0] = (uint8)v; p[1] = (uint8)(v >> 8); p[2] = (uint8)(v >> 16); p[3] = (uint8)(v >> 24);
+}
+
+static void _tpz_put64 (uint8 *p, t_uint64 v)
+{
+_tpz_put32 (p, (uint32)v);
+_tpz_put32 (p + 4, (uint32)(v >> 32));
+}
+
+static uint32 _tpz_get32 (const uint8 *p)
+{
+return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static t_uint64 _tpz_get64 (const uint8 *p)
+{
+return _tpz_get32 (p) | (((t_uint64)_tpz_get32 (p + 4)) << 32);
+}
+
+/* Length of block b of an image of the given size */
+
+static uint32 _tpz_blklen (TAPE_TPZ *tpz, uint32 b)
+{
+t_uint64 start = ((t_uint64)b) * tpz->blksize;
+
+if (start >= tpz->size)
+    return 0;
+return (tpz->size - start < tpz->blksize) ? (uint32)(tpz->size - start) : tpz->blksize;
+}
+
+/* Read and check the header and block table of the container cf */
+
+static t_stat _tpz_read_table (FILE *cf, TAPE_TPZ *tpz)
+{
+uint8 hdr[TPZ_HDRSIZE], ent[TPZ_ENTSIZE];
+t_uint64 fsize = (t_uint64)sim_fsize_ex (cf);
+t_uint64 tbl;
+uint32 i;
+
+if ((sim_fseek (cf, 0, SEEK_SET) != 0) ||
+    (fread (hdr, sizeof (hdr), 1, cf) != 1) ||
+    (memcmp (hdr, TPZ_MAGIC, 8) != 0))
+    return SCPE_FMT;
+tpz->blksize = _tpz_get32 (hdr + 8);
+tpz->nblks = _tpz_get32 (hdr + 12);
+tpz->size = _tpz_get64 (hdr + 16);
+tbl = _tpz_get64 (hdr + 24);
+if ((tpz->blksize < 512) || (tpz->blksize > TPZ_MAXBLKSIZE) ||
+    (tbl < TPZ_HDRSIZE) || (tbl > fsize) ||
+    (tpz->nblks > (fsize - tbl) / TPZ_ENTSIZE) ||      /* table must fit in the file */
+    (tpz->size > ((t_uint64)tpz->nblks) * tpz->blksize) ||
+    (tpz->size + tpz->blksize <= ((t_uint64)tpz->nblks) * tpz->blksize) ||
+    (sim_fseek (cf, (t_addr)tbl, SEEK_SET) != 0))
+    return SCPE_FMT;
+tpz->blk_size = tpz->nblks + 1;
+tpz->blk = (TAPE_TPZ_BLK *)calloc (tpz->blk_size, sizeof (*tpz->blk));
+if (tpz->blk == NULL)
+    return SCPE_MEM;
+for (i = 0; i < tpz->nblks; i++) {                      /* load the block table */
+    TAPE_TPZ_BLK *b = &tpz->blk[i];
+
+    if (fread (ent, sizeof (ent), 1, cf) != 1)
+        return SCPE_FMT;
+    b->offset = _tpz_get64 (ent);
+    b->clen = _tpz_get32 (ent + 8);
+    b->len = _tpz_get32 (ent + 12);
+    b->crc = _tpz_get32 (ent + 16);
+    if ((b->len != _tpz_blklen (tpz, i)) || (b->clen > compressBound (tpz->blksize)) ||
+        (b->offset < TPZ_HDRSIZE) || (b->offset + b->clen > tbl))
+        return SCPE_FMT;
+    }
+tpz->tbl = tbl;
+tpz->ridx = tbl + ((t_uint64)tpz->nblks) * TPZ_ENTSIZE + 8;
+tpz->nrecs = 0;
+if ((tpz->ridx <= fsize) &&                             /* record index present? */
+    (fread (ent, 8, 1, cf) == 1) &&
+    (_tpz_get64 (ent) <= (fsize - tpz->ridx) / TPZ_RECSIZE) &&
+    (_tpz_get64 (ent) < TPZ_NOBLK))
+    tpz->nrecs = (uint32)_tpz_get64 (ent);
+tpz->end = fsize;                                       /* new data goes after everything */
+return SCPE_OK;
+}
+
+/* Remember the stored copy of a block for deduplication */
+
+static t_stat _tpz_add_obj (TAPE_TPZ *tpz, const TAPE_TPZ_BLK *b)
+{
+uint32 h = b->crc & (TPZ_HASH - 1);
+
+if (tpz->nobjs == tpz->obj_size) {
+    uint32 size = tpz->obj_size ? 2 * tpz->obj_size : 1024;
+    TAPE_TPZ_OBJ *obj = (TAPE_TPZ_OBJ *)realloc (tpz->obj, size * sizeof (*obj));
+
+    if (obj == NULL)
+        return SCPE_MEM;
+    tpz->obj = obj;
+    tpz->obj_size = size;
+    }
+tpz->obj[tpz->nobjs].blk = *b;
+tpz->obj[tpz->nobjs].next = tpz->hash[h];
+tpz->hash[h] = tpz->nobjs++;
+return SCPE_OK;
+}
+
+/* Compress block b from data and append it to the container, unless the
+   same contents are stored already */
+
+static t_stat _tpz_store (TAPE_TPZ *tpz, uint32 b, const uint8 *data)
+{
+TAPE_TPZ_BLK e;
+uLongf clen = compressBound (tpz->blksize);
+const uint8 *sdata = tpz->cbuf;
+uint32 j;
+
+if (b >= tpz->blk_size) {                               /* grow the block table */
+    uint32 size = 2 * b + 1;
+    TAPE_TPZ_BLK *blk = (TAPE_TPZ_BLK *)realloc (tpz->blk, size * sizeof (*blk));
+
+    if (blk == NULL)
+        return SCPE_MEM;
+    memset (blk + tpz->blk_size, 0, (size - tpz->blk_size) * sizeof (*blk));
+    tpz->blk = blk;
+    tpz->blk_size = size;
+    }
+e.len = _tpz_blklen (tpz, b);
+e.crc = (uint32)crc32 (0L, data, e.len);
+if ((compress2 (tpz->cbuf, &clen, data, e.len, Z_DEFAULT_COMPRESSION) != Z_OK) ||
+    (clen >= e.len)) {                                  /* doesn't compress? */
+    clen = e.len;                                       /*   store it */
+    sdata = data;
+    }
+e.clen = (uint32)clen;
+for (j = tpz->hash[e.crc & (TPZ_HASH - 1)]; j != TPZ_NOBLK; j = tpz->obj[j].next) {
+    TAPE_TPZ_BLK *o = &tpz->obj[j].blk;
+
+    if ((o->crc == e.crc) && (o->len == e.len) && (o->clen == e.clen) &&
+        (sim_fseek (tpz->file, (t_addr)o->offset, SEEK_SET) == 0) &&
+        (fread (tpz->vbuf, 1, e.clen, tpz->file) == e.clen) &&
+        (memcmp (tpz->vbuf, sdata, e.clen) == 0))
+        break;                                          /* same contents already stored */
+    }
+if (j != TPZ_NOBLK)
+    e.offset = tpz->obj[j].blk.offset;
+else {
+    e.offset = tpz->end;
+    if ((sim_fseek (tpz->file, (t_addr)e.offset, SEEK_SET) != 0) ||
+        (fwrite (sdata, 1, e.clen, tpz->file) != e.clen))
+        return SCPE_IOERR;
+    tpz->end += e.clen;
+    _tpz_add_obj (tpz, &e);                             /* failing only loses deduplication */
+    }
+tpz->blk[b] = e;
+if (b >= tpz->nblks)
+    tpz->nblks = b + 1;
+return SCPE_OK;
+}
+
+/* Expand block b into data */
+
+static t_stat _tpz_load (TAPE_TPZ *tpz, uint32 b, uint8 *data)
+{
+TAPE_TPZ_BLK *e;
+uLongf dlen = tpz->blksize;
+
+memset (data, 0, tpz->blksize);
+if ((b >= tpz->nblks) || (tpz->blk[b].len == 0))        /* not stored yet */
+    return SCPE_OK;
+e = &tpz->blk[b];
+if ((sim_fseek (tpz->file, (t_addr)e->offset, SEEK_SET) != 0) ||
+    (fread (tpz->cbuf, 1, e->clen, tpz->file) != e->clen))
+    return SCPE_IOERR;
+if (e->clen == e->len)                                  /* stored */
+    memcpy (data, tpz->cbuf, e->len);
+else if ((uncompress (data, &dlen, tpz->cbuf, e->clen) != Z_OK) || (dlen != e->len))
+    return SCPE_FMT;
+if (crc32 (0L, data, e->len) != e->crc)
+    return SCPE_FMT;
+return SCPE_OK;
+}
+
+/* Write a changed cache slot back to the container */
+
+static t_stat _tpz_clean (TAPE_TPZ *tpz, TAPE_TPZ_SLOT *s)
+{
+t_stat r;
+
+if (!s->dirty)
+    return SCPE_OK;
+r = _tpz_store (tpz, s->blk, s->data);
+if (r == SCPE_OK)
+    s->dirty = FALSE;
+return r;
+}
+
+/* Return the cache slot holding block b, loading it if need be */
+
+static TAPE_TPZ_SLOT *_tpz_slot (TAPE_TPZ *tpz, uint32 b, t_bool load)
+{
+TAPE_TPZ_SLOT *s, *lru = &tpz->cache[0];
+uint32 i;
+
+for (i = 0; i < TPZ_CACHE; i++) {
+    s = &tpz->cache[i];
+    if (s->blk == b) {
+        s->used = ++tpz->clock;
+        return s;
+        }
+    if (s->used < lru->used)
+        lru = s;
+    }
+s = lru;
+if ((s->data == NULL) &&
+    ((s->data = (uint8 *)malloc (tpz->blksize)) == NULL))
+    return NULL;
+if (_tpz_clean (tpz, s) != SCPE_OK)
+    return NULL;
+s->blk = TPZ_NOBLK;
+if (load) {
+    if (_tpz_load (tpz, b, s->data) != SCPE_OK)
+        return NULL;
+    }
+else
+    memset (s->data, 0, tpz->blksize);
+s->blk = b;
+s->used = ++tpz->clock;
+return s;
+}
+
+static size_t _tape_tpz_read (TAPE_TPZ *tpz, uint8 *buf, size_t len)
+{
+size_t done = 0;
+
+while (done < len) {
+    uint32 b = (uint32)(tpz->pos / tpz->blksize);
+    uint32 off = (uint32)(tpz->pos % tpz->blksize);
+    size_t n = tpz->blksize - off;
+    TAPE_TPZ_SLOT *s;
+
+    if (tpz->pos >= tpz->size) {
+        tpz->eof = TRUE;
+        break;
+        }
+    if (n > tpz->size - tpz->pos)
+        n = (size_t)(tpz->size - tpz->pos);
+    if (n > len - done)
+        n = len - done;
+    if ((s = _tpz_slot (tpz, b, TRUE)) == NULL) {
+        tpz->error = TRUE;
+        break;
+        }
+    memcpy (buf + done, s->data + off, n);
+    done += n;
+    tpz->pos += n;
+    }
+return done;
+}
+
+static size_t _tape_tpz_write (TAPE_TPZ *tpz, const uint8 *buf, size_t len)
+{
+size_t done = 0;
+
+while (done < len) {
+    uint32 b = (uint32)(tpz->pos / tpz->blksize);
+    uint32 off = (uint32)(tpz->pos % tpz->blksize);
+    size_t n = tpz->blksize - off;
+    TAPE_TPZ_SLOT *s;
+
+    if (n > len - done)
+        n = len - done;
+    s = _tpz_slot (tpz, b, ((t_uint64)b) * tpz->blksize < tpz->size);
+    if (s == NULL) {
+        tpz->error = TRUE;
+        break;
+        }
+    memcpy (s->data + off, buf + done, n);
+    s->dirty = TRUE;
+    tpz->changed = TRUE;
+    done += n;
+    tpz->pos += n;
+    if (tpz->pos > tpz->size)
+        tpz->size = tpz->pos;
+    }
+return done;
+}
+
+/* Open the container on uptr->fileref */
+
+static t_stat _tape_tpz_open (UNIT *uptr, TAPE_TPZ **ptpz)
+{
+TAPE_TPZ *tpz = (TAPE_TPZ *)calloc (1, sizeof (*tpz));
+uint32 i;
+t_stat r = SCPE_OK;
+
+*ptpz = NULL;
+if (tpz == NULL)
+    return SCPE_MEM;
+tpz->file = uptr->fileref;
+memset (tpz->hash, 0xFF, sizeof (tpz->hash));
+for (i = 0; i < TPZ_CACHE; i++)
+    tpz->cache[i].blk = TPZ_NOBLK;
+if (sim_fsize_ex (tpz->file) == 0) {                    /* new container */
+    tpz->blksize = TPZ_BLKSIZE;
+    tpz->end = TPZ_HDRSIZE;
+    tpz->changed = TRUE;                                /*   write it on detach */
+    }
+else
+    r = _tpz_read_table (tpz->file, tpz);
+for (i = 0; (r == SCPE_OK) && (i < tpz->nblks); i++)
+    r = _tpz_add_obj (tpz, &tpz->blk[i]);
+if (r == SCPE_OK) {
+    tpz->cbuf = (uint8 *)malloc (compressBound (tpz->blksize));
+    tpz->vbuf = (uint8 *)malloc (compressBound (tpz->blksize));
+    if ((tpz->cbuf == NULL) || (tpz->vbuf == NULL))
+        r = SCPE_MEM;
+    }
+if (r != SCPE_OK) {
+    _tape_tpz_free (tpz);
+    return r;
+    }
+*ptpz = tpz;
+return SCPE_OK;
+}
+
+/* Write the changed blocks, then a new block table and record index after
+   them, and finally the header that refers to that table */
+
+static t_stat _tape_tpz_save (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+TAPE_TPZ *tpz = ctx->tpz;
+uint8 hdr[TPZ_HDRSIZE], ent[TPZ_ENTSIZE], rec[TPZ_RECSIZE];
+uint32 i, nblks, nrecs = ctx->idx_built ? ctx->idx_count : 0;
+t_uint64 tbl;
+t_stat r = SCPE_OK;
+
+if (!tpz->changed &&                                    /* unchanged */
+    !(ctx->idx_built && ctx->idx_dirty))                /*   and no new record index? */
+    return SCPE_OK;
+nblks = (uint32)((tpz->size + tpz->blksize - 1) / tpz->blksize);
+for (i = 0; (i < nblks) && (r == SCPE_OK); i++)         /* blocks that grew */
+    if ((i >= tpz->nblks) || (tpz->blk[i].len != _tpz_blklen (tpz, i))) {
+        TAPE_TPZ_SLOT *s = _tpz_slot (tpz, i, TRUE);
+
+        if (s == NULL)
+            r = SCPE_IOERR;
+        else
+            s->dirty = TRUE;
+        }
+for (i = 0; (i < TPZ_CACHE) && (r == SCPE_OK); i++)
+    if (tpz->cache[i].blk != TPZ_NOBLK)
+        r = _tpz_clean (tpz, &tpz->cache[i]);
+tbl = tpz->end;
+if ((r == SCPE_OK) && (sim_fseek (tpz->file, (t_addr)tbl, SEEK_SET) != 0))
+    r = SCPE_IOERR;
+for (i = 0; (i < nblks) && (r == SCPE_OK); i++) {       /* block table */
+    _tpz_put64 (ent, tpz->blk[i].offset);
+    _tpz_put32 (ent + 8, tpz->blk[i].clen);
+    _tpz_put32 (ent + 12, tpz->blk[i].len);
+    _tpz_put32 (ent + 16, tpz->blk[i].crc);
+    _tpz_put32 (ent + 20, 0);
+    if (fwrite (ent, sizeof (ent), 1, tpz->file) != 1)
+        r = SCPE_IOERR;
+    }
+_tpz_put64 (rec, nrecs);                                /* record index */
+if ((r == SCPE_OK) && (fwrite (rec, 8, 1, tpz->file) != 1))
+    r = SCPE_IOERR;
+for (i = 0; (i < nrecs) && (r == SCPE_OK); i++) {
+    _tpz_put64 (rec, ctx->idx[i].pos);
+    _tpz_put64 (rec + 8, ctx->idx[i].next);
+    _tpz_put32 (rec + 16, ctx->idx[i].bc);
+    _tpz_put32 (rec + 20, ctx->idx[i].tmk ? 1 : 0);
+    if (fwrite (rec, sizeof (rec), 1, tpz->file) != 1)
+        r = SCPE_IOERR;
+    }
+if ((r == SCPE_OK) && (fflush (tpz->file) != 0))        /* table before the header */
+    r = SCPE_IOERR;
+if (r == SCPE_OK) {                                     /* header last */
+    memcpy (hdr, TPZ_MAGIC, 8);
+    _tpz_put32 (hdr + 8, tpz->blksize);
+    _tpz_put32 (hdr + 12, nblks);
+    _tpz_put64 (hdr + 16, tpz->size);
+    _tpz_put64 (hdr + 24, tbl);
+    if ((sim_fseek (tpz->file, 0, SEEK_SET) != 0) ||
+        (fwrite (hdr, sizeof (hdr), 1, tpz->file) != 1) ||
+        (fflush (tpz->file) != 0))
+        r = SCPE_IOERR;
+    }
+if (r == SCPE_OK) {
+    tpz->nblks = nblks;
+    tpz->tbl = tbl;
+    tpz->ridx = tbl + ((t_uint64)nblks) * TPZ_ENTSIZE + 8;
+    tpz->nrecs = nrecs;
+    tpz->end = tpz->ridx + ((t_uint64)nrecs) * TPZ_RECSIZE;
+    tpz->changed = FALSE;
+    ctx->idx_dirty = FALSE;
+    }
+return r;
+}
+
+/* Load the record index stored in the container; returns TRUE if there
+   was one and its entries are in order and self consistent */
+
+static t_bool _tape_tpz_idx_load (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+TAPE_TPZ *tpz = ctx->tpz;
+uint8 rec[TPZ_RECSIZE];
+t_addr last = 0;
+uint32 i;
+
+if ((tpz->nrecs == 0) ||
+    (sim_fseek (tpz->file, (t_addr)tpz->ridx, SEEK_SET) != 0))
+    return FALSE;
+ctx->idx = (TAPE_INDEX *)calloc (tpz->nrecs, sizeof (*ctx->idx));
+if (ctx->idx == NULL)
+    return FALSE;
+ctx->idx_size = tpz->nrecs;
+for (i = 0; i < tpz->nrecs; i++) {
+    TAPE_INDEX *e = &ctx->idx[i];
+
+    if (fread (rec, sizeof (rec), 1, tpz->file) != 1)
+        break;
+    e->pos = (t_addr)_tpz_get64 (rec);
+    e->next = (t_addr)_tpz_get64 (rec + 8);
+    e->bc = _tpz_get32 (rec + 16);
+    e->tmk = _tpz_get32 (rec + 20) & 1;
+    if ((e->pos < last) ||                              /* out of order or */
+        (e->next != e->pos + _tape_idx_extent (uptr, e->bc, e->tmk))) /* inconsistent? */
+        break;
+    last = e->next;
+    }
+if (i < tpz->nrecs) {                                   /* not usable? */
+    free (ctx->idx);
+    ctx->idx = NULL;
+    ctx->idx_size = 0;
+    return FALSE;
+    }
+ctx->idx_count = tpz->nrecs;
+return TRUE;
+}
+
+typedef struct {
+    t_uint64            offset;
+    uint32              idx;
+    } TAPE_TPZ_REF;
+
+static int _tpz_ref_cmp (const void *a, const void *b)
+{
+const TAPE_TPZ_REF *ra = (const TAPE_TPZ_REF *)a, *rb = (const TAPE_TPZ_REF *)b;
+
+if (ra->offset != rb->offset)
+    return (ra->offset < rb->offset) ? -1 : 1;
+return (ra->idx < rb->idx) ? -1 : (ra->idx > rb->idx);
+}
+
+/* Return the block references of tpz sorted by stored position, and the
+   number of stored bytes they use */
+
+static TAPE_TPZ_REF *_tpz_refs (TAPE_TPZ *tpz, t_uint64 *live)
+{
+TAPE_TPZ_REF *ref = (TAPE_TPZ_REF *)malloc ((tpz->nblks + 1) * sizeof (*ref));
+uint32 i;
+
+*live = 0;
+if (ref == NULL)
+    return NULL;
+for (i = 0; i < tpz->nblks; i++) {
+    ref[i].offset = tpz->blk[i].offset;
+    ref[i].idx = i;
+    }
+qsort (ref, tpz->nblks, sizeof (*ref), _tpz_ref_cmp);
+for (i = 0; i < tpz->nblks; i++)
+    if ((i == 0) || (ref[i].offset != ref[i - 1].offset))
+        *live += tpz->blk[ref[i].idx].clen;
+return ref;
+}
+
+/* Copy the container named filename without its unreferenced data, if
+   that is more than half of it.  The copy replaces the original only once
+   it is complete. */
+
+static void _tape_tpz_compact (const char *filename)
+{
+TAPE_TPZ *tpz = (TAPE_TPZ *)calloc (1, sizeof (*tpz));
+TAPE_TPZ_REF *ref = NULL;
+FILE *cf, *nf = NULL;
+char *tname = (char *)malloc (strlen (filename) + 5);
+uint8 hdr[TPZ_HDRSIZE], ent[TPZ_ENTSIZE];
+t_uint64 live, tbl = TPZ_HDRSIZE;
+uint32 i;
+t_bool ok = FALSE;
+
+cf = sim_fopen (filename, "rb");
+if ((tpz == NULL) || (tname == NULL) || (cf == NULL) ||
+    (_tpz_read_table (cf, tpz) != SCPE_OK) ||
+    ((ref = _tpz_refs (tpz, &live)) == NULL))
+    goto Done;
+if ((tpz->tbl - TPZ_HDRSIZE) - live <= live)            /* mostly in use */
+    goto Done;
+tpz->cbuf = (uint8 *)malloc (compressBound (tpz->blksize));
+sprintf (tname, "%s.new", filename);
+nf = sim_fopen (tname, "wb");
+if ((tpz->cbuf == NULL) || (nf == NULL))
+    goto Done;
+memset (hdr, 0, sizeof (hdr));
+if (fwrite (hdr, sizeof (hdr), 1, nf) != 1)
+    goto Done;
+for (i = 0; i < tpz->nblks; i++) {                      /* stored data, in its order */
+    TAPE_TPZ_BLK *b = &tpz->blk[ref[i].idx];
+
+    if ((i > 0) && (ref[i].offset == ref[i - 1].offset)) {
+        b->offset = tpz->blk[ref[i - 1].idx].offset;    /* shared copy */
+        continue;
+        }
+    if ((sim_fseek (cf, (t_addr)b->offset, SEEK_SET) != 0) ||
+        (fread (tpz->cbuf, 1, b->clen, cf) != b->clen) ||
+        (fwrite (tpz->cbuf, 1, b->clen, nf) != b->clen))
+        goto Done;
+    b->offset = tbl;
+    tbl += b->clen;
+    }
+for (i = 0; i < tpz->nblks; i++) {
+    _tpz_put64 (ent, tpz->blk[i].offset);
+    _tpz_put32 (ent + 8, tpz->blk[i].clen);
+    _tpz_put32 (ent + 12, tpz->blk[i].len);
+    _tpz_put32 (ent + 16, tpz->blk[i].crc);
+    _tpz_put32 (ent + 20, 0);
+    if (fwrite (ent, sizeof (ent), 1, nf) != 1)
+        goto Done;
+    }
+_tpz_put64 (ent, tpz->nrecs);                           /* record index, as is */
+if ((fwrite (ent, 8, 1, nf) != 1) ||
+    (sim_fseek (cf, (t_addr)tpz->ridx, SEEK_SET) != 0))
+    goto Done;
+for (i = 0; i < tpz->nrecs; i++)
+    if ((fread (ent, TPZ_RECSIZE, 1, cf) != 1) ||
+        (fwrite (ent, TPZ_RECSIZE, 1, nf) != 1))
+        goto Done;
+memcpy (hdr, TPZ_MAGIC, 8);
+_tpz_put32 (hdr + 8, tpz->blksize);
+_tpz_put32 (hdr + 12, tpz->nblks);
+_tpz_put64 (hdr + 16, tpz->size);
+_tpz_put64 (hdr + 24, tbl);
+ok = (sim_fseek (nf, 0, SEEK_SET) == 0) &&
+     (fwrite (hdr, sizeof (hdr), 1, nf) == 1);
+Done:
+if (nf && fclose (nf))
+    ok = FALSE;
+if (cf)
+    fclose (cf);
+if (ok) {
+#if defined (_WIN32)
+    remove (filename);                                  /* rename won't replace a file */
+#endif
+    ok = (rename (tname, filename) == 0);
+    }
+if (nf && !ok)
+    remove (tname);
+free (ref);
+free (tname);
+_tape_tpz_free (tpz);
+}
+
+#else
+
+static t_stat _tape_tpz_open (UNIT *uptr, TAPE_TPZ **ptpz)
+{
+*ptpz = NULL;
+return sim_messagef (SCPE_NOFNC, "TPZ tape containers are not supported (built without zlib)\n");
+}
+
+static t_stat _tape_tpz_save (UNIT *uptr)
+{
+return SCPE_NOFNC;
+}
+
+static t_bool _tape_tpz_idx_load (UNIT *uptr)
+{
+return FALSE;
+}
+
+static void _tape_tpz_compact (const char *filename)
+{
+}
+
+static size_t _tape_tpz_read (TAPE_TPZ *tpz, uint8 *buf, size_t len)
+{
+return 0;
+}
+
+static size_t _tape_tpz_write (TAPE_TPZ *tpz, const uint8 *buf, size_t len)
+{
+return 0;
+}
+
+#endif
+
+/* Tape file I/O.  These work like their stdio counterparts on the unit's
+   file, or on the image held in a TPZ container. */
+
+#define _TAPE_TPZ(uptr) ((uptr)->tape_ctx ? ((struct tape_context *)(uptr)->tape_ctx)->tpz : NULL)
+
+static int _tape_fseek (UNIT *uptr, t_addr offset, int whence)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+
+if (tpz == NULL)
+    return sim_fseek (uptr->fileref, offset, whence);
+if (whence == SEEK_CUR)
+    offset += (t_addr)tpz->pos;
+else if (whence == SEEK_END)
+    offset += (t_addr)tpz->size;
+tpz->pos = offset;
+tpz->eof = FALSE;
+return 0;
+}
+
+static size_t _tape_fread (void *bptr, size_t size, size_t count, UNIT *uptr)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+size_t c;
+
+if (tpz == NULL)
+    return sim_fread (bptr, size, count, uptr->fileref);
+if (size == 0)
+    return 0;
+c = _tape_tpz_read (tpz, (uint8 *)bptr, size * count) / size;
+if (!sim_end && (size > sizeof (char)))                 /* be and not byte? */
+    sim_buf_swap_data (bptr, size, c);                  /* swap, as sim_fread does */
+return c;
+}
+
+static size_t _tape_fwrite (const void *bptr, size_t size, size_t count, UNIT *uptr)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+uint8 *sbuf;
+size_t c;
+
+if (tpz == NULL)
+    return sim_fwrite (bptr, size, count, uptr->fileref);
+if (size == 0)
+    return 0;
+if (sim_end || (size == sizeof (char)))                 /* le or byte? */
+    return _tape_tpz_write (tpz, (const uint8 *)bptr, size * count) / size;
+sbuf = (uint8 *)malloc (size * count);                  /* swap, as sim_fwrite does */
+if (sbuf == NULL)
+    return 0;
+sim_buf_copy_swapped (sbuf, bptr, size, count);
+c = _tape_tpz_write (tpz, sbuf, size * count) / size;
+free (sbuf);
+return c;
+}
+
+static int _tape_ferror (UNIT *uptr)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+
+return tpz ? tpz->error : ferror (uptr->fileref);
+}
+
+static int _tape_feof (UNIT *uptr)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+
+return tpz ? tpz->eof : feof (uptr->fileref);
+}
+
+static void _tape_clearerr (UNIT *uptr)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+
+if (tpz)
+    tpz->error = tpz->eof = FALSE;
+else
+    clearerr (uptr->fileref);
+}
+
+static t_addr _tape_fsize (UNIT *uptr)
+{
+TAPE_TPZ *tpz = _TAPE_TPZ (uptr);
+
+return tpz ? (t_addr)tpz->size : (t_addr)sim_fsize_ex (uptr->fileref);
+}
+
+/* Check whether a SIMH format attach actually opened a TPZ container */
+
+static t_bool _tape_tpz_check (UNIT *uptr)
+{
+char magic[8];
+
+if ((_tape_fseek (uptr, 0, SEEK_SET) != 0) ||
+    (fread (magic, sizeof (magic), 1, uptr->fileref) != 1))
+    return FALSE;
+return (memcmp (magic, TPZ_MAGIC, sizeof (magic)) == 0);
+}
+
 /* Attach tape unit */
 
 t_stat sim_tape_attach (UNIT *uptr, CONST char *cptr)
@@ -467,6 +1353,7 @@ DEVICE *dptr;
 char gbuf[CBUFSIZE];
 t_stat r;
 t_bool auto_format = FALSE;
+TAPE_TPZ *tpz = NULL;
 
 if ((dptr = find_dev_from_unit (uptr)) == NULL)
     return SCPE_NOATT;
@@ -484,6 +1371,20 @@ if (MT_GET_FMT (uptr) == MTUF_F_TPC)
 r = attach_unit (uptr, (CONST char *)cptr);             /* attach unit */
 if (r != SCPE_OK)                                       /* error? */
     return sim_messagef (r, "Can't open tape image: %s\n", cptr);
+if ((MT_GET_FMT (uptr) == MTUF_F_STD) &&                /* SIMH holding a TPZ container? */
+    _tape_tpz_check (uptr)) {
+    uptr->flags = (uptr->flags & ~MTUF_FMT) | MT_F_TPZ;
+    auto_format = TRUE;
+    }
+if (MT_GET_FMT (uptr) == MTUF_F_TPZ) {                  /* TPZ? */
+    r = _tape_tpz_open (uptr, &tpz);                    /* read the block table */
+    if (r != SCPE_OK) {
+        detach_unit (uptr);
+        if (auto_format)
+            sim_tape_set_fmt (uptr, 0, "SIMH", NULL);
+        return sim_messagef (r, "Invalid TPZ tape container: %s\n", cptr);
+        }
+    }
 switch (MT_GET_FMT (uptr)) {                            /* case on format */
 
     case MTUF_F_STD:                                    /* SIMH */
@@ -523,6 +1424,22 @@ uptr->tape_ctx = ctx = (struct tape_context *)calloc(1, sizeof(struct tape_conte
 ctx->dptr = dptr;                                       /* save DEVICE pointer */
 ctx->dbit = dbit;                                       /* save debug bit */
 ctx->auto_format = auto_format;                         /* save that we auto selected format */
+ctx->tpz = tpz;                                         /* TPZ container */
+ctx->iostats = sim_iostat_open (dptr, uptr, "tape");    /* register I/O statistics */
+ctx->idx_cache = (sim_switches & SWMASK ('I')) != 0;    /* cache the record index? */
+#if defined (SIM_ASYNCH_IO)
+ctx->ra_expect = (t_addr) -1;                           /* no forward read yet */
+#endif
+if (tpz) {                                              /* record index in the container? */
+    if (_tape_tpz_idx_load (uptr)) {
+        ctx->idx_built = TRUE;
+        sim_debug (MTSE_DBG_STR, dptr, "index: %u objects loaded from container\n", ctx->idx_count);
+        }
+    }
+else if (ctx->idx_cache && _tape_idx_load (uptr)) {     /* record index cached? */
+    ctx->idx_built = TRUE;
+    sim_debug (MTSE_DBG_STR, dptr, "index: %u objects loaded from cache\n", ctx->idx_count);
+    }
 
 sim_tape_rewind (uptr);
 
@@ -542,6 +1459,7 @@ struct tape_context *ctx;
 uint32 f;
 t_stat r;
 t_bool auto_format = FALSE;
+char *tpz_name = NULL;
 
 if (uptr == NULL)
     return SCPE_IERR;
@@ -556,10 +1474,29 @@ if (ctx)
     auto_format = ctx->auto_format;
 
 sim_tape_clr_async (uptr);
+_tape_ra_stop (uptr);                                   /* stop reading ahead */
+
+if (ctx->tpz && !(uptr->flags & UNIT_RO)) {             /* TPZ container to update? */
+    t_bool changed = ctx->tpz->changed;
+
+    r = _tape_tpz_save (uptr);
+    if (r != SCPE_OK)
+        return sim_messagef (r, "Can't update TPZ tape container: %s\n", uptr->filename);
+    if (changed) {                                      /* image written? */
+        tpz_name = (char *)malloc (strlen (uptr->filename) + 1);
+        if (tpz_name)                                   /*   may leave unused data */
+            strcpy (tpz_name, uptr->filename);
+        }
+    }
+if (!ctx->tpz && ctx->idx_cache &&                      /* save the record index */
+    ctx->idx_built && ctx->idx_dirty)
+    _tape_idx_save (uptr);
 
 r = detach_unit (uptr);                                 /* detach unit */
-if (r != SCPE_OK)
+if (r != SCPE_OK) {
+    free (tpz_name);
     return r;
+    }
 switch (f) {                                            /* case on format */
 
     case MTUF_F_TPC:                                    /* TPC */
@@ -573,7 +1510,15 @@ switch (f) {                                            /* case on format */
         break;
         }
 
+if (ctx->tpz) {                                         /* TPZ? */
+    _tape_tpz_free (ctx->tpz);
+    if (tpz_name)                                       /* drop data no longer used */
+        _tape_tpz_compact (tpz_name);
+    free (tpz_name);
+    }
 sim_tape_rewind (uptr);
+sim_iostat_close (ctx->iostats);
+free (ctx->idx);
 free (uptr->tape_ctx);
 uptr->tape_ctx = NULL;
 uptr->io_flush = NULL;
@@ -603,7 +1548,9 @@ fprintf (st, "    -R          Attach Read Only.\n");
 fprintf (st, "    -E          Must Exist (if not specified an attempt to create the indicated\n");
 fprintf (st, "                virtual tape will be attempted).\n");
 fprintf (st, "    -F          Open the indicated tape container in a specific format (default\n");
-fprintf (st, "                is SIMH, alternatives are E11, TPC and P7B)\n");
+fprintf (st, "                is SIMH, alternatives are E11, TPC, P7B and TPZ)\n");
+fprintf (st, "    -I          Keep the record index in tapefile.idx so that it need not be\n");
+fprintf (st, "                rebuilt by scanning the tape after the next attach\n");
 return SCPE_OK;
 }
 
@@ -617,6 +1564,635 @@ if (sim_deb && (ctx->dptr->dctrl & reason))
     sim_data_trace(ctx->dptr, uptr, (detail ? data : NULL), "", len, txt, reason);
 }
 
+/* Record index
+
+   The index holds the file position, following position and length marker
+   of each record and tape mark whose layout has been verified, either by
+   a scan of the tape, by an ordinary read or space, or by a write.  The
+   scan is made in stages: each space or reverse operation indexes at most
+   TAPE_IDX_STEP more objects, continuing where the previous stage
+   stopped, so no single operation pays for reading the whole image and a
+   tape that is only read or written forward is never scanned.  Entries are
+   kept in position order and never overlap.  Each entry is only a
+   statement about the bytes at its position, so the index need not be
+   complete: any position it does not describe (an erase gap, the end of
+   medium, data past a runaway) is handled by reading the container as
+   before.  Writes and erases discard the entries they
+   overlap, and record and tape mark writes add their own entries.
+
+   With the index in place, spacing forward or reverse over a described
+   object needs no host I/O at all, and a subsequent data read seeks
+   directly to the data.  If the tape is attached with -I, the index is
+   saved next to the image (tapefile.idx) on detach and reloaded on the
+   next attach when the image size, modification time and a checksum of
+   its first and last TAPE_IDX_CHECK bytes still match.
+*/
+
+#define TAPE_IDX_MAGIC  "SIMTIDX2"                      /* cache file signature */
+#define TAPE_IDX_CHECK  65536                           /* bytes checksummed at each end */
+#define TAPE_IDX_STEP   4096                            /* objects indexed per scan stage */
+
+static uint32 _tape_idx_hdr (UNIT *uptr)
+{
+switch (MT_GET_LAYOUT (uptr)) {
+    case MTUF_F_STD:
+    case MTUF_F_E11:
+        return sizeof (t_mtrlnt);
+    case MTUF_F_TPC:
+        return sizeof (t_tpclnt);
+    default:
+        return 0;
+    }
+}
+
+/* Size of an object on the tape image given its returned length marker */
+
+static t_addr _tape_idx_extent (UNIT *uptr, t_mtrlnt bc, t_bool tmk)
+{
+switch (MT_GET_LAYOUT (uptr)) {
+    case MTUF_F_STD:
+        return tmk ? sizeof (t_mtrlnt) : (2 * sizeof (t_mtrlnt) + ((MTR_L (bc) + 1) & ~1));
+    case MTUF_F_E11:
+        return tmk ? sizeof (t_mtrlnt) : (2 * sizeof (t_mtrlnt) + MTR_L (bc));
+    case MTUF_F_TPC:
+        return tmk ? sizeof (t_tpclnt) : (sizeof (t_tpclnt) + ((bc + 1) & ~1));
+    default:
+        return bc;
+    }
+}
+
+/* Locate the entry starting at (or with next == when by_next) pos */
+
+static int32 _tape_idx_find (struct tape_context *ctx, t_addr pos, t_bool by_next)
+{
+int32 lo, hi, mid;
+uint32 h = ctx->idx_hint;
+t_addr key;
+
+if (ctx->idx_count == 0)
+    return -1;
+if (h < ctx->idx_count) {                               /* sequential access first */
+    if ((by_next ? ctx->idx[h].next : ctx->idx[h].pos) == pos)
+        return (int32)h;
+    if ((h + 1 < ctx->idx_count) && ((by_next ? ctx->idx[h + 1].next : ctx->idx[h + 1].pos) == pos))
+        return (int32)(ctx->idx_hint = h + 1);
+    if ((h > 0) && ((by_next ? ctx->idx[h - 1].next : ctx->idx[h - 1].pos) == pos))
+        return (int32)(ctx->idx_hint = h - 1);
+    }
+lo = 0;
+hi = (int32)ctx->idx_count - 1;
+while (lo <= hi) {
+    mid = (lo + hi) / 2;
+    key = by_next ? ctx->idx[mid].next : ctx->idx[mid].pos;
+    if (key == pos)
+        return (int32)(ctx->idx_hint = (uint32)mid);
+    if (key < pos)
+        lo = mid + 1;
+    else
+        hi = mid - 1;
+    }
+return -1;
+}
+
+/* Locate the first entry ending after pos; idx_count if there is none */
+
+static uint32 _tape_idx_after (struct tape_context *ctx, t_addr pos)
+{
+uint32 lo = 0, hi = ctx->idx_count, mid;
+
+while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (ctx->idx[mid].next <= pos)
+        lo = mid + 1;
+    else
+        hi = mid;
+    }
+return lo;
+}
+
+/* Discard entries overlapping [from, to) */
+
+static void _tape_idx_remove (UNIT *uptr, t_addr from, t_addr to)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 first, last;
+
+if ((ctx == NULL) || (ctx->idx_count == 0))
+    return;
+first = _tape_idx_after (ctx, from);
+for (last = first; (last < ctx->idx_count) && (ctx->idx[last].pos < to); last++) ;
+if (last == first)
+    return;
+if (from < ctx->idx_scan)                               /* rescan what follows */
+    ctx->idx_scan = from;
+memmove (&ctx->idx[first], &ctx->idx[last], (ctx->idx_count - last) * sizeof (*ctx->idx));
+ctx->idx_count -= (last - first);
+ctx->idx_hint = first;
+ctx->idx_dirty = TRUE;
+}
+
+static void _tape_idx_insert (UNIT *uptr, t_addr pos, t_mtrlnt bc, t_bool tmk)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+t_addr next = pos + _tape_idx_extent (uptr, bc, tmk);
+TAPE_INDEX *e;
+uint32 i;
+
+if (ctx == NULL)
+    return;
+if ((ctx->idx_count > 0) &&                             /* common case: appending */
+    (ctx->idx[ctx->idx_count - 1].next <= pos))
+    i = ctx->idx_count;
+else {
+    int32 f = _tape_idx_find (ctx, pos, FALSE);
+
+    if ((f >= 0) && (ctx->idx[f].next == next) &&       /* already known? */
+        (ctx->idx[f].bc == bc) && (ctx->idx[f].tmk == (uint32)tmk))
+        return;
+    _tape_idx_remove (uptr, pos, next);
+    i = _tape_idx_after (ctx, pos);                     /* nothing left overlaps */
+    }
+if (ctx->idx_count == ctx->idx_size) {
+    uint32 size = ctx->idx_size ? 2 * ctx->idx_size : 1024;
+    TAPE_INDEX *idx = (TAPE_INDEX *)realloc (ctx->idx, size * sizeof (*idx));
+
+    if (idx == NULL)                                    /* no memory? the index is only a cache */
+        return;
+    ctx->idx = idx;
+    ctx->idx_size = size;
+    }
+memmove (&ctx->idx[i + 1], &ctx->idx[i], (ctx->idx_count - i) * sizeof (*ctx->idx));
+e = &ctx->idx[i];
+e->pos = pos;
+e->next = next;
+e->bc = bc;
+e->tmk = tmk;
+++ctx->idx_count;
+ctx->idx_hint = i;
+ctx->idx_dirty = TRUE;
+}
+
+/* Record length lookup for sim_tape_rdlntf and sim_tape_rdlntr.  Returns
+   TRUE with the status, length and updated position if the index
+   describes the object adjacent to the current position.  The seek to
+   the record data is deferred until a read actually needs it. */
+
+static t_bool _tape_idx_lookup (UNIT *uptr, t_bool reverse, t_mtrlnt *bc, t_stat *status)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+TAPE_INDEX *e;
+int32 i;
+
+if ((ctx == NULL) || (ctx->idx_count == 0))
+    return FALSE;
+i = _tape_idx_find (ctx, uptr->pos, reverse);
+if (i < 0)
+    return FALSE;
+e = &ctx->idx[i];
+*bc = e->bc;
+*status = e->tmk ? MTSE_TMK : MTSE_OK;
+uptr->pos = reverse ? e->pos : e->next;
+ctx->idx_data = e->pos + _tape_idx_hdr (uptr);
+ctx->idx_seek = TRUE;
+return TRUE;
+}
+
+/* Position the container at the data of the record just located */
+
+static t_stat _tape_idx_seek_data (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if ((ctx == NULL) || !ctx->idx_seek)
+    return MTSE_OK;
+ctx->idx_seek = FALSE;
+if (_tape_fseek (uptr, ctx->idx_data, SEEK_SET))
+    return sim_tape_ioerr (uptr);
+return MTSE_OK;
+}
+
+/* Forget a deferred data seek; called when the container is accessed directly */
+
+static void _tape_idx_seek_cancel (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if (ctx != NULL)
+    ctx->idx_seek = FALSE;
+}
+
+static char *_tape_idx_name (UNIT *uptr)
+{
+char *name = (char *)malloc (strlen (uptr->filename) + 5);
+
+if (name)
+    sprintf (name, "%s.idx", uptr->filename);
+return name;
+}
+
+/* Image size, modification time and a checksum (FNV-1a) of the data at
+   each end of the image, which catches a rewrite made within the
+   modification time's resolution */
+
+static void _tape_idx_stamp (UNIT *uptr, t_uint64 *stamp)
+{
+struct stat statb;
+t_offset size, pos[2];
+t_uint64 hash = 0xCBF29CE484222325ull;
+uint8 *buf = (uint8 *)malloc (TAPE_IDX_CHECK);
+size_t i, n;
+int end;
+
+fflush (uptr->fileref);
+size = sim_fsize_ex (uptr->fileref);
+stamp[0] = (t_uint64)size;
+stamp[1] = (stat (uptr->filename, &statb) == 0) ? (t_uint64)statb.st_mtime : 0;
+pos[0] = 0;
+pos[1] = (size > 2 * TAPE_IDX_CHECK) ? size - TAPE_IDX_CHECK : TAPE_IDX_CHECK;
+for (end = 0; (end < 2) && buf && (pos[end] < size); end++) {
+    n = 0;
+    if (sim_fseeko (uptr->fileref, pos[end], SEEK_SET) == 0)
+        n = fread (buf, 1, TAPE_IDX_CHECK, uptr->fileref);
+    for (i = 0; i < n; i++)
+        hash = (hash ^ buf[i]) * 0x100000001B3ull;
+    }
+free (buf);
+stamp[2] = buf ? hash : 0;
+}
+
+/* Load a cached index; returns TRUE if one matching the image was found */
+
+static t_bool _tape_idx_load (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+char *name = _tape_idx_name (uptr);
+FILE *f = name ? sim_fopen (name, "rb") : NULL;
+char magic[8];
+t_uint64 hdr[5], stamp[3], ent[3];
+uint32 i;
+t_bool ok = FALSE;
+
+free (name);
+if (f == NULL)
+    return FALSE;
+_tape_idx_stamp (uptr, stamp);
+if ((fread (magic, sizeof (magic), 1, f) == 1) &&
+    (memcmp (magic, TAPE_IDX_MAGIC, sizeof (magic)) == 0) &&
+    (fread (hdr, sizeof (hdr), 1, f) == 1) &&
+    (hdr[0] == MT_GET_FMT (uptr)) && (hdr[1] == stamp[0]) && (hdr[2] == stamp[1]) &&
+    (hdr[3] == stamp[2]) && (hdr[4] < 0xFFFFFFFF)) {
+    ctx->idx = (TAPE_INDEX *)calloc ((size_t)(hdr[4] ? hdr[4] : 1), sizeof (*ctx->idx));
+    if (ctx->idx) {
+        ctx->idx_size = (uint32)(hdr[4] ? hdr[4] : 1);
+        for (i = 0; (i < hdr[4]) && (fread (ent, sizeof (ent), 1, f) == 1); i++) {
+            ctx->idx[i].pos = (t_addr)ent[0];
+            ctx->idx[i].next = (t_addr)ent[1];
+            ctx->idx[i].bc = (t_mtrlnt)(ent[2] & 0xFFFFFFFF);
+            ctx->idx[i].tmk = (uint32)(ent[2] >> 32);
+            }
+        ctx->idx_count = i;
+        ok = (i == hdr[4]);
+        if (!ok)
+            ctx->idx_count = 0;
+        }
+    }
+fclose (f);
+return ok;
+}
+
+static void _tape_idx_save (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+char *name = _tape_idx_name (uptr);
+FILE *f = name ? sim_fopen (name, "wb") : NULL;
+t_uint64 hdr[5], stamp[3], ent[3];
+uint32 i;
+
+if (f == NULL) {
+    free (name);
+    return;
+    }
+_tape_idx_stamp (uptr, stamp);
+hdr[0] = MT_GET_FMT (uptr);
+hdr[1] = stamp[0];
+hdr[2] = stamp[1];
+hdr[3] = stamp[2];
+hdr[4] = ctx->idx_count;
+fwrite (TAPE_IDX_MAGIC, 8, 1, f);
+fwrite (hdr, sizeof (hdr), 1, f);
+for (i = 0; i < ctx->idx_count; i++) {
+    ent[0] = ctx->idx[i].pos;
+    ent[1] = ctx->idx[i].next;
+    ent[2] = ((t_uint64)ctx->idx[i].tmk << 32) | ctx->idx[i].bc;
+    fwrite (ent, sizeof (ent), 1, f);
+    }
+if (ferror (f)) {                                       /* incomplete? don't leave a bad cache */
+    fclose (f);
+    remove (name);
+    }
+else {
+    fclose (f);
+    ctx->idx_dirty = FALSE;
+    }
+free (name);
+}
+
+/* Index the next stage of the tape, unless the whole tape has been done
+   (or the index was loaded from the cache) already; called by the space
+   and reverse operations, which are the ones that benefit from a complete
+   index */
+
+static void _tape_idx_need (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+t_addr opos = uptr->pos;
+uint32 opnu = MT_TST_PNU (uptr);
+uint32 n;
+t_mtrlnt bc;
+t_stat st = MTSE_OK;
+
+if ((ctx == NULL) || ctx->idx_built)
+    return;
+uptr->pos = ctx->idx_scan;
+for (n = 0; (n < TAPE_IDX_STEP) &&                      /* each object read is */
+            ((st == MTSE_OK) || (st == MTSE_TMK)); n++) /*   entered by the scan */
+    st = sim_tape_rdlntf (uptr, &bc);
+if ((st == MTSE_OK) || (st == MTSE_TMK))                /* more to do? */
+    ctx->idx_scan = uptr->pos;
+else
+    ctx->idx_built = TRUE;                              /* stopped at the end */
+uptr->pos = opos;
+if (opnu)
+    MT_SET_PNU (uptr);
+else
+    MT_CLR_PNU (uptr);
+ctx->idx_seek = FALSE;
+ctx->idx_dirty = TRUE;
+sim_debug (MTSE_DBG_STR, ctx->dptr, "index: %u objects found by scan%s\n", ctx->idx_count, ctx->idx_built ? ", complete" : "");
+}
+
+/* Read-ahead
+
+   When a unit reads records forward sequentially, a worker thread reads
+   the records that follow into a ring of buffers while the simulated
+   system processes the current one.  The worker uses its own read-only
+   stream on the container, so it never disturbs the unit's position, and
+   it stops at anything other than a data record or tape mark (gaps, EOM,
+   runaway conditions, I/O errors, a record whose trailing length doesn't
+   match its leading length), leaving those to the ordinary read path.
+   Only SIMH and E11 format containers are read ahead.
+
+   A read that finds the record at the current position in the ring is
+   satisfied from it.  Any write or erase, a rewind, or a read from a
+   position not in the ring discards the ring; read-ahead resumes once
+   sequential reading is seen again.  Each discard advances a generation
+   count so that a record the worker was reading at the time is dropped
+   rather than published.
+*/
+
+#if defined (SIM_ASYNCH_IO)
+
+static void *_tape_ra_thread (void *arg)
+{
+UNIT *uptr = (UNIT *)arg;
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint8 *buf = NULL;
+uint32 bufsize = 0;
+uint32 last_gen = 0;
+
+pthread_mutex_lock (&ctx->ra_lock);
+while (!ctx->ra_exit) {
+    t_addr pos, next;
+    t_mtrlnt bc, sbc = 0, tbc;
+    uint32 gen, tmk = FALSE;
+    t_bool ok = FALSE;
+    TAPE_RA *slot;
+
+    if (!ctx->ra_active ||                              /* idle or ring full? */
+        (ctx->ra_count == TAPE_RA_RECS) ||
+        (ctx->ra_bytes >= TAPE_RA_BYTES)) {
+        pthread_cond_wait (&ctx->ra_cond, &ctx->ra_lock);
+        continue;
+        }
+    gen = ctx->ra_gen;
+    pos = ctx->ra_next;
+    pthread_mutex_unlock (&ctx->ra_lock);
+
+    if (gen != last_gen) {                              /* restarted? */
+        fflush (ctx->ra_file);                          /*   drop stale buffered input */
+        last_gen = gen;
+        }
+
+    if ((sim_fseek (ctx->ra_file, pos, SEEK_SET) == 0) &&
+        (sim_fread (&bc, sizeof (t_mtrlnt), 1, ctx->ra_file) == 1)) {
+        if (bc == MTR_TMK) {                            /* tape mark? */
+            tmk = ok = TRUE;
+            next = pos + sizeof (t_mtrlnt);
+            }
+        else if ((bc != MTR_EOM) && (bc != MTR_GAP) && (bc != MTR_FHGAP) &&
+                 (MTR_L (bc) <= MTR_MAXLEN)) {          /* data record? */
+            sbc = MTR_L (bc);
+            if (sbc > bufsize) {
+                uint8 *nbuf = (uint8 *)realloc (buf, sbc);
+
+                if (nbuf) {
+                    buf = nbuf;
+                    bufsize = sbc;
+                    }
+                }
+            next = pos + _tape_idx_extent (uptr, bc, FALSE);
+            ok = (sbc <= bufsize) &&                    /* read data and trailing length */
+                 (sim_fread (buf, 1, sbc, ctx->ra_file) == sbc) &&
+                 (sim_fseek (ctx->ra_file, next - sizeof (t_mtrlnt), SEEK_SET) == 0) &&
+                 (sim_fread (&tbc, sizeof (t_mtrlnt), 1, ctx->ra_file) == 1) &&
+                 (tbc == bc);                           /* lengths agree? */
+            }
+        }
+
+    pthread_mutex_lock (&ctx->ra_lock);
+    if (gen != ctx->ra_gen)                             /* discarded meanwhile? */
+        continue;
+    if (!ok) {                                          /* not a simple object? */
+        ctx->ra_active = FALSE;                         /*   leave it to the ordinary path */
+        pthread_cond_broadcast (&ctx->ra_cond);
+        continue;
+        }
+    slot = &ctx->ra[(ctx->ra_head + ctx->ra_count) % TAPE_RA_RECS];
+    if (sbc > slot->size) {
+        uint8 *nbuf = (uint8 *)realloc (slot->buf, sbc);
+
+        if (nbuf == NULL) {
+            ctx->ra_active = FALSE;
+            pthread_cond_broadcast (&ctx->ra_cond);
+            continue;
+            }
+        slot->buf = nbuf;
+        slot->size = sbc;
+        }
+    memcpy (slot->buf, buf, sbc);
+    slot->pos = pos;
+    slot->next = next;
+    slot->bc = bc;
+    slot->tmk = tmk;
+    ++ctx->ra_count;
+    ctx->ra_bytes += sbc;
+    ctx->ra_next = next;
+    pthread_cond_broadcast (&ctx->ra_cond);
+    }
+pthread_mutex_unlock (&ctx->ra_lock);
+free (buf);
+return NULL;
+}
+
+/* Discard the ring (caller holds ra_lock) */
+
+static void _tape_ra_discard (struct tape_context *ctx)
+{
+ctx->ra_head = ctx->ra_count = ctx->ra_bytes = 0;
+ctx->ra_active = FALSE;
+++ctx->ra_gen;
+}
+
+static void _tape_ra_flush (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if ((ctx == NULL) || !ctx->ra_started)
+    return;
+pthread_mutex_lock (&ctx->ra_lock);
+_tape_ra_discard (ctx);
+ctx->ra_expect = (t_addr) -1;
+pthread_mutex_unlock (&ctx->ra_lock);
+}
+
+/* Satisfy a forward read from the ring.  Returns FALSE if the record at
+   the current position isn't there, or won't fit, so the caller reads it
+   from the container. */
+
+static t_bool _tape_ra_get (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max, t_stat *status)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+TAPE_RA *slot;
+uint32 i;
+
+if ((ctx == NULL) || !ctx->ra_started)
+    return FALSE;
+pthread_mutex_lock (&ctx->ra_lock);
+while ((ctx->ra_count == 0) && ctx->ra_active &&       /* wanted record being */
+       (ctx->ra_next == uptr->pos))                     /*   read right now? */
+    pthread_cond_wait (&ctx->ra_cond, &ctx->ra_lock);
+for (i = 0; i < ctx->ra_count; i++)                     /* find the current position */
+    if (ctx->ra[(ctx->ra_head + i) % TAPE_RA_RECS].pos == uptr->pos)
+        break;
+if (i == ctx->ra_count) {                               /* not read ahead? */
+    if (ctx->ra_count || ctx->ra_active)                /* the reader has moved elsewhere */
+        _tape_ra_discard (ctx);
+    pthread_mutex_unlock (&ctx->ra_lock);
+    return FALSE;
+    }
+while (i--) {                                           /* drop records spaced over */
+    ctx->ra_bytes -= MTR_L (ctx->ra[ctx->ra_head].bc);
+    ctx->ra_head = (ctx->ra_head + 1) % TAPE_RA_RECS;
+    --ctx->ra_count;
+    }
+slot = &ctx->ra[ctx->ra_head];
+if (!slot->tmk && (MTR_L (slot->bc) > max)) {           /* record too long? */
+    pthread_mutex_unlock (&ctx->ra_lock);
+    return FALSE;
+    }
+MT_CLR_PNU (uptr);
+ctx->idx_seek = FALSE;
+if (slot->tmk)
+    *status = MTSE_TMK;
+else {
+    *bc = MTR_L (slot->bc);
+    memcpy (buf, slot->buf, *bc);
+    ctx->ra_bytes -= *bc;
+    *status = MTR_F (slot->bc) ? MTSE_RECE : MTSE_OK;
+    sim_tape_data_trace(uptr, buf, *bc, "Record Read", ctx->dptr->dctrl & MTSE_DBG_DAT, MTSE_DBG_STR);
+    }
+_tape_idx_insert (uptr, slot->pos, slot->bc, slot->tmk);
+uptr->pos = ctx->ra_expect = slot->next;
+ctx->ra_head = (ctx->ra_head + 1) % TAPE_RA_RECS;
+--ctx->ra_count;
+pthread_cond_broadcast (&ctx->ra_cond);                 /* room for another */
+pthread_mutex_unlock (&ctx->ra_lock);
+return TRUE;
+}
+
+/* Note the outcome of a forward read made from the container.  The
+   second of two adjacent reads starts the read-ahead from the new
+   position. */
+
+static void _tape_ra_note (UNIT *uptr, t_addr opos, t_stat st)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 f = MT_GET_FMT (uptr);
+
+if ((ctx == NULL) || ((f != MTUF_F_STD) && (f != MTUF_F_E11)))
+    return;
+if ((st != MTSE_OK) && (st != MTSE_TMK) && (st != MTSE_RECE)) {
+    _tape_ra_flush (uptr);
+    return;
+    }
+if (!ctx->ra_started) {
+    if (opos != ctx->ra_expect) {                       /* not yet sequential */
+        ctx->ra_expect = uptr->pos;
+        return;
+        }
+    ctx->ra_file = sim_fopen (uptr->filename, "rb");    /* private stream for the worker */
+    if (ctx->ra_file == NULL) {
+        ctx->ra_expect = (t_addr) -1;
+        return;
+        }
+    pthread_mutex_init (&ctx->ra_lock, NULL);
+    pthread_cond_init (&ctx->ra_cond, NULL);
+    if (pthread_create (&ctx->ra_thread, NULL, _tape_ra_thread, (void *)uptr)) {
+        pthread_mutex_destroy (&ctx->ra_lock);
+        pthread_cond_destroy (&ctx->ra_cond);
+        fclose (ctx->ra_file);
+        ctx->ra_file = NULL;
+        ctx->ra_expect = (t_addr) -1;
+        return;
+        }
+    ctx->ra_started = TRUE;
+    sim_debug (MTSE_DBG_STR, ctx->dptr, "read-ahead: started at pos: %" T_ADDR_FMT "u\n", uptr->pos);
+    }
+pthread_mutex_lock (&ctx->ra_lock);
+if (!ctx->ra_active && (opos == ctx->ra_expect)) {      /* sequential again? */
+    fflush (uptr->fileref);                             /* make prior writes visible */
+    _tape_ra_discard (ctx);
+    ctx->ra_next = uptr->pos;
+    ctx->ra_active = TRUE;
+    pthread_cond_broadcast (&ctx->ra_cond);
+    }
+ctx->ra_expect = uptr->pos;
+pthread_mutex_unlock (&ctx->ra_lock);
+}
+
+static void _tape_ra_stop (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 i;
+
+if ((ctx == NULL) || !ctx->ra_started)
+    return;
+pthread_mutex_lock (&ctx->ra_lock);
+ctx->ra_exit = TRUE;
+pthread_cond_signal (&ctx->ra_cond);
+pthread_mutex_unlock (&ctx->ra_lock);
+pthread_join (ctx->ra_thread, NULL);
+pthread_mutex_destroy (&ctx->ra_lock);
+pthread_cond_destroy (&ctx->ra_cond);
+fclose (ctx->ra_file);
+ctx->ra_file = NULL;
+for (i = 0; i < TAPE_RA_RECS; i++)
+    free (ctx->ra[i].buf);
+ctx->ra_started = FALSE;
+}
+
+#endif
+
 /* Read record length forward (internal routine).
 
    Inputs:
@@ -711,7 +2287,7 @@ static t_stat sim_tape_rdlntf (UNIT *uptr, t_mtrlnt *bc)
 {
 uint8    c;
 t_bool   all_eof;
-uint32   f = MT_GET_FMT (uptr);
+uint32   f = MT_GET_LAYOUT (uptr);
 t_mtrlnt sbc;
 t_tpclnt tpcbc;
 t_mtrlnt buffer [256];                                  /* local tape buffer */
@@ -724,7 +2300,12 @@ MT_CLR_PNU (uptr);                                      /* clear the position-no
 if ((uptr->flags & UNIT_ATT) == 0)                      /* if the unit is not attached */
     return MTSE_UNATT;                                  /*   then quit with an error */
 
-if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) {   /* set the initial tape position; if it fails */
+if (_tape_idx_lookup (uptr, FALSE, bc, &status))        /* if the next object is indexed */
+    return status;                                      /*   then no container access is needed */
+
+_tape_idx_seek_cancel (uptr);                           /* the data follows the header read here */
+
+if (_tape_fseek (uptr, uptr->pos, SEEK_SET)) {          /* set the initial tape position; if it fails */
     MT_SET_PNU (uptr);                                  /*   then set position not updated */
     status = sim_tape_ioerr (uptr);                     /*     and quit with I/O error status */
     }
@@ -748,7 +2329,7 @@ else switch (f) {                                       /* otherwise the read me
 
         do {                                            /* loop until a record, gap, or error is seen */
             if (bufcntr == bufcap) {                    /* if the buffer is empty then refill it */
-                if (feof (uptr->fileref)) {             /* if we hit the EOF while reading a gap */
+                if (_tape_feof (uptr)) {                /* if we hit the EOF while reading a gap */
                     if (sizeof_gap > 0)                 /*   then if detection is enabled */
                         status = MTSE_RUNAWAY;          /*     then report a tape runaway */
                     else                                /*   otherwise report the physical EOF */
@@ -763,12 +2344,11 @@ else switch (f) {                                       /* otherwise the read me
                     bufcap = sizeof (buffer)            /*   to the full size of the buffer */
                                / sizeof (buffer [0]);
 
-                bufcap = sim_fread (buffer,             /* fill the buffer */
+                bufcap = _tape_fread (buffer,           /* fill the buffer */
                                     sizeof (t_mtrlnt),  /*   with tape metadata */
-                                    bufcap,
-                                    uptr->fileref);
+                                    bufcap, uptr);
 
-                if (ferror (uptr->fileref)) {           /* if a file I/O error occurred */
+                if (_tape_ferror (uptr)) {              /* if a file I/O error occurred */
                     if (bufcntr == 0)                   /*   then if this is the initial read */
                         MT_SET_PNU (uptr);              /*     then set position not updated */
 
@@ -819,7 +2399,7 @@ else switch (f) {                                       /* otherwise the read me
             else if (*bc == MTR_FHGAP) {                        /* otherwise if the value if a half gap */
                 uptr->pos = uptr->pos - sizeof (t_mtrlnt) / 2;  /*   then back up and resync */
 
-                if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) {   /* set the tape position; if it fails */
+                if (_tape_fseek (uptr, uptr->pos, SEEK_SET)) {          /* set the tape position; if it fails */
                     status = sim_tape_ioerr (uptr);                     /*   then quit with I/O error status */
                     break;
                     }
@@ -832,7 +2412,7 @@ else switch (f) {                                       /* otherwise the read me
 
             else {                                                      /* otherwise it's a record marker */
                 if (bufcntr < bufcap                                    /* if the position is within the buffer */
-                  && sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) {  /*   then seek to the data area; if it fails */
+                  && _tape_fseek (uptr, uptr->pos, SEEK_SET)) {         /*   then seek to the data area; if it fails */
                     status = sim_tape_ioerr (uptr);                     /*     then quit with I/O error status */
                     break;
                     }
@@ -850,14 +2430,14 @@ else switch (f) {                                       /* otherwise the read me
         break;                                          /* otherwise the operation succeeded */
 
     case MTUF_F_TPC:
-        sim_fread (&tpcbc, sizeof (t_tpclnt), 1, uptr->fileref);
+        _tape_fread (&tpcbc, sizeof (t_tpclnt), 1, uptr);
         *bc = tpcbc;                                    /* save rec lnt */
 
-        if (ferror (uptr->fileref)) {                   /* error? */
+        if (_tape_ferror (uptr)) {                      /* error? */
             MT_SET_PNU (uptr);                          /* pos not upd */
             status = sim_tape_ioerr (uptr);
             }
-        else if (feof (uptr->fileref)) {                /* eof? */
+        else if (_tape_feof (uptr)) {                   /* eof? */
             MT_SET_PNU (uptr);                          /* pos not upd */
             status = MTSE_EOM;
             }
@@ -872,14 +2452,14 @@ else switch (f) {                                       /* otherwise the read me
 
     case MTUF_F_P7B:
         for (sbc = 0, all_eof = 1; ; sbc++) {           /* loop thru record */
-            sim_fread (&c, sizeof (uint8), 1, uptr->fileref);
+            _tape_fread (&c, sizeof (uint8), 1, uptr);
 
-            if (ferror (uptr->fileref)) {               /* error? */
+            if (_tape_ferror (uptr)) {                  /* error? */
                 MT_SET_PNU (uptr);                      /* pos not upd */
                 status = sim_tape_ioerr (uptr);
                 break;
                 }
-            else if (feof (uptr->fileref)) {            /* eof? */
+            else if (_tape_feof (uptr)) {               /* eof? */
                 if (sbc == 0)                           /* no data? eom */
                     status = MTSE_EOM;
                 break;                                  /* treat like eor */
@@ -892,7 +2472,7 @@ else switch (f) {                                       /* otherwise the read me
 
         if (status == MTSE_OK) {
             *bc = sbc;                                      /* save rec lnt */
-            sim_fseek (uptr->fileref, uptr->pos, SEEK_SET); /* for read */
+            _tape_fseek (uptr, uptr->pos, SEEK_SET);        /* for read */
             uptr->pos = uptr->pos + sbc;                    /* spc over record */
             if (all_eof)                                    /* tape mark? */
                 status = MTSE_TMK;
@@ -903,6 +2483,9 @@ else switch (f) {                                       /* otherwise the read me
         status = MTSE_FMT;
     }
 
+if ((status == MTSE_OK) || (status == MTSE_TMK))        /* if an object was found then index it */
+    _tape_idx_insert (uptr, uptr->pos - _tape_idx_extent (uptr, *bc, status == MTSE_TMK), *bc, status == MTSE_TMK);
+
 return status;
 }
 
@@ -963,7 +2546,7 @@ static t_stat sim_tape_rdlntr (UNIT *uptr, t_mtrlnt *bc)
 {
 uint8    c;
 t_bool   all_eof;
-uint32   f = MT_GET_FMT (uptr);
+uint32   f = MT_GET_LAYOUT (uptr);
 t_addr   ppos;
 t_mtrlnt sbc;
 t_tpclnt tpcbc;
@@ -977,9 +2560,14 @@ MT_CLR_PNU (uptr);                                      /* clear the position-no
 if ((uptr->flags & UNIT_ATT) == 0)                      /* if the unit is not attached */
     return MTSE_UNATT;                                  /*   then quit with an error */
 
+_tape_idx_seek_cancel (uptr);                           /* any earlier indexed lookup is superseded */
+
 if (sim_tape_bot (uptr))                                /* if the unit is positioned at the BOT */
     status = MTSE_BOT;                                  /*   then reading backward is not possible */
 
+else if (_tape_idx_lookup (uptr, TRUE, bc, &status))    /* otherwise if the preceding object is indexed */
+    return status;                                      /*   then no container access is needed */
+
 else switch (f) {                                       /* otherwise the read method depends on the tape format */
 
     case MTUF_F_STD:
@@ -1015,17 +2603,17 @@ else switch (f) {                                       /* otherwise the read me
                     bufcap = sizeof (buffer)            /*   to the full size of the buffer */
                                / sizeof (buffer [0]);
 
-                if (sim_fseek (uptr->fileref,                           /* seek back to the location */
+                if (_tape_fseek (uptr,                                  /* seek back to the location */
                                uptr->pos - bufcap * sizeof (t_mtrlnt),  /*   corresponding to the start */
                                SEEK_SET)) {                             /*     of the buffer; if it fails */
                     status = sim_tape_ioerr (uptr);                     /*         and fail with I/O error status */
                     break;
                     }
 
-                bufcntr = sim_fread (buffer, sizeof (t_mtrlnt), /* fill the buffer */
-                                     bufcap, uptr->fileref);    /*   with tape metadata */
+                bufcntr = _tape_fread (buffer, sizeof (t_mtrlnt), /* fill the buffer */
+                                     bufcap, uptr);     /*   with tape metadata */
 
-                if (ferror (uptr->fileref)) {           /* if a file I/O error occurred */
+                if (_tape_ferror (uptr)) {              /* if a file I/O error occurred */
                     status = sim_tape_ioerr (uptr);     /*   then report the error and quit */
                     break;
                     }
@@ -1057,7 +2645,7 @@ else switch (f) {                                       /* otherwise the read me
                 uptr->pos = uptr->pos - sizeof (t_mtrlnt)       /* position to the start */
                   - (f == MTUF_F_STD ? (sbc + 1) & ~1 : sbc);   /*   of the record */
 
-                if (sim_fseek (uptr->fileref,                   /* seek to the start of the data area; if it fails */
+                if (_tape_fseek (uptr,                          /* seek to the start of the data area; if it fails */
                                uptr->pos + sizeof (t_mtrlnt),   /*   then return with I/O error status */
                                SEEK_SET)) {
                     status = sim_tape_ioerr (uptr);
@@ -1074,33 +2662,33 @@ else switch (f) {                                       /* otherwise the read me
 
     case MTUF_F_TPC:
         ppos = sim_tape_tpc_fnd (uptr, (t_addr *) uptr->filebuf); /* find prev rec */
-        sim_fseek (uptr->fileref, ppos, SEEK_SET);      /* position */
-        sim_fread (&tpcbc, sizeof (t_tpclnt), 1, uptr->fileref);
+        _tape_fseek (uptr, ppos, SEEK_SET);             /* position */
+        _tape_fread (&tpcbc, sizeof (t_tpclnt), 1, uptr);
         *bc = tpcbc;                                    /* save rec lnt */
 
-        if (ferror (uptr->fileref))                     /* error? */
+        if (_tape_ferror (uptr))                        /* error? */
             status = sim_tape_ioerr (uptr);
-        else if (feof (uptr->fileref))                  /* eof? */
+        else if (_tape_feof (uptr))                     /* eof? */
             status = MTSE_EOM;
         else {
             uptr->pos = ppos;                           /* spc over record */
             if (*bc == MTR_TMK)                         /* tape mark? */
                 status = MTSE_TMK;
             else
-                sim_fseek (uptr->fileref, uptr->pos + sizeof (t_tpclnt), SEEK_SET);
+                _tape_fseek (uptr, uptr->pos + sizeof (t_tpclnt), SEEK_SET);
             }
         break;
 
     case MTUF_F_P7B:
         for (sbc = 1, all_eof = 1; (t_addr) sbc <= uptr->pos ; sbc++) {
-            sim_fseek (uptr->fileref, uptr->pos - sbc, SEEK_SET);
-            sim_fread (&c, sizeof (uint8), 1, uptr->fileref);
+            _tape_fseek (uptr, uptr->pos - sbc, SEEK_SET);
+            _tape_fread (&c, sizeof (uint8), 1, uptr);
 
-            if (ferror (uptr->fileref)) {               /* error? */
+            if (_tape_ferror (uptr)) {                  /* error? */
                 status = sim_tape_ioerr (uptr);
                 break;
                 }
-            else if (feof (uptr->fileref)) {            /* eof? */
+            else if (_tape_feof (uptr)) {               /* eof? */
                 status = MTSE_EOM;
                 break;
                 }
@@ -1115,7 +2703,7 @@ else switch (f) {                                       /* otherwise the read me
         if (status == MTSE_OK) {
             uptr->pos = uptr->pos - sbc;                    /* update position */
             *bc = sbc;                                      /* save rec lnt */
-            sim_fseek (uptr->fileref, uptr->pos, SEEK_SET); /* for read */
+            _tape_fseek (uptr, uptr->pos, SEEK_SET);        /* for read */
             if (all_eof)                                    /* tape mark? */
                 status = MTSE_TMK;
             }
@@ -1125,6 +2713,9 @@ else switch (f) {                                       /* otherwise the read me
         status = MTSE_FMT;
         }
 
+if ((status == MTSE_OK) || (status == MTSE_TMK))        /* if an object was found then index it */
+    _tape_idx_insert (uptr, uptr->pos, *bc, status == MTSE_TMK);
+
 return status;
 }
 
@@ -1136,6 +2727,7 @@ t_stat status;
 if (ctx == NULL)                                        /* if not properly attached? */
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 
+_tape_idx_need (uptr);                                  /* index the tape if not yet done */
 status = sim_tape_rdlntr (uptr, bc);                    /* read the record length */
 
 sim_debug (MTSE_DBG_STR, ctx->dptr, "rd_lnt: st: %d, lnt: %d, pos: %" T_ADDR_FMT "u\n", status, *bc, uptr->pos);
@@ -1164,10 +2756,10 @@ return status;
    data record error    updated
 */
 
-t_stat sim_tape_rdrecf (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max)
+static t_stat _sim_tape_rdrecf (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max)
 {
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
-uint32 f = MT_GET_FMT (uptr);
+uint32 f = MT_GET_LAYOUT (uptr);
 t_mtrlnt i, tbc, rbc;
 t_addr opos;
 t_stat st;
@@ -1186,8 +2778,13 @@ if (rbc > max) {                                        /* rec out of range? */
     uptr->pos = opos;
     return MTSE_INVRL;
     }
-i = (t_mtrlnt) sim_fread (buf, sizeof (uint8), rbc, uptr->fileref); /* read record */
-if (ferror (uptr->fileref)) {                           /* error? */
+if ((st = _tape_idx_seek_data (uptr)) != MTSE_OK) {     /* position to the data if indexed */
+    MT_SET_PNU (uptr);
+    uptr->pos = opos;
+    return st;
+    }
+i = (t_mtrlnt) _tape_fread (buf, sizeof (uint8), rbc, uptr);    /* read record */
+if (_tape_ferror (uptr)) {                              /* error? */
     MT_SET_PNU (uptr);
     uptr->pos = opos;
     return sim_tape_ioerr (uptr);
@@ -1200,6 +2797,21 @@ sim_tape_data_trace(uptr, buf, rbc, "Record Read", ctx->dptr->dctrl & MTSE_DBG_D
 return (MTR_F (tbc)? MTSE_RECE: MTSE_OK);
 }
 
+t_stat sim_tape_rdrecf (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max)
+{
+t_uint64 start = sim_iostat_time ();
+t_addr opos = uptr->pos;
+t_stat st;
+
+if (!_tape_ra_get (uptr, buf, bc, max, &st)) {          /* not read ahead? */
+    st = _sim_tape_rdrecf (uptr, buf, bc, max);
+    _tape_ra_note (uptr, opos, st);
+    }
+
+_sim_tape_iostat (uptr, SIM_IOS_READ, start, ((st == MTSE_OK) || (st == MTSE_RECE)) ? *bc : 0, st);
+return st;
+}
+
 t_stat sim_tape_rdrecf_a (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max, TAPE_PCALLBACK callback)
 {
 t_stat r = SCPE_OK;
@@ -1232,10 +2844,10 @@ return r;
    data record error    updated
 */
 
-t_stat sim_tape_rdrecr (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max)
+static t_stat _sim_tape_rdrecr (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max)
 {
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
-uint32 f = MT_GET_FMT (uptr);
+uint32 f = MT_GET_LAYOUT (uptr);
 t_mtrlnt i, rbc, tbc;
 t_stat st;
 
@@ -1249,8 +2861,10 @@ if (st != MTSE_OK)
 *bc = rbc = MTR_L (tbc);                                /* strip error flag */
 if (rbc > max)                                          /* rec out of range? */
     return MTSE_INVRL;
-i = (t_mtrlnt) sim_fread (buf, sizeof (uint8), rbc, uptr->fileref); /* read record */
-if (ferror (uptr->fileref))                             /* error? */
+if ((st = _tape_idx_seek_data (uptr)) != MTSE_OK)       /* position to the data if indexed */
+    return st;
+i = (t_mtrlnt) _tape_fread (buf, sizeof (uint8), rbc, uptr);    /* read record */
+if (_tape_ferror (uptr))                                /* error? */
     return sim_tape_ioerr (uptr);
 for ( ; i < rbc; i++)                                   /* fill with 0's */
     buf[i] = 0;
@@ -1260,6 +2874,15 @@ sim_tape_data_trace(uptr, buf, rbc, "Record Read Reverse", ctx->dptr->dctrl & MT
 return (MTR_F (tbc)? MTSE_RECE: MTSE_OK);
 }
 
+t_stat sim_tape_rdrecr (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max)
+{
+t_uint64 start = sim_iostat_time ();
+t_stat st = _sim_tape_rdrecr (uptr, buf, bc, max);
+
+_sim_tape_iostat (uptr, SIM_IOS_READ, start, ((st == MTSE_OK) || (st == MTSE_RECE)) ? *bc : 0, st);
+return st;
+}
+
 t_stat sim_tape_rdrecr_a (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max, TAPE_PCALLBACK callback)
 {
 t_stat r = SCPE_OK;
@@ -1286,10 +2909,10 @@ return r;
    data record          updated
 */
 
-t_stat sim_tape_wrrecf (UNIT *uptr, uint8 *buf, t_mtrlnt bc)
+static t_stat _sim_tape_wrrecf (UNIT *uptr, uint8 *buf, t_mtrlnt bc)
 {
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
-uint32 f = MT_GET_FMT (uptr);
+uint32 f = MT_GET_LAYOUT (uptr);
 t_mtrlnt sbc;
 
 if (ctx == NULL)                                        /* if not properly attached? */
@@ -1305,27 +2928,32 @@ if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
 if (sbc == 0)                                           /* nothing to do? */
     return MTSE_OK;
-sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);         /* set pos */
+_tape_idx_remove (uptr, uptr->pos,                      /* drop index entries being overwritten */
+                  uptr->pos + _tape_idx_extent (uptr, bc, FALSE) + 1);
+_tape_idx_seek_cancel (uptr);
+_tape_ra_flush (uptr);
+_tape_fseek (uptr, uptr->pos, SEEK_SET);                /* set pos */
 switch (f) {                                            /* case on format */
 
     case MTUF_F_STD:                                    /* standard */
         sbc = MTR_L ((bc + 1) & ~1);                    /* pad odd length */
     case MTUF_F_E11:                                    /* E11 */
-        sim_fwrite (&bc, sizeof (t_mtrlnt), 1, uptr->fileref);
-        sim_fwrite (buf, sizeof (uint8), sbc, uptr->fileref);
-        sim_fwrite (&bc, sizeof (t_mtrlnt), 1, uptr->fileref);
-        if (ferror (uptr->fileref)) {                   /* error? */
+        _tape_fwrite (&bc, sizeof (t_mtrlnt), 1, uptr);
+        _tape_fwrite (buf, sizeof (uint8), sbc, uptr);
+        _tape_fwrite (&bc, sizeof (t_mtrlnt), 1, uptr);
+        if (_tape_ferror (uptr)) {                      /* error? */
             MT_SET_PNU (uptr);
             return sim_tape_ioerr (uptr);
             }
+        _tape_idx_insert (uptr, uptr->pos, bc, FALSE);  /* index the new record */
         uptr->pos = uptr->pos + sbc + (2 * sizeof (t_mtrlnt));  /* move tape */
         break;
 
     case MTUF_F_P7B:                                    /* Pierce 7B */
         buf[0] = buf[0] | P7B_SOR;                      /* mark start of rec */
-        sim_fwrite (buf, sizeof (uint8), sbc, uptr->fileref);
-        sim_fwrite (buf, sizeof (uint8), 1, uptr->fileref); /* delimit rec */
-        if (ferror (uptr->fileref)) {                   /* error? */
+        _tape_fwrite (buf, sizeof (uint8), sbc, uptr);
+        _tape_fwrite (buf, sizeof (uint8), 1, uptr);        /* delimit rec */
+        if (_tape_ferror (uptr)) {                      /* error? */
             MT_SET_PNU (uptr);
             return sim_tape_ioerr (uptr);
             }
@@ -1336,6 +2964,15 @@ sim_tape_data_trace(uptr, buf, sbc, "Record Written", ctx->dptr->dctrl & MTSE_DB
 return MTSE_OK;
 }
 
+t_stat sim_tape_wrrecf (UNIT *uptr, uint8 *buf, t_mtrlnt bc)
+{
+t_uint64 start = sim_iostat_time ();
+t_stat st = _sim_tape_wrrecf (uptr, buf, bc);
+
+_sim_tape_iostat (uptr, SIM_IOS_WRITE, start, (st == MTSE_OK) ? MTR_L (bc) : 0, st);
+return st;
+}
+
 t_stat sim_tape_wrrecf_a (UNIT *uptr, uint8 *buf, t_mtrlnt bc, TAPE_PCALLBACK callback)
 {
 t_stat r = SCPE_OK;
@@ -1358,13 +2995,18 @@ if (ctx == NULL)                                        /* if not properly attac
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
-sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);         /* set pos */
-sim_fwrite (&dat, sizeof (t_mtrlnt), 1, uptr->fileref);
-if (ferror (uptr->fileref)) {                           /* error? */
+_tape_idx_remove (uptr, uptr->pos, uptr->pos + sizeof (t_mtrlnt));
+_tape_idx_seek_cancel (uptr);
+_tape_ra_flush (uptr);
+_tape_fseek (uptr, uptr->pos, SEEK_SET);                /* set pos */
+_tape_fwrite (&dat, sizeof (t_mtrlnt), 1, uptr);
+if (_tape_ferror (uptr)) {                              /* error? */
     MT_SET_PNU (uptr);
     return sim_tape_ioerr (uptr);
     }
 sim_debug (MTSE_DBG_STR, ctx->dptr, "wr_lnt: lnt: %d, pos: %" T_ADDR_FMT "u\n", dat, uptr->pos);
+if ((dat == MTR_TMK) && (MT_GET_FMT (uptr) != MTUF_F_P7B))  /* index a new tape mark */
+    _tape_idx_insert (uptr, uptr->pos, dat, TRUE);
 uptr->pos = uptr->pos + sizeof (t_mtrlnt);              /* move tape */
 return MTSE_OK;
 }
@@ -1555,7 +3197,7 @@ uint32   file_size, marker_count;
 int32    gap_needed = (int32) gap_size;                 /* the gap remaining to be allocated from the tape */
 uint32   gap_alloc = 0;                                 /* the gap currently allocated from the tape */
 const t_addr gap_pos = uptr->pos;                       /* the file position where the gap will start */
-const uint32 format = MT_GET_FMT (uptr);                /* the tape format */
+const uint32 format = MT_GET_LAYOUT (uptr);             /* the tape format */
 const uint32 meta_size = sizeof (t_mtrlnt);             /* the number of bytes per metadatum */
 const uint32 min_rec_size = 2 + sizeof (t_mtrlnt) * 2;  /* the smallest data record size */
 
@@ -1570,9 +3212,13 @@ else if (sim_tape_wrp (uptr))                           /* otherwise if the unit
 else if (gap_size == 0 || format != MTUF_F_STD)         /* otherwise if zero length or gaps aren't supported */
     return MTSE_OK;                                     /*   then take no action */
 
-file_size = sim_fsize (uptr->fileref);                  /* get the file size */
+_tape_idx_remove (uptr, gap_pos, (t_addr) -1);          /* records beyond the gap may be truncated */
+_tape_idx_seek_cancel (uptr);
+_tape_ra_flush (uptr);
+
+file_size = _tape_fsize (uptr);                         /* get the file size */
 
-if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) {   /* position the tape; if it fails */
+if (_tape_fseek (uptr, uptr->pos, SEEK_SET)) {          /* position the tape; if it fails */
     MT_SET_PNU (uptr);                                  /*   then set position not updated */
     return sim_tape_ioerr (uptr);                       /*     and quit with I/O error status */
     }
@@ -1590,15 +3236,15 @@ if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) {   /* position the tape; if
 */
 
 do {
-    xfer = sim_fread (&meta, meta_size, 1, uptr->fileref);  /* read a metadatum */
+    xfer = _tape_fread (&meta, meta_size, 1, uptr);         /* read a metadatum */
 
-    if (ferror (uptr->fileref)) {                       /* read error? */
+    if (_tape_ferror (uptr)) {                          /* read error? */
         uptr->pos = gap_pos;                            /* restore original position */
         MT_SET_PNU (uptr);                              /* position not updated */
         return sim_tape_ioerr (uptr);                   /* translate error */
         }
 
-    else if (xfer != 1 && feof (uptr->fileref) == 0) {  /* otherwise if a partial metadatum was read */
+    else if (xfer != 1 && _tape_feof (uptr) == 0) {     /* otherwise if a partial metadatum was read */
         uptr->pos = gap_pos;                            /*   then restore the original position */
         MT_SET_PNU (uptr);                              /* set the position-not-updated flag */
         return MTSE_INVRL;                              /*   and return an invalid record length error */
@@ -1607,7 +3253,7 @@ do {
     else                                                /* otherwise we had a good read */
         uptr->pos = uptr->pos + meta_size;              /*   so move the tape over the datum */
 
-    if (feof (uptr->fileref) || (meta == MTR_EOM)) {    /* at eof or eom? */
+    if (_tape_feof (uptr) || (meta == MTR_EOM)) {       /* at eof or eom? */
         gap_alloc = gap_alloc + gap_needed;             /* allocate remainder */
         gap_needed = 0;
         }
@@ -1626,7 +3272,7 @@ do {
     else if (meta == MTR_FHGAP) {                       /* half gap? */
         uptr->pos = uptr->pos - meta_size / 2;          /* backup to resync */
 
-        if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) /* position the tape; if it fails */
+        if (_tape_fseek (uptr, uptr->pos, SEEK_SET))        /* position the tape; if it fails */
             return sim_tape_ioerr (uptr);                   /*   then quit with I/O error status */
 
         gap_alloc = gap_alloc + meta_size / 2;          /* allocate marker space */
@@ -1652,7 +3298,7 @@ do {
         if (rec_size < gap_needed + min_rec_size) {         /* rec too small? */
             uptr->pos = uptr->pos - meta_size + rec_size;   /* position past record */
 
-            if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) /* position the tape; if it fails */
+            if (_tape_fseek (uptr, uptr->pos, SEEK_SET))    /* position the tape; if it fails */
                 return sim_tape_ioerr (uptr);                   /*   then quit with I/O error status */
 
             gap_alloc = gap_alloc + rec_size;               /* allocate record */
@@ -1752,7 +3398,7 @@ return MTSE_OK;
 
 static t_stat tape_erase_rev (UNIT *uptr, t_mtrlnt gap_size)
 {
-const uint32 format = MT_GET_FMT (uptr);                /* the tape format */
+const uint32 format = MT_GET_LAYOUT (uptr);             /* the tape format */
 const uint32 meta_size = sizeof (t_mtrlnt);             /* the number of bytes per metadatum */
 t_stat   status;
 t_mtrlnt rec_size, metadatum;
@@ -1778,25 +3424,29 @@ if (gap_size == meta_size) {                            /* if the request is for
     else                                                /*   otherwise */
         uptr->pos -= meta_size;                         /*     back up the file pointer */
 
-    if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) /* position the tape; if it fails */
+    _tape_idx_remove (uptr, uptr->pos, gap_pos);        /* a tape mark there may be erased */
+    _tape_idx_seek_cancel (uptr);
+    _tape_ra_flush (uptr);
+
+    if (_tape_fseek (uptr, uptr->pos, SEEK_SET))            /* position the tape; if it fails */
         return sim_tape_ioerr (uptr);                   /*   then quit with I/O error status */
 
-    sim_fread (&metadatum, meta_size, 1, uptr->fileref);    /* read a metadatum */
+    _tape_fread (&metadatum, meta_size, 1, uptr);           /* read a metadatum */
 
-    if (ferror (uptr->fileref))                             /* if a file I/O error occurred */
+    if (_tape_ferror (uptr))                                /* if a file I/O error occurred */
         return sim_tape_ioerr (uptr);                       /*   then report the error and quit */
 
     else if (metadatum == MTR_TMK)                          /* otherwise if a tape mark is present */
-        if (sim_fseek (uptr->fileref, uptr->pos, SEEK_SET)) /*   then reposition the tape; if it fails */
+        if (_tape_fseek (uptr, uptr->pos, SEEK_SET))        /*   then reposition the tape; if it fails */
             return sim_tape_ioerr (uptr);                   /*     then quit with I/O error status */
 
         else {                                              /*   otherwise */
             metadatum = MTR_GAP;                            /*     replace it with an erase gap marker */
 
-            xfer = sim_fwrite (&metadatum, meta_size,   /* write the gap marker */
-                               1, uptr->fileref);
+            xfer = _tape_fwrite (&metadatum, meta_size, /* write the gap marker */
+                               1, uptr);
 
-            if (ferror (uptr->fileref) || xfer == 0)    /* if a file I/O error occurred */
+            if (_tape_ferror (uptr) || xfer == 0)       /* if a file I/O error occurred */
                 return sim_tape_ioerr (uptr);           /* report the error and quit */
             else                                        /* otherwise the write succeeded */
                 status = MTSE_OK;                       /*   so return success */
@@ -1957,7 +3607,7 @@ else                                                    /* otherwise */
    data record error    updated
 */
 
-t_stat sim_tape_sprecf (UNIT *uptr, t_mtrlnt *bc)
+static t_stat _sim_tape_sprecf (UNIT *uptr, t_mtrlnt *bc)
 {
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
 t_stat st;
@@ -1966,11 +3616,21 @@ if (ctx == NULL)                                        /* if not properly attac
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 sim_debug (ctx->dbit, ctx->dptr, "sim_tape_sprecf(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 
+_tape_idx_need (uptr);                                  /* index the tape if not yet done */
 st = sim_tape_rdrlfwd (uptr, bc);                       /* get record length */
 *bc = MTR_L (*bc);
 return st;
 }
 
+t_stat sim_tape_sprecf (UNIT *uptr, t_mtrlnt *bc)
+{
+t_uint64 start = sim_iostat_time ();
+t_stat st = _sim_tape_sprecf (uptr, bc);
+
+_sim_tape_iostat (uptr, SIM_IOS_POSN, start, 0, st);
+return st;
+}
+
 t_stat sim_tape_sprecf_a (UNIT *uptr, t_mtrlnt *bc, TAPE_PCALLBACK callback)
 {
 t_stat r = MTSE_OK;
@@ -2047,7 +3707,7 @@ return r;
    data record          updated
 */
 
-t_stat sim_tape_sprecr (UNIT *uptr, t_mtrlnt *bc)
+static t_stat _sim_tape_sprecr (UNIT *uptr, t_mtrlnt *bc)
 {
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
 t_stat st;
@@ -2066,6 +3726,15 @@ st = sim_tape_rdrlrev (uptr, bc);                       /* get record length */
 return st;
 }
 
+t_stat sim_tape_sprecr (UNIT *uptr, t_mtrlnt *bc)
+{
+t_uint64 start = sim_iostat_time ();
+t_stat st = _sim_tape_sprecr (uptr, bc);
+
+_sim_tape_iostat (uptr, SIM_IOS_POSN, start, 0, st);
+return st;
+}
+
 t_stat sim_tape_sprecr_a (UNIT *uptr, t_mtrlnt *bc, TAPE_PCALLBACK callback)
 {
 t_stat r = MTSE_OK;
@@ -2346,6 +4015,7 @@ if (uptr->flags & UNIT_ATT) {
     if (ctx == NULL)                                    /* if not properly attached? */
         return sim_messagef (SCPE_IERR, "Bad Attach\n");/*   that's a problem */
     sim_debug (ctx->dbit, ctx->dptr, "sim_tape_rewind(unit=%d)\n", (int)(uptr-ctx->dptr->units));
+    _tape_ra_flush (uptr);
     }
 uptr->pos = 0;
 MT_CLR_PNU (uptr);
@@ -2472,10 +4142,22 @@ return ((uptr->flags & MTUF_WRP) || (MT_GET_FMT (uptr) == MTUF_F_TPC))? TRUE: FA
 static t_stat sim_tape_ioerr (UNIT *uptr)
 {
 sim_printf ("%s: Magtape library I/O error: %s\n", sim_uname (uptr), strerror (errno));
-clearerr (uptr->fileref);
+_tape_clearerr (uptr);
 return MTSE_IOERR;
 }
 
+/* Record a completed operation in the unit's I/O statistics */
+
+static void _sim_tape_iostat (UNIT *uptr, int op, t_uint64 start, t_mtrlnt bytes, t_stat st)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if (ctx == NULL)
+    return;
+sim_iostat_done (ctx->iostats, op, start, bytes,
+                 (st == MTSE_IOERR) || (st == MTSE_RECE) || (st == MTSE_INVRL) || (st == MTSE_FMT));
+}
+
 /* Set tape format */
 
 t_stat sim_tape_set_fmt (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
@@ -2528,11 +4210,11 @@ if ((uptr == NULL) || (uptr->fileref == NULL))
     return 0;
 countmap = (uint32 *)calloc (65536, sizeof(*countmap));
 recbuf = (uint8 *)malloc (65536);
-tape_size = (t_addr)sim_fsize (uptr->fileref);
+tape_size = (t_addr)_tape_fsize (uptr);
 sim_debug (MTSE_DBG_STR, dptr, "tpc_map: tape_size: %" T_ADDR_FMT "u\n", tape_size);
 for (objc = 0, sizec = 0, tpos = 0;; ) {
-    sim_fseek (uptr->fileref, tpos, SEEK_SET);
-    i = sim_fread (&bc, sizeof (t_tpclnt), 1, uptr->fileref);
+    _tape_fseek (uptr, tpos, SEEK_SET);
+    i = _tape_fread (&bc, sizeof (t_tpclnt), 1, uptr);
     if (i == 0)     /* past or at eof? */
         break;
     if (countmap[bc] == 0)
@@ -2543,7 +4225,7 @@ for (objc = 0, sizec = 0, tpos = 0;; ) {
     if (bc) {
         sim_debug (MTSE_DBG_STR, dptr, "tpc_map: %d byte count at pos: %" T_ADDR_FMT "u\n", bc, tpos);
         if (sim_deb && (dptr->dctrl & MTSE_DBG_STR)) {
-            sim_fread (recbuf, 1, bc, uptr->fileref);
+            _tape_fread (recbuf, 1, bc, uptr);
             sim_data_trace(dptr, uptr, ((dptr->dctrl & MTSE_DBG_DAT) ? recbuf : NULL), "", bc, "Data Record", MTSE_DBG_STR);
             }
         }
@@ -1705,6 +1705,24 @@ void sim_throt_cancel (void)
 sim_cancel (&sim_throttle_unit);
 }
 
+/* Suspend/resume throttling (BENCHMARK command) */
+
+void sim_throt_suspend (t_bool suspend)
+{
+static uint32 saved_type = SIM_THROT_NONE;
+
+if (suspend) {
+    saved_type = sim_throt_type;
+    sim_throt_type = SIM_THROT_NONE;
+    sim_throt_cancel ();
+    }
+else {
+    sim_throt_type = saved_type;
+    saved_type = SIM_THROT_NONE;
+    sim_throt_sched ();                                 /* recalibrate and restart */
+    }
+}
+
 /* Throttle service
 
    Throttle service has three distinct states used while dynamically
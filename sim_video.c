@@ -49,12 +49,69 @@ t_stat vid_show (FILE* st, DEVICE *dptr,  UNIT* uptr, int32 val, CONST char* des
 return vid_show_video (st, uptr, val, desc);
 }
 
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+/* Scanline conversion helpers for bitmap displays
 
-char vid_release_key[64] = "Ctrl-Right-Shift";
+   vid_expand_1bpp      1 bit/pixel, LSB first in 32b words, to 32bpp
+   vid_cursor_mono      combine a 1 byte/pixel cursor image with a
+                        monochrome scanline (OR or AND NOT function)
 
-#include <SDL.h>
-#include <SDL_thread.h>
+   The inner loops have fixed trip counts and no data dependent
+   branches so the compiler can vectorize them.  When SSE2 is available
+   the 1bpp case, which is the bulk of the work for monochrome displays,
+   uses it explicitly.
+*/
+
+#if (defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && (_M_IX86_FP >= 2))) && !defined (SIM_VID_NO_SIMD)
+#include <emmintrin.h>
+#define VID_SSE2 1
+#endif
+
+void vid_expand_1bpp (const uint32 *src, uint32 *dst, int32 pixels, const uint32 *palette)
+{
+uint32 p0 = palette[0];
+uint32 px = palette[0] ^ palette[1];                    /* select via xor */
+int32 i, j, words = pixels >> 5;
+#if defined (VID_SSE2)
+__m128i vp0 = _mm_set1_epi32 ((int)p0);
+__m128i vpx = _mm_set1_epi32 ((int)px);
+__m128i vbit = _mm_set_epi32 (8, 4, 2, 1);
+
+for (i = 0; i < words; i++, dst += 32) {
+    __m128i vw = _mm_set1_epi32 ((int)src[i]);
+    __m128i vb = vbit;
+
+    for (j = 0; j < 32; j += 4) {                       /* 4 pixels per step */
+        __m128i m = _mm_cmpeq_epi32 (_mm_and_si128 (vw, vb), vb);
+
+        _mm_storeu_si128 ((__m128i *)(dst + j), _mm_xor_si128 (vp0, _mm_and_si128 (vpx, m)));
+        vb = _mm_slli_epi32 (vb, 4);
+        }
+    }
+#else
+for (i = 0; i < words; i++, dst += 32) {
+    uint32 w = src[i];
+
+    for (j = 0; j < 32; j++)
+        dst[j] = p0 ^ (px & (0 - ((w >> j) & 1)));
+    }
+#endif
+for (j = 0; j < (pixels & 0x1F); j++)                   /* partial word */
+    dst[j] = p0 ^ (px & (0 - ((src[i] >> j) & 1)));
+}
+
+void vid_cursor_mono (uint32 *dst, const uint8 *cur, int32 pixels, const uint32 *palette, t_bool or_func)
+{
+int32 i;
+uint32 on;
+
+for (i = 0; i < pixels; i++) {
+    on = (dst[i] == palette[1]);
+    on = or_func ? (on | (cur[i] & 1)) : (on & (~cur[i] & 1));
+    dst[i] = palette[on];
+    }
+}
+
+/* Key names, shared by the SDL and offscreen backends */
 
 static const char *key_names[] = 
     {"F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "F10", "F11", "F12", 
@@ -84,6 +141,511 @@ static char tmp_key_name[40];
     return tmp_key_name;
 }
 
+/* Offscreen video backend
+
+   SET VIDEO OFFSCREEN selects a backend which needs no window system.
+   The frame buffer is kept in memory and:
+
+   - SCREENSHOT writes it out as a PNG (when libpng is available) or BMP
+   - SET VIDEO DUMP=file writes the frame buffer every DUMPRATE'th frame
+     as raw 32bpp pixels (host order ARGB words, no header); a file name
+     starting with '|' is a command the frames are piped to
+   - keyboard and mouse events given with SET VIDEO KEY/MOUSE, or read
+     from an event script named with SET VIDEO INPUT=file, are returned
+     by vid_poll_kb and vid_poll_mouse
+
+   A frame is one update of the display, marked by vid_refresh, so
+   frames are only counted when the device actually puts something on
+   the screen.  Event script lines use the same keyword=value syntax as
+   the SET VIDEO command; the script is read whenever the device polls
+   the keyboard, up to the next DELAY=n, which pauses it until n more
+   frames have been displayed.
+   Everything here runs on the simulator thread, so no locking is needed.
+*/
+
+#if defined(_WIN32)
+#define popen   _popen
+#define pclose  _pclose
+#endif
+
+#define VID_OFF_EVENTS  64                              /* event queue depth */
+
+static t_bool vid_offscreen = FALSE;                    /* offscreen backend selected */
+
+static struct {
+    DEVICE      *dptr;                                  /* owning device */
+    uint32      *fb;                                    /* frame buffer */
+    int32       width;
+    int32       height;
+    int32       flags;                                  /* vid_open flags */
+    uint32      frames;                                 /* vid_refresh calls */
+    FILE        *dump;                                  /* raw frame dump */
+    t_bool      dump_pipe;                              /* dump is a pipe */
+    uint32      dump_rate;                              /* dump every n frames */
+    uint32      dump_cnt;                               /* frames dumped */
+    char        dump_name[CBUFSIZE];
+    FILE        *input;                                 /* event script */
+    char        input_name[CBUFSIZE];
+    uint32      input_delay;                            /* frames left to wait */
+    int32       mouse_x;                                /* pointer position */
+    int32       mouse_y;
+    SIM_KEY_EVENT   keys[VID_OFF_EVENTS];
+    int32       key_head, key_count;
+    SIM_MOUSE_EVENT mice[VID_OFF_EVENTS];
+    int32       mouse_head, mouse_count;
+    } vid_off = { NULL, NULL, 0, 0, 0, 0, NULL, FALSE, 1 };
+
+static t_stat vid_off_event (CONST char *cptr, t_bool script);
+
+static t_stat vid_off_open (DEVICE *dptr, const char *title, uint32 width, uint32 height, int flags)
+{
+if (vid_active)
+    return SCPE_OK;
+vid_off.fb = (uint32 *)calloc (width * height, sizeof (*vid_off.fb));
+if (vid_off.fb == NULL)
+    return SCPE_MEM;
+vid_off.dptr = dptr;
+vid_off.width = width;
+vid_off.height = height;
+vid_off.flags = flags;
+vid_off.frames = 0;                                     /* events queued before the */
+                                                        /* display opened are kept */
+vid_mono_palette[0] = 0xFF000000;                       /* black */
+vid_mono_palette[1] = 0xFFFFFFFF;                       /* white */
+vid_active = TRUE;
+sim_debug (SIM_VID_DBG_VIDEO, dptr, "vid_open() - Offscreen %dx%d\n", width, height);
+return SCPE_OK;
+}
+
+static t_stat vid_off_close (void)
+{
+if (!vid_active)
+    return SCPE_OK;
+vid_active = FALSE;
+free (vid_off.fb);
+vid_off.fb = NULL;
+vid_off.dptr = NULL;
+if (vid_off.dump)                                       /* dump stays open across */
+    fflush (vid_off.dump);                              /* display open/close */
+return SCPE_OK;
+}
+
+static void vid_off_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf)
+{
+int32 i, cw;
+
+if ((vid_off.fb == NULL) || (x < 0) || (y < 0) || (x >= vid_off.width))
+    return;
+cw = ((x + w) > vid_off.width) ? (vid_off.width - x) : w;
+for (i = 0; (i < h) && ((y + i) < vid_off.height); i++)
+    memcpy (vid_off.fb + ((y + i) * vid_off.width) + x, buf + w*i, cw*sizeof(*vid_off.fb));
+}
+
+static void vid_off_dump_close (void)
+{
+if (vid_off.dump == NULL)
+    return;
+if (vid_off.dump_pipe)
+    pclose (vid_off.dump);
+else
+    fclose (vid_off.dump);
+vid_off.dump = NULL;
+}
+
+/* Queue the events of the event script up to its next delay */
+
+static void vid_off_script (void)
+{
+char buf[CBUFSIZE], *cptr;
+
+while ((vid_off.input != NULL) && (vid_off.input_delay == 0)) {
+    if ((vid_off.key_count > VID_OFF_EVENTS - 2) ||     /* no room for a key press? */
+        (vid_off.mouse_count == VID_OFF_EVENTS))        /* retry next poll */
+        return;
+    if (fgets (buf, sizeof (buf), vid_off.input) == NULL) {
+        fclose (vid_off.input);
+        vid_off.input = NULL;
+        break;
+        }
+    sim_trim_endspc (buf);
+    for (cptr = buf; sim_isspace (*cptr); cptr++)
+        ;
+    if ((*cptr == 0) || (*cptr == ';') || (*cptr == '#'))
+        continue;
+    if (vid_off_event (cptr, TRUE) != SCPE_OK)
+        sim_printf ("Video event script %s: invalid line: %s\n", vid_off.input_name, cptr);
+    }
+}
+
+static void vid_off_refresh (void)
+{
+vid_off.frames++;
+if ((vid_off.dump != NULL) && (vid_off.fb != NULL) &&
+    ((vid_off.frames % vid_off.dump_rate) == 0)) {
+    size_t size = (size_t)vid_off.width * vid_off.height;
+
+    if (fwrite (vid_off.fb, sizeof (*vid_off.fb), size, vid_off.dump) != size) {
+        sim_printf ("Video frame dump to %s failed, dump stopped\n", vid_off.dump_name);
+        vid_off_dump_close ();
+        }
+    else
+        vid_off.dump_cnt++;
+    }
+if (vid_off.input_delay)                                /* script waiting? */
+    vid_off.input_delay--;
+}
+
+static t_stat vid_off_poll_kb (SIM_KEY_EVENT *ev)
+{
+if (vid_active)
+    vid_off_script ();
+if (vid_off.key_count == 0)
+    return SCPE_EOF;
+*ev = vid_off.keys[vid_off.key_head];
+vid_off.key_head = (vid_off.key_head + 1) % VID_OFF_EVENTS;
+vid_off.key_count--;
+sim_debug (SIM_VID_DBG_KEY, vid_off.dptr, "vid_poll_kb() - %s %s\n", vid_key_name (ev->key), (ev->state == SIM_KEYPRESS_UP) ? "UP" : "DOWN");
+return SCPE_OK;
+}
+
+static t_stat vid_off_poll_mouse (SIM_MOUSE_EVENT *ev)
+{
+if (vid_off.mouse_count == 0)
+    return SCPE_EOF;
+*ev = vid_off.mice[vid_off.mouse_head];
+vid_off.mouse_head = (vid_off.mouse_head + 1) % VID_OFF_EVENTS;
+vid_off.mouse_count--;
+sim_debug (SIM_VID_DBG_MOUSE, vid_off.dptr, "vid_poll_mouse() - pos:(%d,%d) rel:(%d,%d) buttons:(%d,%d,%d)\n",
+           ev->x_pos, ev->y_pos, ev->x_rel, ev->y_rel, ev->b1_state, ev->b2_state, ev->b3_state);
+return SCPE_OK;
+}
+
+static t_stat vid_off_key (uint32 key, uint32 state)
+{
+if (vid_off.key_count == VID_OFF_EVENTS)
+    return SCPE_NXM;
+vid_off.keys[(vid_off.key_head + vid_off.key_count) % VID_OFF_EVENTS].key = key;
+vid_off.keys[(vid_off.key_head + vid_off.key_count) % VID_OFF_EVENTS].state = state;
+vid_off.key_count++;
+return SCPE_OK;
+}
+
+static t_stat vid_off_mouse (int32 x, int32 y, uint32 buttons)
+{
+SIM_MOUSE_EVENT *ev;
+
+if (vid_off.mouse_count == VID_OFF_EVENTS)
+    return SCPE_NXM;
+ev = &vid_off.mice[(vid_off.mouse_head + vid_off.mouse_count) % VID_OFF_EVENTS];
+ev->x_rel = x - vid_off.mouse_x;
+ev->y_rel = y - vid_off.mouse_y;
+ev->x_pos = x;
+ev->y_pos = y;
+ev->b1_state = vid_mouse_b1 = (buttons & 1) ? TRUE : FALSE;
+ev->b2_state = vid_mouse_b2 = (buttons & 2) ? TRUE : FALSE;
+ev->b3_state = vid_mouse_b3 = (buttons & 4) ? TRUE : FALSE;
+vid_off.mouse_x = x;
+vid_off.mouse_y = y;
+vid_off.mouse_count++;
+return SCPE_OK;
+}
+
+/* Write the frame buffer as a bottom up 24bpp BMP or, with libpng, a PNG */
+
+static t_stat vid_off_write_bmp (FILE *f)
+{
+uint8 hdr[54], *row;
+int32 x, y, pad = (4 - ((vid_off.width * 3) & 3)) & 3;
+uint32 size = 54 + (vid_off.width * 3 + pad) * vid_off.height;
+static const uint8 zero[4] = {0, 0, 0, 0};
+
+memset (hdr, 0, sizeof (hdr));
+hdr[0] = 'B';
+hdr[1] = 'M';
+hdr[2] = size & 0xFF;                                   /* file size */
+hdr[3] = (size >> 8) & 0xFF;
+hdr[4] = (size >> 16) & 0xFF;
+hdr[5] = (size >> 24) & 0xFF;
+hdr[10] = 54;                                           /* pixel data offset */
+hdr[14] = 40;                                           /* info header size */
+hdr[18] = vid_off.width & 0xFF;
+hdr[19] = (vid_off.width >> 8) & 0xFF;
+hdr[22] = vid_off.height & 0xFF;
+hdr[23] = (vid_off.height >> 8) & 0xFF;
+hdr[26] = 1;                                            /* planes */
+hdr[28] = 24;                                           /* bits per pixel */
+if (fwrite (hdr, sizeof (hdr), 1, f) != 1)
+    return SCPE_IOERR;
+row = (uint8 *)malloc (vid_off.width * 3);
+if (row == NULL)
+    return SCPE_MEM;
+for (y = vid_off.height - 1; y >= 0; y--) {
+    uint32 *src = vid_off.fb + y * vid_off.width;
+
+    for (x = 0; x < vid_off.width; x++) {
+        row[x*3]     = src[x] & 0xFF;                   /* blue */
+        row[x*3 + 1] = (src[x] >> 8) & 0xFF;            /* green */
+        row[x*3 + 2] = (src[x] >> 16) & 0xFF;           /* red */
+        }
+    if ((fwrite (row, 3, vid_off.width, f) != (size_t)vid_off.width) ||
+        (pad && (fwrite (zero, 1, pad, f) != (size_t)pad))) {
+        free (row);
+        return SCPE_IOERR;
+        }
+    }
+free (row);
+return SCPE_OK;
+}
+
+#if defined(HAVE_LIBPNG)
+#include <png.h>
+
+static t_stat vid_off_write_png (FILE *f)
+{
+png_structp png_ptr;
+png_infop info_ptr;
+png_bytep row;
+int32 x, y;
+
+png_ptr = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+if (png_ptr == NULL)
+    return SCPE_MEM;
+info_ptr = png_create_info_struct (png_ptr);
+row = (png_bytep)malloc (vid_off.width * 3);
+if ((info_ptr == NULL) || (row == NULL) || setjmp (png_jmpbuf (png_ptr))) {
+    png_destroy_write_struct (&png_ptr, &info_ptr);
+    free (row);
+    return SCPE_IOERR;
+    }
+png_init_io (png_ptr, f);
+png_set_IHDR (png_ptr, info_ptr, vid_off.width, vid_off.height, 8, PNG_COLOR_TYPE_RGB,
+              PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+png_write_info (png_ptr, info_ptr);
+for (y = 0; y < vid_off.height; y++) {
+    uint32 *src = vid_off.fb + y * vid_off.width;
+
+    for (x = 0; x < vid_off.width; x++) {
+        row[x*3]     = (src[x] >> 16) & 0xFF;           /* red */
+        row[x*3 + 1] = (src[x] >> 8) & 0xFF;            /* green */
+        row[x*3 + 2] = src[x] & 0xFF;                   /* blue */
+        }
+    png_write_row (png_ptr, row);
+    }
+png_write_end (png_ptr, NULL);
+png_destroy_write_struct (&png_ptr, &info_ptr);
+free (row);
+return SCPE_OK;
+}
+#endif /* defined(HAVE_LIBPNG) */
+
+static t_stat vid_off_screenshot (const char *filename)
+{
+char *fullname;
+FILE *f;
+t_stat r;
+t_bool bmp = (match_ext (filename, "bmp") != NULL);
+
+if (!vid_active) {
+    sim_printf ("No video display is active\n");
+    return SCPE_UDIS | SCPE_NOMESSAGE;
+    }
+fullname = (char *)malloc (strlen (filename) + 5);
+if (fullname == NULL)
+    return SCPE_MEM;
+#if defined(HAVE_LIBPNG)
+sprintf (fullname, "%s%s", filename, (bmp || (match_ext (filename, "png") != NULL)) ? "" : ".png");
+#else
+sprintf (fullname, "%s%s", filename, bmp ? "" : ".bmp");
+bmp = TRUE;
+#endif
+f = sim_fopen (fullname, "wb");
+if (f == NULL) {
+    sim_printf ("Error creating screenshot file %s: %s\n", fullname, strerror (errno));
+    free (fullname);
+    return SCPE_OPENERR | SCPE_NOMESSAGE;
+    }
+#if defined(HAVE_LIBPNG)
+if (!bmp)
+    r = vid_off_write_png (f);
+else
+#endif
+    r = vid_off_write_bmp (f);
+fclose (f);
+if (r != SCPE_OK)
+    sim_printf ("Error saving screenshot to %s\n", fullname);
+else {
+    if (!sim_quiet)
+        sim_printf ("Screenshot saved to %s\n", fullname);
+    }
+free (fullname);
+return (r == SCPE_OK) ? r : (r | SCPE_NOMESSAGE);
+}
+
+static t_stat vid_off_show (FILE *st)
+{
+fprintf (st, "Offscreen video backend\n");
+if (vid_active)
+    fprintf (st, "  Active frame buffer: %d by %d pixels, %u frames\n", vid_off.width, vid_off.height, vid_off.frames);
+if (vid_off.dump)
+    fprintf (st, "  Dumping every %u frame(s) to %s (%u dumped)\n", vid_off.dump_rate, vid_off.dump_name, vid_off.dump_cnt);
+if (vid_off.input)
+    fprintf (st, "  Reading events from %s\n", vid_off.input_name);
+if (vid_off.key_count || vid_off.mouse_count)
+    fprintf (st, "  Pending events: %d key, %d mouse\n", vid_off.key_count, vid_off.mouse_count);
+return SCPE_OK;
+}
+
+/* Process one SET VIDEO argument or event script line */
+
+static t_stat vid_off_event (CONST char *cptr, t_bool script)
+{
+char gbuf[CBUFSIZE], vbuf[CBUFSIZE];
+CONST char *vptr;
+uint32 i, key, val[3];
+t_stat r;
+
+vptr = get_glyph (cptr, gbuf, '=');
+if (MATCH_CMD (gbuf, "DELAY") == 0) {                   /* DELAY=frames */
+    val[0] = (uint32) get_uint (vptr, 10, 0xFFFFFFFF, &r);
+    if ((r != SCPE_OK) || (*vptr == 0))
+        return SCPE_ARG;
+    vid_off.input_delay = val[0];
+    return SCPE_OK;
+    }
+if ((strcmp (gbuf, "KEY") == 0) ||                      /* KEY|KEYDOWN|KEYUP=name */
+    (strcmp (gbuf, "KEYDOWN") == 0) ||
+    (strcmp (gbuf, "KEYUP") == 0)) {
+    get_glyph (vptr, vbuf, 0);
+    vptr = vbuf;
+    if (strncmp (vptr, "SIM_KEY_", 8) == 0)
+        vptr += 8;
+    for (key = 0; key < sizeof (key_names)/sizeof (key_names[0]); key++)
+        if (strcmp (vptr, key_names[key]) == 0)
+            break;
+    if (key == sizeof (key_names)/sizeof (key_names[0]))
+        return sim_messagef (SCPE_ARG, "Unknown key name: %s\n", vbuf);
+    if (vid_off.key_count > VID_OFF_EVENTS - 2)
+        return sim_messagef (SCPE_NXM, "Video key event queue full\n");
+    if (strcmp (gbuf, "KEYUP") != 0)
+        vid_off_key (key, SIM_KEYPRESS_DOWN);
+    if (strcmp (gbuf, "KEYDOWN") != 0)
+        vid_off_key (key, SIM_KEYPRESS_UP);
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "MOUSE") == 0) {                   /* MOUSE=x,y{,buttons} */
+    val[2] = 0;
+    for (i = 0; (i < 3) && (*vptr != 0); i++) {
+        vptr = get_glyph (vptr, vbuf, ',');
+        val[i] = (uint32) get_uint (vbuf, 10, 0xFFFF, &r);
+        if (r != SCPE_OK)
+            return SCPE_ARG;
+        }
+    if ((i < 2) || (*vptr != 0))
+        return SCPE_ARG;
+    if (vid_off_mouse ((int32)val[0], (int32)val[1], val[2]) != SCPE_OK)
+        return sim_messagef (SCPE_NXM, "Video mouse event queue full\n");
+    return SCPE_OK;
+    }
+if (script && (MATCH_CMD (gbuf, "SCREENSHOT") == 0)) {  /* SCREENSHOT=file */
+    get_glyph_nc (vptr, vbuf, 0);
+    return vid_off_screenshot (vbuf);
+    }
+return SCPE_ARG;
+}
+
+/* SET VIDEO command
+
+   SET VIDEO OFFSCREEN          use the offscreen backend for the next vid_open
+   SET VIDEO WINDOW             use the window system (SDL) backend
+   SET VIDEO DUMP=file          dump raw frames to file (|command pipes)
+   SET VIDEO DUMPRATE=n         dump every n'th frame
+   SET VIDEO NODUMP             stop dumping frames
+   SET VIDEO INPUT=file         read events from an event script
+   SET VIDEO NOINPUT            stop reading the event script
+   SET VIDEO KEY=name           queue a key press and release
+   SET VIDEO KEYDOWN=name       queue a key press
+   SET VIDEO KEYUP=name         queue a key release
+   SET VIDEO MOUSE=x,y{,b}      queue a mouse move to x,y with buttons b
+                                (bit 0 left, bit 1 middle, bit 2 right)
+*/
+
+t_stat vid_set (int32 flag, CONST char *cptr)
+{
+char gbuf[CBUFSIZE], fbuf[CBUFSIZE];
+CONST char *vptr;
+uint32 rate;
+t_stat r;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+vptr = get_glyph (cptr, gbuf, '=');
+if ((MATCH_CMD (gbuf, "OFFSCREEN") == 0) ||
+    (MATCH_CMD (gbuf, "WINDOW") == 0)) {
+    if (*vptr)
+        return SCPE_2MARG;
+    if (vid_active)
+        return sim_messagef (SCPE_ALATT, "A video display is active\n");
+    vid_offscreen = (MATCH_CMD (gbuf, "OFFSCREEN") == 0);
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "DUMP") == 0) {
+    if (*vptr == 0)
+        return SCPE_2FARG;
+    strlcpy (fbuf, vptr, sizeof (fbuf));                /* rest of line, may be a */
+    sim_trim_endspc (fbuf);                             /* command with arguments */
+    vid_off_dump_close ();
+    vid_off.dump_pipe = (fbuf[0] == '|');
+    if (vid_off.dump_pipe)
+        vid_off.dump = popen (fbuf + 1, "w");
+    else
+        vid_off.dump = sim_fopen (fbuf, "wb");
+    if (vid_off.dump == NULL)
+        return sim_messagef (SCPE_OPENERR, "Can't open %s: %s\n", fbuf, strerror (errno));
+    strlcpy (vid_off.dump_name, fbuf, sizeof (vid_off.dump_name));
+    vid_off.dump_cnt = 0;
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "DUMPRATE") == 0) {
+    rate = (uint32) get_uint (vptr, 10, 0xFFFFFFFF, &r);
+    if ((r != SCPE_OK) || (rate == 0))
+        return SCPE_ARG;
+    vid_off.dump_rate = rate;
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "NODUMP") == 0) {
+    vid_off_dump_close ();
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "INPUT") == 0) {
+    if (*vptr == 0)
+        return SCPE_2FARG;
+    strlcpy (fbuf, vptr, sizeof (fbuf));
+    sim_trim_endspc (fbuf);
+    if (vid_off.input)
+        fclose (vid_off.input);
+    vid_off.input = sim_fopen (fbuf, "r");
+    if (vid_off.input == NULL)
+        return sim_messagef (SCPE_OPENERR, "Can't open %s: %s\n", fbuf, strerror (errno));
+    strlcpy (vid_off.input_name, fbuf, sizeof (vid_off.input_name));
+    vid_off.input_delay = 0;
+    return SCPE_OK;
+    }
+if (MATCH_CMD (gbuf, "NOINPUT") == 0) {
+    if (vid_off.input)
+        fclose (vid_off.input);
+    vid_off.input = NULL;
+    return SCPE_OK;
+    }
+return vid_off_event (cptr, FALSE);
+}
+
+#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+
+char vid_release_key[64] = "Ctrl-Right-Shift";
+
+#include <SDL.h>
+#include <SDL_thread.h>
+
 #if defined(HAVE_LIBPNG)
 /* From: https://github.com/driedfruit/SDL_SavePNG */
 
@@ -271,7 +833,6 @@ static int SDL_SavePNG_RW(SDL_Surface *surface, SDL_RWops *dst, int freedst)
 #define EVENT_CLOSE      2                              /* close event for SDL */
 #define EVENT_CURSOR     3                              /* new cursor for SDL */
 #define EVENT_WARP       4                              /* warp mouse position for SDL */
-#define EVENT_DRAW       5                              /* draw/blit region for SDL */
 #define EVENT_SHOW       6                              /* show SDL capabilities */
 #define EVENT_OPEN       7                              /* vid_open request */
 #define EVENT_EXIT       8                              /* program exit */
@@ -362,6 +923,17 @@ SDL_Texture *vid_texture;                               /* video buffer in GPU *
 SDL_Renderer *vid_renderer;
 SDL_Window *vid_window;                                 /* window handle */
 uint32 vid_windowID;
+#define VID_DIRTY_MAX   32                              /* max pending update regions */
+#define VID_MIN(a,b)    (((a) < (b)) ? (a) : (b))
+#define VID_MAX(a,b)    (((a) > (b)) ? (a) : (b))
+uint32 *vid_fb = NULL;                                  /* simulator side frame buffer */
+SDL_mutex *vid_fb_lock = NULL;                          /* frame buffer/dirty list lock */
+SDL_Rect vid_dirty[VID_DIRTY_MAX];                      /* regions changed since last refresh */
+int32 vid_dirty_cnt = 0;
+t_bool vid_redraw_pending = FALSE;                      /* EVENT_REDRAW queued */
+static void vid_dirty_add (int32 x, int32 y, int32 w, int32 h);
+static void vid_update_dirty (void);
+static void vid_fb_free (void);
 #endif
 SDL_Thread *vid_thread_handle = NULL;                   /* event thread handle */
 SDL_Cursor *vid_cursor = NULL;                          /* current cursor */
@@ -507,6 +1079,8 @@ return SCPE_OK;
 
 t_stat vid_open (DEVICE *dptr, const char *title, uint32 width, uint32 height, int flags)
 {
+if (vid_offscreen)
+    return vid_off_open (dptr, title, width, height, flags);
 if (!vid_active) {
     int wait_count = 0;
     t_stat stat;
@@ -533,9 +1107,29 @@ if (!vid_active) {
 
     vid_dev = dptr;
 
+#if SDL_MAJOR_VERSION != 1
+    vid_fb = (uint32 *)calloc (width * height, sizeof (*vid_fb));
+    vid_fb_lock = SDL_CreateMutex ();
+    vid_dirty_cnt = 0;
+    vid_redraw_pending = FALSE;
+    if ((vid_fb == NULL) || (vid_fb_lock == NULL)) {
+        vid_fb_free ();                                 /* release what was set up */
+        SDL_DestroySemaphore (vid_key_events.sem);
+        vid_key_events.sem = NULL;
+        SDL_DestroySemaphore (vid_mouse_events.sem);
+        vid_mouse_events.sem = NULL;
+        vid_dev = NULL;
+        vid_active = FALSE;
+        return SCPE_MEM;
+        }
+#endif
     stat = vid_create_window ();
-    if (stat != SCPE_OK)
+    if (stat != SCPE_OK) {
+#if SDL_MAJOR_VERSION != 1
+        vid_fb_free ();                                 /* no window to draw into */
+#endif
         return stat;
+        }
 
     sim_debug (SIM_VID_DBG_VIDEO|SIM_VID_DBG_KEY|SIM_VID_DBG_MOUSE, vid_dev, "vid_open() - Success\n");
     }
@@ -544,6 +1138,8 @@ return SCPE_OK;
 
 t_stat vid_close (void)
 {
+if (vid_offscreen)
+    return vid_off_close ();
 if (vid_active) {
     SDL_Event user_event;
     int status;
@@ -574,12 +1170,33 @@ if (vid_active) {
         SDL_DestroySemaphore(vid_key_events.sem);
         vid_key_events.sem = NULL;
         }
+#if SDL_MAJOR_VERSION != 1
+    vid_fb_free ();
+#endif
     }
 return SCPE_OK;
 }
 
+#if SDL_MAJOR_VERSION != 1
+/* Release the frame buffer and its lock; safe to call more than once */
+
+static void vid_fb_free (void)
+{
+if (vid_fb_lock) {
+    SDL_DestroyMutex (vid_fb_lock);
+    vid_fb_lock = NULL;
+    }
+free (vid_fb);
+vid_fb = NULL;
+vid_dirty_cnt = 0;
+vid_redraw_pending = FALSE;
+}
+#endif
+
 t_stat vid_poll_kb (SIM_KEY_EVENT *ev)
 {
+if (vid_offscreen)
+    return vid_off_poll_kb (ev);
 if (SDL_SemTryWait (vid_key_events.sem) == 0) {         /* get lock */
     if (vid_key_events.count > 0) {                     /* events in queue? */
         *ev = vid_key_events.events[vid_key_events.head++];
@@ -599,6 +1216,8 @@ t_stat vid_poll_mouse (SIM_MOUSE_EVENT *ev)
 t_stat stat = SCPE_EOF;
 SIM_MOUSE_EVENT *nev;
 
+if (vid_offscreen)
+    return vid_off_poll_mouse (ev);
 if (SDL_SemTryWait (vid_mouse_events.sem) == 0) {
     if (vid_mouse_events.count > 0) {
         stat = SCPE_OK;
@@ -632,6 +1251,10 @@ void vid_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf)
 int32 i;
 uint32* pixels;
 
+if (vid_offscreen) {
+    vid_off_draw (x, y, w, h, buf);
+    return;
+    }
 sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_draw(%d, %d, %d, %d)\n", x, y, w, h);
 
 pixels = (uint32 *)vid_image->pixels;
@@ -639,45 +1262,96 @@ pixels = (uint32 *)vid_image->pixels;
 for (i = 0; i < h; i++)
     memcpy (pixels + ((i + y) * vid_width) + x, buf + w*i, w*sizeof(*pixels));
 #else
-SDL_Event user_event;
-SDL_Rect *vid_dst;
-uint32 *vid_data;
+int32 i;
 
+if (vid_offscreen) {
+    vid_off_draw (x, y, w, h, buf);
+    return;
+    }
 sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_draw(%d, %d, %d, %d)\n", x, y, w, h);
 
-vid_dst = (SDL_Rect *)malloc (sizeof(*vid_dst));
-if (!vid_dst) {
-    sim_printf ("%s: vid_draw() memory allocation error\n", vid_dev ? sim_dname(vid_dev) : "Video Device");
+if (!vid_fb)
     return;
+SDL_LockMutex (vid_fb_lock);
+for (i = 0; i < h; i++)
+    memcpy (vid_fb + ((i + y) * vid_width) + x, buf + w*i, w*sizeof(*vid_fb));
+vid_dirty_add (x, y, w, h);
+SDL_UnlockMutex (vid_fb_lock);
+#endif
+}
+
+#if SDL_MAJOR_VERSION != 1
+/* Record a changed region, merging it with any pending region it overlaps
+   or touches.  Called with vid_fb_lock held. */
+
+static void vid_dirty_add (int32 x, int32 y, int32 w, int32 h)
+{
+int32 i, x2, y2;
+SDL_Rect *r;
+
+for (i = 0; i < vid_dirty_cnt; i++) {
+    r = &vid_dirty[i];
+    if ((x <= r->x + r->w) && (r->x <= x + w) &&
+        (y <= r->y + r->h) && (r->y <= y + h))
+        break;
     }
-vid_dst->x = x;
-vid_dst->y = y;
-vid_dst->w = w;
-vid_dst->h = h;
-vid_data = (uint32 *)malloc (w*h*sizeof(*buf));
-if (!vid_data) {
-    sim_printf ("%s: vid_draw() memory allocation error\n", vid_dev ? sim_dname(vid_dev) : "Video Device");
-    free (vid_dst);
-    return;
+if (i == vid_dirty_cnt) {                               /* no neighbor? */
+    if (vid_dirty_cnt < VID_DIRTY_MAX) {                /* room for another? */
+        r = &vid_dirty[vid_dirty_cnt++];
+        r->x = x;
+        r->y = y;
+        r->w = w;
+        r->h = h;
+        return;
+        }
+    r = &vid_dirty[0];                                  /* list full, collapse */
+    for (i = 1; i < vid_dirty_cnt; i++) {
+        x2 = VID_MAX (r->x + r->w, vid_dirty[i].x + vid_dirty[i].w);
+        y2 = VID_MAX (r->y + r->h, vid_dirty[i].y + vid_dirty[i].h);
+        r->x = VID_MIN (r->x, vid_dirty[i].x);
+        r->y = VID_MIN (r->y, vid_dirty[i].y);
+        r->w = x2 - r->x;
+        r->h = y2 - r->y;
+        }
+    vid_dirty_cnt = 1;
     }
-memcpy (vid_data, buf, w*h*sizeof(*buf));
-user_event.type = SDL_USEREVENT;
-user_event.user.code = EVENT_DRAW;
-user_event.user.data1 = (void *)vid_dst;
-user_event.user.data2 = (void *)vid_data;
-if (SDL_PushEvent (&user_event) < 0) {
-    sim_printf ("%s: vid_draw() SDL_PushEvent error: %s\n", vid_dev ? sim_dname(vid_dev) : "Video Device", SDL_GetError());
-    free (vid_dst);
-    free (vid_data);
+x2 = VID_MAX (r->x + r->w, x + w);                      /* merge into r */
+y2 = VID_MAX (r->y + r->h, y + h);
+r->x = VID_MIN (r->x, x);
+r->y = VID_MIN (r->y, y);
+r->w = x2 - r->x;
+r->h = y2 - r->y;
+}
+
+/* Move the changed regions of the frame buffer to the texture */
+
+static void vid_update_dirty (void)
+{
+int32 i;
+SDL_Rect *r;
+
+SDL_LockMutex (vid_fb_lock);
+vid_redraw_pending = FALSE;
+for (i = 0; i < vid_dirty_cnt; i++) {
+    r = &vid_dirty[i];
+    sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "Draw Region: (%d,%d,%d,%d)\n", r->x, r->y, r->w, r->h);
+    if (SDL_UpdateTexture (vid_texture, r, vid_fb + (r->y * vid_width) + r->x, vid_width*sizeof(*vid_fb)))
+        sim_printf ("%s: vid_update_dirty() - SDL_UpdateTexture error: %s\n", sim_dname(vid_dev), SDL_GetError());
     }
-#endif
+vid_dirty_cnt = 0;
+SDL_UnlockMutex (vid_fb_lock);
 }
+#endif
 
 t_stat vid_set_cursor (t_bool visible, uint32 width, uint32 height, uint8 *data, uint8 *mask, uint32 hot_x, uint32 hot_y)
 {
-SDL_Cursor *cursor = SDL_CreateCursor (data, mask, width, height, hot_x, hot_y);
+SDL_Cursor *cursor;
 SDL_Event user_event;
 
+if (vid_offscreen)
+    return SCPE_OK;
+cursor = SDL_CreateCursor (data, mask, width, height, hot_x, hot_y);
+
 sim_debug (SIM_VID_DBG_CURSOR, vid_dev, "vid_set_cursor(%s, %d, %d) Setting New Cursor\n", visible ? "visible" : "invisible", width, height);
 if (sim_deb) {
     uint32 i, j;
@@ -713,6 +1387,11 @@ void vid_set_cursor_position (int32 x, int32 y)
 int32 x_delta = vid_cursor_x - x;
 int32 y_delta = vid_cursor_y - y;
 
+if (vid_offscreen) {
+    vid_cursor_x = x;
+    vid_cursor_y = y;
+    return;
+    }
 if (vid_flags & SIM_VID_INPUTCAPTURED)
     return;
 
@@ -760,6 +1439,24 @@ void vid_refresh (void)
 {
 SDL_Event user_event;
 
+if (vid_offscreen) {
+    vid_off_refresh ();
+    return;
+    }
+#if SDL_MAJOR_VERSION != 1
+if (vid_fb_lock) {
+    t_bool pending;
+
+    SDL_LockMutex (vid_fb_lock);
+    pending = vid_redraw_pending;
+    vid_redraw_pending = TRUE;
+    SDL_UnlockMutex (vid_fb_lock);
+    if (pending) {                                      /* one refresh per frame */
+        sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_refresh() - Refresh Already Pending\n");
+        return;
+        }
+    }
+#endif
 sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_refresh() - Queueing Refresh Event\n");
 
 user_event.type = SDL_USEREVENT;
@@ -767,8 +1464,16 @@ user_event.user.code = EVENT_REDRAW;
 user_event.user.data1 = NULL;
 user_event.user.data2 = NULL;
 
-if (SDL_PushEvent (&user_event) < 0)
+if (SDL_PushEvent (&user_event) < 0) {
     sim_printf ("%s: vid_refresh() SDL_PushEvent error: %s\n", sim_dname(vid_dev), SDL_GetError());
+#if SDL_MAJOR_VERSION != 1
+    if (vid_fb_lock) {                                  /* not queued after all */
+        SDL_LockMutex (vid_fb_lock);
+        vid_redraw_pending = FALSE;                     /* let next one try */
+        SDL_UnlockMutex (vid_fb_lock);
+        }
+#endif
+    }
 }
 
 int vid_map_key (int key)
@@ -1409,33 +2114,6 @@ SDL_WarpMouseInWindow (NULL, vid_cursor_x, vid_cursor_y);
 SDL_PumpEvents ();
 }
 
-void vid_draw_region (SDL_UserEvent *event)
-{
-SDL_Rect *vid_dst = (SDL_Rect *)event->data1;
-uint32 *buf = (uint32 *)event->data2;
-
-sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "Draw Region Event: (%d,%d,%d,%d)\n", vid_dst->x, vid_dst->x, vid_dst->w, vid_dst->h);
-
-#if SDL_MAJOR_VERSION == 1
-if (1) {
-    int32 i;
-    uint32* pixels;
-
-    pixels = (uint32 *)vid_image->pixels;
-
-    for (i = 0; i < vid_dst->h; i++)
-        memcpy (pixels + ((i + vid_dst->y) * vid_width) + vid_dst->x, buf + vid_dst->w*i, vid_dst->w*sizeof(*pixels));
-    }
-#else
-if (SDL_UpdateTexture(vid_texture, vid_dst, buf, vid_dst->w*sizeof(*buf)))
-    sim_printf ("%s: vid_draw() - SDL_UpdateTexture error: %s\n", sim_dname(vid_dev), SDL_GetError());
-#endif
-
-free (vid_dst);
-free (buf);
-event->data1 = NULL;
-}
-
 int vid_video_events (void)
 {
 SDL_Event event;
@@ -1706,9 +2384,9 @@ while (vid_active) {
                 break;
 #endif
             case SDL_USEREVENT:
-                /* There are 6 user events generated */
-                /* EVENT_REDRAW to update the display */
-                /* EVENT_DRAW   to update a region in the display texture */
+                /* There are 5 user events generated */
+                /* EVENT_REDRAW to move changed frame buffer regions */
+                /*              to the texture and update the display */
                 /* EVENT_SHOW   to display the current SDL video capabilities */
                 /* EVENT_CURSOR to change the current cursor */
                 /* EVENT_WARP   to warp the cursor position */
@@ -1716,6 +2394,9 @@ while (vid_active) {
                 /*              it notice vid_active has changed */
                 while (vid_active && event.user.code) {
                     if (event.user.code == EVENT_REDRAW) {
+#if SDL_MAJOR_VERSION != 1
+                        vid_update_dirty ();
+#endif
                         vid_update ();
                         event.user.code = 0;    /* Mark as done */
 #if SDL_MAJOR_VERSION == 1
@@ -1744,10 +2425,6 @@ if (0)                        while (SDL_PeepEvents (&event, 1, SDL_GETEVENT, SD
                     if (event.user.code == EVENT_CLOSE) {
                         event.user.code = 0;    /* Mark as done */
                         }
-                    if (event.user.code == EVENT_DRAW) {
-                        vid_draw_region ((SDL_UserEvent*)&event);
-                        event.user.code = 0;    /* Mark as done */
-                        }
                     if (event.user.code == EVENT_SHOW) {
                         vid_show_video_event ();
                         event.user.code = 0;    /* Mark as done */
@@ -2107,6 +2784,8 @@ t_stat vid_show_video (FILE* st, UNIT* uptr, int32 val, CONST void* desc)
 {
 SDL_Event user_event;
 
+if (vid_offscreen)
+    return vid_off_show (st);
 _show_stat = -1;
 _show_st = st;
 _show_uptr = uptr;
@@ -2200,6 +2879,8 @@ t_stat vid_screenshot (const char *filename)
 {
 SDL_Event user_event;
 
+if (vid_offscreen)
+    return vid_off_screenshot (filename);
 _screenshot_stat = -1;
 _screenshot_filename = filename;
 
@@ -2287,6 +2968,9 @@ void vid_beep (void)
 {
 SDL_Event user_event;
 
+if (vid_offscreen)
+    return;
+
 user_event.type = SDL_USEREVENT;
 user_event.user.code = EVENT_BEEP;
 user_event.user.data1 = NULL;
@@ -2301,48 +2985,51 @@ SDL_Delay (vid_beep_duration + 100);/* Wait for sound to finnish */
 }
 
 #else /* !(defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)) */
-/* Non-implemented versions */
+/* Versions without window system support, only the offscreen backend */
 
 uint32 vid_mono_palette[2];                             /* Monochrome Color Map */
 
 t_stat vid_open (DEVICE *dptr, const char *title, uint32 width, uint32 height, int flags)
 {
+if (vid_offscreen)
+    return vid_off_open (dptr, title, width, height, flags);
 return SCPE_NOFNC;
 }
 
 t_stat vid_close (void)
 {
-return SCPE_OK;
+return vid_off_close ();
 }
 
 t_stat vid_poll_kb (SIM_KEY_EVENT *ev)
 {
-return SCPE_EOF;
+return vid_off_poll_kb (ev);
 }
 
 t_stat vid_poll_mouse (SIM_MOUSE_EVENT *ev)
 {
-return SCPE_EOF;
+return vid_off_poll_mouse (ev);
 }
 
 void vid_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf)
 {
-return;
+vid_off_draw (x, y, w, h, buf);
 }
 
 t_stat vid_set_cursor (t_bool visible, uint32 width, uint32 height, uint8 *data, uint8 *mask, uint32 hot_x, uint32 hot_y)
 {
-return SCPE_NOFNC;
+return vid_offscreen ? SCPE_OK : SCPE_NOFNC;
 }
 
 void vid_set_cursor_position (int32 x, int32 y)
 {
-return;
+vid_cursor_x = x;
+vid_cursor_y = y;
 }
 
 void vid_refresh (void)
 {
-return;
+vid_off_refresh ();
 }
 
 void vid_beep (void)
@@ -2368,12 +3055,16 @@ return SCPE_OK;
 
 t_stat vid_show_video (FILE* st, UNIT* uptr, int32 val, CONST void* desc)
 {
-fprintf (st, "video support unavailable");
+if (vid_offscreen)
+    return vid_off_show (st);
+fprintf (st, "video support unavailable, SET VIDEO OFFSCREEN selects the offscreen backend\n");
 return SCPE_OK;
 }
 
 t_stat vid_screenshot (const char *filename)
 {
+if (vid_offscreen)
+    return vid_off_screenshot (filename);
 sim_printf ("video support unavailable\n");
 return SCPE_NOFNC|SCPE_NOMESSAGE;
 }
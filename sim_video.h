@@ -194,6 +194,9 @@ t_stat vid_show_release_key (FILE* st, UNIT* uptr, int32 val, CONST void* desc);
 t_stat vid_show_video (FILE* st, UNIT* uptr, int32 val, CONST void* desc);
 t_stat vid_show (FILE* st, DEVICE *dptr,  UNIT* uptr, int32 val, CONST char* desc);
 t_stat vid_screenshot (const char *filename);
+t_stat vid_set (int32 flag, CONST char *cptr);
+void vid_expand_1bpp (const uint32 *src, uint32 *dst, int32 pixels, const uint32 *palette);
+void vid_cursor_mono (uint32 *dst, const uint8 *cur, int32 pixels, const uint32 *palette, t_bool or_func);
 
 extern t_bool vid_active;
 extern uint32 vid_mono_palette[2];